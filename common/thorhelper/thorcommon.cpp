@@ -1771,6 +1771,8 @@ IDiskMerger *createDiskMerger(IRowInterfaces *rowInterfaces, IRowLinkCounter *li
 
 //---------------------------------------------------------------------------------------------------------------------
 
+static const StatisticKind hardwareCounterKinds[HwMaxCounter] = { StNumHwCycles, StNumHwInstructions, StNumHwCacheMisses, StNumHwBranchMisses };
+
 void ActivityTimeAccumulator::addStatistics(IStatisticGatherer & builder) const
 {
     if (totalCycles)
@@ -1781,6 +1783,11 @@ void ActivityTimeAccumulator::addStatistics(IStatisticGatherer & builder) const
         builder.addStatistic(StTimeFirstExecute, latency());
         if (blockedCycles)
             builder.addStatistic(StTimeBlocked, cycle_to_nanosec(blockedCycles));
+        if (!hardwareCounters.isEmpty())
+        {
+            for (unsigned i=0; i < HwMaxCounter; i++)
+                builder.addStatistic(hardwareCounterKinds[i], hardwareCounters.values[i]);
+        }
     }
 }
 
@@ -1794,6 +1801,16 @@ void ActivityTimeAccumulator::addStatistics(CRuntimeStatisticCollection & merged
         merged.mergeStatistic(StTimeFirstExecute, latency());
         if (blockedCycles)
             merged.mergeStatistic(StTimeBlocked, cycle_to_nanosec(blockedCycles));
+        addHardwareStatistics(merged);
+    }
+}
+
+void ActivityTimeAccumulator::addHardwareStatistics(CRuntimeStatisticCollection & merged) const
+{
+    if (!hardwareCounters.isEmpty())
+    {
+        for (unsigned i=0; i < HwMaxCounter; i++)
+            merged.mergeStatistic(hardwareCounterKinds[i], hardwareCounters.values[i]);
     }
 }
 
@@ -1817,6 +1834,7 @@ void ActivityTimeAccumulator::merge(const ActivityTimeAccumulator & other)
                 endCycles = other.endCycles;
             totalCycles += other.totalCycles;
             blockedCycles += other.blockedCycles;
+            hardwareCounters += other.hardwareCounters;
         }
         else
             *this = other;
@@ -24,6 +24,7 @@
 #include "jlzw.hpp"
 #include "jsort.hpp"
 #include "jdebug.hpp"
+#include "jprofiler.hpp"
 #include "jfile.hpp"
 #include "eclhelper.hpp"
 #include "rtldynfield.hpp"
@@ -245,6 +246,8 @@ public:
     unsigned __int64 firstRow; // Timestamp of first row (nanoseconds since epoch)
     cycle_t firstExitCycles;    // Wall clock time of first exit from this activity
     cycle_t blockedCycles;  // Time spent blocked
+    HardwareCounterValues hardwareCounters; // Hardware counters while in this activity (only if enabled) - includes any inputs called
+    unsigned profileActivityId = 0;         // Activity that samples taken by the sampling profiler are attributed to (not reset)
 
     // Return the total amount of time (in nanoseconds) spent in this activity (first entry to last exit)
     inline unsigned __int64 elapsed() const { return cycle_to_nanosec(endCycles-startCycles); }
@@ -254,6 +257,7 @@ public:
 
     void addStatistics(IStatisticGatherer & builder) const;
     void addStatistics(CRuntimeStatisticCollection & merged) const;
+    void addHardwareStatistics(CRuntimeStatisticCollection & merged) const;
     void merge(const ActivityTimeAccumulator & other);
 
     void reset()
@@ -264,6 +268,7 @@ public:
         firstRow = 0;
         firstExitCycles = 0;
         blockedCycles = 0;
+        hardwareCounters.clear();
     }
 };
 
@@ -273,15 +278,26 @@ class ActivityTimer
 {
     unsigned __int64 startCycles;
     ActivityTimeAccumulator &accumulator;
+    HardwareCounterValues startCounters;
+    unsigned prevProfileActivityId;
 protected:
     const bool enabled;
     bool isFirstRow;
+    bool countingHardware = false;
+    bool profiling = false;
 public:
     ActivityTimer(ActivityTimeAccumulator &_accumulator, const bool _enabled)
     : accumulator(_accumulator), enabled(_enabled), isFirstRow(false)
     {
+        if (unlikely(isSamplingProfilerActive()))
+        {
+            profiling = true;
+            prevProfileActivityId = setProfilerActivity(accumulator.profileActivityId);
+        }
         if (likely(enabled))
         {
+            if (unlikely(queryCollectHardwareCounters()))
+                countingHardware = readThreadHardwareCounters(startCounters);
             startCycles = get_cycles_now();
             if (unlikely(!accumulator.firstRow))
             {
@@ -304,7 +320,15 @@ public:
             accumulator.totalCycles += elapsedCycles;
             if (unlikely(isFirstRow))
                 accumulator.firstExitCycles = nowCycles;
+            if (unlikely(countingHardware))
+            {
+                HardwareCounterValues endCounters;
+                if (readThreadHardwareCounters(endCounters))
+                    accumulator.hardwareCounters += endCounters - startCounters;
+            }
         }
+        if (unlikely(profiling))
+            setProfilerActivity(prevProfileActivityId);
     }
 };
 
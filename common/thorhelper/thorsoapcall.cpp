@@ -32,7 +32,9 @@
 #include "roxiemem.hpp"
 #include "zcrypt.hpp"
 #include "persistent.hpp"
+#include "jmetrics.hpp"
 
+#include <map>
 #include <memory>
 
 using roxiemem::OwnedRoxieString;
@@ -100,6 +102,14 @@ public:
     unsigned port;
     StringBuffer path;
     StringBuffer userPasswordPair;
+    const SoapCallEndpointMetrics * metrics = nullptr;
+
+    const SoapCallEndpointMetrics & queryMetrics()
+    {
+        if (!metrics)
+            metrics = &querySoapCallEndpointMetrics(host, port);
+        return *metrics;
+    }
 
     StringBuffer &getUrlString(StringBuffer &url) const
     {
@@ -563,6 +573,56 @@ static std::atomic<bool> globalFeaturesInitDone{false};
 static std::atomic<bool> mapUrlsToSecrets{false};
 static std::atomic<bool> warnIfUrlNotMappedToSecret{false};
 static std::atomic<bool> requireUrlsMappedToSecrets{false};
+static unsigned batchLatencyTargetMs = 0;   // 0 disables adaptive batching
+
+static ReadWriteLock endpointMetricsLock;
+static std::map<std::string, SoapCallEndpointMetrics> endpointMetrics;
+
+// The number of distinct services called by a process is normally small, so the metrics are labelled with the endpoint
+const SoapCallEndpointMetrics & querySoapCallEndpointMetrics(const char * host, unsigned port)
+{
+    VStringBuffer endpoint("%s:%u", nullText(host), port);
+    {
+        ReadLockBlock block(endpointMetricsLock);
+        auto match = endpointMetrics.find(endpoint.str());
+        if (match != endpointMetrics.end())
+            return match->second;
+    }
+
+    WriteLockBlock block(endpointMetricsLock);
+    if (endpointMetrics.size() >= maxSoapCallEndpointMetrics)
+        endpoint.set("other");
+    auto match = endpointMetrics.find(endpoint.str());
+    if (match != endpointMetrics.end())
+        return match->second;
+
+    static const std::vector<__uint64> latencyBuckets = {
+        1000000, 2000000, 5000000, 10000000, 20000000, 50000000, 100000000, 200000000, 500000000,
+        1000000000, 2000000000, 5000000000, 10000000000, 30000000000, 60000000000 };
+    hpccMetrics::MetricMetaData metaData{{"endpoint", endpoint.str()}};
+    SoapCallEndpointMetrics & metrics = endpointMetrics[endpoint.str()];
+    metrics.latency = hpccMetrics::registerCyclesToNsScaledHistogramMetric("soapcall.latency", "Time from sending a SOAPCALL/HTTPCALL request until its response has been read", latencyBuckets, metaData);
+    metrics.connects = hpccMetrics::registerCounterMetric("soapcall.connects", "Number of new connections made for SOAPCALL/HTTPCALL requests", SMeasureCount, metaData);
+    return metrics;
+}
+
+// The batch size requested in the query is an upper limit.  If a batch takes longer than the latency target the size
+// is reduced to the number of rows that would have completed within the target.  While full batches complete within
+// the target the size grows gradually towards that estimate, in case the latency does not scale linearly.
+unsigned calcAdaptiveRecordsPerBatch(unsigned current, unsigned maxRecords, unsigned numRows, unsigned elapsedMs, unsigned targetMs)
+{
+    if (!targetMs || (maxRecords <= 1))
+        return maxRecords;
+    current = std::min(std::max(current, 1U), maxRecords);
+    unsigned estimate = maxRecords;
+    if (elapsedMs)
+        estimate = (unsigned)std::min((unsigned __int64)numRows * targetMs / elapsedMs, (unsigned __int64)maxRecords);
+    if (elapsedMs > targetMs)
+        return std::max(std::min(estimate, current), 1U);
+    if ((numRows >= current) && (elapsedMs < targetMs - targetMs / 10))
+        return std::max(std::min(estimate, current + current / 4 + 1), current);
+    return current;
+}
 
 void initGlobalFeatures()
 {
@@ -583,6 +643,7 @@ void initGlobalFeatures()
         mapUrlsToSecrets = conf->getPropBool("@mapHttpCallUrlsToSecrets", false);
         warnIfUrlNotMappedToSecret = conf->getPropBool("@warnIfUrlNotMappedToSecret", mapUrlsToSecrets);
         requireUrlsMappedToSecrets = conf->getPropBool("@requireUrlsMappedToSecrets", false);
+        batchLatencyTargetMs = conf->getPropInt("@httpCallBatchLatencyMs", 0);
 
         if (maxPersistentRequests != 0)
             persistentHandler = createPersistentHandler(nullptr, DEFAULT_MAX_PERSISTENT_IDLE_TIME, maxPersistentRequests, PersistentLogLevel::PLogMin, true);
@@ -1180,6 +1241,12 @@ public:
                 throw MakeStringException(0, "%s proxy address specified no URLs", getWsCallTypeName(wscType));
         }
 
+        // Look up the metrics once, rather than for each request
+        ForEachItemIn(iu, urlArray)
+            urlArray.item(iu).queryMetrics();
+        ForEachItemIn(ip, proxyUrlArray)
+            proxyUrlArray.item(ip).queryMetrics();
+
         if (wscMode == SCrow)
         {
             numRowThreads = 1;
@@ -1212,6 +1279,7 @@ public:
             if (numRecordsPerBatch < 1)
                 numRecordsPerBatch = 1;
         }
+        adaptiveRecordsPerBatch = numRecordsPerBatch;
 
         for (unsigned i=0; i<numRowThreads; i++)
             threads.append(*new CWSCHelperThread(this));
@@ -1359,6 +1427,20 @@ public:
     inline IXmlToRowTransformer * getRowTransformer() { return rowTransformer; }
     inline const char * wscCallTypeText() const { return getWsCallTypeName(wscType); }
     inline bool usePersistConnections() const { return persistEnabled; }
+    inline unsigned getRecordsPerBatch() const { return batchLatencyTargetMs ? adaptiveRecordsPerBatch.load() : numRecordsPerBatch; }
+
+    void noteBatchLatency(unsigned numRows, unsigned elapsedMs)
+    {
+        if (!batchLatencyTargetMs || (numRecordsPerBatch <= 1))
+            return;
+        unsigned current = adaptiveRecordsPerBatch.load();
+        unsigned next = calcAdaptiveRecordsPerBatch(current, numRecordsPerBatch, numRows, elapsedMs, batchLatencyTargetMs);
+        if ((next != current) && adaptiveRecordsPerBatch.compare_exchange_strong(current, next))
+        {
+            if (soapTraceLevel > 4)
+                logctx.CTXLOG("%s: batch of %u rows took %ums, records per batch now %u", getWsCallTypeName(wscType), numRows, elapsedMs, next);
+        }
+    }
     inline unsigned getPersistMaxRequests() const { return persistMaxRequests; }
 
 protected:
@@ -1413,6 +1495,7 @@ protected:
     UrlArray urlArray;
     UrlArray proxyUrlArray;
     unsigned numRecordsPerBatch;
+    std::atomic<unsigned> adaptiveRecordsPerBatch{1};
     unsigned numUrls;
     unsigned numRowThreads;
     unsigned numUrlThreads;
@@ -1680,12 +1763,14 @@ int CWSCHelperThread::run()
                     if (!r)
                         break;
                     inputRows.append(r);
-                    if (inputRows.ordinality() >= master->numRecordsPerBatch)
+                    if (inputRows.ordinality() >= master->getRecordsPerBatch())
                         break;
                 }
                 if (inputRows.ordinality() == 0)
                     break;
+                CCycleTimer batchTimer;
                 processQuery(inputRows);
+                master->noteBatchLatency(inputRows.ordinality(), batchTimer.elapsedMs());
             }
             catch (IException *e)
             {
@@ -2469,6 +2554,7 @@ public:
                     {
                         isReused = false;
                         keepAlive = true;
+                        connUrl.queryMetrics().connects->inc(1);
                         socket.setown(blacklist->connect(ep, master->logctx, (unsigned)master->maxRetries, master->timeoutMS, master->roxieAbortMonitor, master->rowProvider));
                         if (proto == PersistentProtocol::ProtoTLS)
                         {
@@ -2535,6 +2621,7 @@ public:
             {
                 checkTimeLimitExceeded(&remainingMS);
                 checkRoxieAbortMonitor(master->roxieAbortMonitor);
+                cycle_t sendCycles = get_cycles_now();
                 socket->write(request.str(), request.length());
                 if (soapTraceLevel > 4)
                     master->logctx.CTXLOG("%s: sent request (%s) to %s:%d", getWsCallTypeName(master->wscType),master->service.str(), url.host.str(), url.port);
@@ -2545,6 +2632,7 @@ public:
                 StringBuffer contentType;
                 int rval = readHttpResponse(response, socket, keepAlive2, contentType);
                 keepAlive = keepAlive && keepAlive2;
+                url.queryMetrics().latency->recordMeasurement(get_cycles_now() - sendCycles);
 
                 if (soapTraceLevel > 4)
                     master->logctx.CTXLOG("%s: received response (%s) from %s:%d", getWsCallTypeName(master->wscType),master->service.str(), url.host.str(), url.port);
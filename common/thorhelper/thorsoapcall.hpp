@@ -24,7 +24,9 @@
  #define THORHELPER_API DECL_IMPORT
 #endif
 
+#include <memory>
 #include "jlog.hpp"
+#include "jmetrics.hpp"
 #include "eclhelper.hpp"
 
 #define DEBLACKLIST_RETRY_DELAY 5000
@@ -82,6 +84,19 @@ interface IRoxieAbortMonitor
 };
 
 
+// Metrics for the requests sent to each endpoint.  Endpoints beyond the first maxSoapCallEndpointMetrics share a
+// single set of metrics, so that a query calling many different hosts cannot grow the metrics without limit.
+struct SoapCallEndpointMetrics
+{
+    std::shared_ptr<hpccMetrics::ScaledHistogramMetric> latency;
+    std::shared_ptr<hpccMetrics::CounterMetric> connects;
+};
+constexpr unsigned maxSoapCallEndpointMetrics = 100;
+
+extern THORHELPER_API const SoapCallEndpointMetrics & querySoapCallEndpointMetrics(const char * host, unsigned port);
+// Returns the number of records to send in the next batch, given how long the last batch of numRows took
+extern THORHELPER_API unsigned calcAdaptiveRecordsPerBatch(unsigned current, unsigned maxRecords, unsigned numRows, unsigned elapsedMs, unsigned targetMs);
+
 extern THORHELPER_API unsigned soapTraceLevel;
 extern THORHELPER_API IWSCHelper * createSoapCallHelper(IWSCRowProvider *, IEngineRowAllocator * outputAllocator, const char *authToken, SoapCallMode scMode, ClientCertificate *clientCert, const IContextLogger &logctx, IRoxieAbortMonitor * roxieAbortMonitor);
 extern THORHELPER_API IWSCHelper * createHttpCallHelper(IWSCRowProvider *, IEngineRowAllocator * outputAllocator, const char *authToken, SoapCallMode scMode, ClientCertificate *clientCert, const IContextLogger &logctx, IRoxieAbortMonitor * roxieAbortMonitor);
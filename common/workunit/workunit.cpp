@@ -16,6 +16,8 @@
 ############################################################################## */
 
 #include <string>
+#include <memory>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "jlib.hpp"
@@ -57,9 +59,11 @@
 #endif
 #include "daqueue.hpp"
 #include "workunit.ipp"
+#include "wustats.hpp"
 #include "digisign.hpp"
 
 #include <list>
+#include <map>
 #include <string>
 #include <algorithm>
 
@@ -242,6 +246,56 @@ IStatisticGatherer & CWuGraphStats::queryStatsBuilder()
     return *collector;
 }
 
+//Save a columnar form of the statistics for each subgraph, which is much cheaper for the scope iterators to process.
+//This is only done once the graph has finished, rather than on every progress update.  Any later update replaces
+//the subgraph tree, so the columns can never be out of date with the statistics.
+static void saveSubGraphColumns(IPropertyTree & graphProgress)
+{
+    Owned<IPropertyTreeIterator> subgraphs = graphProgress.getElements("*[Stats]");
+    ForEach(*subgraphs)
+    {
+        IPropertyTree & subgraph = subgraphs->query();
+        if (subgraph.hasProp("Columns"))
+            continue;
+
+        MemoryBuffer compressed;
+        subgraph.getPropBin("Stats", compressed);
+        if (compressed.length() == 0)
+            continue;
+
+        MemoryBuffer serialized;
+        decompressToBuffer(serialized, compressed);
+        Owned<IStatisticCollection> collection = createStatisticCollection(serialized);
+        ColumnarStatistics columns;
+        columns.build(*collection);
+        columns.serialize(serialized.clear());
+        compressToBuffer(compressed.clear(), serialized.length(), serialized.toByteArray());
+        subgraph.setPropBin("Columns", compressed.length(), compressed.toByteArray());
+    }
+}
+
+//Read the columnar statistics for a subgraph - creating them from the serialized collection if the workunit was
+//created before they were saved.  Returns false if the subgraph has no statistics.
+static bool loadSubGraphStatistics(ColumnarStatistics & target, IPropertyTree & subgraph, MemoryBuffer & buffer)
+{
+    subgraph.getPropBin("Columns", buffer.clear());
+    if (buffer.length())
+    {
+        target.deserializeCompressed(buffer);
+        return true;
+    }
+
+    subgraph.getPropBin("Stats", buffer.clear());
+    if (buffer.length() == 0)
+        return false;
+
+    MemoryBuffer serialized;
+    decompressToBuffer(serialized, buffer);
+    Owned<IStatisticCollection> collection = createStatisticCollection(serialized);
+    target.build(*collection);
+    return true;
+}
+
 class CConstGraphProgress : public CInterface, implements IConstWUGraphProgress
 {
 public:
@@ -262,6 +316,17 @@ public:
     {
         return formatVersion;
     }
+    virtual void getStatisticRollups(std::vector<StatisticRollup> & rollups) override
+    {
+        MemoryBuffer buffer;
+        Owned<IPropertyTreeIterator> iter = progress->getElements("sg*");
+        ForEach(*iter)
+        {
+            ColumnarStatistics stats;
+            if (loadSubGraphStatistics(stats, iter->query(), buffer))
+                mergeStatisticRollups(rollups, stats.queryRollups());
+        }
+    }
 
 protected:
     CConstGraphProgress(const char *_wuid, const char *_graphName) : wuid(_wuid), graphName(_graphName)
@@ -650,46 +715,24 @@ public:
 
     virtual bool next()
     {
-        if (!nextChildScope())
-        {
-            if (!nextSubGraph())
-            {
-                if (!nextGraph())
-                {
-                    valid = false;
-                    return false;
-                }
-            }
-        }
-        return true;
+        //Only walk the children of the current scope if they could match the filter
+        if (curCompare & SCparent)
+            return moveTo(curScope+1);
+        return moveTo(stats.skipChildren(curScope));
     }
 
     virtual bool nextSibling() override
     {
-        if (collections.ordinality() == 0)
+        if (!valid)
             return false;
-
-        assertex(childIterators.ordinality() < collections.ordinality());
-        collections.pop();
-        //next will call childIterator.next() - walking the next sibling
-        return next();
+        return moveTo(stats.skipChildren(curScope));
     }
 
     virtual bool nextParent() override
     {
-        if (collections.ordinality() == 0)
+        if (!valid)
             return false;
-
-        assertex(childIterators.ordinality() < collections.ordinality());
-        collections.pop();
-
-        if (collections.ordinality() == 0)
-            return false;
-
-        //Finish with this node - so next will move onto the sibling of the parent node.
-        finishCollection();
-
-        return next();
+        return moveTo(stats.skipToParentSibling(curScope));
     }
 
     virtual bool isValid()
@@ -755,98 +798,65 @@ protected:
         if (!checkSubGraph())
             return false;
 
-        curSubGraph.getPropBin("Stats", compressed.clear());
         //Don't crash on old format progress...
-        if (compressed.length() == 0)
-            return false;
-
-        decompressToBuffer(serialized.clear(), compressed);
-
-        Owned<IStatisticCollection> collection = createStatisticCollection(serialized);
-        statsIterator.timeStamp = collection->queryWhenCreated();
-        if (!beginCollection(*collection))
+        if (!loadSubGraphStatistics(stats, curSubGraph, buffer))
             return false;
 
-        // When workflow is root element, it is just a container.  Ignore the workflow element here
-        // as WorkUnitStatisticsScopeIterator will produce workflow scope - don't want duplicates.
-        // (Note: workflow element never contains stats).
-        if (collections.tos().queryScopeType() == SSTworkflow)
-        {
-            if (!next())
-                return false;
-        }
-
-        //The root element of a collection is a graph - but it is only there to nest the subgraphs in.
-        //Do not iterate it as a separate element - unless it has some stats.
-        IStatisticCollection & curCollection = collections.tos();
-        if ((curCollection.queryScopeType() != SSTgraph) || (curCollection.getNumStatistics() != 0))
-            return true;
-        return next();
+        curStatistic.timeStamp = stats.queryWhenCreated();
+        curScope = 0;
+        return findMatch();
     }
 
-    bool beginCollection(IStatisticCollection & collection)
+    bool moveTo(unsigned nextScope)
     {
-        collections.append(OLINK(collection));
-        curScopeType = collection.queryScopeType();
-        collection.getFullScope(curScopeName.clear());
-
-        ScopeCompare result = filter.compare(curScopeName);
-        if (result & SCequal)
+        curScope = nextScope;
+        if (findMatch())
             return true;
-
-        //If this scope cannot be the parent of a match then discard it.
-        if (!(result & SCparent))
-            collections.pop();
-
-        //walk the next element
-        return nextChildScope();
+        if (nextSubGraph() || nextGraph())
+            return true;
+        valid = false;
+        return false;
     }
 
-    bool nextChildScope()
+    //Find the next scope (starting from curScope) in the current subgraph that matches the filter
+    bool findMatch()
     {
-        for (;;)
+        unsigned numScopes = stats.numScopes();
+        while (curScope < numScopes)
         {
-            if (collections.ordinality() == 0)
-                return false;
-
-            IStatisticCollection * curCollection = &collections.tos();
-            if (childIterators.ordinality() < collections.ordinality())
+            const char * scope = stats.queryScope(curScope);
+            curCompare = filter.compare(scope);
+            if ((curCompare & SCequal) && !isContainerScope(curScope))
             {
-                ScopeCompare result = filter.compare(curScopeName);
-
-                //Do not walk children scopes if it is unrelated
-                if (result & SCparent)
-                {
-                    //Start iterating the children for the current collection
-                    childIterators.append(curCollection->getScopes(NULL, true));
-                    if (!childIterators.tos().first())
-                    {
-                        finishCollection();
-                        continue;
-                    }
-                }
-                else
-                {
-                    //Don't walk the child scopes
-                    collections.pop();
-                    continue;
-                }
-            }
-            else if (!childIterators.tos().next())
-            {
-                finishCollection();
-                continue;
+                curScopeName.set(scope);
+                curScopeType = stats.queryScopeType(curScope);
+                return true;
             }
 
-            if (beginCollection(childIterators.tos().query()))
-                return true;
+            //If this scope cannot be the parent of a match then skip all its children
+            if (curCompare & SCparent)
+                curScope++;
+            else
+                curScope = stats.skipChildren(curScope);
         }
+        return false;
     }
 
-    void finishCollection()
+    bool isContainerScope(unsigned scope) const
     {
-        collections.pop();
-        childIterators.pop();
+        // When workflow is root element, it is just a container.  Ignore the workflow element here
+        // as WorkUnitStatisticsScopeIterator will produce workflow scope - don't want duplicates.
+        // (Note: workflow element never contains stats).
+        // The graph is only there to nest the subgraphs in - do not return it unless it has some stats.
+        unsigned depth = stats.queryDepth(scope);
+        switch (stats.queryScopeType(scope))
+        {
+        case SSTworkflow:
+            return depth == 0;
+        case SSTgraph:
+            return (depth <= 1) && (stats.queryNumStats(scope) == 0);
+        }
+        return false;
     }
 
     bool checkSubGraph()
@@ -862,8 +872,8 @@ protected:
 //        if (!filter->matches(creatorType, creator, SSTall, NULL, SMeasureAll, StKindAll, AnyStatisticValue))
 //            return false;
 
-        statsIterator.creatorType = creatorType;
-        statsIterator.creator.set(creator);
+        curStatistic.creatorType = creatorType;
+        curStatistic.creator.set(creator);
         return true;
     }
 
@@ -871,27 +881,17 @@ protected:
     {
         if ((whichProperties & PTstatistics))
         {
-            /*
-            MORE: Code from the statsIterator class should be inlined here - code will be much simpler
-            but it currently needs an implementation of the IConstWUStatistic 3rd parameter
-            IStatisticCollection & collection = collections.tos();
-            ForEachItemIn(i, collection)
-            {
-                StatisticKind kind;
-                unsigned __int64 value;
-                collection->getStatistic(kind, value, i);
-                visitor.noteStatistic(kind, value, *this);
-            }
-            */
-            statsIterator.reset(curScopeName, curScopeType, collections.tos());
-            ForEach(statsIterator)
-                statsIterator.play(visitor);
+            curStatistic.reset(curScopeName, curScopeType);
+            unsigned first = stats.queryFirstStat(curScope);
+            unsigned last = first + stats.queryNumStats(curScope);
+            for (unsigned i = first; i < last; i++)
+                curStatistic.play(visitor, stats.queryKind(i), stats.queryValue(i));
         }
     }
 
     virtual bool getStat(StatisticKind kind, unsigned __int64 & value) const override
     {
-        return collections.tos().getStatistic(kind, value);
+        return stats.getStatistic(curScope, kind, value);
     }
 
     virtual const char * queryAttribute(WuAttr attr, StringBuffer & scratchpad) const override
@@ -914,52 +914,14 @@ protected:
     }
 
 private:
-    class ScopeStatisticsIterator : public CInterfaceOf<IConstWUStatistic>
+    class ScopeStatistic : public CInterfaceOf<IConstWUStatistic>
     {
         friend class CConstGraphProgressScopeIterator; // cleaner if this was removed + setScope() functions added.
     public:
-        void reset(const char * _scopeName, StatisticScopeType _scopeType, IStatisticCollection & _collection)
+        void reset(const char * _scopeName, StatisticScopeType _scopeType)
         {
             scope.set(_scopeName);
             scopeType = _scopeType;
-            collection = &_collection;
-            numStats = collection->getNumStatistics();
-        }
-
-// interface IConstWUStatisticIterator
-        IConstWUStatistic & query()
-        {
-            return *this;
-        }
-        bool first()
-        {
-            curStatIndex = 0;
-            if (curStatIndex >= numStats)
-                return false;
-
-            collection->getStatistic(kind, value, curStatIndex);
-            //MORE: Allow filtering:
-/*
- *             if (filter && !filter->matches(SCTall, NULL, SSTall, NULL, queryMeasure(kind), kind, value))
-                    continue;
- */
-            return true;
-        }
-        bool next()
-        {
-            for (;;)
-            {
-                ++curStatIndex;
-                if (curStatIndex >= numStats)
-                    return false;
-                collection->getStatistic(kind, value, curStatIndex);
-                //MORE: Allow stats filtering
-                return true;
-            }
-        }
-        bool isValid()
-        {
-            return curStatIndex < numStats;
         }
 
 //interface IConstWUStatistic
@@ -1022,23 +984,22 @@ private:
             return timeStamp;
         }
 
-        void play(IWuScopeVisitor & visitor)
+        void play(IWuScopeVisitor & visitor, StatisticKind _kind, unsigned __int64 _value)
         {
+            kind = _kind;
+            value = _value;
             visitor.noteStatistic(kind, value, *this);
         }
 
     protected:
-        IStatisticCollection * collection = nullptr;
         StringBuffer creator;
         StringBuffer scope;
-        StatisticKind kind;
+        StatisticKind kind = StKindNone;
         StatisticCreatorType creatorType;
         StatisticScopeType scopeType;
         unsigned __int64 value = 0;
         unsigned __int64 timeStamp;
-        unsigned curStatIndex = 0;
-        unsigned numStats = 0;
-    } statsIterator;
+    } curStatistic;
 
     Owned<IRemoteConnection> conn;
     StringBuffer curScopeName;
@@ -1049,10 +1010,10 @@ private:
     StringAttr singleSubGraph;
     Owned<IPropertyTreeIterator> graphIter;
     Owned<IPropertyTreeIterator> subgraphIter;
-    IArrayOf<IStatisticCollection> collections;
-    IArrayOf<IStatisticCollectionIterator> childIterators; // Iterator(n) through collections(n) - created once iterating children
-    MemoryBuffer compressed;
-    MemoryBuffer serialized;
+    ColumnarStatistics stats;           // statistics for the current subgraph
+    unsigned curScope = 0;              // index of the current scope within stats
+    ScopeCompare curCompare = SCunknown;
+    MemoryBuffer buffer;
     bool valid;
 };
 
@@ -4075,7 +4036,10 @@ public:
     virtual void setGraphState(const char *graphName, unsigned wfid, WUGraphState state) const
     {
         Owned<IRemoteConnection> conn = getWritableProgressConnection(graphName, wfid);
-        conn->queryRoot()->setPropInt("@_state", state);
+        IPropertyTree * graphProgress = conn->queryRoot();
+        graphProgress->setPropInt("@_state", state);
+        if ((state == WUGraphComplete) || (state == WUGraphFailed))
+            saveSubGraphColumns(*graphProgress);
     }
     virtual void setNodeState(const char *graphName, WUGraphIDType nodeId, WUGraphState state) const
     {
@@ -5962,20 +5926,482 @@ static void asyncRemoveFile(const char * ip, const char * name)
     deleteDllWorkQ->post(new asyncRemoveRemoteFileWorkItem(ip, name));
 }
 
+/*
+ * An in-memory index of the summary information (the attributes, action, priority and application values) for all
+ * the workunits in dali.  It is loaded the first time it is used, and then kept up to date by subscribing to changes
+ * to /WorkUnits - only the workunits that have changed are re-read.  Sorted views are cached for each sort order until
+ * the next change, so a request for a page of workunits can be answered without fetching any workunits from dali.
+ *
+ * Filters on information that is not included in the summary (e.g. files read, ecl) are not supported, and the
+ * caller falls back to querying dali directly.
+ */
+class CWorkUnitSummaryIndex : public CInterfaceOf<ISDSSubscription>
+{
+    typedef std::vector<Linked<IPropertyTree>> SummaryList;
+
+    //The entries are shared with any requests that are still using them, so the view is replaced rather than updated
+    struct SortedView
+    {
+        unsigned sortOrder = 0;
+        unsigned generation = 0;
+        std::shared_ptr<const SummaryList> entries;
+    };
+
+    class FieldFilter : public CInterface
+    {
+    public:
+        FieldFilter(const char * _xpath, unsigned _flags, const char * _values) : xpath(_xpath), flags(_flags)
+        {
+            values.appendListUniq(_values, "|");
+        }
+
+        const char * xpath;
+        unsigned flags;
+        StringArray values;
+    };
+
+public:
+    CWorkUnitSummaryIndex(ISDSManager * _sdsManager, SessionId _session) : sdsManager(_sdsManager), session(_session)
+    {
+    }
+
+    void stop()
+    {
+        CriticalBlock block(refreshCrit);
+        if (subscriptionId)
+        {
+            sdsManager->unsubscribe(subscriptionId);
+            subscriptionId = 0;
+        }
+    }
+
+    virtual void notify(SubscriptionId id, const char * xpath, SDSNotifyFlags flags, unsigned valueLen, const void * valueData) override
+    {
+        //xpath is of the form /WorkUnits/<wuid>/...
+        const char * wuid = xpath;
+        if (*wuid == '/')
+            wuid++;
+        if (strncmp(wuid, "WorkUnits/", 10) == 0)
+            wuid += 10;
+        else
+            wuid = "";
+        size_t len = strcspn(wuid, "/[");
+
+        CriticalBlock block(crit);
+        if (len)
+            dirty.emplace(wuid, len);
+        else
+            reloadAll = true;
+    }
+
+    //Returns false if the filter cannot be processed using the summaries
+    //userName identifies the user that postFilter checks the access of, so that the number of matches can be cached
+    bool getWorkUnitsSorted(WUSortField sortorder, WUSortField * filters, const void * filterbuf, unsigned startoffset, unsigned maxnum,
+                            unsigned * total, ISortedElementsTreeFilter * postFilter, const char * userName, IArrayOf<IPropertyTree> & results)
+    {
+        StringBuffer filterKey;
+        CIArrayOf<FieldFilter> fieldFilters;
+        StringArray unknownAttributes;
+        StringArray appNames, appValues;
+        const char * wuidLow = nullptr;
+        const char * wuidHigh = nullptr;
+        const char * wildWuid = nullptr;
+        const char * minThorTime = nullptr;
+        StringBuffer minThorTimeText;
+        int protectedFilter = -1;
+        if (filters)
+        {
+            const char * fv = (const char *)filterbuf;
+            for (unsigned i=0; filters[i] != WUSFterm; i++)
+            {
+                int fmt = filters[i];
+                int subfmt = (fmt & 0xff);
+                filterKey.append(fmt).append(':').append(fv);
+                switch (subfmt)
+                {
+                case WUSFwuid:
+                    wuidLow = fv;
+                    break;
+                case WUSFwuidhigh:
+                    wuidHigh = fv;
+                    break;
+                case WUSFwildwuid:
+                    wildWuid = fv;
+                    break;
+                case WUSFappvalue:
+                    appNames.append(fv);
+                    fv = fv + strlen(fv)+1;
+                    appValues.append(fv);
+                    filterKey.append('=').append(fv);
+                    break;
+                case WUSFtotalthortime:
+                    formatTimeCollatable(minThorTimeText, milliToNano(atoi(fv)), false);
+                    minThorTime = minThorTimeText.str();
+                    break;
+                case WUSFprotected:
+                    protectedFilter = (*fv == '1') ? 1 : 0;
+                    break;
+                case WUSFecl:
+                case WUSFfileread:
+                case WUSFfilewritten:
+                    return false;
+                default:
+                    if (!*fv)
+                        unknownAttributes.append(getEnumText(subfmt, workunitSortFields));
+                    else
+                        fieldFilters.append(*new FieldFilter(getEnumText(subfmt, workunitSortFields), fmt, fv));
+                    break;
+                }
+                filterKey.append('\n');
+                fv = fv + strlen(fv)+1;
+            }
+        }
+        if (postFilter)
+            filterKey.append("user:").append(userName);
+        if (wuidLow && !*wuidLow)
+            wuidLow = nullptr;
+        if (wuidHigh && !*wuidHigh)
+            wuidHigh = nullptr;
+
+        ensureCurrent();
+
+        //Take a reference to the sorted entries, so the filtering (and security checks) are done without blocking updates
+        std::shared_ptr<const SummaryList> entries;
+        unsigned viewGeneration;
+        unsigned knownTotal = 0;
+        bool totalKnown = false;
+        {
+            CriticalBlock block(crit);
+            const SortedView & view = querySortedView(sortorder);
+            entries = view.entries;
+            viewGeneration = view.generation;
+            if (total && (countGeneration == viewGeneration))
+            {
+                auto match = filteredCounts.find(filterKey.str());
+                if (match != filteredCounts.end())
+                {
+                    knownTotal = match->second;
+                    totalKnown = true;
+                }
+            }
+        }
+
+        //The total is only required to count all the matches, so it is possible to stop early if it is not needed
+        bool countAll = total && !totalKnown;
+        unsigned numFiltered = 0;
+        for (IPropertyTree * cur : *entries)
+        {
+            const char * wuid = cur->queryName();
+            if (wuidLow && (strcmp(wuidLow, wuid) > 0))
+                continue;
+            if (wuidHigh && (strcmp(wuidHigh, wuid) < 0))
+                continue;
+            if (wildWuid && !WildMatch(wuid, wildWuid, true))
+                continue;
+            if ((protectedFilter != -1) && (cur->getPropBool("@protected", false) != (protectedFilter == 1)))
+                continue;
+            if (minThorTime && (strcmp(queryValue(*cur, "@totalThorTime"), minThorTime) < 0))
+                continue;
+            if (!matchesFields(*cur, fieldFilters) || !matchesApplicationValues(*cur, appNames, appValues))
+                continue;
+            if (hasAnyAttribute(*cur, unknownAttributes))
+                continue;
+
+            //Workunits the user cannot access are not included in the total - the same as the dali query
+            if (postFilter && !postFilter->isOK(*cur))
+                continue;
+            if ((numFiltered >= startoffset) && (numFiltered - startoffset < maxnum))
+                results.append(*LINK(cur));
+            numFiltered++;
+
+            if (!countAll && (numFiltered >= startoffset) && (numFiltered - startoffset >= maxnum))
+                break;
+        }
+
+        if (total)
+        {
+            if (totalKnown)
+                *total = knownTotal;
+            else
+            {
+                *total = numFiltered;
+                //Cache the number of matches so that requests for the following pages can stop once they are filled
+                CriticalBlock block(crit);
+                if (viewGeneration == generation)
+                {
+                    if ((countGeneration != generation) || (filteredCounts.size() >= maxFilteredCounts))
+                    {
+                        filteredCounts.clear();
+                        countGeneration = generation;
+                    }
+                    filteredCounts[filterKey.str()] = numFiltered;
+                }
+            }
+        }
+        return true;
+    }
+
+protected:
+    void ensureCurrent()
+    {
+        CriticalBlock refreshBlock(refreshCrit);
+        if (!subscriptionId)
+        {
+            //Subscribe before loading so that no changes can be missed
+            subscriptionId = sdsManager->subscribe("/WorkUnits", *this, true, false);
+            loadAll();
+            return;
+        }
+
+        std::unordered_set<std::string> changed;
+        bool reload;
+        {
+            CriticalBlock block(crit);
+            changed.swap(dirty);
+            reload = reloadAll;
+            reloadAll = false;
+        }
+
+        //If a large proportion of the workunits have changed it is quicker to reload everything
+        if (reload || (changed.size() > maxIncrementalRefresh))
+            loadAll();
+        else
+        {
+            for (const std::string & wuid : changed)
+                refreshWorkUnit(wuid);
+        }
+    }
+
+    void loadAll()
+    {
+        std::map<std::string, Linked<IPropertyTree>> newSummaries;
+        Owned<IRemoteConnection> conn = sdsManager->connect("/WorkUnits", session, 0, SDS_LOCK_TIMEOUT);
+        if (conn)
+        {
+            Owned<IPropertyTreeIterator> iter = conn->queryRoot()->getElements("*");
+            ForEach(*iter)
+            {
+                IPropertyTree & cur = iter->query();
+                newSummaries[cur.queryName()].setown(createSummary(cur));
+            }
+        }
+
+        CriticalBlock block(crit);
+        summaries.swap(newSummaries);
+        generation++;
+    }
+
+    void refreshWorkUnit(const std::string & wuid)
+    {
+        VStringBuffer xpath("/WorkUnits/%s", wuid.c_str());
+        Owned<IRemoteConnection> conn = sdsManager->connect(xpath, session, 0, SDS_LOCK_TIMEOUT);
+        Owned<IPropertyTree> summary = conn ? createSummary(*conn->queryRoot()) : nullptr;
+
+        CriticalBlock block(crit);
+        if (summary)
+            summaries[wuid].setown(summary.getClear());
+        else
+            summaries.erase(wuid);
+        generation++;
+    }
+
+    static IPropertyTree * createSummary(IPropertyTree & wu)
+    {
+        Owned<IPropertyTree> summary = createPTree(wu.queryName());
+        Owned<IAttributeIterator> attrs = wu.getAttributes();
+        ForEach(*attrs)
+            summary->setProp(attrs->queryName(), attrs->queryValue());
+        const char * action = wu.queryProp("Action");
+        if (action)
+            summary->setProp("Action", action);
+        if (wu.hasProp("PriorityFlag"))
+            summary->setPropInt("PriorityFlag", wu.getPropInt("PriorityFlag"));
+        IPropertyTree * application = wu.queryPropTree("Application");
+        if (application)
+            summary->setPropTree("Application", createPTreeFromIPT(application));
+        return summary.getClear();
+    }
+
+    const SortedView & querySortedView(unsigned sortorder)
+    {
+        //Sorting by total thor time uses the collatable text, as for the dali queries
+        if ((sortorder & 0xff) == WUSFtotalthortime)
+            sortorder &= ~WUSFnumeric;
+
+        SortedView * oldest = nullptr;
+        for (SortedView & cur : views)
+        {
+            if (cur.sortOrder == sortorder)
+            {
+                if (cur.generation != generation)
+                    break;
+                return cur;
+            }
+        }
+
+        //Reuse the view for this sort order if there is one, otherwise replace the least recently created
+        SortedView * target = nullptr;
+        for (SortedView & cur : views)
+        {
+            if (cur.sortOrder == sortorder)
+                target = &cur;
+            else if (!oldest || (cur.generation < oldest->generation))
+                oldest = &cur;
+        }
+        if (!target)
+        {
+            if (views.size() < maxSortedViews)
+            {
+                views.emplace_back();
+                target = &views.back();
+            }
+            else
+                target = oldest;
+        }
+
+        std::shared_ptr<SummaryList> entries = std::make_shared<SummaryList>();
+        entries->reserve(summaries.size());
+        for (auto & cur : summaries)
+            entries->emplace_back(cur.second);
+
+        //The summaries are already ordered by wuid, so no sort is required for the default order
+        unsigned field = sortorder & 0xff;
+        if (field && (field != WUSFwuid))
+        {
+            const char * xpath = getEnumText(field, workunitSortFields);
+            auto compare = [xpath, sortorder](IPropertyTree * left, IPropertyTree * right)
+            {
+                const char * leftValue = queryValue(*left, xpath);
+                const char * rightValue = queryValue(*right, xpath);
+                int ret;
+                if (sortorder & WUSFnumeric)
+                {
+                    __int64 diff = _atoi64(leftValue) - _atoi64(rightValue);
+                    ret = (diff > 0) ? 1 : (diff < 0) ? -1 : 0;
+                }
+                else if (sortorder & WUSFnocase)
+                    ret = stricmp(leftValue, rightValue);
+                else
+                    ret = strcmp(leftValue, rightValue);
+                if (sortorder & WUSFreverse)
+                    ret = -ret;
+                if (ret == 0)
+                    ret = strcmp(left->queryName(), right->queryName());
+                return ret < 0;
+            };
+            std::sort(entries->begin(), entries->end(), compare);
+        }
+        else if (sortorder & WUSFreverse)
+            std::reverse(entries->begin(), entries->end());
+
+        target->sortOrder = sortorder;
+        target->generation = generation;
+        target->entries = std::move(entries);
+        return *target;
+    }
+
+    static const char * queryValue(IPropertyTree & summary, const char * xpath)
+    {
+        const char * value = summary.queryProp(xpath);
+        return value ? value : "";
+    }
+
+    static bool matchesValue(const char * value, const char * pattern, unsigned flags)
+    {
+        if (flags & WUSFwild)
+            return WildMatch(value, pattern, (flags & WUSFnocase) != 0);
+        if (flags & WUSFnocase)
+            return strieq(value, pattern);
+        return streq(value, pattern);
+    }
+
+    static bool matchesFields(IPropertyTree & summary, const CIArrayOf<FieldFilter> & fieldFilters)
+    {
+        ForEachItemIn(iFilter, fieldFilters)
+        {
+            const FieldFilter & filter = fieldFilters.item(iFilter);
+            const char * value = summary.queryProp(filter.xpath);
+            if (!value)
+                return false;
+            bool matched = false;
+            ForEachItemIn(i, filter.values)
+            {
+                const char * pattern = filter.values.item(i);
+                if (!isEmptyString(pattern) && matchesValue(value, pattern, filter.flags))
+                {
+                    matched = true;
+                    break;
+                }
+            }
+            if (!matched)
+                return false;
+        }
+        return true;
+    }
+
+    static bool matchesApplicationValues(IPropertyTree & summary, const StringArray & appNames, const StringArray & appValues)
+    {
+        ForEachItemIn(i, appNames)
+        {
+            VStringBuffer xpath("Application/%s", appNames.item(i));
+            const char * value = summary.queryProp(xpath);
+            if (!value)
+                return false;
+            const char * pattern = appValues.item(i);
+            if (*pattern && !WildMatch(value, pattern, true))
+                return false;
+        }
+        return true;
+    }
+
+    static bool hasAnyAttribute(IPropertyTree & summary, const StringArray & attributes)
+    {
+        ForEachItemIn(i, attributes)
+        {
+            const char * value = summary.queryProp(attributes.item(i));
+            if (!isEmptyString(value))
+                return true;
+        }
+        return false;
+    }
+
+protected:
+    static constexpr unsigned maxSortedViews = 4;
+    static constexpr size_t maxIncrementalRefresh = 1000;
+    static constexpr size_t maxFilteredCounts = 1000;
+
+    ISDSManager * sdsManager;
+    SessionId session;
+    CriticalSection refreshCrit;        // serializes the reading of workunits from dali
+    CriticalSection crit;               // protects the following members
+    std::map<std::string, Linked<IPropertyTree>> summaries;     // ordered by wuid
+    std::unordered_set<std::string> dirty;
+    std::vector<SortedView> views;
+    std::unordered_map<std::string, unsigned> filteredCounts;  // number of matches for each filter and user, for countGeneration
+    SubscriptionId subscriptionId = 0;
+    unsigned generation = 0;
+    unsigned countGeneration = 0;
+    bool reloadAll = false;
+};
+
 class CDaliWorkUnitFactory : public CWorkUnitFactory, implements IDaliClientShutdown
 {
 public:
     IMPLEMENT_IINTERFACE_USING(CWorkUnitFactory);
-    CDaliWorkUnitFactory()
+    CDaliWorkUnitFactory(bool useSummaryIndex)
     {
         // Assumes dali client configuration has already been done
         sdsManager = &querySDS();
         session = myProcessSession();
         addShutdownHook(*this);
+        if (useSummaryIndex)
+            summaryIndex.setown(new CWorkUnitSummaryIndex(sdsManager, session));
     }
     ~CDaliWorkUnitFactory()
     {
         removeShutdownHook(*this);
+        if (summaryIndex)
+            summaryIndex->stop();
     }
     virtual bool initializeStore()
     {
@@ -6293,6 +6719,10 @@ public:
         };
         Owned<CQueryOrFilter> orFilter;
         Owned<ISortedElementsTreeFilter> sc = new CScopeChecker(secmgr,secuser);
+        IArrayOf<IPropertyTree> results;
+        if (summaryIndex && summaryIndex->getWorkUnitsSorted(sortorder, filters, filterbuf, startoffset, maxnum, total, secmgr ? sc.get() : nullptr, secuser ? secuser->getName() : "", results))
+            return new CConstWUArrayIterator(results);
+
         StringBuffer query;
         StringBuffer so;
         StringAttr namefilter("*");
@@ -6375,7 +6805,6 @@ public:
                 so.append('#');
             so.append(getEnumText(sortorder&0xff,workunitSortFields));
         }
-        IArrayOf<IPropertyTree> results;
         Owned<IElementsPager> elementsPager = new CWorkUnitsPager(query.str(), orFilter.getClear(), so.length()?so.str():NULL, namefilterlo.get(), namefilterhi.get(), unknownAttributes);
         Owned<IRemoteConnection> conn=getElementsPaged(elementsPager,startoffset,maxnum,secmgr?sc:NULL,"",cachehint,results,total,NULL);
         return new CConstWUArrayIterator(results);
@@ -6529,6 +6958,7 @@ protected:
 
     ISDSManager *sdsManager;
     SessionId session;
+    Owned<CWorkUnitSummaryIndex> summaryIndex;     // Optional cache used to answer getWorkUnitsSorted()
 };
 
 extern WORKUNIT_API IConstWorkUnitIterator *createSecureConstWUIterator(IConstWorkUnitIterator *iter, ISecManager *secmgr, ISecUser *secuser)
@@ -6553,6 +6983,8 @@ static Owned<IWorkUnitFactory> globalFactory;
 
 void CDaliWorkUnitFactory::clientShutdown()
 {
+    if (summaryIndex)
+        summaryIndex->stop();
     CriticalBlock b(factoryCrit);
     globalFactory.clear();
 }
@@ -6600,7 +7032,7 @@ extern WORKUNIT_API IWorkUnitFactory * getWorkUnitFactory()
             if (pluginInfo && !forceDali)
                 globalFactory.setown( (IWorkUnitFactory *) loadPlugin(pluginInfo));
             else
-                globalFactory.setown(new CDaliWorkUnitFactory());
+                globalFactory.setown(new CDaliWorkUnitFactory(getComponentConfigSP()->getPropBool("@workunitSummaryIndex", false)));
         }
     }
     return globalFactory.getLink();
@@ -6612,7 +7044,7 @@ extern WORKUNIT_API IWorkUnitFactory * getDaliWorkUnitFactory()
     {
         CriticalBlock b(factoryCrit);
         if (!globalFactory)   // NOTE - this "double test" paradigm is not guaranteed threadsafe on modern systems/compilers - I think in this instance that is harmless even in the (extremely) unlikely event that it resulted in the setown being called twice.
-            globalFactory.setown(new CDaliWorkUnitFactory());
+            globalFactory.setown(new CDaliWorkUnitFactory(getComponentConfigSP()->getPropBool("@workunitSummaryIndex", false)));
     }
     return globalFactory.getLink();
 }
@@ -6937,6 +7369,11 @@ public:
     }
 };
 
+IWorkUnitFactory * createDaliWorkUnitFactory(bool useSummaryIndex)
+{
+    return new CDaliWorkUnitFactory(useSummaryIndex);
+}
+
 IWorkUnitFactory * createUnexpectedWorkUnitFactory()
 {
     return new CUnexpectedWorkUnitFactory;
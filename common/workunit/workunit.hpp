@@ -769,10 +769,22 @@ typedef unsigned __int64 WUNodeIDType;
 interface IWUGraphProgress;
 interface IWUGraphStats;
 interface IPropertyTree;
+// Summary of all the values of a statistic kind for a particular type of scope
+struct StatisticRollup
+{
+    StatisticScopeType scopeType;
+    StatisticKind kind;
+    unsigned count;
+    stat_type sum;
+    stat_type minValue;
+    stat_type maxValue;
+};
+
 interface IConstWUGraphProgress : extends IInterface
 {
     virtual IPropertyTree * getProgressTree(bool doFormat) = 0;
     virtual unsigned queryFormatVersion() = 0;
+    virtual void getStatisticRollups(std::vector<StatisticRollup> & rollups) = 0; // Combined over all the subgraphs in the graph
 };
 
 
@@ -1618,6 +1630,7 @@ extern WORKUNIT_API ILocalWorkUnit * createLocalWorkUnit(ILoadedDllEntry * dll);
 extern WORKUNIT_API ILocalWorkUnit * createLocalWorkUnitFromFile(const char * filename);
 extern WORKUNIT_API IConstWorkUnitInfo *createConstWorkUnitInfo(IPropertyTree &p);
 extern WORKUNIT_API IWorkUnitFactory * createUnexpectedWorkUnitFactory();
+extern WORKUNIT_API IWorkUnitFactory * createDaliWorkUnitFactory(bool useSummaryIndex); // Allows the summary index to be compared with querying dali
 extern WORKUNIT_API StringBuffer &exportWorkUnitToXML(const IConstWorkUnit *wu, StringBuffer &str, bool unpack, bool includeProgress, bool hidePasswords);
 extern WORKUNIT_API void exportWorkUnitToBinary(const IConstWorkUnit *wu, MemoryBuffer & serialized);
 extern WORKUNIT_API void exportWorkUnitToXMLFile(const IConstWorkUnit *wu, const char * filename, unsigned extraXmlFlags, bool unpack, bool includeProgress, bool hidePasswords, bool splitStats);
@@ -0,0 +1,273 @@
+/*##############################################################################
+
+    HPCC SYSTEMS software Copyright (C) 2024 HPCC Systems®.
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+############################################################################## */
+
+#include "jlib.hpp"
+#include "jlzw.hpp"
+#include "wustats.hpp"
+
+static constexpr byte columnarStatsVersion = 1;
+
+void ColumnarStatistics::build(IStatisticCollection & collection)
+{
+    scopeNames.clear();
+    scopeOffsets.clear();
+    scopeTypes.clear();
+    depths.clear();
+    statOffsets.clear();
+    kinds.clear();
+    values.clear();
+    rollups.clear();
+
+    whenCreated = collection.queryWhenCreated();
+    StringBuffer scopeName;
+    addScope(collection, 0, scopeName);
+    statOffsets.push_back((unsigned)kinds.size());
+}
+
+void ColumnarStatistics::addScope(IStatisticCollection & collection, unsigned depth, StringBuffer & scopeName)
+{
+    size32_t prevLength = scopeName.length();
+    if (prevLength)
+        scopeName.append(':');
+    collection.getScope(scopeName);
+
+    StatisticScopeType scopeType = collection.queryScopeType();
+    scopeOffsets.push_back(scopeNames.length());
+    scopeNames.append(scopeName).append('\0');
+    scopeTypes.push_back((byte)scopeType);
+    depths.push_back((unsigned short)depth);
+    statOffsets.push_back((unsigned)kinds.size());
+
+    unsigned numStats = collection.getNumStatistics();
+    for (unsigned i=0; i < numStats; i++)
+    {
+        StatisticKind kind;
+        stat_type value;
+        collection.getStatistic(kind, value, i);
+        kinds.push_back(kind);
+        values.push_back(value);
+        noteRollup(scopeType, kind, value);
+    }
+
+    //Walk the children in the same order as the collection based scope iterators
+    Owned<IStatisticCollectionIterator> childIter = &collection.getScopes(nullptr, true);
+    ForEach(*childIter)
+        addScope(childIter->query(), depth+1, scopeName);
+
+    scopeName.setLength(prevLength);
+}
+
+void ColumnarStatistics::noteRollup(StatisticScopeType scopeType, StatisticKind kind, stat_type value)
+{
+    //The number of distinct scope type/kind pairs is small, so a linear search is sufficient
+    for (auto & cur : rollups)
+    {
+        if ((cur.kind == kind) && (cur.scopeType == scopeType))
+        {
+            cur.count++;
+            cur.sum += value;
+            if (value < cur.minValue)
+                cur.minValue = value;
+            if (value > cur.maxValue)
+                cur.maxValue = value;
+            return;
+        }
+    }
+    rollups.push_back({ scopeType, kind, 1, value, value, value });
+}
+
+bool ColumnarStatistics::getStatistic(unsigned scope, StatisticKind kind, stat_type & value) const
+{
+    unsigned last = statOffsets[scope+1];
+    for (unsigned i = statOffsets[scope]; i < last; i++)
+    {
+        if (kinds[i] == kind)
+        {
+            value = values[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+unsigned ColumnarStatistics::skipChildren(unsigned scope) const
+{
+    unsigned depth = depths[scope];
+    unsigned max = numScopes();
+    unsigned next = scope+1;
+    while ((next < max) && (depths[next] > depth))
+        next++;
+    return next;
+}
+
+unsigned ColumnarStatistics::skipToParentSibling(unsigned scope) const
+{
+    unsigned depth = depths[scope];
+    unsigned max = numScopes();
+    unsigned next = scope+1;
+    while ((next < max) && (depths[next] >= depth))
+        next++;
+    return next;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ColumnarStatistics::serialize(MemoryBuffer & out) const
+{
+    unsigned numScopes = this->numScopes();
+    out.append(columnarStatsVersion);
+    out.append(whenCreated);
+    out.appendPacked(numScopes);
+
+    //Successive scope names share long prefixes - only serialize the part that differs
+    const char * prevScope = "";
+    for (unsigned i=0; i < numScopes; i++)
+    {
+        const char * scope = queryScope(i);
+        unsigned common = 0;
+        while (prevScope[common] && (prevScope[common] == scope[common]))
+            common++;
+        out.appendPacked(common).append(scope + common);
+        prevScope = scope;
+    }
+
+    for (unsigned i=0; i < numScopes; i++)
+        out.append(scopeTypes[i]);
+    for (unsigned i=0; i < numScopes; i++)
+        out.appendPacked(depths[i]);
+    for (unsigned i=0; i < numScopes; i++)
+        out.appendPacked(queryNumStats(i));
+    for (unsigned kind : kinds)
+        out.appendPacked(kind);
+    for (stat_type value : values)
+        out.appendPacked(value);
+
+    out.appendPacked((unsigned)rollups.size());
+    for (auto & cur : rollups)
+    {
+        out.append((byte)cur.scopeType);
+        out.appendPacked((unsigned)cur.kind);
+        out.appendPacked(cur.count).appendPacked(cur.sum).appendPacked(cur.minValue).appendPacked(cur.maxValue);
+    }
+}
+
+void ColumnarStatistics::deserialize(MemoryBuffer & in)
+{
+    byte version;
+    in.read(version);
+    if (version != columnarStatsVersion)
+        throw makeStringExceptionV(0, "Unsupported columnar statistics version %u", (unsigned)version);
+
+    in.read(whenCreated);
+    unsigned numScopes;
+    in.readPacked(numScopes);
+
+    scopeNames.clear();
+    scopeOffsets.resize(numScopes);
+    size32_t prevOffset = 0;
+    for (unsigned i=0; i < numScopes; i++)
+    {
+        unsigned common;
+        in.readPacked(common);
+        const char * suffix;
+        in.read(suffix);
+        size32_t offset = scopeNames.length();
+        //The previous scope is copied via an index since append may reallocate the buffer
+        for (unsigned j=0; j < common; j++)
+            scopeNames.append(scopeNames.charAt(prevOffset + j));
+        scopeNames.append(suffix).append('\0');
+        scopeOffsets[i] = offset;
+        prevOffset = offset;
+    }
+
+    scopeTypes.resize(numScopes);
+    for (unsigned i=0; i < numScopes; i++)
+        in.read(scopeTypes[i]);
+
+    depths.resize(numScopes);
+    for (unsigned i=0; i < numScopes; i++)
+    {
+        unsigned depth;
+        in.readPacked(depth);
+        depths[i] = (unsigned short)depth;
+    }
+
+    statOffsets.resize(numScopes+1);
+    unsigned numStats = 0;
+    for (unsigned i=0; i < numScopes; i++)
+    {
+        statOffsets[i] = numStats;
+        unsigned count;
+        in.readPacked(count);
+        numStats += count;
+    }
+    statOffsets[numScopes] = numStats;
+
+    kinds.resize(numStats);
+    for (unsigned i=0; i < numStats; i++)
+        in.readPacked(kinds[i]);
+    values.resize(numStats);
+    for (unsigned i=0; i < numStats; i++)
+        in.readPacked(values[i]);
+
+    unsigned numRollups;
+    in.readPacked(numRollups);
+    rollups.resize(numRollups);
+    for (auto & cur : rollups)
+    {
+        byte scopeType;
+        unsigned kind;
+        in.read(scopeType);
+        in.readPacked(kind);
+        cur.scopeType = (StatisticScopeType)scopeType;
+        cur.kind = (StatisticKind)kind;
+        in.readPacked(cur.count).readPacked(cur.sum).readPacked(cur.minValue).readPacked(cur.maxValue);
+    }
+}
+
+void ColumnarStatistics::deserializeCompressed(MemoryBuffer & compressed)
+{
+    MemoryBuffer serialized;
+    decompressToBuffer(serialized, compressed);
+    deserialize(serialized);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void mergeStatisticRollups(std::vector<StatisticRollup> & target, const std::vector<StatisticRollup> & source)
+{
+    for (auto & cur : source)
+    {
+        bool found = false;
+        for (auto & existing : target)
+        {
+            if ((existing.kind == cur.kind) && (existing.scopeType == cur.scopeType))
+            {
+                existing.count += cur.count;
+                existing.sum += cur.sum;
+                if (cur.minValue < existing.minValue)
+                    existing.minValue = cur.minValue;
+                if (cur.maxValue > existing.maxValue)
+                    existing.maxValue = cur.maxValue;
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+            target.push_back(cur);
+    }
+}
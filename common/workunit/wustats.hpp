@@ -0,0 +1,76 @@
+/*##############################################################################
+
+    HPCC SYSTEMS software Copyright (C) 2024 HPCC Systems®.
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+############################################################################## */
+
+#ifndef WUSTATS_HPP
+#define WUSTATS_HPP
+
+#include "workunit.hpp"
+#include <vector>
+
+/*
+ * A column orientated representation of the statistics gathered for a subgraph.  It is written alongside the
+ * serialized IStatisticCollection once the graph has finished (it is built on the fly before then), and allows the
+ * scope iterators to walk the scopes and statistics without recreating the collection hierarchy.
+ *
+ * The scopes are held in the order they would be returned by a depth first walk of the (sorted) collection, which
+ * matches the order of compareScopeName().  Each scope records its depth so the children of a scope can be skipped
+ * without examining them.  The statistics for scope i are the entries [statOffsets[i], statOffsets[i+1]) of the
+ * kind and value columns.  A set of rollups (count/sum/min/max for each scope type and statistic kind) is calculated
+ * when the statistics are gathered so that summaries do not require all the scopes to be walked.
+ */
+class WORKUNIT_API ColumnarStatistics
+{
+public:
+    void build(IStatisticCollection & collection);
+    void serialize(MemoryBuffer & out) const;
+    void deserialize(MemoryBuffer & in);
+    void deserializeCompressed(MemoryBuffer & compressed);
+
+    unsigned numScopes() const { return (unsigned)scopeTypes.size(); }
+    const char * queryScope(unsigned scope) const { return scopeNames.str() + scopeOffsets[scope]; }
+    StatisticScopeType queryScopeType(unsigned scope) const { return (StatisticScopeType)scopeTypes[scope]; }
+    unsigned queryDepth(unsigned scope) const { return depths[scope]; }
+    unsigned queryFirstStat(unsigned scope) const { return statOffsets[scope]; }
+    unsigned queryNumStats(unsigned scope) const { return statOffsets[scope+1] - statOffsets[scope]; }
+    StatisticKind queryKind(unsigned stat) const { return (StatisticKind)kinds[stat]; }
+    stat_type queryValue(unsigned stat) const { return values[stat]; }
+    bool getStatistic(unsigned scope, StatisticKind kind, stat_type & value) const;
+    unsigned skipChildren(unsigned scope) const;       // index of the first following scope that is not nested within scope
+    unsigned skipToParentSibling(unsigned scope) const;// index of the first following scope that is not nested within the parent of scope
+
+    const std::vector<StatisticRollup> & queryRollups() const { return rollups; }
+    unsigned __int64 queryWhenCreated() const { return whenCreated; }
+
+protected:
+    void addScope(IStatisticCollection & collection, unsigned depth, StringBuffer & scopeName);
+    void noteRollup(StatisticScopeType scopeType, StatisticKind kind, stat_type value);
+
+protected:
+    StringBuffer scopeNames;                // all the full scope names, each null terminated
+    std::vector<unsigned> scopeOffsets;
+    std::vector<byte> scopeTypes;
+    std::vector<unsigned short> depths;
+    std::vector<unsigned> statOffsets;      // numScopes()+1 entries
+    std::vector<unsigned> kinds;
+    std::vector<stat_type> values;
+    std::vector<StatisticRollup> rollups;
+    unsigned __int64 whenCreated = 0;
+};
+
+extern WORKUNIT_API void mergeStatisticRollups(std::vector<StatisticRollup> & target, const std::vector<StatisticRollup> & source);
+
+#endif
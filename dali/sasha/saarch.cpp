@@ -1,4 +1,6 @@
 #include <atomic>
+#include <string>
+#include <unordered_set>
 
 #include "platform.h"
 #include "jlib.hpp"
@@ -24,6 +26,7 @@
 #define DEFAULT_WORKUNIT_LIMIT          1000
 #define DEFAULT_WORKUNIT_CUTOFF         60      // days
 #define DEFAULT_DFUWORKUNIT_LIMIT       1000
+#define DEFAULT_DFUWORKUNIT_DELETE_BATCH 100
 #define DEFAULT_DFUWORKUNIT_CUTOFF      60      // days
 #define DEFAULT_DFURECOVERY_LIMIT       5
 #define DEFAULT_DFURECOVERY_CUTOFF      4       // days
@@ -35,8 +38,70 @@
 //#define TESTING
 
 static CriticalSection archivingSect;
+static std::unordered_set<std::string> archivingWuids; // protected by archivingSect
+static unsigned archivingWaiters = 0;               // protected by archivingSect
+static Semaphore archivingReleased;
 static const bool keepOldVersions=true;
 
+// Prevents the same workunit being archived or restored by more than one thread at a time
+class CArchivingBlock
+{
+    std::string wuid;
+public:
+    CArchivingBlock(const char *_wuid) : wuid(_wuid ? _wuid : "")
+    {
+        for (;;) {
+            {
+                CriticalBlock block(archivingSect);
+                if (archivingWuids.insert(wuid).second)
+                    return;
+                archivingWaiters++;
+            }
+            archivingReleased.wait();
+        }
+    }
+    ~CArchivingBlock()
+    {
+        CriticalBlock block(archivingSect);
+        archivingWuids.erase(wuid);
+        // Wake every waiting thread - each one checks whether the workunit it is waiting for is now free
+        if (archivingWaiters) {
+            archivingReleased.signal(archivingWaiters);
+            archivingWaiters = 0;
+        }
+    }
+};
+
+static CPendingWorkUnitDeletes pendingDfuDeletes;
+
+// Spreads the start of the items processed by a run evenly so that no more than maxPerSecond are started each second
+class CArchiveRateLimiter
+{
+    std::atomic<unsigned> next{0};
+    unsigned maxPerSecond;
+    unsigned startTick;
+public:
+    CArchiveRateLimiter(unsigned _maxPerSecond) : maxPerSecond(_maxPerSecond), startTick(msTick())
+    {
+    }
+    bool wait(std::atomic<bool> &stopped)
+    {
+        if (!maxPerSecond)
+            return !stopped;
+        unsigned slot = next++;
+        unsigned due = (unsigned)(((unsigned __int64)slot*1000)/maxPerSecond);
+        for (;;) {
+            if (stopped)
+                return false;
+            unsigned elapsed = msTick()-startTick;
+            if (elapsed>=due)
+                return true;
+            unsigned delay = due-elapsed;
+            Sleep((delay>1000)?1000:delay);
+        }
+    }
+};
+
 
 static const char *splitWUID(const char *wuid,StringBuffer &head)
 {
@@ -626,6 +691,8 @@ protected:
     IRemoteConnection* conn;
     unsigned cutoffdays;
     unsigned backupdays;    // if 0 not used
+    unsigned workers;       // number of items archived in parallel
+    unsigned maxPerSecond;  // if 0 not limited
     CDateTime cutoff;   // set when run
     CDateTime backupcutoff; // set when run
 #ifdef _DEBUG
@@ -656,6 +723,10 @@ public:
         limit = props->getPropInt("@limit",deflimit);
         cutoffdays = props->getPropInt("@cutoff",defcutoff);
         backupdays = props->getPropInt("@backup",0);
+        workers = props->getPropInt("@workers",1);
+        if (workers==0)
+            workers = 1;
+        maxPerSecond = props->getPropInt("@maxPerSecond",0);
     }
 
     virtual ~CBranchArchiver()
@@ -663,6 +734,30 @@ public:
     }
 
     virtual IBranchItem *createBranchItem(IPropertyTree &e) = 0;
+    virtual void flush() {} // called once a set of items has been processed
+
+    // Archive (or backup) the items, newest first, using multiple workers if configured
+    unsigned processItems(IArrayOf<IBranchItem> &items, bool isArchive, unsigned start)
+    {
+        unsigned num = items.ordinality();
+        std::atomic<unsigned> done{0};
+        std::atomic<bool> finished{false};
+        CArchiveRateLimiter limiter(maxPerSecond);
+        asyncFor(num, workers, [&](unsigned i)
+        {
+            if (finished||!limiter.wait(stopped))
+                return;
+            unsigned start1 = msTick();
+            IBranchItem &item = items.item(num-1-i);
+            if (isArchive ? item.archive() : item.backup())
+                done++;
+            if (!schedule.checkDurationAndThrottle(start,start1,stopped))
+                finished = true;
+        });
+        flush();
+        items.kill();
+        return done;
+    }
 
     static int compareBranch(IInterface * const *v1, IInterface * const *v2) // for bAdd only
     {
@@ -756,25 +851,11 @@ public:
                         tobackup.append(*itemp.getClear());
                 }
             }
-            PROGLOG("ARCHIVE: %s - %d to archive, %d to backup",branchname.get(),toarchive.ordinality(),tobackup.ordinality());
+            PROGLOG("ARCHIVE: %s - %d to archive, %d to backup (workers=%u, maxPerSecond=%u)",branchname.get(),toarchive.ordinality(),tobackup.ordinality(),workers,maxPerSecond);
             unsigned start = msTick();
-            unsigned start1;
-            while (toarchive.ordinality()&&!stopped) {
-                start1 = msTick();
-                Owned<IBranchItem> item = &toarchive.popGet();
-                if (item&&item->archive())
-                    done++;
-                if (!schedule.checkDurationAndThrottle(start,start1,stopped))
-                    break;
-            }
-            while (tobackup.ordinality()&&!stopped) {
-                start1 = msTick();
-                Owned<IBranchItem> item = &tobackup.popGet();
-                if (item&&item->backup())
-                    bdone++;
-                if (!schedule.checkDurationAndThrottle(start,start1,stopped))
-                    break;
-            }
+            done = processItems(toarchive,true,start);
+            if (!stopped)
+                bdone = processItems(tobackup,false,start);
         }
         PROGLOG("ARCHIVE: %s complete (%d archived of %d, %d backed up)",branchname.get(),done,total,bdone);
     }
@@ -782,15 +863,15 @@ public:
 
 };
 
-static bool doArchiveDfuWorkUnit(const char *dfuwuid, StringBuffer &res)
+// If deferDelete is set the workunit is added to pendingDfuDeletes, and removed from dali when the batch is flushed
+// unless it is restored first.  Returns the number of workunits waiting to be removed in pending.
+static bool doArchiveDfuWorkUnit(const char *dfuwuid, StringBuffer &res, bool del=true, bool deferDelete=false, unsigned *pending=nullptr)
 {
-    CriticalBlock block(archivingSect);
     if (!dfuwuid||!*dfuwuid)
         return false;
+    CArchivingBlock block(dfuwuid);
 #ifdef TESTING
-    bool del = false; 
-#else
-    bool del = true;
+    del = false; 
 #endif
     StringBuffer ldspath("Archive/DFUWorkUnits");
     splitWUIDpath(dfuwuid,ldspath);
@@ -810,8 +891,17 @@ static bool doArchiveDfuWorkUnit(const char *dfuwuid, StringBuffer &res)
                 Owned<IFileIO> fileio = file->open(IFOcreate);
                 if (fileio && (fileio->write(0,buf.length(),buf.str())==buf.length())) {
                     fileio.clear();
-                    if (del)
-                        conn->close(true);
+                    if (del) {
+                        if (deferDelete) {
+                            // Release the lock first - the batch is removed through a write lock on DFU/WorkUnits
+                            conn.clear();
+                            unsigned numPending = pendingDfuDeletes.add(dfuwuid);
+                            if (pending)
+                                *pending = numPending;
+                        }
+                        else
+                            conn->close(true);
+                    }
                     res.append("OK");
                     return true; 
                 }
@@ -830,7 +920,7 @@ static bool doArchiveDfuWorkUnit(const char *dfuwuid, StringBuffer &res)
 
 static bool doArchiveWorkUnit(IWorkUnitFactory *wufactory,const char *wuid, StringBuffer &res,bool deleteOwned, bool del, CDateTime *time)
 {
-    CriticalBlock block(archivingSect);
+    CArchivingBlock block(wuid);
     if (del)
         res.append("ARCHIVE: ");
     else
@@ -903,7 +993,7 @@ static bool doRestoreWorkUnit(IWorkUnitFactory *wufactory,const char *wuid, Stri
 {
     if (wuid && *wuid)
     {
-        CriticalBlock block(archivingSect);
+        CArchivingBlock block(wuid);
         res.append("RESTORE: ").append(wuid).append(" ");
         StringBuffer ldspath("Archive/WorkUnits");
         splitWUIDpath(wuid,ldspath);
@@ -927,8 +1017,13 @@ static bool doRestoreWorkUnit(IWorkUnitFactory *wufactory,const char *wuid, Stri
 
 static bool doRestoreDfuWorkUnit(const char *wuid, StringBuffer &res)
 {
-    CriticalBlock block(archivingSect);
+    CArchivingBlock block(wuid);
     res.append("RESTORE: ").append(wuid).append(" ");
+    // If the workunit has been archived, but not yet deleted, it is still in dali - keep it there
+    if (pendingDfuDeletes.cancel(wuid)) {
+        res.append("OK");
+        return true;
+    }
     StringBuffer ldspath("Archive/DFUWorkUnits");
     splitWUIDpath(wuid,ldspath);
     StringBuffer path;
@@ -1214,16 +1309,21 @@ public:
     CDFUWorkUnitArchiver(IPropertyTree *archprops,unsigned definterval, std::atomic<bool> &_stopped)
         : CBranchArchiver(archprops,"DFUworkunits","DFU/WorkUnits/*",DEFAULT_DFUWORKUNIT_LIMIT,DEFAULT_DFUWORKUNIT_CUTOFF,definterval,_stopped)
     {
-        PROGLOG("ARCHIVE DFU Workunits: limit=%d, cutoff=%d days",limit,cutoffdays);
+        deleteBatchSize = props->getPropInt("@deleteBatchSize",DEFAULT_DFUWORKUNIT_DELETE_BATCH);
+        PROGLOG("ARCHIVE DFU Workunits: limit=%d, cutoff=%d days, workers=%u, deleteBatchSize=%u",limit,cutoffdays,workers,deleteBatchSize);
     }
 
 
     bool archive(const char *wuid)
     {
         StringBuffer s;
-        if (doArchiveDfuWorkUnit(wuid,s)) {
+        bool batchDelete = (deleteBatchSize>1);
+        unsigned numPending = 0;
+        if (doArchiveDfuWorkUnit(wuid,s,true,batchDelete,&numPending)) {
             if (s.length())
                 PROGLOG("%s",s.str());
+            if (numPending>=deleteBatchSize)
+                flushDeletes();
             return true;
         }
         if (s.length())
@@ -1231,6 +1331,46 @@ public:
         return false;
     }
 
+    virtual void flush() override
+    {
+        flushDeletes();
+    }
+
+protected:
+    // Remove the archived workunits that have not been restored from dali, through a single locked connection
+    void flushDeletes()
+    {
+        unsigned numDeleted = pendingDfuDeletes.flush([](const std::vector<std::string> &wuids)
+        {
+#ifndef TESTING
+            try {
+                Owned<IRemoteConnection> conn = querySDS().connect("DFU/WorkUnits", myProcessSession(), RTM_LOCK_WRITE, 5*60*1000);
+                if (!conn) {
+                    OWARNLOG("ARCHIVE: could not connect to DFU/WorkUnits to remove archived workunits");
+                    return false;
+                }
+                IPropertyTree *root = conn->queryRoot();
+                for (const std::string &wuid : wuids) {
+                    if (!root->removeProp(wuid.c_str()))
+                        OWARNLOG("ARCHIVE: archived DFU workunit %s was already removed from dali",wuid.c_str());
+                }
+                conn->commit();
+            }
+            catch (IException *e) {
+                // Retried by the next flush
+                EXCLOG(e,"ARCHIVE: removing archived DFU workunits");
+                e->Release();
+                return false;
+            }
+#endif
+            return true;
+        });
+        if (numDeleted)
+            PROGLOG("ARCHIVE: removed %u archived DFU workunits",numDeleted);
+    }
+
+    unsigned deleteBatchSize;
+
 
 };
 
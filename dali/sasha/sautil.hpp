@@ -1,7 +1,11 @@
 #ifndef SAUTIL_HPP
 #define SAUTIL_HPP
 
+#include <algorithm>
+#include <string>
+#include <vector>
 #include "jtime.hpp"
+#include "jmutex.hpp"
 
 class CSashaSchedule
 {
@@ -124,6 +128,44 @@ public:
 extern void operationStarted(const char *msg);
 extern void operationFinished(const char *msg);
 
+// Workunits that have been archived, but not yet removed from dali.  They are removed a batch at a time, and a workunit
+// that is restored before its batch is removed is left in dali.
+class CPendingWorkUnitDeletes
+{
+    CriticalSection sect;       // held while a batch is removed, so a restore waits until the removal has completed
+    std::vector<std::string> pending;
+public:
+    // Returns the number of workunits now waiting to be removed
+    unsigned add(const char *wuid)
+    {
+        CriticalBlock block(sect);
+        pending.emplace_back(wuid);
+        return (unsigned)pending.size();
+    }
+    // Returns true if the workunit was waiting to be removed, and now will not be
+    bool cancel(const char *wuid)
+    {
+        CriticalBlock block(sect);
+        auto match = std::find(pending.begin(), pending.end(), wuid);
+        if (match == pending.end())
+            return false;
+        pending.erase(match);
+        return true;
+    }
+    // Calls remove(const std::vector<std::string> &) to remove every pending workunit.  If it returns false the
+    // workunits are kept for the next flush.  Returns the number removed.
+    template <class REMOVE>
+    unsigned flush(REMOVE remove)
+    {
+        CriticalBlock block(sect);
+        if (pending.empty() || !remove(pending))
+            return 0;
+        unsigned num = (unsigned)pending.size();
+        pending.clear();
+        return num;
+    }
+};
+
 extern unsigned clustersToGroups(IPropertyTree *envroot,const StringArray &cmplst,StringArray &cnames,StringArray &groups,bool *done);
 extern unsigned clustersToGroups(IPropertyTree *envroot,const StringArray &cmplst,StringArray &groups,bool *done);
 
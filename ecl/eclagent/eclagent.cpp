@@ -19,6 +19,7 @@
 #include "jcontainerized.hpp"
 #include "jmisc.hpp"
 #include "jdebug.hpp"
+#include "jprofiler.hpp"
 #include "jptree.hpp"
 #include "jprop.hpp"
 #include "jfile.hpp"
@@ -2229,15 +2230,27 @@ void EclAgent::runProcess(IEclProcess *process)
     if (debugContext)
         debugContext->checkBreakpoint(DebugStateReady, NULL, NULL);
 
-    if(queryWorkUnit()->hasWorkflow())
+    unsigned profileSampleRate = queryWorkUnit()->getDebugValueInt("profileSampleRate", agentTopology->getPropInt("@profileSampleRate", 0));
+    bool profiling = profileSampleRate && startSamplingProfiler(profileSampleRate);
+
+    try
     {
-        workflow.setown(new EclAgentWorkflowMachine(*this));
-        workflow->perform(this, process);
+        if(queryWorkUnit()->hasWorkflow())
+        {
+            workflow.setown(new EclAgentWorkflowMachine(*this));
+            workflow->perform(this, process);
+        }
+        else
+        {
+            GlobalCodeContextExtra gctx(this, 0);
+            process->perform(&gctx, 0);
+        }
     }
-    else
+    catch (...)
     {
-        GlobalCodeContextExtra gctx(this, 0);
-        process->perform(&gctx, 0);
+        if (profiling)
+            stopSamplingProfiler();
+        throw;
     }
 
     ForEachItemIn(i, queryLibraries)
@@ -2249,6 +2262,16 @@ void EclAgent::runProcess(IEclProcess *process)
     {
         WorkunitUpdate wu = updateWorkUnit();
         updateAggregates(wu);
+        if (profiling)
+        {
+            stopSamplingProfiler();
+            VStringBuffer profileName("%s.profile.folded", wu->queryWuid());
+            if (saveSamplingProfile(profileName, true))
+            {
+                Owned<IWUQuery> query = wu->updateQuery();
+                associateLocalFile(query, FileTypeLog, profileName, "Sampling profile", 0);
+            }
+        }
         if (rowManager)
         {
             WuStatisticTarget statsTarget(wu, "eclagent");
@@ -385,6 +385,8 @@ protected:
     StringArray allowSignedPermissions;
     StringArray deniedPermissions;
     StringAttr optMetaLocation;
+    StringAttr optObjectCache;
+    StringAttr optPchCache;
     StringBuffer neverSimplifyRegEx;
     StringAttr optDefaultGitPrefix;
     StringAttr optGitUser;
@@ -794,6 +796,10 @@ ICppCompiler * EclCC::createCompiler(const char * coreName, const char * sourceD
     Owned<ICppCompiler> compiler = ::createCompiler(coreName, sourceDir, targetDir, optTargetCompiler, logVerbose, compileBatchOut);
     compiler->setOnlyCompile(optOnlyCompile);
     compiler->setCCLogPath(cclogFilename);
+    if (optObjectCache)
+        compiler->setObjectCache(optObjectCache);
+    if (optPchCache)
+        compiler->setPrecompiledHeaderCache(optPchCache);
 
     ForEachItemIn(iComp, compileOptions)
         compiler->addCompileOption(compileOptions.item(iComp));
@@ -1316,6 +1322,24 @@ void EclCC::processSingleQuery(const EclRepositoryManager & localRepositoryManag
 
         optionHash = rtlHash64Data(sizeof(optLegacyImport), &optLegacyImport, optionHash);
         optionHash = rtlHash64Data(sizeof(optLegacyWhen), &optLegacyWhen, optionHash);
+
+        //__TARGET_PLATFORM__, __OS__, __CONTAINERIZED__ and __ECL_VERSION__ are folded to constants when the source is
+        //parsed, so the simplified definitions saved in the cache are only valid if they have not changed.
+        StringBuffer targetPlatform;
+        instance.getTargetPlatform(targetPlatform);
+        optionHash = rtlHash64VStr(targetPlatform, optionHash);
+#ifdef _WIN32
+        const char * targetOs = "windows";
+#elif defined(__APPLE__)
+        const char * targetOs = "macos";
+#else
+        const char * targetOs = "linux";
+#endif
+        optionHash = rtlHash64VStr(targetOs, optionHash);
+        bool containerized = isContainerized();
+        optionHash = rtlHash64Data(sizeof(containerized), &containerized, optionHash);
+        optionHash = rtlHash64VStr(LANGUAGE_VERSION, optionHash);
+
         //And create a cache instances
         cache.setown(createEclFileCachedDefinitionCollection(instance.dataServer, optMetaLocation));
     }
@@ -2952,6 +2976,13 @@ int EclCC::parseCommandLineOptions(int argc, const char* argv[])
             else
                 optMetaLocation.clear();
         }
+        else if (iter.matchOption(tempArg, "--objectcache"))
+        {
+            if (!tempArg.isEmpty())
+                optObjectCache.set(tempArg);
+            else
+                optObjectCache.clear();
+        }
         else if (iter.matchOption(tempArg, "--neversimplify"))
         {
             appendNeverSimplifyList(tempArg);
@@ -2974,6 +3005,13 @@ int EclCC::parseCommandLineOptions(int argc, const char* argv[])
         else if (iter.matchFlag(optOutputDirectory, "-P"))
         {
         }
+        else if (iter.matchOption(tempArg, "--pchcache"))
+        {
+            if (!tempArg.isEmpty())
+                optPchCache.set(tempArg);
+            else
+                optPchCache.clear();
+        }
         else if (iter.matchFlag(optGenerateHeader, "-pch"))
         {
         }
@@ -98,7 +98,7 @@ const char * const helpText[] = {
     "!   --gituser=x   Which user should be used for accessing git repositories (for servers)",
     "    -help, --help Display this message",
     "    -help -v      Display verbose help message",
-    "!   --ignoresimplified Do not use simplified expressions when syntax checking",
+    "!   --ignoresimplified Do not use simplified definitions from the cache",
     "!   --ignoreunknownimport Do not report an error on an unknown import",
     "!   -internal     Run internal tests",
     "!   --jobid=str   Set the name of the job id output in the logging",
@@ -119,10 +119,12 @@ const char * const helpText[] = {
     "!   -m            Enable leak checking",
 #endif
     "!   --nogpg       Do not run gpg to check signatures on signed code",
+    "!   --objectcache=x Directory used to cache compiled object files between compiles",
     "    --nosourcepath Compile as if the source came from stdin",
     "?!  --nostdinc    Do not include the current directory in -I",
 #ifndef _WIN32
     "!   -pch          Generate precompiled header for eclinclude4.hpp",
+    "!   --pchcache=x  Directory used to maintain precompiled headers for each set of compile options",
 #endif
     "!   -P <path>     Specify the path of the output files (only with -b option)",
     "!   --prunearchive Do not include plugins and standard library in the archive (defaults on)",
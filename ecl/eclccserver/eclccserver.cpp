@@ -242,7 +242,9 @@ class EclccCompileThread : implements IPooledThread, implements IErrorReporter,
     StringBuffer idxStr;
     StringArray filesSeen;
     StringBuffer repoRootPath;
+    StringBuffer objectCacheDir;
     unsigned defaultMaxCompileThreads = 1;
+    unsigned numCacheAdds = 0;
     bool saveTemps = false;
 
     virtual void reportError(IException *e)
@@ -438,6 +440,19 @@ class EclccCompileThread : implements IPooledThread, implements IErrorReporter,
                 recursiveRemoveDirectory(tempDir);
             return 0;
         }
+        else if (startsWith(line, "cachestore "))
+        {
+            //cachestore <key> <objectfile> - only add objects to the cache if everything compiled successfully
+            const char * key = line + 11;
+            const char * object = strchr(key, ' ');
+            if (!alreadyFailed && object && objectCacheDir.length())
+            {
+                StringAttr keyText(key, object - key);
+                if (storeCachedObject(objectCacheDir, keyText, object + 1))
+                    numCacheAdds++;
+            }
+            return 0;
+        }
         else if (startsWith(line , "rm "))
         {
             DBGLOG("Removing file %s", line+3);
@@ -503,14 +518,27 @@ class EclccCompileThread : implements IPooledThread, implements IErrorReporter,
                 }
             });
         }
+        bool usedCache = false;
+        unsigned numCacheHits = 0;
+        numCacheAdds = 0;
         while (lines.isItem(lineIdx))
         {
             const char *line = lines.item(lineIdx);
+            if (startsWith(line, "#cache "))
+            {
+                usedCache = true;
+                numCacheHits = atoi(line + 7);
+            }
             unsigned retcode = executeLine(abortWaiter, line, output, (numFailed != 0));
             if (retcode)
                 numFailed++;
             lineIdx++;
         }
+        if (usedCache)
+        {
+            workunit->setStatistic(queryStatisticsComponentType(), queryStatisticsComponentName(), SSToperation, ">compile:>compile c++", StNumCompileCacheHits, NULL, numCacheHits, 1, 0, StatsMergeReplace);
+            workunit->setStatistic(queryStatisticsComponentType(), queryStatisticsComponentName(), SSToperation, ">compile:>compile c++", StNumCompileCacheAdds, NULL, numCacheAdds, 1, 0, StatsMergeReplace);
+        }
         if (!saveTemps)
             removeFileTraceIfFail(ccfileName);
 
@@ -652,6 +680,37 @@ class EclccCompileThread : implements IPooledThread, implements IErrorReporter,
         if (config->hasProp("@gitUsername"))
             eclccCmd.appendf(" --gituser=%s", config->queryProp("@gitUsername"));
 
+        //Compiled objects are shared between compiles via a directory or a storage plane
+        objectCacheDir.clear();
+        if (workunit->getDebugValueBool("useObjectCache", true))
+        {
+            const char * cachePlane = config->queryProp("@objectCachePlane");
+            if (cachePlane)
+            {
+                Owned<IPropertyTree> plane = getStoragePlane(cachePlane);
+                if (plane)
+                    objectCacheDir.append(plane->queryProp("@prefix"));
+                else
+                    IWARNLOG("Object cache plane %s not found", cachePlane);
+            }
+            else if (config->hasProp("@objectCacheDir"))
+                objectCacheDir.append(config->queryProp("@objectCacheDir"));
+        }
+        if (objectCacheDir.length())
+            eclccCmd.appendf(" \"--objectcache=%s\"", objectCacheDir.str());
+
+        //Precompiled headers for the generated code are maintained for each set of compile options
+        if (workunit->getDebugValueBool("usePrecompiledHeader", true))
+        {
+            StringBuffer pchCacheDir;
+            if (config->hasProp("@pchCacheDir"))
+                pchCacheDir.append(config->queryProp("@pchCacheDir"));
+            else if (objectCacheDir.length())
+                addPathSepChar(pchCacheDir.append(objectCacheDir)).append("pch");
+            if (pchCacheDir.length())
+                eclccCmd.appendf(" \"--pchcache=%s\"", pchCacheDir.str());
+        }
+
         Owned<IPipeProcess> pipe = createPipeProcess();
         pipe->setenv("ECLCCSERVER_THREAD_INDEX", idxStr.str());
         Owned<IPropertyTreeIterator> options = config->getElements(isContainerized() ? "./options" : "./Option");
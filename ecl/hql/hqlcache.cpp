@@ -117,6 +117,7 @@ public:
 
     virtual timestamp_type getTimeStamp() const override;
     virtual void queryDependencies(StringArray & values) const override;
+    virtual IFileContents * getSimplifiedEcl(bool requireExact) const override;
     virtual bool hasKnownDependents() const override
     {
         return !cacheTree->getPropBool("@isMacro");
@@ -166,6 +167,42 @@ void EclXmlCachedDefinition::queryDependencies(StringArray & values) const
     }
 }
 
+/*
+ * Return the ecl for a simplified version of the definition that can be parsed in place of the original.
+ * If requireExact is true then only return it if it is semantically identical to the original definition,
+ * otherwise it may only be suitable for syntax checking (e.g., a dataset replaced with an empty dataset).
+ */
+IFileContents * EclXmlCachedDefinition::getSimplifiedEcl(bool requireExact) const
+{
+    if (!cacheTree)
+        return nullptr;
+
+    IPropertyTree * simplified = cacheTree->queryPropTree("Simplified");
+    if (!simplified)
+        return nullptr;
+    if (simplified->getPropInt("@version") != simplifiedDefinitionVersion)
+        return nullptr;
+    if (requireExact && !simplified->getPropBool("@exact"))
+        return nullptr;
+
+    const char * ecl = simplified->queryProp("");
+    if (isEmptyString(ecl))
+        return nullptr;
+
+    //The text does not match the original source, so use a different source path to avoid misleading error locations
+    IFileContents * original = definition ? definition->queryFileContents() : nullptr;
+    ISourcePath * originalPath = original ? original->querySourcePath() : nullptr;
+    StringBuffer pathText;
+    if (originalPath)
+        pathText.append(str(originalPath));
+    else
+        pathText.append(queryName());
+    pathText.append(" (simplified from cache)");
+    Owned<ISourcePath> sourcePath = createSourcePath(pathText);
+    timestamp_type ts = original ? original->getTimeStamp() : 0;
+    return createFileContentsFromText(ecl, sourcePath, false, nullptr, ts);
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 
 /*
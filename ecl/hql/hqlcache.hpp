@@ -19,6 +19,10 @@
 #define __HQLCACHE_HPP_
 
 interface IHqlExpression;
+interface IFileContents;
+
+//Increment if the format of the simplified definitions saved in the cache changes, so old entries are ignored
+constexpr unsigned simplifiedDefinitionVersion = 1;
 /*
  * This interface represents cached information about an ECL definition.  If it is up to date then
  * the stored information can be used to optimize creating an archive, and parsing source code.
@@ -29,6 +33,7 @@ public:
     virtual timestamp_type getTimeStamp() const = 0;
     virtual IEclSource * queryOriginal() const = 0;
     virtual bool isUpToDate(hash64_t optionHash) const = 0;
+    virtual IFileContents * getSimplifiedEcl(bool requireExact) const = 0;
     virtual void queryDependencies(StringArray & values) const = 0;
     virtual bool hasKnownDependents() const = 0;
 };
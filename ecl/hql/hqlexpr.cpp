@@ -329,7 +329,15 @@ PURE(expression) - treat an expression as pure - probably superseded with WITHIN
 
 //---------------------------------------------------------------------------------------------------------------------
 
-const unsigned InitialExprCacheSize = 0x1000U; // Allocating larger than default has a very minor benefit
+//The expression cache is split into partitions (selected by the hash code) which are locked independently, so
+//that threads creating expressions concurrently (e.g. eclcc -threads batch mode, esp) rarely contend for the same
+//critical section.  HQLEXPR_MULTI_THREADED is defined in hqlexpr.ipp.
+#ifdef HQLEXPR_MULTI_THREADED
+const unsigned NumExprCachePartitions = 16;
+#else
+const unsigned NumExprCachePartitions = 1;
+#endif
+const unsigned InitialExprCacheSize = 0x1000U / NumExprCachePartitions; // Allocating larger than default has a very minor benefit
 class HqlExprCache : public JavaHashTableOf<CHqlExpression>
 {
 public:
@@ -357,7 +365,7 @@ protected:
 static Mutex * transformMutex;
 static CriticalSection * transformCS;
 static Semaphore * transformSemaphore;
-static HqlExprCache *exprCache;
+static HqlExprCache *exprCache[NumExprCachePartitions];
 static CriticalSection * nullIntCS;
 static CriticalSection * unadornedCS;
 static CriticalSection * sourcePathCS;
@@ -390,7 +398,12 @@ static IHqlExpression * processingMarker;
 static IHqlExpression * mergePendingMarker;
 static IHqlExpression * mergeNoMatchMarker;
 static IHqlExpression * nullIntValue[9][2];
-static CriticalSection * exprCacheCS;
+static CriticalSection * exprCacheCS[NumExprCachePartitions];
+static inline unsigned getExprCachePartition(unsigned hash)
+{
+    //The low bits are used to select the slot within each hash table, so use the upper bits to select the partition
+    return (hash >> 24) % NumExprCachePartitions;
+}
 static CriticalSection * crcCS;
 static KeptAtomTable * sourcePaths;
 
@@ -436,9 +449,12 @@ MODULE_INIT(INIT_PRIORITY_HQLINTERNAL)
     transformMutex = new Mutex;
     transformCS = new CriticalSection;
     transformSemaphore = new Semaphore(NUM_PARALLEL_TRANSFORMS);
-    exprCacheCS = new CriticalSection;
+    for (unsigned iPart=0; iPart < NumExprCachePartitions; iPart++)
+    {
+        exprCacheCS[iPart] = new CriticalSection;
+        exprCache[iPart] = new HqlExprCache;
+    }
     crcCS = new CriticalSection;
-    exprCache = new HqlExprCache;
     nullIntCS = new CriticalSection;
     unadornedCS = new CriticalSection;
     sourcePathCS = new CriticalSection;
@@ -477,7 +493,8 @@ MODULE_INIT(INIT_PRIORITY_HQLINTERNAL)
 MODULE_EXIT()
 {
 #ifdef TRACE_HASH
-    exprCache->dumpStats();
+    for (unsigned iPart=0; iPart < NumExprCachePartitions; iPart++)
+        exprCache[iPart]->dumpStats();
 #endif
     for (unsigned i=0; i<=8; i++)
     {
@@ -513,16 +530,19 @@ MODULE_EXIT()
     nullType->Release();
 
 #ifdef _REPORT_EXPRESSION_LEAKS
-    if (exprCache->count())
+    unsigned numCached = 0;
+    for (unsigned iPart=0; iPart < NumExprCachePartitions; iPart++)
+        numCached += exprCache[iPart]->count();
+    if (numCached)
     {
 #if 0 // Place debugging code inside here
-        JavaHashIteratorOf<IHqlExpression> iter(*exprCache, false);
+        JavaHashIteratorOf<IHqlExpression> iter(*exprCache[0], false);
         ForEach(iter)
         {
             IHqlExpression & ret = iter.query();
         }
 #endif
-        fprintf(stderr, "%s Hash table contains %d entries\n", activeSource.str(), exprCache->count());
+        fprintf(stderr, "%s Hash table contains %d entries\n", activeSource.str(), numCached);
     }
 #endif
 
@@ -530,8 +550,11 @@ MODULE_EXIT()
     delete sourcePathCS;
     delete unadornedCS;
     delete nullIntCS;
-    exprCache->Release();
-    delete exprCacheCS;
+    for (unsigned iPart=0; iPart < NumExprCachePartitions; iPart++)
+    {
+        exprCache[iPart]->Release();
+        delete exprCacheCS[iPart];
+    }
     delete crcCS;
     delete transformMutex;
     delete transformCS;
@@ -546,13 +569,16 @@ MODULE_INIT(INIT_PRIORITY_STANDARD)
 }
 MODULE_EXIT()
 {
-    for (auto & cur  : *exprCache)
+    for (unsigned iPart=0; iPart < NumExprCachePartitions; iPart++)
     {
-        if (cur.getOperator() == no_constant)
+        for (auto & cur  : *exprCache[iPart])
         {
-            StringBuffer text;
-            toECL(cur.queryBody(), text, false);
-            printf("CONST:%" I64F "u:%s", querySeqId(&cur), text.str());
+            if (cur.getOperator() == no_constant)
+            {
+                StringBuffer text;
+                toECL(cur.queryBody(), text, false);
+                printf("CONST:%" I64F "u:%s", querySeqId(&cur), text.str());
+            }
         }
     }
 
@@ -1088,7 +1114,7 @@ bool HqlParseContext::checkEndMeta()
     return wasGathering;
 }
 
-bool HqlParseContext::createCache(bool isMacro)
+bool HqlParseContext::createCache(IHqlExpression * simplifiedDefinition, bool isExact, bool isMacro)
 {
     StringBuffer fullName;
     StringBuffer baseFilename;
@@ -1120,6 +1146,32 @@ bool HqlParseContext::createCache(bool isMacro)
         if (curMeta().dependencies)
             saveXML(*stream, curMeta().dependencies, 0, XML_Embed|XML_LineBreak);
 
+        if (simplifiedDefinition)
+        {
+            StringBuffer ecl;
+            try
+            {
+                regenerateDefinition(simplifiedDefinition, ecl);
+            }
+            catch (IException * e)
+            {
+                //Failing to regenerate the definition only means it will be parsed in full next time
+                DBGLOG(e);
+                e->Release();
+                ecl.clear();
+            }
+            if (ecl.length())
+            {
+                VStringBuffer simplifiedText("<Simplified version=\"%u\"", simplifiedDefinitionVersion);
+                if (isExact)
+                    simplifiedText.append(" exact=\"1\"");
+                simplifiedText.append(">");
+                encodeUtf8XML(ecl, simplifiedText);
+                simplifiedText.append("</Simplified>\n");
+                writeStringToStream(*stream, simplifiedText);
+            }
+        }
+
         writeStringToStream(*stream, "</Cache>\n");
         stream->flush();
     }
@@ -3992,9 +4044,10 @@ void CHqlExpression::beforeDispose()
 #endif
     if (observed)
     {
-        HqlCriticalBlock block(*exprCacheCS);
+        unsigned partition = getExprCachePartition(hashcode);
+        HqlCriticalBlock block(*exprCacheCS[partition]);
         if (observed)
-            exprCache->removeExact(this);
+            exprCache[partition]->removeExact(this);
     }
     assertex(!(observed));
 }
@@ -4009,14 +4062,14 @@ unsigned CHqlExpression::getHash() const
 void CHqlExpression::addObserver(IObserver & observer)
 {
     assertex(!(observed));
-    assert(&observer == exprCache);
+    assert(&observer == exprCache[getExprCachePartition(hashcode)]);
     observed = true;
 }
 
 void CHqlExpression::removeObserver(IObserver & observer)
 {
     assertex(observed);
-    assert(&observer == exprCache);
+    assert(&observer == exprCache[getExprCachePartition(hashcode)]);
     observed = false;
 }
 
@@ -4043,15 +4096,16 @@ IHqlExpression * CHqlExpression::commonUpExpression()
 
     IHqlExpression * match;
     {
-        HqlCriticalBlock block(*exprCacheCS);
-        match = exprCache->addOrFind(*this);
+        unsigned partition = getExprCachePartition(hashcode);
+        HqlCriticalBlock block(*exprCacheCS[partition]);
+        match = exprCache[partition]->addOrFind(*this);
 #ifndef GATHER_COMMON_STATS
         if (match == this)
             return this;
 #endif
         if (!static_cast<CHqlExpression *>(match)->isAliveAndLink())
         {
-            exprCache->replace(*this);
+            exprCache[partition]->replace(*this);
 #ifdef GATHER_COMMON_STATS
             Link();
             match = this;
@@ -4105,9 +4159,9 @@ void displayHqlCacheStats()
 {
 #if 0
     static HqlExprCopyArray prev;
-    DBGLOG("CachedItems = %d", exprCache->count());
-    exprCache->dumpStats();
-    for (CHqlExpression & ret : *exprCache)
+    DBGLOG("CachedItems = %d", exprCache[0]->count());
+    exprCache[0]->dumpStats();
+    for (CHqlExpression & ret : *exprCache[0])
     {
         if (!prev.contains(ret))
         {
@@ -4118,7 +4172,7 @@ void displayHqlCacheStats()
     }
 
     prev.kill();
-    for (auto & iter2 : *exprCache)
+    for (auto & iter2 : *exprCache[0])
     {
         prev.append(iter2);
     }
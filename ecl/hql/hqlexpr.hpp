@@ -919,7 +919,7 @@ public:
     void beginMetaScope() { metaStack.append(*new FileParseMeta); }
     void beginMetaScope(FileParseMeta & active) { metaStack.append(OLINK(active)); }
     void endMetaScope() { metaStack.pop(); }
-    bool createCache(bool isMacro);
+    bool createCache(IHqlExpression * simplifiedDefinition, bool isExact, bool isMacro);
     inline FileParseMeta & curMeta() { return metaStack.tos(); }
     inline bool hasCacheLocation( ) const { return !metaOptions.cacheLocation.isEmpty();}
 public:
@@ -1027,7 +1027,7 @@ public:
     inline bool checkSimpleDef() const { return parseCtx.checkSimpleDef; }
     inline bool ignoreCache() const { return parseCtx.ignoreCache; }
     inline bool ignoreSimplified() const { return parseCtx.ignoreSimplified; }
-    inline bool createCache(bool isMacro) { return parseCtx.createCache(isMacro); }
+    inline bool createCache(IHqlExpression * simplifiedDefinition, bool isExact, bool isMacro) { return parseCtx.createCache(simplifiedDefinition, isExact, isMacro); }
     void reportTiming(const char * name);
     inline void incrementAttribsProcessed() { ++parseCtx.numAttribsProcessed; }
     inline bool neverSimplify(const char *fullname) { return parseCtx.neverSimplify(fullname); }
@@ -12808,7 +12808,7 @@ extern HQL_API void parseModule(IHqlScope *scope, IFileContents * contents, HqlL
         E->Release();
     }
     if (ctx.hasCacheLocation())
-        moduleCtx.createCache(false);
+        moduleCtx.createCache(nullptr, false, false);
 
     moduleCtx.noteEndModule(success);
 }
@@ -12837,6 +12837,78 @@ bool parseForwardModuleMember(HqlGramCtx & _parent, IHqlScope *scope, IHqlExpres
     return (prevErrors == ctx.errs->errCount());
 }
 
+//When a definition is parsed from its simplified form the definitions it depends on are not parsed, so note
+//them (and everything they depend on) so that any associated manifests are still located.
+static void noteCachedDependencies(IPropertyTree * dependTree, IEclCachedDefinitionCollection * cache, IEclCachedDefinition * cached, StringArray & visited)
+{
+    StringArray dependencies;
+    cached->queryDependencies(dependencies);
+    ForEachItemIn(i, dependencies)
+    {
+        const char * name = dependencies.item(i);
+        if (visited.contains(name))
+            continue;
+        visited.append(name);
+
+        Owned<IEclCachedDefinition> match = cache->getDefinition(name);
+        if (!match)
+            continue;
+        IEclSource * original = match->queryOriginal();
+        IFileContents * contents = original ? original->queryFileContents() : nullptr;
+        if (contents)
+        {
+            IPropertyTree * attr = dependTree->addPropTree("Attribute");
+            attr->setProp("@name", name);
+            attr->setProp("@sourcePath", str(contents->querySourcePath()));
+        }
+        noteCachedDependencies(dependTree, cache, match, visited);
+    }
+}
+
+//Check that the simplified definition saved in the cache can still be used in place of the full definition.  An exact
+//definition must have the same value, otherwise the simplified definition is only used for syntax checking, and
+//only needs to have the same kind of type and the same record structure.
+static void checkSimplifiedDefinition(IEclCachedDefinition * cached, IHqlExpression * parsed, HqlLookupContext & ctx, IIdAtom * name, const char * fullName)
+{
+    bool isExact = true;
+    Owned<IFileContents> simplifiedContents = cached->getSimplifiedEcl(true);
+    if (!simplifiedContents)
+    {
+        isExact = false;
+        simplifiedContents.setown(cached->getSimplifiedEcl(false));
+        if (!simplifiedContents)
+            return;
+    }
+
+    MultiErrorReceiver errors;
+    OwnedHqlExpr simplified = parseDefinition(simplifiedContents->getText(), name, errors);
+    bool matches = false;
+    if (simplified && (errors.errCount() == 0))
+    {
+        ITypeInfo * expectedType = parsed->queryType();
+        ITypeInfo * actualType = simplified->queryType();
+        if (isExact)
+        {
+            OwnedHqlExpr folded = quickFoldExpression(parsed->queryBody());
+            IValue * expectedValue = folded->queryValue();
+            IValue * actualValue = simplified->queryBody()->queryValue();
+            matches = expectedValue && actualValue &&
+                      (queryUnqualifiedType(expectedType) == queryUnqualifiedType(actualType)) &&
+                      (expectedValue->compare(actualValue) == 0);
+        }
+        else if (!expectedType || !actualType)
+            matches = (expectedType == actualType);
+        else if (expectedType->getTypeCode() != actualType->getTypeCode())
+            matches = false;
+        else if (queryRecordType(expectedType))
+            matches = recordTypesMatch(expectedType, actualType);
+        else
+            matches = (queryUnqualifiedType(expectedType) == queryUnqualifiedType(actualType));
+    }
+    if (!matches)
+        UWARNLOG("Simplified definition of %s does not match the original definition", fullName);
+}
+
 // If ctx.hasCacheLocation() then the cache entry is always updated with the dependency information (unless it is unavailable i.e. a forward scope)
 // if ctx.ignoreCache() then the contents of the cache are not used, but the cache is still updated
 // if ctx.regenerateCache() then the contents of the cache are not used and the cache is forced to be updated
@@ -12847,14 +12919,26 @@ void parseAttribute(IHqlScope * scope, IFileContents * contents, HqlLookupContex
     attrCtx.noteBeginAttribute(scope, contents, name);
 
     // Set cacheUptoDate to true if cache is upto date
-    // Set usingSimplified to true if cache is upto date and option to ignoreSimplified & ignoreCache are both false
-    // Use simplified expression from cache if usingSimplified is true & syntaxChecking
+    // Use the simplified definition from the cache if it is upto date and ignoreSimplified & ignoreCache are both false.
+    // Definitions that are only simplified for syntax checking (e.g. datasets) are only used if syntaxChecking.
     // * None of these are set of ctx.regenerateCache==true, as the simplified expression & cache will need to regenerated.
+    Owned<IEclCachedDefinition> cached;
+    Owned<IFileContents> simplifiedContents;
     if (ctx.hasCacheLocation() && !ctx.regenerateCache())
     {
         HqlParseContext & parseContext = ctx.queryParseContext();
-        Owned<IEclCachedDefinition> cached = parseContext.cache->getDefinition(fullName);
+        cached.setown(parseContext.cache->getDefinition(fullName));
         cacheUptoDate = cached->isUpToDate(parseContext.optionHash);
+        if (cacheUptoDate && !ctx.ignoreCache() && !ctx.ignoreSimplified() && !ctx.checkSimpleDef() &&
+            !parseContext.queryArchive() && !ctx.neverSimplify(fullName))
+        {
+            simplifiedContents.setown(cached->getSimplifiedEcl(!ctx.syntaxChecking()));
+            if (simplifiedContents && parseContext.globalDependTree)
+            {
+                StringArray visited;
+                noteCachedDependencies(parseContext.globalDependTree, parseContext.cache, cached, visited);
+            }
+        }
     }
 
     //The attribute will be added to the current scope as a side-effect of parsing the attribute.
@@ -12864,7 +12948,8 @@ void parseAttribute(IHqlScope * scope, IFileContents * contents, HqlLookupContex
         const char * moduleName = scope->queryFullName();
         Owned<IHqlScope> globalScope = getResolveDottedScope(moduleName, LSFpublic, ctx);
         assertex(globalScope);
-        HqlGram parser(globalScope, scope, contents, attrCtx, NULL, false, true);
+        IFileContents * parseContents = simplifiedContents ? simplifiedContents.get() : contents;
+        HqlGram parser(globalScope, scope, parseContents, attrCtx, NULL, false, true);
         parser.setExpectedAttribute(name);
         parser.setAssociateWarnings(true);
         parser.getLexer()->set_yyLineNo(1);
@@ -12888,7 +12973,15 @@ void parseAttribute(IHqlScope * scope, IFileContents * contents, HqlLookupContex
             const bool isMacro = parsed->isMacro();
             const bool updateCache = ctx.hasCacheLocation() && (!cacheUptoDate || ctx.regenerateCache());
             if (updateCache)
-                attrCtx.createCache(isMacro);
+            {
+                bool isExact = false;
+                OwnedHqlExpr simplified;
+                if (!isMacro && !ctx.neverSimplify(fullName))
+                    simplified.setown(createSimplifiedDefinition(parsed, isExact));
+                attrCtx.createCache(simplified, isExact, isMacro);
+            }
+            else if (ctx.checkSimpleDef() && cacheUptoDate)
+                checkSimplifiedDefinition(cached, parsed, ctx, name, fullName);
         }
     }
 
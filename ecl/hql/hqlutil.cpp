@@ -10700,6 +10700,74 @@ IHqlExpression * queryAttributeModifier(ITypeInfo * type, IAtom * name)
 }
 
 
+static bool canCreateNullConstant(ITypeInfo * type)
+{
+    switch (type->getTypeCode())
+    {
+    case type_boolean:
+    case type_int:
+    case type_swapint:
+    case type_packedint:
+    case type_real:
+    case type_decimal:
+    case type_string:
+    case type_varstring:
+    case type_qstring:
+    case type_data:
+    case type_unicode:
+    case type_varunicode:
+    case type_utf8:
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Create a version of a definition that can be saved in the definition cache and parsed instead of the
+ * original source (and everything it depends on).  isExact is set if the result is equivalent to the original,
+ * otherwise it only preserves the type of the definition and can only be used when syntax checking.
+ * Returns null if the definition cannot be simplified.
+ */
+IHqlExpression * createSimplifiedDefinition(IHqlExpression * expr, bool & isExact)
+{
+    isExact = false;
+    if (!expr || expr->isFunction() || expr->isMacro() || expr->isScope())
+        return nullptr;
+
+    IHqlExpression * body = expr->queryBody();
+    switch (body->getOperator())
+    {
+    case no_constant:
+        isExact = true;
+        return LINK(expr);
+    case no_record:
+        return LINK(expr);
+    }
+
+    if (isGrouped(body))
+        return nullptr;
+    if (expr->isDataset() || expr->isDatarow() || expr->isDictionary())
+    {
+        OwnedHqlExpr null = createNullExpr(body);
+        return cloneSymbol(expr, nullptr, null, nullptr, nullptr);
+    }
+
+    //Scalars that are calculated from other constant definitions can be replaced with their value.  Any other
+    //scalar is replaced with a value of the same type, which is enough to syntax check the definitions that use it.
+    ITypeInfo * type = body->queryType();
+    if (!type || !canCreateNullConstant(type))
+        return nullptr;
+    OwnedHqlExpr folded = quickFoldExpression(body);
+    if (folded->getOperator() == no_constant)
+    {
+        isExact = true;
+        return cloneSymbol(expr, nullptr, folded, nullptr, nullptr);
+    }
+    OwnedHqlExpr null = createConstant(createNullValue(type));
+    return cloneSymbol(expr, nullptr, null, nullptr, nullptr);
+}
+
+
 IException * checkRegexSyntax(IHqlExpression * expr)
 {
     if (expr)
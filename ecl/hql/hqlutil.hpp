@@ -880,5 +880,6 @@ protected:
 extern HQL_API bool joinHasRightOnlyHardMatch(IHqlExpression * expr, bool allowSlidingMatch);
 extern HQL_API void gatherParseWarnings(IErrorReceiver * errs, IHqlExpression * expr, IErrorArray & warnings);
 extern HQL_API IHqlExpression * queryAttributeModifier(ITypeInfo * type, IAtom * name);
+extern HQL_API IHqlExpression * createSimplifiedDefinition(IHqlExpression * expr, bool & isExact);
 
 #endif
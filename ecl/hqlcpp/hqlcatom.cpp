@@ -398,11 +398,13 @@ IIdAtom * hash32Data5Id;
 IIdAtom * hash32Data6Id;
 IIdAtom * hash32Data7Id;
 IIdAtom * hash32Data8Id;
+IIdAtom * hash32FastDataId;
 IIdAtom * hash32UnicodeId;
 IIdAtom * hash32Utf8Id;
 IIdAtom * hash32VStrId;
 IIdAtom * hash32VUnicodeId;
 IIdAtom * hash64DataId;
+IIdAtom * hash64FastDataId;
 IIdAtom * hash64UnicodeId;
 IIdAtom * hash64Utf8Id;
 IIdAtom * hash64VStrId;
@@ -1064,11 +1066,13 @@ MODULE_INIT(INIT_PRIORITY_HQLATOM-1)
     MAKEID(hash32Data6);
     MAKEID(hash32Data7);
     MAKEID(hash32Data8);
+    MAKEID(hash32FastData);
     MAKEID(hash32VStr);
     MAKEID(hash32Unicode);
     MAKEID(hash32Utf8);
     MAKEID(hash32VUnicode);
     MAKEID(hash64Data);
+    MAKEID(hash64FastData);
     MAKEID(hash64VStr);
     MAKEID(hash64Unicode);
     MAKEID(hash64Utf8);
@@ -396,11 +396,13 @@ extern IIdAtom * hash32Data5Id;
 extern IIdAtom * hash32Data6Id;
 extern IIdAtom * hash32Data7Id;
 extern IIdAtom * hash32Data8Id;
+extern IIdAtom * hash32FastDataId;
 extern IIdAtom * hash32UnicodeId;
 extern IIdAtom * hash32Utf8Id;
 extern IIdAtom * hash32VStrId;
 extern IIdAtom * hash32VUnicodeId;
 extern IIdAtom * hash64DataId;
+extern IIdAtom * hash64FastDataId;
 extern IIdAtom * hash64UnicodeId;
 extern IIdAtom * hash64Utf8Id;
 extern IIdAtom * hash64VStrId;
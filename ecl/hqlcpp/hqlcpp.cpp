@@ -9278,6 +9278,20 @@ public:
     {
         if ((func == hash32DataId) || (func == hash64DataId))
         {
+            //Internal hashes (e.g., for a hash dedup or aggregate) are never persisted, so use the quicker block hash for
+            //anything longer than a few bytes.  It is not a streaming hash - hashing adjacent fields in a single call gives
+            //a different value - so each of these fields is hashed separately, ensuring a row and its extracted key match.
+            if (optimizeInternal)
+            {
+                unsigned fixedSize = (unsigned)getIntValue(length, 0);
+                if ((func == hash64DataId) || (fixedSize == 0) || (fixedSize > 8))
+                {
+                    flush(ctx);
+                    buildCall(ctx, (func == hash32DataId) ? hash32FastDataId : hash64FastDataId, length, ptr);
+                    return;
+                }
+            }
+
             ptr = stripTranslatedCasts(ptr);
             if (prevFunc)
             {
@@ -2142,6 +2142,26 @@ protected:
     HqlExprArray tracedActivities;
 };
 
+//Records the time taken by a transformation pass (if timeTransforms is set) when it goes out of scope
+class TransformPassTimer
+{
+public:
+    TransformPassTimer(HqlCppTranslator & _translator, const char * _scope)
+        : translator(_translator), scope(_scope), startCycles(get_cycles_now())
+    {
+    }
+    ~TransformPassTimer()
+    {
+        if (translator.queryOptions().timeTransforms)
+            translator.noteFinishedTiming(scope, startCycles);
+    }
+
+private:
+    HqlCppTranslator & translator;
+    const char * scope;
+    cycle_t startCycles;
+};
+
 
 //---------------------------------------------------------------------------------------------------------------------
 
@@ -736,7 +736,15 @@ bool HqlDllGenerator::doCompile(ICppCompiler * compiler)
 
         unsigned __int64 elapsed = cycle_to_nanosec(get_cycles_now() - startCycles);
         updateWorkunitStat(wu, SSToperation, ">compile:>compile c++", StTimeElapsed, NULL, elapsed);
+        if (compiler->getNumObjectCacheHits() || compiler->getNumObjectCacheAdds())
+        {
+            updateWorkunitStat(wu, SSToperation, ">compile:>compile c++", StNumCompileCacheHits, NULL, compiler->getNumObjectCacheHits());
+            updateWorkunitStat(wu, SSToperation, ">compile:>compile c++", StNumCompileCacheAdds, NULL, compiler->getNumObjectCacheAdds());
+        }
     }
+    //The precompiled header is prepared by this process even if the compile itself is performed by the caller
+    if (compiler->getPrecompiledHeaderTimeNs())
+        updateWorkunitStat(wu, SSToperation, ">compile:>compile c++:>precompile header", StTimeElapsed, NULL, compiler->getPrecompiledHeaderTimeNs());
     //Keep the files if there was a compile error.
     if (ok && deleteGenerated)
     {
@@ -14157,6 +14157,7 @@ void HqlCppTranslator::normalizeGraphForGeneration(HqlExprArray & exprs, HqlQuer
         checkWorkflowDuplication(exprs);
 
     {
+        TransformPassTimer timer(*this, ">compile:>transform:>normalize");
         traceExpressions("beforeNormalize", exprs);
         normalizeHqlTree(*this, exprs);
     }
@@ -14194,6 +14195,7 @@ void HqlCppTranslator::applyGlobalOptimizations(HqlExprArray & exprs)
     substituteClusterSize(exprs);
 
     {
+        TransformPassTimer timer(*this, ">compile:>transform:>global fold");
         HqlExprArray folded;
         unsigned foldOptions = DEFAULT_FOLD_OPTIONS;
         if (options.foldConstantDatasets) foldOptions |= HFOconstantdatasets;
@@ -14213,6 +14215,7 @@ void HqlCppTranslator::applyGlobalOptimizations(HqlExprArray & exprs)
 
     if (options.globalOptimize)
     {
+        TransformPassTimer timer(*this, ">compile:>transform:>global optimize");
         HqlExprArray folded;
         optimizeHqlExpression(queryErrorProcessor(), folded, exprs, HOOfold);
         sanityCheckTransformation("Global optimize", exprs, folded);
@@ -14237,17 +14240,20 @@ void HqlCppTranslator::transformWorkflowItem(WorkflowItem & curWorkflow)
 
     if (queryOptions().createImplicitAliases)
     {
+        TransformPassTimer timer(*this, ">compile:>transform:>implicit aliases");
         ImplicitAliasTransformer normalizer;
         normalizer.process(curWorkflow.queryExprs());
         //traceExpressions("afterImplicitAlias", workflow);
     }
 
     {
+        TransformPassTimer timer(*this, ">compile:>transform:>hoist compound");
         hoistNestedCompound(*this, curWorkflow.queryExprs());
     }
 
     if (options.optimizeNestedConditional)
     {
+        TransformPassTimer timer(*this, ">compile:>transform:>nested conditional");
         optimizeNestedConditional(curWorkflow.queryExprs());
         traceExpressions("nested", curWorkflow);
         checkNormalized(curWorkflow);
@@ -14256,6 +14262,7 @@ void HqlCppTranslator::transformWorkflowItem(WorkflowItem & curWorkflow)
     checkNormalized(curWorkflow);
     //sort(x)[n] -> topn(x, n)[]n, count(x)>n -> count(choosen(x,n+1)) > n and possibly others
     {
+        TransformPassTimer timer(*this, ">compile:>transform:>optimize activities");
         optimizeActivities(curWorkflow.queryWfid(), curWorkflow.queryExprs(), !targetThor(), options.optimizeNonEmpty);
     }
     checkNormalized(curWorkflow);
@@ -14263,6 +14270,7 @@ void HqlCppTranslator::transformWorkflowItem(WorkflowItem & curWorkflow)
     //----------------------------- Transformations below this mark may have created globals so be very careful with hoisting ---------------------
 
     {
+        TransformPassTimer timer(*this, ">compile:>transform:>migrate");
         migrateExprToNaturalLevel(curWorkflow, wu(), *this);       // Ensure expressions are evaluated at the best level - e.g., counts moved to most appropriate level.
         //transformToAliases(exprs);
         traceExpressions("migrate", curWorkflow);
@@ -14271,6 +14279,7 @@ void HqlCppTranslator::transformWorkflowItem(WorkflowItem & curWorkflow)
 
     if (!curWorkflow.isFunction())
     {
+        TransformPassTimer timer(*this, ">compile:>transform:>thor boundaries");
         markThorBoundaries(curWorkflow);                                               // work out which engine is going to perform which operation.
         traceExpressions("boundary", curWorkflow);
         checkNormalized(curWorkflow);
@@ -14278,6 +14287,7 @@ void HqlCppTranslator::transformWorkflowItem(WorkflowItem & curWorkflow)
 
     if (options.optimizeGlobalProjects)
     {
+        TransformPassTimer timer(*this, ">compile:>transform:>implicit project");
         insertImplicitProjects(*this, curWorkflow.queryExprs());
         traceExpressions("implicit", curWorkflow);
         checkNormalized(curWorkflow);
@@ -14295,6 +14305,7 @@ void HqlCppTranslator::transformWorkflowItem(WorkflowItem & curWorkflow)
 //  traceExpressions("flatten", workflow);
 
     {
+        TransformPassTimer timer(*this, ">compile:>transform:>merge graphs");
         mergeThorGraphs(curWorkflow, options.resourceConditionalActions, options.resourceSequential);          // reduces number of graphs sent to thor
     }
 
@@ -14304,12 +14315,16 @@ void HqlCppTranslator::transformWorkflowItem(WorkflowItem & curWorkflow)
     if (queryOptions().normalizeLocations)
         normalizeAnnotations(*this, curWorkflow.queryExprs());
 
-    spotGlobalCSE(curWorkflow);                                                        // spot CSE within those graphs, and create some more
+    {
+        TransformPassTimer timer(*this, ">compile:>transform:>global cse");
+        spotGlobalCSE(curWorkflow);                                                    // spot CSE within those graphs, and create some more
+    }
     checkNormalized(curWorkflow);
 
     //expandGlobalDatasets(workflow, wu(), *this);
 
     {
+        TransformPassTimer timer(*this, ">compile:>transform:>remerge graphs");
         mergeThorGraphs(curWorkflow, options.resourceConditionalActions, options.resourceSequential);
     }
     checkNormalized(curWorkflow);
@@ -14388,7 +14403,10 @@ bool HqlCppTranslator::transformGraphForGeneration(HqlQueryContext & query, Work
         WorkflowItem & curWorkflow = workflow.item(i2);
         traceExpressions("beforeConvertLogicalToActivities", curWorkflow);
 
-        convertLogicalToActivities(curWorkflow);                                           // e.g., merge disk reads, transform group, all to sort etc.
+        {
+            TransformPassTimer timer(*this, ">compile:>transform:>convert to activities");
+            convertLogicalToActivities(curWorkflow);                                       // e.g., merge disk reads, transform group, all to sort etc.
+        }
 
     #ifndef _DEBUG
         if (options.regressionTest)
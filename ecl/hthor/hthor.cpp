@@ -66,6 +66,8 @@
 
 static unsigned const hthorReadBufferSize = 0x10000;
 static offset_t const defaultHThorDiskWriteSizeLimit = I64C(10*1024*1024*1024); //10 GB, per Nigel
+static unsigned const defaultHThorStrandBlockSize = 512;
+static unsigned const maxSensibleHThorStrands = 1024;
 
 using roxiemem::IRowManager;
 using roxiemem::OwnedRoxieRow;
@@ -2294,7 +2296,28 @@ const void * CHThorNormalizeLinkedChildActivity::nextRow()
 }
 
 //=====================================================================================================
-CHThorProjectActivity::CHThorProjectActivity(IAgentContext &_agent, unsigned _activityId, unsigned _subgraphId, IHThorProjectArg &_arg, ThorActivityKind _kind, EclGraph & _graph) : CHThorSimpleActivityBase(_agent, _activityId, _subgraphId, _arg, _kind, _graph), helper(_arg)
+CHThorStrandedActivityBase::CHThorStrandedActivityBase(IAgentContext &_agent, unsigned _activityId, unsigned _subgraphId, IHThorArg & _help, ThorActivityKind _kind, EclGraph & _graph) : CHThorSimpleActivityBase(_agent, _activityId, _subgraphId, _help, _kind, _graph)
+{
+}
+
+void CHThorStrandedActivityBase::ready()
+{
+    CHThorSimpleActivityBase::ready();
+    if (!strandBlockSize)
+    {
+        IConstWorkUnit * wu = agent.queryWorkUnit();
+        numStrands = wu->getDebugValueInt("forceNumStrands", 0);
+        if ((numStrands == (unsigned)-1) || (numStrands > maxSensibleHThorStrands))
+            numStrands = getAffinityCpus();
+        strandBlockSize = wu->getDebugValueInt("strandBlockSize", defaultHThorStrandBlockSize);
+        if (!strandBlockSize)
+            strandBlockSize = defaultHThorStrandBlockSize;
+    }
+}
+
+//=====================================================================================================
+
+CHThorProjectActivity::CHThorProjectActivity(IAgentContext &_agent, unsigned _activityId, unsigned _subgraphId, IHThorProjectArg &_arg, ThorActivityKind _kind, EclGraph & _graph) : CHThorStrandedActivityBase(_agent, _activityId, _subgraphId, _arg, _kind, _graph), helper(_arg)
 {
 }
 
@@ -2302,42 +2325,95 @@ CHThorProjectActivity::~CHThorProjectActivity()
 {
 }
 
+void CHThorProjectActivity::createStrands()
+{
+    if (numStrands > 1)
+    {
+        //The branch preserves the order of the rows (and the group boundaries) when they are recombined
+        branch.setown(createStrandBranch(*queryRowManager(), numStrands, strandBlockSize, true, input->isGrouped(), false, nullptr));
+        IStrandJunction * splitter = branch->queryInputJunction();
+        IStrandJunction * recombiner = branch->queryOutputJunction();
+        splitter->setInput(0, &input->queryStream());
+        for (unsigned i=0; i < numStrands; i++)
+        {
+            ProjectStrand * strand = new ProjectStrand(*this, *splitter->queryOutput(i));
+            strands.append(*strand);
+            recombiner->setInput(i, strand);
+        }
+        output = recombiner->queryOutput(0);
+    }
+    else
+    {
+        ProjectStrand * strand = new ProjectStrand(*this, input->queryStream());
+        strands.append(*strand);
+        output = strand;
+    }
+}
+
 void CHThorProjectActivity::ready()
 {
-    CHThorSimpleActivityBase::ready();
-    numProcessedLastGroup = processed;
+    CHThorStrandedActivityBase::ready();
+    if (strands.empty())
+        createStrands();
+    ForEachItemIn(i, strands)
+        strands.item(i).ready();
+    if (branch)
+    {
+        startJunction(branch->queryInputJunction());
+        startJunction(branch->queryOutputJunction());
+    }
 }
 
+void CHThorProjectActivity::stop()
+{
+    if (branch)
+    {
+        //Stopping the recombined output stops each of the strands, and those in turn stop the input
+        output->stop();
+        resetJunction(branch->queryInputJunction());
+        resetJunction(branch->queryOutputJunction());
+    }
+    else
+        CHThorStrandedActivityBase::stop();
+}
 
 const void * CHThorProjectActivity::nextRow()
+{
+    const void * ret = output->nextRow();
+    if (ret)
+        processed++;
+    return ret;
+}
+
+const void * CHThorProjectActivity::ProjectStrand::nextRow()
 {
     for (;;)
     {
-        OwnedConstRoxieRow in(input->nextRow());
+        OwnedConstRoxieRow in(inputStream.nextRow());
         if (!in)
         {
-            if (numProcessedLastGroup == processed)
-                in.setown(input->nextRow());
+            if (numProcessedLastGroup == numProcessed)
+                in.setown(inputStream.nextRow());
             if (!in)
             {
-                numProcessedLastGroup = processed;
+                numProcessedLastGroup = numProcessed;
                 return NULL;
             }
         }
 
         try
         {
-            RtlDynamicRowBuilder rowBuilder(rowAllocator);
-            size32_t outSize = helper.transform(rowBuilder, in);
+            RtlDynamicRowBuilder rowBuilder(parent.rowAllocator);
+            size32_t outSize = parent.helper.transform(rowBuilder, in);
             if (outSize)
             {
-                processed++;
+                numProcessed++;
                 return rowBuilder.finalizeRowClear(outSize);
             }
         }
         catch(IException * e)
         {
-            throw makeWrappedException(e);
+            throw parent.makeWrappedException(e);
         }
     }
 }
@@ -3484,20 +3560,142 @@ const void * CHThorSampleActivity::nextRow()
 
 //=====================================================================================================
 
-CHThorAggregateActivity::CHThorAggregateActivity(IAgentContext &_agent, unsigned _activityId, unsigned _subgraphId, IHThorAggregateArg &_arg, ThorActivityKind _kind, EclGraph & _graph) : CHThorSimpleActivityBase(_agent, _activityId, _subgraphId, _arg, _kind, _graph), helper(_arg)
+CHThorAggregateActivity::CHThorAggregateActivity(IAgentContext &_agent, unsigned _activityId, unsigned _subgraphId, IHThorAggregateArg &_arg, ThorActivityKind _kind, EclGraph & _graph) : CHThorStrandedActivityBase(_agent, _activityId, _subgraphId, _arg, _kind, _graph), helper(_arg)
 {
 }
 
+bool CHThorAggregateActivity::canUseStrands()
+{
+    //EXISTS stops reading as soon as it finds a row, and some aggregates need the partial results to be merged in
+    //input order, so only calculate other ungrouped aggregates on multiple strands.
+    if ((numStrands <= 1) || input->isGrouped() || (kind == TAKexistsaggregate))
+        return false;
+    return (helper.getAggregateFlags() & TAForderedmerge) == 0;
+}
+
 void CHThorAggregateActivity::ready()
 {
-    CHThorSimpleActivityBase::ready();
+    CHThorStrandedActivityBase::ready();
     eof = false;
+    aborting = false;
+    if (!splitter && canUseStrands())
+    {
+        splitter.setown(createStrandJunction(*queryRowManager(), 1, numStrands, strandBlockSize, false));
+        splitter->setInput(0, &input->queryStream());
+        for (unsigned i=0; i < numStrands; i++)
+            strands.append(*new AggregateStrand(*this, *splitter->queryOutput(i)));
+    }
+
+    if (splitter)
+    {
+        ForEachItemIn(i, strands)
+            strands.item(i).reset();
+        splitter->start();
+        barrier.setown(createStrandBarrier());
+        ForEachItemIn(i2, strands)
+            barrier->startStrand(strands.item(i2));
+    }
+}
+
+void CHThorAggregateActivity::stop()
+{
+    if (splitter)
+    {
+        //If the result has not been read then there is no need for the strands to process the rest of the input
+        aborting = true;
+        waitForStrands();
+        resetJunction(splitter);
+    }
+    else
+        CHThorStrandedActivityBase::stop();
+}
+
+void CHThorAggregateActivity::waitForStrands()
+{
+    //Each strand stops its output of the splitter when it finishes, which stops the input once all have finished
+    if (barrier)
+    {
+        barrier->waitForStrands();
+        barrier.clear();
+    }
+}
+
+const void * CHThorAggregateActivity::getCombinedAggregate()
+{
+    waitForStrands();
+    ForEachItemIn(i, strands)
+    {
+        IException * e = strands.item(i).queryException();
+        if (e)
+            throw makeWrappedException(LINK(e));
+    }
+
+    RtlDynamicRowBuilder rowBuilder(rowAllocator);
+    helper.clearAggregate(rowBuilder);
+
+    bool isFirst = true;
+    ForEachItemIn(i2, strands)
+    {
+        const void * next = strands.item(i2).queryResult();
+        if (next)
+        {
+            if (isFirst)
+            {
+                cloneRow(rowBuilder, next, outputMeta.queryOriginal());
+                isFirst = false;
+            }
+            else
+                helper.mergeAggregate(rowBuilder, next);
+        }
+    }
+
+    processed++;
+    size32_t finalSize = outputMeta.getRecordSize(rowBuilder.getSelf());
+    return rowBuilder.finalizeRowClear(finalSize);
+}
+
+void CHThorAggregateActivity::AggregateStrand::threadmain()
+{
+    try
+    {
+        //A strand that does not receive any rows does not generate a result, since it cannot be merged
+        OwnedConstRoxieRow next(inputStream.nextRow());
+        if (next)
+        {
+            RtlDynamicRowBuilder rowBuilder(parent.rowAllocator);
+            parent.helper.clearAggregate(rowBuilder);
+            parent.helper.processFirst(rowBuilder, next);
+
+            while (!parent.aborting)
+            {
+                next.setown(inputStream.nextRow());
+                if (!next)
+                    break;
+
+                parent.helper.processNext(rowBuilder, next);
+            }
+
+            size32_t finalSize = parent.outputMeta.getRecordSize(rowBuilder.getSelf());
+            result.setown(rowBuilder.finalizeRowClear(finalSize));
+        }
+    }
+    catch (IException * e)
+    {
+        exception.setown(e);
+    }
+    parent.barrier->noteStrandFinished(&inputStream);
 }
 
 const void * CHThorAggregateActivity::nextRow()
 {
     if (eof)
         return NULL;
+    if (splitter)
+    {
+        eof = true;
+        return getCombinedAggregate();
+    }
+
     const void * next = input->nextRow();
     if (!next && input->isGrouped())
     {
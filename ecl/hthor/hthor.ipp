@@ -46,6 +46,7 @@
 
 #include "thormeta.hpp"
 #include "thorread.hpp"
+#include "thorstrand.hpp"
 
 roxiemem::IRowManager * queryRowManager();
 using roxiemem::OwnedConstRoxieRow;
@@ -263,6 +264,20 @@ public:
     virtual IOutputMetaData * queryOutputMeta() const;
 };
 
+//Base class for activities that can process their input on multiple threads.  The number of strands is
+//controlled by the forceNumStrands workunit option - 0 or 1 processes the rows on the calling thread.
+class CHThorStrandedActivityBase : public CHThorSimpleActivityBase
+{
+public:
+    CHThorStrandedActivityBase(IAgentContext &agent, unsigned _activityId, unsigned _subgraphId, IHThorArg & _help, ThorActivityKind _kind, EclGraph & _graph);
+
+    virtual void ready();
+
+protected:
+    unsigned numStrands = 0;
+    unsigned strandBlockSize = 0;
+};
+
 class CHThorSteppableActivityBase : public CHThorSimpleActivityBase
 {
 public:
@@ -710,19 +725,45 @@ protected:
 };
 
 
-class CHThorProjectActivity : public CHThorSimpleActivityBase
+class CHThorProjectActivity : public CHThorStrandedActivityBase
 {
+    //Applies the transform to the rows from a single stream - either the input, or one output of the strand branch
+    class ProjectStrand : public CInterfaceOf<IEngineRowStream>
+    {
+    public:
+        ProjectStrand(CHThorProjectActivity & _parent, IEngineRowStream & _inputStream) : parent(_parent), inputStream(_inputStream) {}
+
+        void ready() { numProcessedLastGroup = numProcessed; }
+
+        //interface IEngineRowStream
+        virtual const void *nextRow() override;
+        virtual void stop() override { inputStream.stop(); }
+        virtual void resetEOF() override { inputStream.resetEOF(); }
+
+    protected:
+        CHThorProjectActivity & parent;
+        IEngineRowStream & inputStream;
+        unsigned __int64 numProcessed = 0;
+        unsigned __int64 numProcessedLastGroup = 0;
+    };
+
     IHThorProjectArg &helper;
-    unsigned __int64 numProcessedLastGroup;
+    IArrayOf<ProjectStrand> strands;
+    Owned<IStrandBranch> branch;
+    IEngineRowStream * output = nullptr;
 public:
     CHThorProjectActivity(IAgentContext &agent, unsigned _activityId, unsigned _subgraphId, IHThorProjectArg &_arg, ThorActivityKind _kind, EclGraph & _graph);
     ~CHThorProjectActivity();
 
     virtual void ready();
+    virtual void stop();
     virtual bool needsAllocator() const { return true; }    
 
     //interface IHThorInput
     virtual const void *nextRow();
+
+protected:
+    void createStrands();
 };
 
 class CHThorPrefetchProjectActivity : public CHThorSimpleActivityBase
@@ -914,19 +955,50 @@ public:
     virtual const void *nextRow();
 };
 
-class CHThorAggregateActivity : public CHThorSimpleActivityBase
+class CHThorAggregateActivity : public CHThorStrandedActivityBase
 {
+    //Calculates a partial aggregate from one output of the splitter, which is later merged with the other strands
+    class AggregateStrand : public CInterface, implements IStrandThreaded
+    {
+    public:
+        AggregateStrand(CHThorAggregateActivity & _parent, IEngineRowStream & _inputStream) : parent(_parent), inputStream(_inputStream) {}
+
+        void reset() { result.clear(); exception.clear(); }
+        const void * queryResult() const { return result; }
+        IException * queryException() const { return exception; }
+
+        //interface IStrandThreaded
+        virtual void threadmain() override;
+        virtual void stopStream() override { inputStream.stop(); }
+
+    protected:
+        CHThorAggregateActivity & parent;
+        IEngineRowStream & inputStream;
+        OwnedConstRoxieRow result;
+        Owned<IException> exception;
+    };
+
     IHThorAggregateArg &helper;
+    CIArrayOf<AggregateStrand> strands;
+    Owned<IStrandJunction> splitter;
+    Owned<IStrandBarrier> barrier;
+    std::atomic<bool> aborting{false};
     bool eof = false;
 public:
     CHThorAggregateActivity(IAgentContext &agent, unsigned _activityId, unsigned _subgraphId, IHThorAggregateArg &_arg, ThorActivityKind _kind, EclGraph & _graph);
 
     virtual void ready();
+    virtual void stop();
     virtual bool needsAllocator() const { return true; }    
 
     //interface IHThorInput
     virtual const void *nextRow();
     virtual bool isGrouped()                                            { return false; }
+
+protected:
+    bool canUseStrands();
+    const void * getCombinedAggregate();
+    void waitForStrands();
 };
 
 class CHThorHashAggregateActivity : public CHThorSimpleActivityBase
@@ -40,6 +40,39 @@
 
 IThreadPool* http_thread_pool;
 CHttpThreadPoolFactory* http_pool_factory;
+CHttpRequestReader* http_request_reader;
+
+static constexpr unsigned defaultEventWorkerThreads = 50;
+static constexpr unsigned maxRequestBufferSize = 0x10000;
+static constexpr unsigned requestResumeDelayMs = 100;
+
+static CriticalSection latencyMetricsCrit;
+static std::map<int, std::shared_ptr<hpccMetrics::ScaledHistogramMetric>> latencyMetrics;
+
+// Each binding listens on its own port, so the latency histograms are labelled with the port
+static hpccMetrics::ScaledHistogramMetric* queryRequestLatencyMetric(int port)
+{
+    CriticalBlock block(latencyMetricsCrit);
+    auto match = latencyMetrics.find(port);
+    if (match != latencyMetrics.end())
+        return match->second.get();
+
+    static const std::vector<__uint64> latencyBuckets = {
+        1000000, 2000000, 5000000, 10000000, 20000000, 50000000, 100000000, 200000000, 500000000,
+        1000000000, 2000000000, 5000000000, 10000000000, 30000000000, 60000000000 };
+    VStringBuffer portText("%d", port);
+    hpccMetrics::MetricMetaData metaData{{"port", portText.str()}};
+    auto metric = hpccMetrics::registerCyclesToNsScaledHistogramMetric("esp.http.request.latency", "Time taken to process http requests, from when the request has been read", latencyBuckets, metaData);
+    latencyMetrics[port] = metric;
+    return metric.get();
+}
+
+// The request's server span, if there was one, so the latency can be linked to the trace as an exemplar
+static const ISpan * queryRequestSpan(CEspHttpServer * httpserver)
+{
+    IEspContext * ctx = httpserver->queryContext();
+    return ctx ? ctx->queryActiveSpan() : nullptr;
+}
 
 /**************************************************************************
  *  CHttpProtocol Implementation                                          *
@@ -51,6 +84,13 @@ CHttpProtocol::CHttpProtocol()
 
 CHttpProtocol::~CHttpProtocol()
 {
+    if(http_request_reader)
+    {
+        http_request_reader->stop();
+        http_request_reader->Release();
+        http_request_reader = NULL;
+    }
+
     if(http_thread_pool)
     {
         http_thread_pool->Release();
@@ -83,6 +123,11 @@ void CHttpProtocol::init(IPropertyTree * cfg, const char * process, const char *
             m_threadCreateTimeout = atoi(timeoutstr);
         }
 
+        // Requests are read by a single epoll thread, and then processed by a bounded pool of worker threads
+        bool eventDriven = proc_cfg->getPropBool("@eventDrivenRequests", false);
+        if(eventDriven && m_maxConcurrentThreads <= 0)
+            m_maxConcurrentThreads = defaultEventWorkerThreads;
+
         if(m_maxConcurrentThreads > 0)
         {
             // Could use a mutex, but since all the protocols are instantiated sequentially, not really necessary
@@ -91,6 +136,14 @@ void CHttpProtocol::init(IPropertyTree * cfg, const char * process, const char *
             if(!http_thread_pool)
                 http_thread_pool = createThreadPool("Http Thread", http_pool_factory, NULL, m_maxConcurrentThreads, INFINITE);
         }
+
+        if(eventDriven && !http_request_reader)
+        {
+            unsigned maxQueued = proc_cfg->getPropInt("@maxQueuedRequests", 1000);
+            unsigned readTimeout = proc_cfg->getPropInt("@requestReadTimeout", 60);
+            http_request_reader = new CHttpRequestReader(http_thread_pool, maxQueued, readTimeout * 1000);
+            http_request_reader->start();
+        }
     }
 
     initPersistentHandler(proc_cfg);
@@ -117,6 +170,8 @@ bool CHttpProtocol::notifySelected(ISocket *sock,unsigned selected, IPersistentH
 
         if(apport == NULL)
             throw MakeStringException(-1, "binding not found!");
+
+        hpccMetrics::ScaledHistogramMetric* latencyMetric = queryRequestLatencyMetric(port);
         
         if(apport != NULL)
         {
@@ -134,10 +189,15 @@ bool CHttpProtocol::notifySelected(ISocket *sock,unsigned selected, IPersistentH
                 DBGLOG("HTTP connection from %s:%d on %s socket", peername, port, persistentHandler?"persistent":"new");
     #endif          
 
-                if(m_maxConcurrentThreads > 0)
+                if(http_request_reader)
+                {
+                    // The request is passed to the thread pool once it has been completely received
+                    http_request_reader->add(accepted, apport, persistentHandler, shouldClose, getMaxRequestEntityLength(), latencyMetric);
+                }
+                else if(m_maxConcurrentThreads > 0)
                 {
                     // Using Threading pool instead of generating one thread per request.
-                    void ** holder = new void*[7];
+                    void ** holder = new void*[11];
                     holder[0] = (void*)(accepted.getLink());
                     holder[1] = (void*)apport;
                     int maxEntityLength = getMaxRequestEntityLength();
@@ -148,6 +208,12 @@ bool CHttpProtocol::notifySelected(ISocket *sock,unsigned selected, IPersistentH
                     holder[4] = (void*)ctx;
                     holder[5] = (void*)persistentHandler;
                     holder[6] = (void*)&shouldClose;
+                    unsigned __int64 requestLength = 0;
+                    holder[7] = (void*)&requestLength;
+                    holder[8] = (void*)latencyMetric;
+                    cycle_t startCycles = get_cycles_now();
+                    holder[9] = (void*)&startCycles;
+                    holder[10] = nullptr;
                     try
                     {
                         http_thread_pool->start((void*)holder, "", m_threadCreateTimeout > 0?m_threadCreateTimeout*1000:0);
@@ -175,6 +241,7 @@ bool CHttpProtocol::notifySelected(ISocket *sock,unsigned selected, IPersistentH
                     CHttpThread *workthread = new CHttpThread(accepted.getLink(), apport, CEspProtocol::getViewConfig(), false, nullptr, persistentHandler);
                     workthread->setMaxRequestEntityLength(getMaxRequestEntityLength());
                     workthread->setShouldClose(shouldClose);
+                    workthread->setLatencyMetric(latencyMetric);
                     workthread->start();
                     workthread->Release();
                 }
@@ -253,6 +320,13 @@ CSecureHttpProtocol::CSecureHttpProtocol(IPropertyTree* cfg)
 
 CSecureHttpProtocol::~CSecureHttpProtocol()
 {
+    if(http_request_reader)
+    {
+        http_request_reader->stop();
+        http_request_reader->Release();
+        http_request_reader = NULL;
+    }
+
     if(http_thread_pool)
     {
         http_thread_pool->Release();
@@ -311,6 +385,8 @@ bool CSecureHttpProtocol::notifySelected(ISocket *sock,unsigned selected, IPersi
         CEspApplicationPort *apport = queryApplicationPort(port);
         if(apport == NULL)
             throw MakeStringException(-1, "binding not found!");
+
+        hpccMetrics::ScaledHistogramMetric* latencyMetric = queryRequestLatencyMetric(port);
         
         if(apport != NULL)
         {
@@ -329,7 +405,7 @@ bool CSecureHttpProtocol::notifySelected(ISocket *sock,unsigned selected, IPersi
                     if(m_maxConcurrentThreads > 0)
                     {
                         // Using Threading pool instead of generating one thread per request.
-                        void ** holder = new void*[7];
+                        void ** holder = new void*[11];
                         holder[0] = (void*)accepted.getLink();
                         holder[1] = (void*)apport;
                         int maxEntityLength = getMaxRequestEntityLength();
@@ -339,6 +415,12 @@ bool CSecureHttpProtocol::notifySelected(ISocket *sock,unsigned selected, IPersi
                         holder[4] = (void*)m_ssctx.get();
                         holder[5] = (void*)persistentHandler;
                         holder[6] = (void*)&shouldClose;
+                        unsigned __int64 requestLength = 0;
+                        holder[7] = (void*)&requestLength;
+                        holder[8] = (void*)latencyMetric;
+                        cycle_t startCycles = get_cycles_now();
+                        holder[9] = (void*)&startCycles;
+                        holder[10] = nullptr;
                         http_thread_pool->start((void*)holder);
                         delete [] holder;
                     }
@@ -348,6 +430,7 @@ bool CSecureHttpProtocol::notifySelected(ISocket *sock,unsigned selected, IPersi
                         CHttpThread *workthread = new CHttpThread(accepted.getLink(), apport, CEspProtocol::getViewConfig(), true, m_ssctx.get(), persistentHandler);
                         workthread->setMaxRequestEntityLength(getMaxRequestEntityLength());
                         workthread->setShouldClose(shouldClose);
+                        workthread->setLatencyMetric(latencyMetric);
                         workthread->start();
                         ESPLOG(LogMax, "Request processing thread started.");
                         workthread->Release();
@@ -469,11 +552,14 @@ bool CHttpThread::onRequest()
     time_t t = time(NULL);  
     initThreadLocal(sizeof(t), &t);
 
+    cycle_t startCycles = get_cycles_now();
     m_httpserver = httpserver;
     httpserver->setSocketReturner(this);
     httpserver->setIsSSL(m_is_ssl);
     httpserver->setShouldClose(m_shouldClose);
     httpserver->processRequest();
+    if (m_latencyMetric)
+        m_latencyMetric->recordMeasurement(get_cycles_now() - startCycles, queryRequestSpan(httpserver));
 
     returnSocket(false);
 
@@ -520,6 +606,14 @@ void CPooledHttpThread::init(void *param)
     m_ssctx = (ISecureSocketContext*)(((void**)param)[4]);
     m_persistentHandler = (IPersistentHandler*)(((void**)param)[5]);
     m_shouldClose = *(bool*)(((void**)param)[6]);
+    m_requestLength = *(unsigned __int64*)(((void**)param)[7]);
+    m_latencyMetric = (hpccMetrics::ScaledHistogramMetric*)(((void**)param)[8]);
+    m_startCycles = *(cycle_t*)(((void**)param)[9]);
+    MemoryBuffer* received = (MemoryBuffer*)(((void**)param)[10]);
+    if (received)
+        m_received.swapWith(*received);
+    else
+        m_received.clear();
     m_httpserver = nullptr;
     m_processAborted = false;
     m_socketReturned = false;
@@ -575,6 +669,10 @@ void CPooledHttpThread::threadmain()
     m_httpserver = httpserver;
     httpserver->setShouldClose(m_shouldClose);
     httpserver->setSocketReturner(this);
+    if (m_requestLength)
+        httpserver->setRequestLength(m_requestLength);
+    if (m_received.length())
+        httpserver->setReceivedData(m_received);
     time_t t = time(NULL);  
     initThreadLocal(sizeof(t), &t);
     try
@@ -595,6 +693,9 @@ void CPooledHttpThread::threadmain()
         IERRLOG("General Exception - in CPooledHttpThread::threadmain().");
     }
 
+    if (m_latencyMetric)
+        m_latencyMetric->recordMeasurement(get_cycles_now() - m_startCycles, queryRequestSpan(httpserver));
+
     returnSocket();
 
     clearThreadLocal();
@@ -643,3 +744,383 @@ void CPooledHttpThread::returnSocket()
         IERRLOG("General Exception - CPooledHttpThread::threadmain(), closing socket.");
     }
 }
+
+/**************************************************************************
+ *  CHttpRequestReader Implementation                                     *
+ **************************************************************************/
+CHttpRequestReader::CHttpRequestReader(IThreadPool* workers, unsigned maxQueued, unsigned readTimeoutMs)
+    : m_workers(workers), m_maxQueued(maxQueued), m_readTimeoutMs(readTimeoutMs)
+{
+    m_selectHandler.setown(createSocketEpollHandler("HttpRequestReader"));
+    m_dispatcher.setown(new CDispatchThread(*this));
+}
+
+CHttpRequestReader::~CHttpRequestReader()
+{
+    stop();
+}
+
+void CHttpRequestReader::start()
+{
+    m_selectHandler->start();
+    m_dispatcher->start();
+}
+
+void CHttpRequestReader::stop()
+{
+    if (m_stopping.exchange(true))
+        return;
+    m_readySem.signal();
+    m_dispatcher->join();
+    m_selectHandler->stop(true);
+
+    CriticalBlock block(m_crit);
+    for (auto& cur : m_pending)
+        discard(cur.second);
+    m_pending.clear();
+    m_numPaused = 0;
+    for (auto& cur : m_ready)
+        discard(cur);
+    m_ready.clear();
+}
+
+void CHttpRequestReader::add(ISocket* sock, CEspApplicationPort* apport, IPersistentHandler* persistentHandler, bool shouldClose, int maxEntityLength, hpccMetrics::ScaledHistogramMetric* latencyMetric)
+{
+    Owned<PendingConnection> conn = new PendingConnection;
+    conn->sock.set(sock);
+    conn->apport = apport;
+    conn->persistentHandler = persistentHandler;
+    conn->shouldClose = shouldClose;
+    conn->maxEntityLength = maxEntityLength;
+    conn->latencyMetric = latencyMetric;
+    conn->startTime = msTick();
+    {
+        CriticalBlock block(m_crit);
+        m_pending[sock].setown(conn.getClear());
+    }
+    m_selectHandler->add(sock, SELECTMODE_READ, this);
+}
+
+// Read whatever has arrived since the last notification, without blocking, and check whether the request is complete
+CHttpRequestReader::ReadState CHttpRequestReader::readRequest(PendingConnection* conn, bool& progress)
+{
+    progress = false;
+    MemoryBuffer& received = conn->received;
+    int flags = 0;
+#ifdef MSG_DONTWAIT
+    flags |= MSG_DONTWAIT;
+#endif
+    for (;;)
+    {
+        // Until the headers are complete the whole buffer can be used, after that only the rest of the request is read
+        size32_t limit = conn->headerLength ? (size32_t)conn->requestLength : maxRequestBufferSize;
+        size32_t have = received.length();
+        // Headers that do not fit in the buffer are left to the request parser to reject
+        if (have >= limit)
+            return ReadState::Complete;
+
+        char* target = (char*)received.ensureCapacity(limit - have);
+        int got = ::recv(conn->sock->OShandle(), target, limit - have, flags);
+        if (got == 0)
+            return ReadState::Closed;
+        if (got < 0)
+        {
+            int err = SOCKETERRNO();
+#ifdef _WIN32
+            if (err == WSAEINTR)
+                continue;
+            if (err == WSAEWOULDBLOCK)
+#else
+            if (err == EINTR)
+                continue;
+            if (err == EAGAIN || err == EWOULDBLOCK)
+#endif
+                return ReadState::Incomplete;
+            return ReadState::Closed;
+        }
+
+        received.setLength(have + got);
+        progress = true;
+        if (!conn->headerLength && parseHeaders(conn))
+            return ReadState::Complete;
+    }
+}
+
+// Search the data that has not already been checked for the end of the headers.  Returns true if the request should be
+// processed as soon as the headers have been received.
+bool CHttpRequestReader::parseHeaders(PendingConnection* conn)
+{
+    const char* data = conn->received.toByteArray();
+    size32_t available = conn->received.length();
+    size32_t headerLength = 0;
+    size32_t i = conn->scanned;
+    for (; i + 1 < available; i++)
+    {
+        if (data[i] != '\n')
+            continue;
+        if (data[i+1] == '\n')
+        {
+            headerLength = i + 2;
+            break;
+        }
+        if (data[i+1] == '\r')
+        {
+            if (i + 2 >= available)
+                break;
+            if (data[i+2] == '\n')
+            {
+                headerLength = i + 3;
+                break;
+            }
+        }
+    }
+    conn->scanned = i;
+    if (!headerLength)
+        return false;
+
+    unsigned __int64 contentLength = 0;
+    bool chunked = false;
+    bool expectContinue = false;
+    const char* line = data;
+    const char* end = data + headerLength;
+    while (line < end)
+    {
+        const char* eol = (const char*)memchr(line, '\n', end - line);
+        if (!eol)
+            break;
+        const char* colon = (const char*)memchr(line, ':', eol - line);
+        if (colon)
+        {
+            size32_t nameLen = colon - line;
+            const char* value = colon + 1;
+            while (value < eol && isspace(*value))
+                value++;
+            if (nameLen == 14 && strnicmp(line, "Content-Length", nameLen) == 0)
+                contentLength = strtoull(value, nullptr, 10);
+            else if (nameLen == 17 && strnicmp(line, "Transfer-Encoding", nameLen) == 0)
+                chunked = true;
+            else if (nameLen == 6 && strnicmp(line, "Expect", nameLen) == 0)
+                expectContinue = true;
+        }
+        line = eol + 1;
+    }
+
+    conn->headerLength = headerLength;
+    // The end of a chunked request is only known by parsing it, so it is processed as soon as the headers arrive
+    if (chunked)
+    {
+        conn->requestLength = 0;
+        return true;
+    }
+
+    conn->requestLength = headerLength + contentLength;
+    // If the client is waiting for a 100-continue, or the body is too large to buffer, then pass it on now
+    return expectContinue || (conn->requestLength > maxRequestBufferSize);
+}
+
+bool CHttpRequestReader::notifySelected(ISocket* sock, unsigned selected)
+{
+    Linked<PendingConnection> conn;
+    {
+        CriticalBlock block(m_crit);
+        auto match = m_pending.find(sock);
+        if (match != m_pending.end())
+            conn.set(match->second);
+    }
+    if (!conn)
+    {
+        // Already expired, or dispatched
+        m_selectHandler->remove(sock);
+        return false;
+    }
+
+    bool progress;
+    ReadState state = readRequest(conn, progress);
+    if (state == ReadState::Incomplete)
+    {
+        // Everything available has been read, so the (level triggered) handler will not report the socket again until
+        // more data arrives.  If it is reported without any new data, stop polling it for a while rather than spinning.
+        if (!progress)
+        {
+            m_selectHandler->remove(sock);
+            CriticalBlock block(m_crit);
+            auto match = m_pending.find(sock);
+            if ((match != m_pending.end()) && (match->second.get() == conn.get()))
+            {
+                conn->paused = true;
+                conn->resumeTime = msTick() + requestResumeDelayMs;
+                m_numPaused++;
+                m_readySem.signal();    // so the dispatcher resumes it promptly
+            }
+        }
+        return false;
+    }
+
+    {
+        CriticalBlock block(m_crit);
+        auto match = m_pending.find(sock);
+        if ((match == m_pending.end()) || (match->second.get() != conn.get()))
+            return false;   // Expired while it was being read
+        m_pending.erase(match);
+    }
+    m_selectHandler->remove(sock);
+
+    if (state == ReadState::Closed)
+    {
+        discard(conn);
+        return false;
+    }
+
+    if (conn->requestLength && (conn->received.length() > conn->requestLength))
+    {
+        // The start of a pipelined request was read with this one, and cannot be returned to the socket.  Answer this
+        // request and close the connection - the client resends any requests that were not answered.
+        conn->received.setLength((size32_t)conn->requestLength);
+        conn->shouldClose = true;
+    }
+
+    conn->readyCycles = get_cycles_now();
+    {
+        CriticalBlock block(m_crit);
+        if (m_ready.size() < m_maxQueued)
+        {
+            m_ready.emplace_back(conn.getClear());
+            m_readySem.signal();
+            return false;
+        }
+    }
+
+    OWARNLOG("HTTP request queue is full (%u requests), rejecting request", m_maxQueued);
+    static const char busyResponse[] = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    try
+    {
+        sock->write(busyResponse, sizeof(busyResponse)-1);
+    }
+    catch (IException* e)
+    {
+        e->Release();
+    }
+    discard(conn);
+    return false;
+}
+
+void CHttpRequestReader::dispatchRequests()
+{
+    unsigned lastExpiryCheck = msTick();
+    while (!m_stopping)
+    {
+        if (m_readySem.wait(m_numPaused ? requestResumeDelayMs : 1000))
+        {
+            Owned<PendingConnection> conn;
+            {
+                CriticalBlock block(m_crit);
+                if (!m_ready.empty())
+                {
+                    conn.setown(m_ready.front().getClear());
+                    m_ready.pop_front();
+                }
+            }
+            // Blocks until a worker is available, so the pool limits the number of requests being processed
+            if (conn)
+                startWorker(conn);
+        }
+
+        resumeConnections();
+        if (msTick() - lastExpiryCheck >= 1000)
+        {
+            expireConnections();
+            lastExpiryCheck = msTick();
+        }
+    }
+}
+
+void CHttpRequestReader::startWorker(PendingConnection* conn)
+{
+    void ** holder = new void*[10];
+    holder[0] = (void*)conn->sock.getLink();
+    holder[1] = (void*)conn->apport;
+    holder[2] = (void*)&conn->maxEntityLength;
+    bool useSSL = false;
+    holder[3] = (void*)&useSSL;
+    holder[4] = nullptr;
+    holder[5] = (void*)conn->persistentHandler;
+    holder[6] = (void*)&conn->shouldClose;
+    holder[7] = (void*)&conn->requestLength;
+    holder[8] = (void*)conn->latencyMetric;
+    holder[9] = (void*)&conn->readyCycles;
+    holder[10] = (void*)&conn->received;
+    try
+    {
+        m_workers->start((void*)holder);
+    }
+    catch (IException* e)
+    {
+        StringBuffer estr;
+        IERRLOG("Exception(%d, %s) starting thread from http thread pool.", e->errorCode(), e->errorMessage(estr).str());
+        e->Release();
+        //As in CHttpProtocol::notifySelected(), if start() throws the thread has not taken ownership of the link
+        CInterface* ci = dynamic_cast<CInterface*>(conn->sock.get());
+        if(ci && ci->IsShared())
+            conn->sock->Release();
+        discard(conn);
+    }
+    delete [] holder;
+}
+
+void CHttpRequestReader::expireConnections()
+{
+    std::vector<Owned<PendingConnection>> expired;
+    unsigned now = msTick();
+    {
+        CriticalBlock block(m_crit);
+        for (auto it = m_pending.begin(); it != m_pending.end();)
+        {
+            if (now - it->second->startTime >= m_readTimeoutMs)
+            {
+                if (it->second->paused)
+                    m_numPaused--;
+                expired.emplace_back(it->second.getClear());
+                it = m_pending.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+    for (auto& conn : expired)
+    {
+        ESPLOG(LogNormal, "Closing HTTP connection %d, request not received within %u seconds", conn->sock->OShandle(), m_readTimeoutMs / 1000);
+        m_selectHandler->remove(conn->sock);
+        discard(conn);
+    }
+}
+
+void CHttpRequestReader::resumeConnections()
+{
+    std::vector<Linked<ISocket>> resumed;
+    {
+        CriticalBlock block(m_crit);
+        if (!m_numPaused)
+            return;
+        unsigned now = msTick();
+        for (auto& cur : m_pending)
+        {
+            PendingConnection* conn = cur.second;
+            if (conn->paused && ((int)(now - conn->resumeTime) >= 0))
+            {
+                conn->paused = false;
+                m_numPaused--;
+                resumed.emplace_back(conn->sock);
+            }
+        }
+    }
+    // If a connection expires before it is added it is removed again when it is next reported
+    for (auto& sock : resumed)
+        m_selectHandler->add(sock, SELECTMODE_READ, this);
+}
+
+void CHttpRequestReader::discard(PendingConnection* conn)
+{
+    if (conn->persistentHandler)
+        conn->persistentHandler->doneUsing(conn->sock, false);
+    conn->sock->shutdownNoThrow();
+}
@@ -31,11 +31,14 @@
 #include "espprotocol.hpp"
 #include "http/platform/httpbinding.hpp"
 #include "securesocket.hpp"
+#include "jmetrics.hpp"
 
 //STL
 #include <algorithm>
 #include <string>
 #include <map>
+#include <deque>
+#include <unordered_map>
 
 class CPooledHttpThread : public CInterface, implements IPooledThread, implements ISocketReturner
 {
@@ -51,6 +54,10 @@ private:
     IHttpServerService* m_httpserver = nullptr;
     bool m_socketReturned = false;
     bool m_processAborted = false;
+    unsigned __int64 m_requestLength = 0;
+    MemoryBuffer m_received;
+    hpccMetrics::ScaledHistogramMetric* m_latencyMetric = nullptr;
+    cycle_t m_startCycles = 0;
 public:
     IMPLEMENT_IINTERFACE;
 
@@ -95,6 +102,7 @@ private:
     bool m_shouldClose = false;
     IHttpServerService* m_httpserver = nullptr;
     bool m_httpSocketReturned = false;
+    hpccMetrics::ScaledHistogramMetric* m_latencyMetric = nullptr;
     void returnSocket(bool cascade);
 
 public:
@@ -107,9 +115,80 @@ public:
     virtual int getMaxRequestEntityLength() { return m_MaxRequestEntityLength; }
 
     void setShouldClose(bool should) {m_shouldClose = should;}
+    void setLatencyMetric(hpccMetrics::ScaledHistogramMetric* metric) {m_latencyMetric = metric;}
     virtual void returnSocket();
 };
 
+// Waits for requests on all the connections with a single epoll handler, and only passes a connection to the
+// worker pool once a complete request has arrived.  Slow clients, and clients that connect and send nothing,
+// therefore do not occupy worker threads.  The request is examined with MSG_PEEK so the worker still reads it
+// from the socket, but the worker is told the length of the request so that it never consumes any pipelined
+// request that follows - that is seen by this reader once the socket is returned to the persistent handler.
+class CHttpRequestReader : public CInterface, implements ISocketSelectNotify
+{
+private:
+    struct PendingConnection : public CInterface
+    {
+        Linked<ISocket> sock;
+        CEspApplicationPort* apport = nullptr;
+        IPersistentHandler* persistentHandler = nullptr;
+        hpccMetrics::ScaledHistogramMetric* latencyMetric = nullptr;
+        int maxEntityLength = 0;
+        bool shouldClose = false;
+        bool paused = false;                   // removed from the select handler until resumeTime
+        unsigned startTime = 0;
+        unsigned resumeTime = 0;
+        MemoryBuffer received;                 // the start of the request, read from the socket so far
+        size32_t scanned = 0;                  // how much of received has been searched for the end of the headers
+        size32_t headerLength = 0;             // 0 until the headers have been received
+        unsigned __int64 requestLength = 0;    // 0 if not known, e.g. a chunked request
+        cycle_t readyCycles = 0;
+    };
+
+    class CDispatchThread : public Thread
+    {
+        CHttpRequestReader& owner;
+    public:
+        CDispatchThread(CHttpRequestReader& _owner) : Thread("HttpRequestDispatch"), owner(_owner) {}
+        virtual int run() override { owner.dispatchRequests(); return 0; }
+    };
+
+    enum class ReadState { Incomplete, Complete, Closed };
+
+    Owned<ISocketSelectHandler> m_selectHandler;
+    Owned<CDispatchThread> m_dispatcher;
+    IThreadPool* m_workers;
+    CriticalSection m_crit;
+    std::unordered_map<ISocket*, Owned<PendingConnection>> m_pending;
+    std::deque<Owned<PendingConnection>> m_ready;
+    std::atomic<unsigned> m_numPaused{0};
+    Semaphore m_readySem;
+    unsigned m_maxQueued;
+    unsigned m_readTimeoutMs;
+    std::atomic<bool> m_stopping{false};
+
+    ReadState readRequest(PendingConnection* conn, bool& progress);
+    bool parseHeaders(PendingConnection* conn);
+    void dispatchRequests();
+    void startWorker(PendingConnection* conn);
+    void expireConnections();
+    void resumeConnections();
+    void discard(PendingConnection* conn);
+
+public:
+    IMPLEMENT_IINTERFACE_USING(CInterface);
+
+    CHttpRequestReader(IThreadPool* workers, unsigned maxQueued, unsigned readTimeoutMs);
+    ~CHttpRequestReader();
+
+    void start();
+    void stop();
+    void add(ISocket* sock, CEspApplicationPort* apport, IPersistentHandler* persistentHandler, bool shouldClose, int maxEntityLength, hpccMetrics::ScaledHistogramMetric* latencyMetric);
+
+//ISocketSelectNotify
+    virtual bool notifySelected(ISocket* sock, unsigned selected) override;
+};
+
 class esp_http_decl CHttpProtocol : public CEspProtocol
 {
 private:
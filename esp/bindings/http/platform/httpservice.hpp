@@ -167,6 +167,8 @@ public:
     bool persistentEligible();
     void setIsSSL(bool _isSSL) { isSSL = _isSSL; };
     void setShouldClose(bool should) { shouldClose = should; }
+    void setRequestLength(unsigned __int64 len) { m_request->setReadLimit(len); }
+    void setReceivedData(const MemoryBuffer & data) { m_request->setInitialData(data); }
     void setSocketReturner(ISocketReturner* returner)
     {
         m_socketReturner = returner;
@@ -285,6 +285,8 @@ public:
     virtual bool decompressContent(StringBuffer* originalContent, int compressType) { return false; }
     virtual void setSocketReturner(ISocketReturner* returner) { m_socketReturner = returner; }
     virtual ISocketReturner* querySocketReturner() { return m_socketReturner; }
+    virtual void setReadLimit(unsigned __int64 limit) { m_bufferedsocket->setReadLimit(limit); }
+    virtual void setInitialData(const MemoryBuffer & data) { m_bufferedsocket->setInitialData(data.toByteArray(), data.length()); }
     virtual StringBuffer& getStatus(StringBuffer& status) { return status; }
 
 };
@@ -62,6 +62,8 @@ interface IEsdlTransformer : extends IInterface
     virtual int process(IEspContext &ctx, EsdlProcessMode mode, const char* service, const char *method, IPropertyTree &in, IXmlWriterExt * writer, unsigned int flags, const char *ns=NULL)=0;
     virtual int processElement(IEspContext &ctx, const char* service, const char *parentStructName, IXmlWriterExt * writer, const char *xmlin)=0;
     virtual void processHPCCResult(IEspContext &ctx, IEsdlDefMethod &mthdef, const char *xml, IXmlWriterExt * writer, StringBuffer &logdata, unsigned int flags = 0, const char *ns=NULL, const char *schema_location=NULL)=0;
+    // Build the transform plans for every method of the service for a client version, so the first requests do not have to
+    virtual void precompile(const char *service, double clientVersion)=0;
 };
 
 esdl_decl IEsdlTransformer *createEsdlXFormerFromXMLFiles(StringArray &files, StringArray &types);
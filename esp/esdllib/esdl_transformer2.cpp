@@ -194,6 +194,26 @@ Esdl2Base::Esdl2Base(Esdl2Transformer *xformer, IEsdlDefObject* def, EsdlBasicEl
         xml_tag.set(def->queryProp("xml_tag"));
     if (xml_tag.isEmpty())
         xml_tag.set(queryName());
+
+    ecl_null.set(def->queryProp("ecl_null"));
+    const char *verstr = def->queryProp("depr_ver");
+    if (verstr)
+    {
+        has_depr_ver = true;
+        depr_ver = atof(verstr);
+    }
+    verstr = def->queryProp("max_ver");
+    if (verstr)
+    {
+        has_max_ver = true;
+        max_ver = atof(verstr);
+    }
+    verstr = def->queryProp("min_ver");
+    if (verstr)
+    {
+        has_min_ver = true;
+        min_ver = atof(verstr);
+    }
 }
 
 Esdl2Base::~Esdl2Base()
@@ -232,8 +252,8 @@ void Esdl2Base::serialize_attributes(StringBuffer &out)
     }
 }
 
-// return true if it passed optional check and version check
-bool Esdl2Base::checkVersion(Esdl2TransformerContext &ctx)
+// return true if it passed optional check - the version check is inVersion()
+bool Esdl2Base::checkOptional(Esdl2TransformerContext &ctx)
 {
     if (!param_group.isEmpty())
     {
@@ -248,7 +268,7 @@ bool Esdl2Base::checkVersion(Esdl2TransformerContext &ctx)
                 return false;
         }
     }
-    return m_def->checkVersion(ctx.client_ver);
+    return true;
 }
 
 void Esdl2Base::countContent(Esdl2TransformerContext &ctx)
@@ -648,7 +668,8 @@ Esdl2Array::Esdl2Array(Esdl2Transformer *xformer, IEsdlDefObject *def) : Esdl2Ba
     inited=false;
 
     IEsdlDefArray* defArray = dynamic_cast<IEsdlDefArray*>(def);
-    isEsdlList = defArray->checkIsEsdlList();
+    is_esdl_list = defArray->checkIsEsdlList();
+    flat_array = def->hasProp("flat_array");
 
     const char *atype = def->queryProp("type");
     if (atype)
@@ -694,8 +715,6 @@ void Esdl2Array::process(Esdl2TransformerContext &ctx, IPropertyTree *pt, const
     if (!inited)
         init(ctx);
 
-    bool flat_array = m_def->hasProp("flat_array");
-
     if (data_for && data_for->checkVersion(ctx))
     {
         throw MakeStringException(-1, "EsdlElement::process(pt):%s: IPTree version of data_for not implemented", queryName());
@@ -719,7 +738,7 @@ void Esdl2Array::process(Esdl2TransformerContext &ctx, IPropertyTree *pt, const
         if (ctx.writer->length() != curlen && count)
             ctx.counter++;
     }
-    else if (isEsdlList)
+    else if (is_esdl_list)
     {
         int curlen = ctx.writer->length();
         const char *tagname = queryOutputName(ctx);
@@ -776,8 +795,6 @@ void Esdl2Array::process(Esdl2TransformerContext &ctx, const char *out_name, Esd
     if (!inited)
         init(ctx);
 
-    bool flat_array = m_def->hasProp("flat_array");
-
     if (data_for && data_for->checkVersion(ctx))
     {
         ESDL_DBG("DataFor %s processed", data_for->queryName());
@@ -804,7 +821,7 @@ void Esdl2Array::process(Esdl2TransformerContext &ctx, const char *out_name, Esd
         if (ctx.writer->length() != curlen && count)
             ctx.counter++;
     }
-    else if (isEsdlList)
+    else if (is_esdl_list)
     {
         int curlen = ctx.writer->length();
         const char *tagname = queryOutputName(ctx);
@@ -932,22 +949,16 @@ void Esdl2Struct::process(Esdl2TransformerContext &ctx, IPropertyTree *pt, const
         unsigned curlen = ctx.writer->length();
 
         Esdl2LocalContext local;
-        ForEachItemIn(idx, m_children)
+        Owned<Esdl2StructPlan> plan = getPlan(ctx.client_ver);
+        for (Esdl2Base *pchild : plan->children)
         {
-            Esdl2Base &child = m_children.item(idx);
-            if (child.checkVersion(ctx))
+            Esdl2Base &child = *pchild;
+            if (child.checkOptional(ctx))
             {
                 const char *tagname = child.queryInputName(ctx);
                 if (pt->hasProp(tagname)||child.hasDefaults())
                 {
-                    bool isEsdlList = false;
-                    IEsdlDefObject*  def = child.queryEsdlDefObject();
-                    if (def->getEsdlType() == EsdlTypeArray)
-                    {
-                        IEsdlDefArray* defArray = dynamic_cast<IEsdlDefArray*>(def);
-                        isEsdlList = defArray->checkIsEsdlList();
-                    }
-                    if (!isEsdlList)
+                    if (!child.isEsdlList())
                         child.process(ctx, pt->queryPropTree(tagname), child.queryOutputName(ctx), &local, count);
                     else
                     {
@@ -1032,6 +1043,7 @@ void Esdl2Struct::process(Esdl2TransformerContext &ctx, const char *out_name, Es
         unsigned esdlListItemCount = 0;
         Esdl2LocalContext local;
         StringBuffer completeContent;
+        Owned<Esdl2StructPlan> plan = getPlan(ctx.client_ver);
         for (int type=ctx.xppp->next(); type!=XmlPullParser::END_TAG; type=ctx.xppp->next())
         {
             switch(type)
@@ -1055,28 +1067,7 @@ void Esdl2Struct::process(Esdl2TransformerContext &ctx, const char *out_name, Es
                     {
                         local.m_startTag = &child_start;
 
-                        Esdl2Base *child = queryChild(child_start.getLocalName());
-                        if (!child || !child->checkVersion(ctx))
-                        {
-                            if(ctx.mode==EsdlRequestMode)
-                            {
-                                EsdlBaseArrayPtr * arrayPtr = xml_tags.getValue(child_start.getLocalName());
-                                if(arrayPtr && *arrayPtr)
-                                {
-                                    EsdlBaseArray& array = **arrayPtr;
-
-                                    ForEachItemIn(idx, array)
-                                    {
-                                        Esdl2Base *base = &array.item(idx);
-                                        if(base->checkVersion(ctx))
-                                        {
-                                            child = base;
-                                            break;
-                                        }
-                                    }
-                                }
-                            }
-                        }
+                        Esdl2Base *child = selectChild(ctx, *plan, child_start.getLocalName());
 
                         if (!child && type_id==ESDLT_RESPONSE && strieq("Row", child_start.getLocalName()))
                             child = queryChild("response", true);
@@ -1102,19 +1093,11 @@ void Esdl2Struct::process(Esdl2TransformerContext &ctx, const char *out_name, Es
                                 }
                             }
 
-                            if (esdlListName.isEmpty())
+                            if (esdlListName.isEmpty() && child->isEsdlList())
                             {
-                                IEsdlDefObject*  def = child->queryEsdlDefObject();
-                                if (def->getEsdlType() == EsdlTypeArray)
-                                {
-                                    IEsdlDefArray* defArray = dynamic_cast<IEsdlDefArray*>(def);
-                                    if (defArray->checkIsEsdlList())
-                                    {
-                                        ctx.writer->outputBeginArray(tagName);
-                                        esdlListName.set(tagName);
-                                        esdlListItemCount++;
-                                    }
-                                }
+                                ctx.writer->outputBeginArray(tagName);
+                                esdlListName.set(tagName);
+                                esdlListItemCount++;
                             }
                             chd.process(ctx, NULL, &local);
 
@@ -1181,6 +1164,110 @@ void Esdl2Struct::process(Esdl2TransformerContext &ctx, const char *out_name, Es
     }
 }
 
+Esdl2StructPlan *Esdl2Struct::compilePlan(double ver)
+{
+    Owned<Esdl2StructPlan> plan = new Esdl2StructPlan;
+    auto addEntry = [&plan](const char *tag) -> Esdl2PlanEntry &
+    {
+        const unsigned *match = plan->tagMap.getValue(tag);
+        if (match)
+            return plan->entries[*match];
+        plan->tagMap.setValue(tag, (unsigned)plan->entries.size());
+        plan->entries.emplace_back();
+        return plan->entries.back();
+    };
+
+    ForEachItemIn(idx, m_children)
+    {
+        Esdl2Base &child = m_children.item(idx);
+        bool inVer = child.inVersion(ver);
+        if (inVer)
+            plan->children.push_back(&child);
+        Esdl2PlanEntry &entry = addEntry(child.queryName());
+        entry.named = &child;
+        entry.namedInVersion = inVer;
+    }
+
+    HashIterator xti(xml_tags);
+    for (xti.first(); xti.isValid(); xti.next())
+    {
+        IMapping &m = xti.query();
+        EsdlBaseArrayPtr *arrayPtr = xml_tags.mapToValue(&m);
+        if (!arrayPtr || !*arrayPtr)
+            continue;
+        Esdl2PlanEntry &entry = addEntry((const char *)m.getKey());
+        ForEachItemIn(idx, **arrayPtr)
+        {
+            Esdl2Base &base = (*arrayPtr)->item(idx);
+            if (base.inVersion(ver))
+                entry.alternates.push_back(&base);
+        }
+    }
+    return plan.getClear();
+}
+
+Esdl2StructPlan *Esdl2Struct::getPlan(double ver)
+{
+    {
+        ReadLockBlock block(planLock);
+        auto match = plans.find(ver);
+        if (match != plans.end())
+            return LINK(match->second.get());
+    }
+
+    Owned<Esdl2StructPlan> plan = compilePlan(ver);
+    WriteLockBlock block(planLock);
+    auto match = plans.find(ver);
+    if (match != plans.end())
+        return LINK(match->second.get());
+    // Clients can request any version, so limit how many plans are retained
+    if (plans.size() < maxCachedPlans)
+        plans[ver].set(plan);
+    return plan.getClear();
+}
+
+// Equivalent to queryChild() followed by a check of the version, and then the xml_tag alternatives in request mode
+Esdl2Base *Esdl2Struct::selectChild(Esdl2TransformerContext &ctx, const Esdl2StructPlan &plan, const char *tag)
+{
+    const Esdl2PlanEntry *entry = plan.queryEntry(tag);
+    if (!entry)
+        return nullptr;
+    Esdl2Base *child = entry->named;
+    if (child && entry->namedInVersion && child->checkOptional(ctx))
+        return child;
+    if (ctx.mode==EsdlRequestMode)
+    {
+        for (Esdl2Base *alternate : entry->alternates)
+        {
+            if (alternate->checkOptional(ctx))
+                return alternate;
+        }
+    }
+    return child;
+}
+
+void Esdl2Struct::precompile(Esdl2Transformer *xformer, double ver, std::set<Esdl2Base *> &visited)
+{
+    if (!visited.insert(this).second)
+        return;
+    Owned<Esdl2StructPlan> plan = getPlan(ver);
+    for (Esdl2Base *child : plan->children)
+    {
+        IEsdlDefObject *def = child->queryEsdlDefObject();
+        const char *typeName = nullptr;
+        if (def->getEsdlType() == EsdlTypeElement)
+            typeName = def->queryProp("complex_type");
+        else if (def->getEsdlType() == EsdlTypeArray)
+            typeName = def->queryProp("type");
+        if (typeName)
+        {
+            Esdl2Struct *type = dynamic_cast<Esdl2Struct *>(xformer->queryType(typeName));
+            if (type)
+                type->precompile(xformer, ver, visited);
+        }
+    }
+}
+
 void Esdl2Struct::processElement(Esdl2TransformerContext &ctx)
 {
     ESDL_DBG("Esdl2Struct::processElement: %s", queryName());
@@ -1535,6 +1622,28 @@ Esdl2Base* Esdl2Transformer::queryType(const char* name)
     return NULL;
 }
 
+void Esdl2Transformer::precompile(const char *service, double clientVersion)
+{
+    IEsdlDefService *svc = m_def->queryService(service);
+    if (!svc)
+        return;
+    std::set<Esdl2Base *> visited;
+    Owned<IEsdlDefMethodIterator> it = svc->getMethods();
+    ForEach(*it)
+    {
+        IEsdlDefMethod &method = it->query();
+        if (!method.checkVersion(clientVersion))
+            continue;
+        const char *types[] = { method.queryRequestType(), method.queryResponseType() };
+        for (const char *typeName : types)
+        {
+            Esdl2Struct *type = typeName ? dynamic_cast<Esdl2Struct *>(queryType(typeName)) : nullptr;
+            if (type)
+                type->precompile(this, clientVersion, visited);
+        }
+    }
+}
+
 Esdl2Transformer::~Esdl2Transformer()
 {
     ForEachItemIn(idx, types)
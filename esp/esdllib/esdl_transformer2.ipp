@@ -25,6 +25,8 @@
 #include "esdl_transformer.hpp"
 #include <xpp/XmlPullParser.h>
 #include <map>
+#include <set>
+#include <vector>
 #include "esp.hpp"
 #include "soapesp.hpp"
 #include "ws_ecl_client.hpp"
@@ -140,6 +142,16 @@ protected:
     bool might_skip_root;
     bool count_output = false;
     bool count_value = false;
+    bool is_esdl_list = false;
+
+    // Resolved from the definition once, rather than looking up and parsing the properties for every element
+    StringAttr ecl_null;
+    double min_ver = 0.0;
+    double max_ver = 0.0;
+    double depr_ver = 0.0;
+    bool has_min_ver = false;
+    bool has_max_ver = false;
+    bool has_depr_ver = false;
 
 public:
     Esdl2Base(Esdl2Transformer *xformer, IEsdlDefObject* def, EsdlBasicElementType t=ESDLT_UNKOWN, bool might_skip_root_=false);
@@ -172,7 +184,7 @@ public:
     const char* queryDefaultValueS() { const char* s = m_def->queryProp("default"); return s?s:""; }
 
     const char *queryEclName() { return m_def->queryProp("ecl_name"); }
-    const char* queryEclNull() { return m_def->queryProp("ecl_null"); }
+    const char* queryEclNull() { return ecl_null.get(); }
     const char* queryInputName(Esdl2TransformerContext &ctx){if (ctx.flags & ESDL_TRANS_INPUT_XMLTAG) return xml_tag.get(); else return queryName();}
     const char* queryOutputName(Esdl2TransformerContext &ctx){if (ctx.flags & ESDL_TRANS_OUTPUT_XMLTAG) return xml_tag.get(); else return queryName();}
     Esdl2Base*   queryDataFor() { return data_for; }
@@ -185,8 +197,24 @@ public:
     bool hasDataFrom() { return m_hasDataFrom; }
     void setHasDataFrom() { m_hasDataFrom = true; }
 
+    bool isEsdlList() const { return is_esdl_list; }
+
     // return true if it passed version check
-    bool checkVersion(Esdl2TransformerContext &ctx);
+    bool checkVersion(Esdl2TransformerContext &ctx) { return checkOptional(ctx) && inVersion(ctx.client_ver); }
+    bool checkOptional(Esdl2TransformerContext &ctx);
+    bool inVersion(double ver) const
+    {
+        if (ver >= 0.0)
+        {
+            if (has_depr_ver && ver >= depr_ver)
+                return false;
+            if (has_max_ver && ver > max_ver)
+                return false;
+            if (has_min_ver && ver < min_ver)
+                return false;
+        }
+        return true;
+    }
 
     void countContent(Esdl2TransformerContext &ctx);
 
@@ -310,7 +338,7 @@ class Esdl2Array : public Esdl2Base
 
     bool inited;
     bool type_unknown;
-    bool isEsdlList;
+    bool flat_array;
 
 public:
     Esdl2Array(Esdl2Transformer *xformer, IEsdlDefObject *def);
@@ -327,6 +355,30 @@ public:
     virtual void process(Esdl2TransformerContext &ctx, IPropertyTree *pt, const char *out_name, Esdl2LocalContext* local=NULL,bool count=false);
 };
 
+// The children of a struct that are present in one client version, with the name and xml_tag lookups resolved,
+// so that processing a request does not need to check the version of every child or search the xml_tags.
+// Only the optional (param_group) checks depend on the request.
+struct Esdl2PlanEntry
+{
+    Esdl2Base *named = nullptr;                 // child with this name, even if it is not in this version
+    bool namedInVersion = false;
+    std::vector<Esdl2Base *> alternates;        // children in this version with this xml_tag (request mode only)
+};
+
+class Esdl2StructPlan : public CInterface
+{
+public:
+    std::vector<Esdl2Base *> children;          // children in this version, in definition order
+    std::vector<Esdl2PlanEntry> entries;
+    MapStringTo<unsigned> tagMap;               // tag -> index in entries
+
+    const Esdl2PlanEntry *queryEntry(const char *tag) const
+    {
+        const unsigned *match = tagMap.getValue(tag);
+        return match ? &entries[*match] : nullptr;
+    }
+};
+
 class Esdl2Struct : public Esdl2Base
 {
 protected:
@@ -338,6 +390,13 @@ private:
     EsdlBaseMap   m_child_map;
     EsdlBaseMap   m_child_nocasemap;
 
+    static constexpr unsigned maxCachedPlans = 32;
+    ReadWriteLock planLock;
+    std::map<double, Owned<Esdl2StructPlan>> plans;
+
+    Esdl2StructPlan *compilePlan(double ver);
+    Esdl2Base *selectChild(Esdl2TransformerContext &ctx, const Esdl2StructPlan &plan, const char *tag);
+
 public:
     Esdl2Struct(Esdl2Transformer *xformer, IEsdlDefStruct *def, EsdlBasicElementType t=ESDLT_STRUCT);
     virtual ~Esdl2Struct();
@@ -366,6 +425,9 @@ public:
 
     virtual void addChildren(Esdl2Transformer *xformer, IEsdlDefObjectIterator *it);
     Esdl2Base*  queryChild(const char* name, bool nocase=false);
+
+    Esdl2StructPlan *getPlan(double ver);
+    void precompile(Esdl2Transformer *xformer, double ver, std::set<Esdl2Base *> &visited);
 };
 
 class Esdl2Request : public Esdl2Struct
@@ -507,6 +569,7 @@ public:
     virtual int process(IEspContext &ctx, EsdlProcessMode mode, const char* service, const char *method, IPropertyTree &in, IXmlWriterExt * writer, unsigned int flags, const char *ns);
     virtual int processElement(IEspContext &ctx, const char* service, const char *parentStructName, IXmlWriterExt * writer, const char *in);
     virtual void processHPCCResult(IEspContext &ctx, IEsdlDefMethod &mthdef, const char *xml, IXmlWriterExt * writer, StringBuffer &logdata, unsigned int flags = 0, const char *ns=NULL, const char *schema_location=NULL);
+    virtual void precompile(const char *service, double clientVersion);
 };
 
 #endif
@@ -175,6 +175,8 @@ public: // IEsdlScriptContext
     {
         return (!traceOptionsScopes.empty() && traceOptionsScopes.back().second);
     }
+    virtual void setTraceTimingEnabled(bool enabled) override { traceTiming = enabled; }
+    virtual bool isTraceTimingEnabled() const override { return traceTiming && isTraceEnabled(); }
 
 protected:
     virtual void pushMaskerScope() override
@@ -215,6 +217,7 @@ private:
     Owned<ISectionalXmlDocModel>  docModel;
     bool                          traceToStdout = false;
     bool                          testMode = false;
+    bool                          traceTiming = false;
     Owned<CModularTracer>         tracer;
     Owned<IModularTraceMsgSink>   jlogSink;
     Owned<IModularTraceMsgSink>   consoleSink;
@@ -495,7 +498,12 @@ public:
     }
     virtual bool process(IEsdlScriptContext * scriptContext, IXpathContext * targetContext, IXpathContext * sourceContext) override
     {
-        return exec(nullptr, nullptr, scriptContext, targetContext, sourceContext);
+        if (!scriptContext->isTraceTimingEnabled())
+            return exec(nullptr, nullptr, scriptContext, targetContext, sourceContext);
+        cycle_t startCycles = get_cycles_now();
+        bool ret = exec(nullptr, nullptr, scriptContext, targetContext, sourceContext);
+        traceElapsed(scriptContext, startCycles);
+        return ret;
     }
     virtual IInterface *prepareForAsync(IEsdlScriptContext * scriptContext, IXpathContext * targetContext, IXpathContext * sourceContext) override
     {
@@ -513,6 +521,17 @@ public:
     {
         esdlOperationError(code, m_tagname, msg, m_traceName, true);
     }
+
+protected:
+    //Times include any child operations, so nested operations are reported individually and as part of their parent
+    void traceElapsed(IEsdlScriptContext * scriptContext, cycle_t startCycles) const
+    {
+        double elapsedMs = cycle_to_nanosec(get_cycles_now() - startCycles) / 1000000.0;
+        if (m_traceName.isEmpty())
+            scriptContext->tracerRef().log(MCuserInfo, "timing %s %.3fms", m_tagname.str(), elapsedMs);
+        else
+            scriptContext->tracerRef().log(MCuserInfo, "timing %s '%s' %.3fms", m_tagname.str(), m_traceName.str(), elapsedMs);
+    }
 };
 
 class CEsdlTransformOperationWithChildren : public CEsdlTransformOperationBase
@@ -1254,8 +1273,12 @@ public:
         //if process is called here we are not currently a child of "synchronize", but because we do support synchronize
         //  we keep our state isolated.  Therefor unlike other operations we still need to prepare our "pre async" state object before calling exec
         //  in future additional operations may be optimized for synchronize in this way.
+        cycle_t startCycles = get_cycles_now();
         Owned<IInterface> state = prepareForAsync(scriptContext, targetContext, sourceContext);
-        return exec(nullptr, state, scriptContext, targetContext, sourceContext);
+        bool ret = exec(nullptr, state, scriptContext, targetContext, sourceContext);
+        if (scriptContext->isTraceTimingEnabled())
+            traceElapsed(scriptContext, startCycles);
+        return ret;
     }
 
     virtual bool exec(CriticalSection *crit, IInterface *preparedForAsync, IEsdlScriptContext * scriptContext, IXpathContext * targetContext, IXpathContext * sourceContext) override
@@ -3562,6 +3585,7 @@ void processServiceAndMethodTransforms(IEsdlScriptContext * scriptCtx, std::init
     }
 
     bool strictParams = scriptCtx->getXPathBool("config/*/@strictParams", false);
+    scriptCtx->setTraceTimingEnabled(scriptCtx->getXPathBool("config/*/@traceTimings", false));
     Owned<IXpathContext> sourceContext = scriptCtx->createXpathContext(nullptr, srcSection, strictParams);
 
     StringArray prefixes;
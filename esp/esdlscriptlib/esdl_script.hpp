@@ -124,6 +124,23 @@ interface IEsdlScriptContext : extends ISectionalXmlDocModel
      */
     virtual bool isTraceLocked() const = 0;
 
+    /**
+     * @brief Enable or disable reporting the elapsed time of each operation.
+     *
+     * Timings are reported through the tracer, and only while the `trace` operation is enabled.
+     *
+     * @param enabled
+     */
+    virtual void setTraceTimingEnabled(bool enabled) = 0;
+
+    /**
+     * @brief Should the elapsed time of each operation be traced?
+     *
+     * @return true  timing is enabled and tracing is enabled
+     * @return false otherwise
+     */
+    virtual bool isTraceTimingEnabled() const = 0;
+
 protected:
     /**
      * @brief Helper class encapsulating the use of `pushMaskerScope` and `popMaskerScope`.
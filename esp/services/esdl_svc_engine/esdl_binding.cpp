@@ -2060,6 +2060,8 @@ bool EsdlBindingImpl::reloadDefinitionsFromCentralStore(IPropertyTree * esdlBndC
 
         m_esdl.setown(tempESDLDef.getClear());
         m_pESDLService->setEsdlTransformer(createEsdlXFormer(m_esdl));
+        if (m_defaultSvcVersion.length())
+            m_pESDLService->m_pEsdlTransformer->precompile(m_espServiceName.get(), atof(m_defaultSvcVersion.str()));
 
         return true;
     }
@@ -2208,7 +2210,12 @@ void EsdlBindingImpl::addService(IPropertyTree *esdlArchive, const char * name,
                 }
 
                 if (srvdef)
+                {
                     initEsdlServiceInfo(*srvdef);
+                    // Build the transform plans for the default client version now, rather than on the first requests
+                    if (m_defaultSvcVersion.length())
+                        m_pESDLService->m_pEsdlTransformer->precompile(name, atof(m_defaultSvcVersion.str()));
+                }
 
                 configureProxies(m_esdlBndCfg, name);
 
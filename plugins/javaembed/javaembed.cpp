@@ -418,6 +418,9 @@ public:
     jboolean IsAssignableFrom(jclass clazz1, jclass clazz2) {
         return checkException(functions->IsAssignableFrom(this,clazz1,clazz2));
     }
+    jboolean IsInstanceOf(jobject obj, jclass clazz) {
+        return checkException(functions->IsInstanceOf(this,obj,clazz));
+    }
     jclass GetObjectClass(jobject obj)
     {
         return checkException(JNIEnv::GetObjectClass(obj));
@@ -481,6 +484,15 @@ public:
         checkException();
         return result;
     }
+    jint CallIntMethod(jobject obj, jmethodID methodID, ...) {
+        va_list args;
+        jint result;
+        va_start(args,methodID);
+        result = functions->CallIntMethodV(this,obj,methodID,args);
+        va_end(args);
+        checkException();
+        return result;
+    }
     jboolean CallBooleanMethod(jobject obj, jmethodID methodID, ...)
     {
         va_list args;
@@ -604,6 +616,14 @@ public:
     {
         return checkException(JNIEnv::NewStringUTF(utf));
     }
+    jobject NewDirectByteBuffer(void *address, jlong capacity)
+    {
+        return checkException(JNIEnv::NewDirectByteBuffer(address, capacity));
+    }
+    void *GetDirectBufferAddress(jobject buf)
+    {
+        return checkException(JNIEnv::GetDirectBufferAddress(buf));
+    }
     jfieldID FromReflectedField(jobject field)
     {
         return checkException(JNIEnv::FromReflectedField(field));
@@ -741,6 +761,12 @@ static jclass throwableClass;
 //static jmethodID throwable_toString; and others declared above
 static jclass stackTraceElementClass;
 static jclass langIllegalArgumentExceptionClass;
+static jclass byteBufferClass;
+static jmethodID byteBuffer_position;
+static jmethodID byteBuffer_limit;
+static jmethodID byteBuffer_order;
+static jmethodID byteBuffer_allocate;
+static jobject nativeByteOrder;
 
 static void forceGC(CheckedJNIEnv* JNIenv)
 {
@@ -784,6 +810,15 @@ static void setupGlobals(CheckedJNIEnv *J)
         utilIteratorClass = J->FindGlobalClass("java/util/Iterator");
 
         langIllegalArgumentExceptionClass = J->FindGlobalClass("java/lang/IllegalArgumentException");
+
+        byteBufferClass = J->FindGlobalClass("java/nio/ByteBuffer");
+        byteBuffer_position = J->GetMethodID(byteBufferClass, "position", "()I");
+        byteBuffer_limit = J->GetMethodID(byteBufferClass, "limit", "()I");
+        byteBuffer_order = J->GetMethodID(byteBufferClass, "order", "(Ljava/nio/ByteOrder;)Ljava/nio/ByteBuffer;");
+        byteBuffer_allocate = J->GetStaticMethodID(byteBufferClass, "allocate", "(I)Ljava/nio/ByteBuffer;");
+        jclass byteOrderClass = J->FindClass("java/nio/ByteOrder");
+        jmethodID byteOrder_nativeOrder = J->GetStaticMethodID(byteOrderClass, "nativeOrder", "()Ljava/nio/ByteOrder;");
+        nativeByteOrder = J->NewGlobalRef(J->CallStaticObjectMethod(byteOrderClass, byteOrder_nativeOrder), "nativeByteOrder");
     }
     catch (IException *E)
     {
@@ -1908,9 +1943,16 @@ protected:
 
 //----------------------------------------------------------------------
 
-// Wrap an IRowStream into a Java Iterator
+// Wrap an IRowStream into a Java Iterator. The iterator is proxied by a com.HPCCSystems.HpccUtils object
+
+class ECLDatasetIteratorBase : public CInterfaceOf<IInterface>
+{
+public:
+    virtual bool hasNext() = 0;
+    virtual jobject next() = 0;
+};
 
-class ECLDatasetIterator : public CInterfaceOf<IInterface>
+class ECLDatasetIterator : public ECLDatasetIteratorBase
 {
 public:
     ECLDatasetIterator(CheckedJNIEnv *JNIenv, const RtlTypeInfo *_typeInfo, jclass className, IRowStream * _val)
@@ -1921,7 +1963,7 @@ public:
         nextRead = false;
     }
 
-    bool hasNext()
+    virtual bool hasNext() override
     {
         if (!nextRead)
         {
@@ -1933,7 +1975,7 @@ public:
         return nextPending != NULL;
     }
 
-    jobject next()
+    virtual jobject next() override
     {
         if (!hasNext())
             return NULL;
@@ -1950,6 +1992,76 @@ protected:
     bool nextRead;
 };
 
+// Pass a dataset with fixed-size rows to Java in blocks. Each block is a direct ByteBuffer (in native byte order)
+// containing a whole number of rows in their ECL layout, so that JNI is crossed once per block rather than once per
+// row and field. The memory behind a block is reused, so a block is only valid until the next one is requested.
+
+static constexpr size32_t defaultJavaBatchSize = 0x10000;
+
+class ECLDatasetBatchIterator : public ECLDatasetIteratorBase
+{
+public:
+    ECLDatasetBatchIterator(IRowStream * _val, size32_t _rowSize, size32_t batchSize)
+    : val(_val), rowSize(_rowSize)
+    {
+        assertex(rowSize);
+        rowsPerBatch = batchSize / rowSize;
+        if (!rowsPerBatch)
+            rowsPerBatch = 1;
+    }
+
+    virtual bool hasNext() override
+    {
+        if (!nextRead)
+        {
+            batch.clear();
+            if (val)
+            {
+                for (unsigned i = 0; i < rowsPerBatch; i++)
+                {
+                    roxiemem::OwnedConstRoxieRow row = val->ungroupedNextRow();
+                    if (!row)
+                    {
+                        val->stop();
+                        val.clear();
+                        break;
+                    }
+                    batch.append(rowSize, row.get());
+                }
+            }
+            nextRead = true;
+        }
+        return batch.length() != 0;
+    }
+
+    virtual jobject next() override
+    {
+        if (!hasNext())
+            return NULL;
+        nextRead = false;
+        CheckedJNIEnv *JNIenv = queryJNIEnv();
+        // hasNext() guarantees the batch is not empty - a direct buffer needs a valid address
+        assertex(batch.length() && batch.bufferBase());
+        jobject buffer = JNIenv->NewDirectByteBuffer(batch.bufferBase(), batch.length());
+        JNIenv->DeleteLocalRef(JNIenv->CallObjectMethod(buffer, byteBuffer_order, nativeByteOrder));
+        return buffer;
+    }
+
+    // An empty dataset is passed as an empty heap buffer, since a direct buffer cannot be created without any data
+    static jobject createEmptyBuffer(CheckedJNIEnv *JNIenv)
+    {
+        jobject buffer = JNIenv->CallStaticObjectMethod(byteBufferClass, byteBuffer_allocate, (jint) 0);
+        JNIenv->DeleteLocalRef(JNIenv->CallObjectMethod(buffer, byteBuffer_order, nativeByteOrder));
+        return buffer;
+    }
+protected:
+    Linked<IRowStream> val;
+    MemoryBuffer batch;
+    size32_t rowSize;
+    unsigned rowsPerBatch;
+    bool nextRead = false;
+};
+
 //-------------------------------------------
 
 // A Java function that returns a dataset will return a JavaRowStream object that can be
@@ -1977,10 +2089,13 @@ public:
     : resultAllocator(_resultAllocator)
     {
         CheckedJNIEnv *JNIenv = queryJNIEnv();
-        iterator = JNIenv->NewGlobalRef(_iterator, "iterator");
-        iterClass = (jclass) JNIenv->NewGlobalRef(JNIenv->GetObjectClass(iterator), "iterClass");
-        hasNextMethod = JNIenv->GetMethodID(iterClass, "hasNext", "()Z" );
-        nextMethod = JNIenv->GetMethodID(iterClass, "next", "()Ljava/lang/Object;" );
+        if (_iterator)
+        {
+            iterator = JNIenv->NewGlobalRef(_iterator, "iterator");
+            iterClass = (jclass) JNIenv->NewGlobalRef(JNIenv->GetObjectClass(iterator), "iterClass");
+            hasNextMethod = JNIenv->GetMethodID(iterClass, "hasNext", "()Z" );
+            nextMethod = JNIenv->GetMethodID(iterClass, "next", "()Ljava/lang/Object;" );
+        }
         // Note that we can't save the JNIEnv value here - calls may be made on different threads (though not at the same time).
     }
     ~JavaRowStream()
@@ -1989,34 +2104,73 @@ public:
     }
     virtual const void *nextRow()
     {
-        if (!iterator)
-            return NULL;
-        CheckedJNIEnv *JNIenv = queryJNIEnv();
-        JavaLocalFrame lf(JNIenv);
-        // Java code would be
-        // if (!iterator.hasNext)
-        // {
-        //    stop();
-        //    return NULL;
-        // }
-        // result = iterator.next();
-        jboolean hasNext = JNIenv->CallBooleanMethod(iterator, hasNextMethod);
-        if (!hasNext)
-        {
-            stop();
-            return NULL;
+        for (;;)
+        {
+            if (nextBatchRow < batchRows.ordinality())
+                return batchRows.item(nextBatchRow++);
+            if (!iterator)
+            {
+                stop();
+                return NULL;
+            }
+            CheckedJNIEnv *JNIenv = queryJNIEnv();
+            JavaLocalFrame lf(JNIenv);
+            // Java code would be
+            // if (!iterator.hasNext)
+            // {
+            //    stop();
+            //    return NULL;
+            // }
+            // result = iterator.next();
+            jboolean hasNext = JNIenv->CallBooleanMethod(iterator, hasNextMethod);
+            if (!hasNext)
+            {
+                stop();
+                return NULL;
+            }
+            jobject result = JNIenv->CallObjectMethod(iterator, nextMethod);
+            if (result && JNIenv->IsInstanceOf(result, byteBufferClass))
+            {
+                setBatch(JNIenv, result);
+                continue;
+            }
+            RtlDynamicRowBuilder rowBuilder(resultAllocator);
+            const RtlTypeInfo *typeInfo = resultAllocator->queryOutputMeta()->queryTypeInfo();
+            assertex(typeInfo);
+            RtlFieldStrInfo dummyField("<row>", NULL, typeInfo);
+            JavaRowBuilder javaRowBuilder(queryJNIEnv(), &dummyField, result);
+            size32_t len = typeInfo->build(rowBuilder, 0, &dummyField, javaRowBuilder);
+            return rowBuilder.finalizeRowClear(len);
+        }
+    }
+    void setBatch(CheckedJNIEnv *JNIenv, jobject buffer)
+    {
+        // A block of rows in ECL format, from position() to limit() of a direct ByteBuffer
+        IOutputMetaData *meta = resultAllocator->queryOutputMeta();
+        if (!meta->isFixedSize())
+            throw MakeStringException(0, "javaembed: ByteBuffer results are only supported for fixed-size records");
+        const byte *base = (const byte *) JNIenv->GetDirectBufferAddress(buffer);
+        if (!base)
+            throw MakeStringException(0, "javaembed: ByteBuffer results must use direct buffers");
+        jint position = JNIenv->CallIntMethod(buffer, byteBuffer_position);
+        jint limit = JNIenv->CallIntMethod(buffer, byteBuffer_limit);
+        size32_t rowSize = meta->getFixedSize();
+        if ((limit - position) % rowSize)
+            throw MakeStringException(0, "javaembed: ByteBuffer result of %d bytes is not a multiple of the record size %u", limit - position, rowSize);
+
+        // The rows are copied straight away.  The buffer may be (or be a slice of) an input block, whose memory is
+        // reused when the next input block is requested, and freed when the function context is destroyed.
+        releaseBatch();
+        for (const byte *cur = base + position; cur < base + limit; cur += rowSize)
+        {
+            RtlDynamicRowBuilder rowBuilder(resultAllocator);
+            memcpy(rowBuilder.getSelf(), cur, rowSize);
+            batchRows.append(rowBuilder.finalizeRowClear(rowSize));
         }
-        jobject result = JNIenv->CallObjectMethod(iterator, nextMethod);
-        RtlDynamicRowBuilder rowBuilder(resultAllocator);
-        const RtlTypeInfo *typeInfo = resultAllocator->queryOutputMeta()->queryTypeInfo();
-        assertex(typeInfo);
-        RtlFieldStrInfo dummyField("<row>", NULL, typeInfo);
-        JavaRowBuilder javaRowBuilder(queryJNIEnv(), &dummyField, result);
-        size32_t len = typeInfo->build(rowBuilder, 0, &dummyField, javaRowBuilder);
-        return rowBuilder.finalizeRowClear(len);
     }
     virtual void stop()
     {
+        releaseBatch();
         resultAllocator.clear();
         CheckedJNIEnv *JNIenv = queryJNIEnv();
         if (JNIenv)
@@ -2037,11 +2191,20 @@ public:
     }
 
 protected:
+    void releaseBatch()
+    {
+        while (nextBatchRow < batchRows.ordinality())
+            ReleaseRoxieRow(batchRows.item(nextBatchRow++));
+        batchRows.kill();
+        nextBatchRow = 0;
+    }
     Linked<IEngineRowAllocator> resultAllocator;
     jobject iterator = nullptr;
     jclass iterClass = nullptr;
     jmethodID hasNextMethod = nullptr;
     jmethodID nextMethod = nullptr;
+    ConstPointerArray batchRows;     // Rows copied from the last ByteBuffer returned by Java
+    unsigned nextBatchRow = 0;
 };
 
 const char *esdl2JavaSig(IEsdlDefinition &esdl, const char *esdlType)
@@ -3667,6 +3830,13 @@ public:
     }
     virtual IRowStream *getDatasetResult(IEngineRowAllocator * _resultAllocator)
     {
+        if (result.l && JNIenv->IsInstanceOf(result.l, byteBufferClass))
+        {
+            // A single block containing all the result rows
+            Owned<JavaRowStream> ret = new JavaRowStream(nullptr, _resultAllocator);
+            ret->setBatch((CheckedJNIEnv *) JNIenv, result.l);
+            return ret.getClear();
+        }
         jclass iterClass =JNIenv->GetObjectClass(result.l);
         if (!JNIenv->IsAssignableFrom(iterClass, utilIteratorClass))
         {
@@ -4117,6 +4287,20 @@ public:
                 argsig += 20;
                 break;
             }
+            if (strncmp(argsig, "Ljava/nio/ByteBuffer;", 21) == 0)
+            {
+                // Pass in all the rows as a single block
+                argsig += 21;
+                if (!metaVal.isFixedSize())
+                    typeError("DATASET of fixed-size records");
+                ECLDatasetBatchIterator *batch = new ECLDatasetBatchIterator(val, metaVal.getFixedSize(), (size32_t) -1);
+                iterators.append(*batch);
+                v.l = batch->next();
+                if (!v.l)
+                    v.l = ECLDatasetBatchIterator::createEmptyBuffer(JNIenv);
+                addArg(v);
+                return;
+            }
             /* no break */
         default:
             typeError("DATASET");
@@ -4166,8 +4350,19 @@ public:
             // Create a java object of type com.HPCCSystems.HpccUtils - this acts as a proxy for the iterator
             JNIenv->ExceptionClear();
             jvalue param;
-            const RtlTypeInfo *typeInfo = metaVal.queryTypeInfo();
-            ECLDatasetIterator *iterator = new ECLDatasetIterator((CheckedJNIEnv *) JNIenv, typeInfo, loadClass(className), val);
+            ECLDatasetIteratorBase *iterator;
+            if (streq(className, "java/nio/ByteBuffer"))
+            {
+                // An iterator of ByteBuffers receives the rows in blocks
+                if (!metaVal.isFixedSize())
+                    typeError("DATASET of fixed-size records");
+                iterator = new ECLDatasetBatchIterator(val, metaVal.getFixedSize(), defaultJavaBatchSize);
+            }
+            else
+            {
+                const RtlTypeInfo *typeInfo = metaVal.queryTypeInfo();
+                iterator = new ECLDatasetIterator((CheckedJNIEnv *) JNIenv, typeInfo, loadClass(className), val);
+            }
             param.j = (jlong) iterator;
             iterators.append(*iterator);
             jobject proxy = JNIenv->NewObject(hpccIteratorClass, hi_constructor, param, JNIenv->NewStringUTF(helperLibraryName));
@@ -4663,7 +4858,7 @@ protected:
     jvalue result = {0};
     StringAttr classpath;
     StringBuffer classname;
-    IArrayOf<ECLDatasetIterator> iterators;   // to make sure they get freed
+    IArrayOf<ECLDatasetIteratorBase> iterators;   // to make sure they get freed
     bool nonStatic = false;
     jobject instance = nullptr; // class instance of object to call methods on
     const IThorActivityContext *activityContext = nullptr;
@@ -5132,7 +5327,7 @@ JNIEXPORT jboolean JNICALL Java_com_HPCCSystems_HpccUtils__1hasNext (JNIEnv *JNI
 {
     try
     {
-        javaembed::ECLDatasetIterator *e = (javaembed::ECLDatasetIterator *) proxy;
+        javaembed::ECLDatasetIteratorBase *e = (javaembed::ECLDatasetIteratorBase *) proxy;
         return e->hasNext();
     }
     catch (IException *E)
@@ -5149,7 +5344,7 @@ JNIEXPORT jobject JNICALL Java_com_HPCCSystems_HpccUtils__1next (JNIEnv *JNIenv,
 {
     try
     {
-        javaembed::ECLDatasetIterator *e = (javaembed::ECLDatasetIterator *) proxy;
+        javaembed::ECLDatasetIteratorBase *e = (javaembed::ECLDatasetIteratorBase *) proxy;
         return e->next();
     }
     catch (IException *E)
@@ -43,6 +43,7 @@
 #include "roxiemem.hpp"
 #include "enginecontext.hpp"
 #include <regex>
+#include <vector>
 
 #if defined (__linux__) || defined(__FreeBSD__)  || defined(__APPLE__)
 #include <execinfo.h> // comment out if not present
@@ -58,6 +59,14 @@
   #define INIT_PY_THREADS
 #endif
 
+#if PY_VERSION_HEX >= 0x030C0000
+  #define USE_SUBINTERPRETERS      // Python 3.12 allows each sub-interpreter to have its own GIL
+#endif
+
+#if PY_VERSION_HEX >= 0x03090000
+  #define USE_ROW_BUFFERS          // Py_bf_getbuffer can only be supplied via PyType_FromSpec from 3.9 onwards
+#endif
+
 static const char * compatibleVersions[] = {
     "Python3.x Embed Helper 1.0.0",
     NULL };
@@ -263,6 +272,213 @@ def namedtuple(typename, field_names):
 
 #endif
 
+// A PythonInterpreterCache holds the Python objects that are cached on behalf of a single interpreter.
+// Python objects can never be shared between interpreters, so when sub-interpreters are in use each of
+// them has its own cache, otherwise the main interpreter's cache (owned by the global state) is used.
+
+class PythonInterpreterCache
+{
+public:
+    void clear()
+    {
+        namedtuple.clear();
+        namedtupleTypes.clear();
+        compiledScripts.clear();
+        activityContextTupleType.clear();
+        datasetIteratorType.clear();
+        rowBufferType.clear();
+    }
+    void abandon()
+    {
+        // Need to avoid releasing the associated py objects when these members destructors are called.
+        namedtuple.getClear();
+        namedtupleTypes.getClear();
+        compiledScripts.getClear();
+        activityContextTupleType.getClear();
+        datasetIteratorType.getClear();
+        rowBufferType.getClear();
+    }
+
+    PyObject *getActivityContextTupleType()
+    {
+        // Note - we do not need (and must not have) a lock protecting this. It is protected by the Python GIL,
+        // and if we add our own lock we are liable to deadlock as the code within Py_CompileStringFlags may
+        // temporarily release then re-acquire the GIL.
+        if (!activityContextTupleType)
+            activityContextTupleType.setown(getNamedTupleType("isLocal,numSlaves,numStrands,slave,strand"));
+        return activityContextTupleType.get();
+    }
+
+    PyObject *getNamedTupleType(const char *names)
+    {
+        // It seems the customized namedtuple types leak, and they are slow to create, so take care to reuse
+        // Note - we do not need (and must not have) a lock protecting this. It is protected by the Python GIL,
+        // and if we add our own lock we are liable to deadlock as the code within Py_CompileStringFlags may
+        // temporarily release then re-acquire the GIL.
+        if (!namedtuple)
+        {
+            namedtupleTypes.setown(PyDict_New());
+#ifdef USE_CUSTOM_NAMEDTUPLES
+            OwnedPyObject temp_namespace(PyDict_New());
+            PyDict_SetItemString(temp_namespace, "__builtins__",  PyEval_GetBuiltins());  // required for import to work
+            checkPythonError();
+            OwnedPyObject ran = PyRun_String(_py36code, Py_file_input, temp_namespace, temp_namespace);
+            checkPythonError();
+            namedtuple.set(PyDict_GetItemString(temp_namespace, "namedtuple"));   // NOTE - returns borrowed reference
+#else
+            OwnedPyObject pName = PyUnicode_FromString("collections");
+            OwnedPyObject collections = PyImport_Import(pName);
+            checkPythonError();
+            namedtuple.setown(PyObject_GetAttrString(collections, "namedtuple"));
+#endif
+            checkPythonError();
+            assertex(PyCallable_Check(namedtuple));
+        }
+
+        OwnedPyObject pnames = PyUnicode_FromString(names);
+        OwnedPyObject mynamedtupletype;
+        checkPythonError();
+        mynamedtupletype.set(PyDict_GetItem(namedtupleTypes, pnames));   // NOTE - returns borrowed reference
+        if (!mynamedtupletype)
+        {
+            OwnedPyObject recname = PyUnicode_FromString("namerec");     // MORE - do we care what the name is?
+            OwnedPyObject ntargs = PyTuple_Pack(2, recname.get(), pnames.get());
+            checkPythonError();
+            mynamedtupletype.setown(PyObject_CallObject(namedtuple, ntargs));
+            checkPythonError();
+            PyDict_SetItem(namedtupleTypes, pnames, mynamedtupletype);
+        }
+        checkPythonError();
+        assertex(PyCallable_Check(mynamedtupletype));
+        return mynamedtupletype.getClear();
+    }
+
+    PyObject *getNamedTupleType(const RtlTypeInfo *type)
+    {
+        const RtlFieldInfo * const *fields = type->queryFields();
+        if (!fields && type->queryChildType())
+            fields = type->queryChildType()->queryFields();
+        assertex(fields);
+        StringBuffer names;
+        while (*fields)
+        {
+            const RtlFieldInfo *field = *fields;
+            if (names.length())
+                names.append(',');
+            names.append(field->name);
+            fields++;
+        }
+        return getNamedTupleType(names.str());
+    }
+
+    StringBuffer & reformatCompilerError(StringBuffer &ret, const char *error, unsigned leadingLines)
+    {
+        // Errors from compiler tend to look like this:
+        // "('invalid syntax', ('<embed>', 3, 12, '     sfsf ss fs dfs f sfs\n'))"
+        const char pattern [] = "\\('(.*)', \\('.*', ([0-9]*), ([0-9]*), (.*)\\)\\)";
+        // Hopefully there are no embedded quotes in the error message or the filename
+        rtlCompiledStrRegex r;
+        size32_t outlen;
+        char * out = NULL;
+        r.setPattern(pattern, false);
+        r->replace(outlen, out, strlen(error), error, 2, "$2");
+        if (outlen < strlen(error))
+        {
+            unsigned line = atoi(out);
+            rtlFree(out);
+            if (line > leadingLines)
+                line--;
+            r->replace(outlen, out, strlen(error), error, 13, ", $3): $1: $4");
+            ret.appendf("(%d", line);
+        }
+        ret.append(outlen, out);
+        rtlFree(out);
+        return ret;
+    }
+    PyObject *compileScript(const char *text, const char *parameters)
+    {
+        // Note - we do not need (and must not have) a lock protecting this. It is protected by the Python GIL,
+        // and if we add our own lock we are liable to deadlock as the code within Py_CompileStringFlags may
+        // temporarily release then re-acquire the GIL.
+        if (!compiledScripts)
+            compiledScripts.setown(PyDict_New());
+        OwnedPyObject code;
+        code.set(PyDict_GetItemString(compiledScripts, text));
+        if (!code)
+        {
+            unsigned leadingLines = (unsigned) -1;  // Number of lines from input that have not been offset by 1 line in input to compiler
+            code.setown(Py_CompileString(text, "", Py_eval_input));   // try compiling as simple expression...
+            if (!code)
+            {
+                PyErr_Clear();
+                PyCompilerFlags flags = { PyCF_SOURCE_IS_UTF8 };
+                code.setown(Py_CompileStringFlags(text, "<embed>", Py_file_input, &flags));  // try compiling as global code
+                if (!code)
+                {
+                    PyErr_Clear();
+                    StringBuffer wrapped;
+                    wrapPythonText(wrapped, text, parameters, leadingLines);
+                    code.setown(Py_CompileStringFlags(wrapped, "<embed>", Py_file_input, &flags)); // try compiling as a function body
+                }
+            }
+            PyObject* err = PyErr_Occurred();
+            if (err)
+            {
+                OwnedPyObject pType, pValue, pTraceBack;
+                PyErr_Fetch(pType.ref(), pValue.ref(), pTraceBack.ref());
+                OwnedPyObject valStr = PyObject_Str(pValue);
+                PyErr_Clear();
+                // We reformat the error message a little, to make it more helpful
+                assertex(PyUnicode_Check(valStr));
+                const char *errtext = PyUnicode_AsUTF8AndSize(valStr, NULL);
+                StringBuffer msg;
+                reformatCompilerError(msg, errtext, leadingLines);
+                rtlFail(0, msg.str());
+            }
+            if (code)
+                PyDict_SetItemString(compiledScripts, text, code);
+        }
+        return code.getClear();
+    }
+    PyObject *getDatasetIteratorType();
+    PyObject *getRowBufferType();
+protected:
+    static StringBuffer &wrapPythonText(StringBuffer &out, const char *in, const char *params, unsigned &leadingLines)
+    {
+        // Complicated by needing to keep future import lines outside defined function
+        // Per python spec, a future statement must appear near the top of the module. The only lines that can appear before a future statement are:
+        //   the module docstring (if any),
+        //   comments,
+        //   blank lines, and
+        //   other future statements.
+        // We don't attempt to parse the python to spot these - instead, we pull all lines up to and including the last future statement out to the global scope.
+        // Because this is a little unsophisticated it will be fooled by code that includes things that look like future statements inside multiline strings.
+        // I don't care.
+        StringArray lines;
+        lines.appendList(in, "\n", false);
+        RegExpr expr("^ *from +__future__ +import ");
+        leadingLines = 0;
+        ForEachItemIn(idx, lines)
+        {
+            if (expr.find(lines.item(idx)))
+                leadingLines = idx+1;
+        }
+        for (unsigned leadingLine = 0; leadingLine < leadingLines; leadingLine++)
+            out.append(lines.item(leadingLine)).append('\n');
+        out.appendf("def __user__(%s):\n", params);
+        for (unsigned line = leadingLines; line < lines.length(); line++)
+            out.append("  ").append(lines.item(line)).append('\n');
+        out.appendf("__result__ = __user__(%s)\n", params);
+        return out;
+    }
+    OwnedPyObject namedtuple;      // collections.namedtuple
+    OwnedPyObject namedtupleTypes; // dictionary of return values from namedtuple()
+    OwnedPyObject compiledScripts; // dictionary of previously compiled scripts
+    OwnedPyObject activityContextTupleType; // type used for activity context
+    OwnedPyObject datasetIteratorType; // type used to pass ECL datasets as Python iterators
+    OwnedPyObject rowBufferType;   // type used to pass fixed-size ECL datasets as Python buffers
+};
+
 // The Python Global Interpreter Lock (GIL) won't know about C++-created threads, so we need to
 // call PyGILState_Ensure() and PyGILState_Release at the start and end of every function.
 // Wrapping them in a class like this ensures that the release always happens even if
@@ -286,23 +502,22 @@ public:
 // ensure that we can make repeated calls to a Python function efficiently.
 // Note that we assume that a thread is not shared between workunits/queries
 
+#ifdef USE_SUBINTERPRETERS
+struct PythonSubInterpreter
+{
+    PyInterpreterState *interp = nullptr;
+    PythonInterpreterCache cache;
+};
+#endif
+
 class PythonThreadContext
 {
 public:
     PyThreadState *threadState;
+    PythonInterpreterCache *cache;  // Objects cached on behalf of the interpreter this thread is using
 public:
-    PythonThreadContext()
-    {
-        threadState = PyEval_SaveThread();
-        lrutype = NULL;
-    }
-    ~PythonThreadContext()
-    {
-        PyEval_RestoreThread(threadState);
-        script.clear();
-        module.clear();
-        lru.clear();
-    }
+    PythonThreadContext();
+    ~PythonThreadContext();
 
     void addManifestFiles(ICodeContext *codeCtx);
 
@@ -382,6 +597,10 @@ private:
     const RtlTypeInfo *lrutype;
     StringAttr prevtext;
     bool manifestAdded = false;
+#ifdef USE_SUBINTERPRETERS
+    PythonSubInterpreter *subInterpreter = nullptr;
+    PyThreadState *mainThreadState = nullptr;
+#endif
 };
 
 static __thread PythonThreadContext* threadContext;  // We reuse per thread, for speed
@@ -454,188 +673,108 @@ public:
 #ifndef _CONTAINERIZED
         skipPythonCleanup = queryEnvironmentConf().getPropBool("skipPythonCleanup", skipPythonCleanup);
 #endif
-        initialized = true;
-    }
-    ~Python3xGlobalState()
-    {
-        if (threadContext)
-            delete threadContext;   // The one on the main thread won't get picked up by the thread hook mechanism
-        threadContext = NULL;
-        if (initialized && !skipPythonCleanup)
-        {
-            PyEval_RestoreThread(tstate);
-            // Finish the Python Interpreter
-            namedtuple.clear();
-            namedtupleTypes.clear();
-            compiledScripts.clear();
-            preservedScopes.clear();
-            Py_Finalize();
-            if (pythonLibrary)
-                FreeSharedObject(pythonLibrary);
-        }
-        else
-        {
-            // Need to avoid releasing the associated py objects when these members destructors are called.
-            namedtuple.getClear();
-            namedtupleTypes.getClear();
-            compiledScripts.getClear();
-            preservedScopes.getClear();
-
-        }
-    }
-    void checkInitialized()
-    {
-        if (multiPython)
-            rtlFail(0, "Python3 not initialized as Python2 already loaded");
-        else if (!initialized)
-            rtlFail(0, "Python3 not initialized");
-    }
-    bool isInitialized()
-    {
-        return initialized;
-    }
-
-    PyObject *getActivityContextTupleType()
-    {
-        // Note - we do not need (and must not have) a lock protecting this. It is protected by the Python GIL,
-        // and if we add our own lock we are liable to deadlock as the code within Py_CompileStringFlags may
-        // temporarily release then re-acquire the GIL.
-        if (!activityContextTupleType)
-            activityContextTupleType.setown(getNamedTupleType("isLocal,numSlaves,numStrands,slave,strand"));
-        return activityContextTupleType.get();
-    }
-
-    PyObject *getNamedTupleType(const char *names)
-    {
-        // It seems the customized namedtuple types leak, and they are slow to create, so take care to reuse
-        // Note - we do not need (and must not have) a lock protecting this. It is protected by the Python GIL,
-        // and if we add our own lock we are liable to deadlock as the code within Py_CompileStringFlags may
-        // temporarily release then re-acquire the GIL.
-        if (!namedtuple)
-        {
-            namedtupleTypes.setown(PyDict_New());
-#ifdef USE_CUSTOM_NAMEDTUPLES
-            OwnedPyObject temp_namespace(PyDict_New());
-            PyDict_SetItemString(temp_namespace, "__builtins__",  PyEval_GetBuiltins());  // required for import to work
-            checkPythonError();
-            OwnedPyObject ran = PyRun_String(_py36code, Py_file_input, temp_namespace, temp_namespace);
-            checkPythonError();
-            namedtuple.set(PyDict_GetItemString(temp_namespace, "namedtuple"));   // NOTE - returns borrowed reference
-#else
-            OwnedPyObject pName = PyUnicode_FromString("collections");
-            OwnedPyObject collections = PyImport_Import(pName);
-            checkPythonError();
-            namedtuple.setown(PyObject_GetAttrString(collections, "namedtuple"));
+#ifdef USE_SUBINTERPRETERS
+        const char* subInterpretersText = getenv("PYTHON_SUBINTERPRETERS");
+        if (subInterpretersText)
+            useSubInterpreters = strToBool(subInterpretersText);
+        const char* poolSizeText = getenv("PYTHON_SUBINTERPRETER_POOL");
+        if (poolSizeText)
+            maxPooledInterpreters = atoi(poolSizeText);
+#ifndef _CONTAINERIZED
+        useSubInterpreters = queryEnvironmentConf().getPropBool("pythonSubInterpreters", useSubInterpreters);
+        maxPooledInterpreters = queryEnvironmentConf().getPropInt("pythonSubInterpreterPool", maxPooledInterpreters);
 #endif
-            checkPythonError();
-            assertex(PyCallable_Check(namedtuple));
-        }
-
-        OwnedPyObject pnames = PyUnicode_FromString(names);
-        OwnedPyObject mynamedtupletype;
-        checkPythonError();
-        mynamedtupletype.set(PyDict_GetItem(namedtupleTypes, pnames));   // NOTE - returns borrowed reference
-        if (!mynamedtupletype)
-        {
-            OwnedPyObject recname = PyUnicode_FromString("namerec");     // MORE - do we care what the name is?
-            OwnedPyObject ntargs = PyTuple_Pack(2, recname.get(), pnames.get());
-            checkPythonError();
-            mynamedtupletype.setown(PyObject_CallObject(namedtuple, ntargs));
-            checkPythonError();
-            PyDict_SetItem(namedtupleTypes, pnames, mynamedtupletype);
-        }
-        checkPythonError();
-        assertex(PyCallable_Check(mynamedtupletype));
-        return mynamedtupletype.getClear();
-    }
-
-    PyObject *getNamedTupleType(const RtlTypeInfo *type)
-    {
-        const RtlFieldInfo * const *fields = type->queryFields();
-        if (!fields && type->queryChildType())
-            fields = type->queryChildType()->queryFields();
-        assertex(fields);
-        StringBuffer names;
-        while (*fields)
-        {
-            const RtlFieldInfo *field = *fields;
-            if (names.length())
-                names.append(',');
-            names.append(field->name);
-            fields++;
-        }
-        return getNamedTupleType(names.str());
-    }
-
-    StringBuffer & reformatCompilerError(StringBuffer &ret, const char *error, unsigned leadingLines)
-    {
-        // Errors from compiler tend to look like this:
-        // "('invalid syntax', ('<embed>', 3, 12, '     sfsf ss fs dfs f sfs\n'))"
-        const char pattern [] = "\\('(.*)', \\('.*', ([0-9]*), ([0-9]*), (.*)\\)\\)";
-        // Hopefully there are no embedded quotes in the error message or the filename
-        rtlCompiledStrRegex r;
-        size32_t outlen;
-        char * out = NULL;
-        r.setPattern(pattern, false);
-        r->replace(outlen, out, strlen(error), error, 2, "$2");
-        if (outlen < strlen(error))
-        {
-            unsigned line = atoi(out);
-            rtlFree(out);
-            if (line > leadingLines)
-                line--;
-            r->replace(outlen, out, strlen(error), error, 13, ", $3): $1: $4");
-            ret.appendf("(%d", line);
-        }
-        ret.append(outlen, out);
-        rtlFree(out);
-        return ret;
+        if (useSubInterpreters)
+            DBGLOG("pyembed: using sub-interpreters (pool size %u)", maxPooledInterpreters);
+#endif
+        initialized = true;
     }
-    PyObject *compileScript(const char *text, const char *parameters)
+    ~Python3xGlobalState()
     {
-        // Note - we do not need (and must not have) a lock protecting this. It is protected by the Python GIL,
-        // and if we add our own lock we are liable to deadlock as the code within Py_CompileStringFlags may
-        // temporarily release then re-acquire the GIL.
-        if (!compiledScripts)
-            compiledScripts.setown(PyDict_New());
-        OwnedPyObject code;
-        code.set(PyDict_GetItemString(compiledScripts, text));
-        if (!code)
+        if (threadContext)
+            delete threadContext;   // The one on the main thread won't get picked up by the thread hook mechanism
+        threadContext = NULL;
+        if (initialized && !skipPythonCleanup)
         {
-            unsigned leadingLines = (unsigned) -1;  // Number of lines from input that have not been offset by 1 line in input to compiler
-            code.setown(Py_CompileString(text, "", Py_eval_input));   // try compiling as simple expression...
-            if (!code)
+            PyEval_RestoreThread(tstate);
+#ifdef USE_SUBINTERPRETERS
+            // Any pooled sub-interpreters must be ended before the main interpreter is finalized
+            for (PythonSubInterpreter *sub : pooledInterpreters)
             {
-                PyErr_Clear();
-                PyCompilerFlags flags = { PyCF_SOURCE_IS_UTF8 };
-                code.setown(Py_CompileStringFlags(text, "<embed>", Py_file_input, &flags));  // try compiling as global code
-                if (!code)
-                {
-                    PyErr_Clear();
-                    StringBuffer wrapped;
-                    wrapPythonText(wrapped, text, parameters, leadingLines);
-                    code.setown(Py_CompileStringFlags(wrapped, "<embed>", Py_file_input, &flags)); // try compiling as a function body
-                }
+                PyThreadState *subState = PyThreadState_New(sub->interp);
+                PyThreadState *mainState = PyEval_SaveThread();
+                PyEval_RestoreThread(subState);
+                sub->cache.clear();
+                Py_EndInterpreter(subState);
+                PyEval_RestoreThread(mainState);
+                delete sub;
             }
-            PyObject* err = PyErr_Occurred();
-            if (err)
+            pooledInterpreters.clear();
+#endif
+            // Finish the Python Interpreter
+            mainCache.clear();
+            preservedScopes.clear();
+            Py_Finalize();
+            if (pythonLibrary)
+                FreeSharedObject(pythonLibrary);
+        }
+        else
+        {
+            // Need to avoid releasing the associated py objects when these members destructors are called.
+#ifdef USE_SUBINTERPRETERS
+            for (PythonSubInterpreter *sub : pooledInterpreters)
             {
-                OwnedPyObject pType, pValue, pTraceBack;
-                PyErr_Fetch(pType.ref(), pValue.ref(), pTraceBack.ref());
-                OwnedPyObject valStr = PyObject_Str(pValue);
-                PyErr_Clear();
-                // We reformat the error message a little, to make it more helpful
-                assertex(PyUnicode_Check(valStr));
-                const char *errtext = PyUnicode_AsUTF8AndSize(valStr, NULL);
-                StringBuffer msg;
-                reformatCompilerError(msg, errtext, leadingLines);
-                rtlFail(0, msg.str());
+                sub->cache.abandon();
+                delete sub;
             }
-            if (code)
-                PyDict_SetItemString(compiledScripts, text, code);
+            pooledInterpreters.clear();
+#endif
+            mainCache.abandon();
+            preservedScopes.getClear();
         }
-        return code.getClear();
     }
+    void checkInitialized()
+    {
+        if (multiPython)
+            rtlFail(0, "Python3 not initialized as Python2 already loaded");
+        else if (!initialized)
+            rtlFail(0, "Python3 not initialized");
+    }
+    bool isInitialized()
+    {
+        return initialized;
+    }
+    PythonInterpreterCache &queryMainCache()
+    {
+        return mainCache;
+    }
+
+#ifdef USE_SUBINTERPRETERS
+    bool usingSubInterpreters() const
+    {
+        return useSubInterpreters;
+    }
+    PythonSubInterpreter *getPooledInterpreter()
+    {
+        CriticalBlock b(poolCrit);
+        if (pooledInterpreters.empty())
+            return nullptr;
+        PythonSubInterpreter *ret = pooledInterpreters.back();
+        pooledInterpreters.pop_back();
+        return ret;
+    }
+    bool canPoolInterpreter()
+    {
+        CriticalBlock b(poolCrit);
+        return pooledInterpreters.size() < maxPooledInterpreters;
+    }
+    void poolInterpreter(PythonSubInterpreter *sub)
+    {
+        CriticalBlock b(poolCrit);
+        pooledInterpreters.push_back(sub);
+    }
+#endif
+
     PyObject *getNamedScope(const char *key, bool &isNew)
     {
         if (!preservedScopes)
@@ -663,44 +802,19 @@ public:
     static void unregister(const char *key);
     static void removePath(const char *file);
 protected:
-    static StringBuffer &wrapPythonText(StringBuffer &out, const char *in, const char *params, unsigned &leadingLines)
-    {
-        // Complicated by needing to keep future import lines outside defined function
-        // Per python spec, a future statement must appear near the top of the module. The only lines that can appear before a future statement are:
-        //   the module docstring (if any),
-        //   comments,
-        //   blank lines, and
-        //   other future statements.
-        // We don't attempt to parse the python to spot these - instead, we pull all lines up to and including the last future statement out to the global scope.
-        // Because this is a little unsophisticated it will be fooled by code that includes things that look like future statements inside multiline strings.
-        // I don't care.
-        StringArray lines;
-        lines.appendList(in, "\n", false);
-        RegExpr expr("^ *from +__future__ +import ");
-        leadingLines = 0;
-        ForEachItemIn(idx, lines)
-        {
-            if (expr.find(lines.item(idx)))
-                leadingLines = idx+1;
-        }
-        for (unsigned leadingLine = 0; leadingLine < leadingLines; leadingLine++)
-            out.append(lines.item(leadingLine)).append('\n');
-        out.appendf("def __user__(%s):\n", params);
-        for (unsigned line = leadingLines; line < lines.length(); line++)
-            out.append("  ").append(lines.item(line)).append('\n');
-        out.appendf("__result__ = __user__(%s)\n", params);
-        return out;
-    }
     PyThreadState *tstate = nullptr;
     bool initialized = false;
     bool multiPython = false;
     bool skipPythonCleanup = true; // Tensorflow seems to often lockup in the python cleanup process.
     HINSTANCE pythonLibrary = 0;
-    OwnedPyObject namedtuple;      // collections.namedtuple
-    OwnedPyObject namedtupleTypes; // dictionary of return values from namedtuple()
-    OwnedPyObject compiledScripts; // dictionary of previously compiled scripts
+    PythonInterpreterCache mainCache;
     OwnedPyObject preservedScopes; // dictionary of preserved scopes
-    OwnedPyObject activityContextTupleType; // type used for activity context
+#ifdef USE_SUBINTERPRETERS
+    bool useSubInterpreters = false;
+    unsigned maxPooledInterpreters = 16;
+    CriticalSection poolCrit;
+    std::vector<PythonSubInterpreter *> pooledInterpreters;  // Sub-interpreters not currently assigned to any thread
+#endif
 } globalState;
 
 MODULE_INIT(INIT_PRIORITY_STANDARD)
@@ -729,6 +843,80 @@ MODULE_INIT(INIT_PRIORITY_STANDARD)
     return true;
 }
 
+PythonThreadContext::PythonThreadContext()
+{
+    lrutype = NULL;
+    cache = &globalState.queryMainCache();
+#ifdef USE_SUBINTERPRETERS
+    if (globalState.usingSubInterpreters())
+    {
+        // The GILState member has made this thread's main interpreter state current. Each thread is given a
+        // sub-interpreter with its own GIL (reusing one from the pool if possible), so that Python code
+        // running on different threads does not serialize on a single lock.
+        subInterpreter = globalState.getPooledInterpreter();
+        if (subInterpreter)
+        {
+            mainThreadState = PyEval_SaveThread();
+            threadState = PyThreadState_New(subInterpreter->interp);
+            cache = &subInterpreter->cache;
+            return;
+        }
+        PyInterpreterConfig config = {};
+        config.use_main_obmalloc = 0;
+        config.allow_fork = 0;
+        config.allow_exec = 0;
+        config.allow_threads = 1;
+        config.allow_daemon_threads = 0;
+        config.check_multi_interp_extensions = 1;  // Required for a separate GIL - modules using single-phase init cannot be imported
+        config.gil = PyInterpreterConfig_OWN_GIL;
+        mainThreadState = PyThreadState_Get();
+        PyThreadState *subState = nullptr;
+        PyStatus status = Py_NewInterpreterFromConfig(&subState, &config);
+        if (!PyStatus_Exception(status))
+        {
+            // Creating the interpreter released the main GIL, and left the new interpreter's state current
+            subInterpreter = new PythonSubInterpreter;
+            subInterpreter->interp = PyThreadState_GetInterpreter(subState);
+            threadState = PyEval_SaveThread();
+            cache = &subInterpreter->cache;
+            return;
+        }
+        OWARNLOG("pyembed: failed to create sub-interpreter (%s) - using main interpreter", status.err_msg ? status.err_msg : "unknown error");
+        mainThreadState = nullptr;
+    }
+#endif
+    threadState = PyEval_SaveThread();
+}
+
+PythonThreadContext::~PythonThreadContext()
+{
+    PyEval_RestoreThread(threadState);
+    script.clear();
+    module.clear();
+    lru.clear();
+#ifdef USE_SUBINTERPRETERS
+    if (subInterpreter)
+    {
+        // Interpreters that have had manifest files added to their path are not reused by other threads
+        if (!manifestAdded && globalState.canPoolInterpreter())
+        {
+            PyThreadState_Clear(threadState);
+            PyThreadState_DeleteCurrent();
+            globalState.poolInterpreter(subInterpreter);
+        }
+        else
+        {
+            subInterpreter->cache.clear();
+            Py_EndInterpreter(threadState);
+            delete subInterpreter;
+        }
+        subInterpreter = nullptr;
+        // The GILState member expects to find the main interpreter's state current when it is released
+        PyEval_RestoreThread(mainThreadState);
+    }
+#endif
+}
+
 static void checkThreadContext()
 {
     if (!threadContext)
@@ -776,7 +964,7 @@ PyObject *PythonThreadContext::getNamedTupleType(const RtlTypeInfo *type)
 {
     if (!lru || (type!=lrutype))
     {
-        lru.setown(globalState.getNamedTupleType(type));
+        lru.setown(cache->getNamedTupleType(type));
         lrutype = type;
     }
     return lru.getLink();
@@ -791,7 +979,7 @@ PyObject *PythonThreadContext::compileEmbeddedScript(ICodeContext *codeCtx, size
         prevtext.clear();
         text.stripChar('\r');
         addManifestFiles(codeCtx);
-        script.setown(globalState.compileScript(text, argstring));
+        script.setown(cache->compileScript(text, argstring));
         prevtext.set(utf, bytes);
     }
     return script.getLink();
@@ -1230,7 +1418,11 @@ class PythonNamedTupleBuilder : public CInterfaceOf<IFieldProcessor>
 {
 public:
     PythonNamedTupleBuilder(PythonThreadContext *_sharedCtx, const RtlFieldInfo *_outerRow)
-    : outerRow(_outerRow), sharedCtx(_sharedCtx)
+    : outerRow(_outerRow), sharedCtx(_sharedCtx), cache(_sharedCtx->cache)
+    {
+    }
+    PythonNamedTupleBuilder(PythonInterpreterCache *_cache, const RtlFieldInfo *_outerRow)
+    : outerRow(_outerRow), sharedCtx(nullptr), cache(_cache)
     {
     }
     virtual void processString(unsigned len, const char *value, const RtlFieldInfo * field)
@@ -1328,7 +1520,7 @@ public:
     }
     PyObject *getTuple(const RtlTypeInfo *type)
     {
-        OwnedPyObject mynamedtupletype = sharedCtx ? sharedCtx->getNamedTupleType(type) : globalState.getNamedTupleType(type);
+        OwnedPyObject mynamedtupletype = sharedCtx ? sharedCtx->getNamedTupleType(type) : cache->getNamedTupleType(type);
 #ifdef USE_CUSTOM_NAMEDTUPLES
         OwnedPyObject argsTuple = PyTuple_New(1);
         Py_INCREF(args);
@@ -1365,6 +1557,7 @@ protected:
     PointerArray stack;
     const RtlFieldInfo *outerRow;
     PythonThreadContext *sharedCtx;
+    PythonInterpreterCache *cache;
 };
 
 //----------------------------------------------------------------------
@@ -1413,8 +1606,20 @@ struct ECLDatasetIterator
     PyObject_HEAD;
     const RtlTypeInfo *typeInfo;  // Not linked (or linkable)
     IRowStream * val;  // Linked
+    PythonInterpreterCache *cache;  // Cache for the interpreter that created the iterator
 };
 
+// Objects created from heap types (as required when using sub-interpreters) hold a reference to their type
+
+static void releasePyObject(PyObject *self)
+{
+    PyTypeObject *type = Py_TYPE(self);
+    type->tp_free(self);
+#if PY_VERSION_HEX >= 0x03080000
+    Py_DECREF(type);
+#endif
+}
+
 PyObject* ECLDatasetIterator_iter(PyObject *self)
 {
       Py_INCREF(self);
@@ -1431,7 +1636,7 @@ void ECLDatasetIterator_dealloc(PyObject *self)
         ::Release(p->val);
         p->val = NULL;
     }
-    self->ob_type->tp_free(self);
+    releasePyObject(self);
 }
 
 PyObject* ECLDatasetIterator_iternext(PyObject *self)
@@ -1452,7 +1657,7 @@ PyObject* ECLDatasetIterator_iternext(PyObject *self)
     if (p->val)
     {
         RtlFieldStrInfo dummyField("<row>", NULL, p->typeInfo);
-        PythonNamedTupleBuilder tupleBuilder(NULL, &dummyField);
+        PythonNamedTupleBuilder tupleBuilder(p->cache, &dummyField);
         const byte *brow = (const byte *) nextRow.get();
         p->typeInfo->process(brow, brow, &dummyField, tupleBuilder);
         return tupleBuilder.getTuple(p->typeInfo);
@@ -1465,53 +1670,255 @@ PyObject* ECLDatasetIterator_iternext(PyObject *self)
     }
 }
 
-static PyTypeObject ECLDatasetIteratorType =
-{
-    PyVarObject_HEAD_INIT(NULL, 0)
-    "ECLDatasetIterator._MyIter",      /*tp_name*/
-    sizeof(ECLDatasetIterator),       /*tp_basicsize*/
-    0,                         /*tp_itemsize*/
-    ECLDatasetIterator_dealloc,        /*tp_dealloc*/
-    0,                         /*tp_print*/
-    0,                         /*tp_getattr*/
-    0,                         /*tp_setattr*/
-    0,                         /*tp_compare*/
-    0,                         /*tp_repr*/
-    0,                         /*tp_as_number*/
-    0,                         /*tp_as_sequence*/
-    0,                         /*tp_as_mapping*/
-    0,                         /*tp_hash */
-    0,                         /*tp_call*/
-    0,                         /*tp_str*/
-    0,                         /*tp_getattro*/
-    0,                         /*tp_setattro*/
-    0,                         /*tp_as_buffer*/
-    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_ITER,  /* tp_flags: tell python to use tp_iter and tp_iternext fields. */
-    "ECL dataset iterator object.",           /* tp_doc */
-    0,  /* tp_traverse */
-    0,  /* tp_clear */
-    0,  /* tp_richcompare */
-    0,  /* tp_weaklistoffset */
-    ECLDatasetIterator_iter,  /* tp_iter: __iter__() method */
-    ECLDatasetIterator_iternext  /* tp_iternext: next() method */
+static PyType_Slot ECLDatasetIteratorSlots[] =
+{
+    { Py_tp_dealloc, (void *) ECLDatasetIterator_dealloc },
+    { Py_tp_iter, (void *) ECLDatasetIterator_iter },
+    { Py_tp_iternext, (void *) ECLDatasetIterator_iternext },
+    { Py_tp_doc, (void *) "ECL dataset iterator object." },
+    { 0, nullptr }
+};
+
+static PyType_Spec ECLDatasetIteratorSpec =
+{
+    "ECLDatasetIterator._MyIter",
+    sizeof(ECLDatasetIterator),
+    0,
+    Py_TPFLAGS_DEFAULT,
+    ECLDatasetIteratorSlots
 };
 
-static PyObject *createECLDatasetIterator(const RtlTypeInfo *_typeInfo, IRowStream * _val)
+PyObject *PythonInterpreterCache::getDatasetIteratorType()
 {
-    ECLDatasetIteratorType.tp_new = PyType_GenericNew;
-    if (PyType_Ready(&ECLDatasetIteratorType) < 0)  return NULL;
+    // Static types cannot be shared between interpreters, so each interpreter creates its own
+    if (!datasetIteratorType)
+    {
+        datasetIteratorType.setown(PyType_FromSpec(&ECLDatasetIteratorSpec));
+        checkPythonError();
+    }
+    return datasetIteratorType.getLink();
+}
 
-    ECLDatasetIterator *p = PyObject_New(ECLDatasetIterator, &ECLDatasetIteratorType);
+static PyObject *createECLDatasetIterator(PythonInterpreterCache *cache, const RtlTypeInfo *_typeInfo, IRowStream * _val)
+{
+    OwnedPyObject type = cache->getDatasetIteratorType();
+    ECLDatasetIterator *p = PyObject_New(ECLDatasetIterator, (PyTypeObject *) type.get());
     if (!p)
     {
+        ::Release(_val);
         checkPythonError();
         rtlFail(0, "pyembed: failed to create dataset iterator");
     }
     p->typeInfo = _typeInfo;
     p->val = _val;
+    p->cache = cache;
+    return (PyObject *)p;
+}
+
+#ifdef USE_ROW_BUFFERS
+
+// Wrap the rows of a fixed-size ECL dataset into a single contiguous block that supports the buffer protocol.
+// Each row is an item of the buffer, described using a PEP 3118 struct format so that it can be viewed
+// without any per-field conversion (e.g. by numpy.asarray() or memoryview.cast()).
+
+struct ECLRowBuffer
+{
+    PyObject_HEAD;
+    void *rows;          // Owned, allocated with malloc
+    char *format;        // Owned, allocated with malloc
+    Py_ssize_t rowSize;
+    Py_ssize_t numRows;
+};
+
+void ECLRowBuffer_dealloc(PyObject *self)
+{
+    ECLRowBuffer *p = (ECLRowBuffer *)self;
+    free(p->rows);
+    free(p->format);
+    releasePyObject(self);
+}
+
+int ECLRowBuffer_getbuffer(PyObject *self, Py_buffer *view, int flags)
+{
+    ECLRowBuffer *p = (ECLRowBuffer *)self;
+    if (PyBuffer_FillInfo(view, self, p->rows, p->rowSize * p->numRows, 0, flags) != 0)
+        return -1;
+    if (flags & PyBUF_FORMAT)
+    {
+        // Only describe the buffer as a list of rows if the consumer understands formats, otherwise it is a block of bytes
+        view->format = p->format;
+        view->itemsize = p->rowSize;
+        if (flags & PyBUF_ND)
+            view->shape = &p->numRows;
+        if ((flags & PyBUF_STRIDES) == PyBUF_STRIDES)
+            view->strides = &p->rowSize;
+    }
+    return 0;
+}
+
+static PyType_Slot ECLRowBufferSlots[] =
+{
+    { Py_tp_dealloc, (void *) ECLRowBuffer_dealloc },
+    { Py_bf_getbuffer, (void *) ECLRowBuffer_getbuffer },
+    { Py_tp_doc, (void *) "ECL fixed-size dataset buffer object." },
+    { 0, nullptr }
+};
+
+static PyType_Spec ECLRowBufferSpec =
+{
+    "ECLRowBuffer._MyBuffer",
+    sizeof(ECLRowBuffer),
+    0,
+    Py_TPFLAGS_DEFAULT,
+    ECLRowBufferSlots
+};
+
+PyObject *PythonInterpreterCache::getRowBufferType()
+{
+    if (!rowBufferType)
+    {
+        rowBufferType.setown(PyType_FromSpec(&ECLRowBufferSpec));
+        checkPythonError();
+    }
+    return rowBufferType.getLink();
+}
+
+static bool getStructFormat(StringBuffer &format, const RtlTypeInfo *type)
+{
+    const RtlFieldInfo * const *fields = type->queryFields();
+    if (!fields)
+        return false;
+    format.append("T{");
+    for (; *fields; fields++)
+    {
+        const RtlFieldInfo *field = *fields;
+        const RtlTypeInfo *fieldType = field->type;
+        size32_t len = fieldType->length;
+        switch (fieldType->getType())
+        {
+        case type_boolean:
+            format.append('?');
+            break;
+        case type_int:
+        case type_swapint:
+        {
+            const char *codes = fieldType->isUnsigned() ? "BHIQ" : "bhiq";
+            char code;
+            switch (len)
+            {
+            case 1: code = codes[0]; break;
+            case 2: code = codes[1]; break;
+            case 4: code = codes[2]; break;
+            case 8: code = codes[3]; break;
+            default:
+                return false;
+            }
+            format.append(fieldType->getType() == type_swapint ? '>' : '<').append(code);
+            break;
+        }
+        case type_real:
+            if (len == 4)
+                format.append("<f");
+            else if (len == 8)
+                format.append("<d");
+            else
+                return false;
+            break;
+        case type_string:
+            if (fieldType->isEbcdic())
+                return false;
+            //fallthrough
+        case type_data:
+            format.append(len).append('s');
+            break;
+        case type_record:
+        case type_row:
+            if (!getStructFormat(format, fieldType))
+                return false;
+            break;
+        default:
+            return false;
+        }
+        format.append(':').append(field->name).append(':');
+    }
+    format.append('}');
+    return true;
+}
+
+static void getRowBufferFormat(StringBuffer &format, const RtlTypeInfo *typeInfo, size32_t rowSize)
+{
+    if (!getStructFormat(format, typeInfo))
+    {
+        // Fields that have no struct equivalent are still passed, but each row is presented as a single bytes item
+        format.clear().append(rowSize).append('s');
+    }
+}
+
+// Field names do not affect the layout of a row, and '=' (native byte order, no alignment) is the same as '<'
+static void normalizeStructFormat(StringBuffer &out, const char *format)
+{
+    for (const char *cur = format; *cur; cur++)
+    {
+        if (*cur == ':')
+        {
+            const char *end = strchr(cur+1, ':');
+            if (!end)
+                break;
+            cur = end;
+        }
+        else if (*cur == '=')
+            out.append(__BYTE_ORDER == __LITTLE_ENDIAN ? '<' : '>');
+        else
+            out.append(*cur);
+    }
+}
+
+static bool isSameStructFormat(const char *format, const RtlTypeInfo *typeInfo, size32_t rowSize)
+{
+    if (!format)
+        return false;
+    StringBuffer expected, normalExpected, normalFormat;
+    getRowBufferFormat(expected, typeInfo, rowSize);
+    normalizeStructFormat(normalExpected, expected);
+    normalizeStructFormat(normalFormat, format);
+    return streq(normalExpected, normalFormat);
+}
+
+static PyObject *createECLRowBuffer(PythonInterpreterCache *cache, const RtlTypeInfo *typeInfo, IRowStream * val)
+{
+    size32_t rowSize = typeInfo->getMinSize();
+    StringBuffer format;
+    getRowBufferFormat(format, typeInfo, rowSize);
+    MemoryBuffer rows;
+    {
+        // Rows from the stream are not contiguous, so copy them (once) into a single block
+        GILUnblock b;
+        for (;;)
+        {
+            roxiemem::OwnedConstRoxieRow nextRow = val->ungroupedNextRow();
+            if (!nextRow)
+                break;
+            rows.append(rowSize, nextRow.get());
+        }
+        val->stop();
+    }
+    ::Release(val);
+    OwnedPyObject type = cache->getRowBufferType();
+    ECLRowBuffer *p = PyObject_New(ECLRowBuffer, (PyTypeObject *) type.get());
+    if (!p)
+    {
+        checkPythonError();
+        rtlFail(0, "pyembed: failed to create dataset buffer");
+    }
+    p->numRows = rowSize ? rows.length() / rowSize : 0;
+    p->rowSize = rowSize;
+    p->rows = rows.detach();
+    p->format = format.detach();
     return (PyObject *)p;
 }
 
+#endif
+
 //-----------------------------------------------------
 
 
@@ -1573,27 +1980,42 @@ void Python3xGlobalState::removePath(const char *path)
 class PythonRowStream : public CInterfaceOf<IRowStream>
 {
 public:
-    PythonRowStream(PyObject *result, IEngineRowAllocator *_resultAllocator)
+    PythonRowStream(PyObject *result, IEngineRowAllocator *_resultAllocator, bool allowBuffer)
     : resultIterator(NULL)
     {
         // NOTE - the caller should already have the GIL lock before creating me
         if (!result || result == Py_None)
             typeError("list or generator", NULL);
+        resultAllocator.set(_resultAllocator);
+#ifdef USE_ROW_BUFFERS
+        if (allowBuffer && PyObject_CheckBuffer(result) && useResultBuffer(result, resultAllocator->queryOutputMeta()))
+            return;
+#endif
         resultIterator.setown(PyObject_GetIter(result));   // We allow anything that is iterable to be returned for a row stream
         checkPythonError();
-        resultAllocator.set(_resultAllocator);
     }
     ~PythonRowStream()
     {
-        if (resultIterator)
+        if (resultIterator || hasBuffer)
         {
             checkThreadContext();
             GILBlock b(threadContext->threadState);
             resultIterator.clear();
+            releaseBuffer();
         }
     }
     virtual const void *nextRow()
     {
+        if (hasBuffer)
+        {
+            // The exported buffer remains valid until it is released, so the GIL is not needed to read it
+            if (bufferOffset >= resultBuffer.len)
+                return NULL;
+            RtlDynamicRowBuilder rowBuilder(resultAllocator);
+            memcpy(rowBuilder.getSelf(), (const byte *) resultBuffer.buf + bufferOffset, rowSize);
+            bufferOffset += rowSize;
+            return rowBuilder.finalizeRowClear(rowSize);
+        }
         checkThreadContext();
         GILBlock b(threadContext->threadState);
         if (!resultIterator)
@@ -1613,11 +2035,46 @@ public:
         GILBlock b(threadContext->threadState);
         resultAllocator.clear();
         resultIterator.clear();
+        releaseBuffer();
     }
 
 protected:
+#ifdef USE_ROW_BUFFERS
+    // A buffer (e.g. a numpy structured array, or a dataset that was passed in as a buffer) can be copied directly
+    // into the result rows if it is contiguous and each item has the same layout as the output record.  Anything
+    // else is iterated as before.
+    bool useResultBuffer(PyObject *result, IOutputMetaData *meta)
+    {
+        if (!meta->isFixedSize())
+            return false;
+        if (PyObject_GetBuffer(result, &resultBuffer, PyBUF_RECORDS_RO) != 0)
+        {
+            PyErr_Clear();
+            return false;
+        }
+        hasBuffer = true;
+        rowSize = meta->getFixedSize();
+        if ((resultBuffer.ndim == 1) && (resultBuffer.itemsize == rowSize) && PyBuffer_IsContiguous(&resultBuffer, 'C') &&
+            isSameStructFormat(resultBuffer.format, meta->queryTypeInfo(), rowSize))
+            return true;
+        releaseBuffer();
+        return false;
+    }
+#endif
+    void releaseBuffer()
+    {
+        if (hasBuffer)
+        {
+            PyBuffer_Release(&resultBuffer);
+            hasBuffer = false;
+        }
+    }
     Linked<IEngineRowAllocator> resultAllocator;
     OwnedPyObject resultIterator;
+    Py_buffer resultBuffer;
+    bool hasBuffer = false;
+    size32_t rowSize = 0;
+    Py_ssize_t bufferOffset = 0;
 };
 
 // Each call to a Python function will use a new Python3xEmbedFunctionContext object
@@ -1635,7 +2092,7 @@ public:
 
     virtual void setActivityOptions(const IThorActivityContext *ctx)
     {
-        OwnedPyObject mynamedtupletype = globalState.getActivityContextTupleType();
+        OwnedPyObject mynamedtupletype = sharedCtx->cache->getActivityContextTupleType();
         OwnedPyObject args = PyTuple_New(5);
         OwnedPyObject isLocal;
         isLocal.set(ctx->isLocal() ? Py_True : Py_False);
@@ -1699,6 +2156,17 @@ public:
                     else
                         failx("Unrecognized persist mode %s", val);
                 }
+                else if (strieq(optName, "datasets"))
+                {
+                    if (strieq(val, "buffer"))
+                        useRowBuffers = true;
+                    else if (!strieq(val, "iterator"))
+                        failx("Unrecognized datasets mode %s", val);
+#ifndef USE_ROW_BUFFERS
+                    if (useRowBuffers)
+                        failx("datasets=buffer requires Python 3.9 or later");
+#endif
+                }
                 else
                     failx("Unrecognized option %s", optName.str());
             }
@@ -1711,6 +2179,11 @@ public:
             scopeKey.append(':').append(scopeKey2);
         if (scopeKey.length())
         {
+#ifdef USE_SUBINTERPRETERS
+            // Preserved scopes are shared between threads, which is not possible when each has its own interpreter
+            if (sharedCtx->cache != &globalState.queryMainCache())
+                failx("persist and globalscope options are not supported when using sub-interpreters");
+#endif
             bool isNew;
             globals.setown(globalState.getNamedScope(scopeKey, isNew));
             if (isNew && engine)
@@ -1768,7 +2241,7 @@ public:
     }
     virtual IRowStream *getDatasetResult(IEngineRowAllocator * _resultAllocator)
     {
-        return new PythonRowStream(result, _resultAllocator);
+        return new PythonRowStream(result, _resultAllocator, useRowBuffers);
     }
     virtual byte * getRowResult(IEngineRowAllocator * _resultAllocator)
     {
@@ -1936,13 +2409,21 @@ public:
     }
     virtual void bindDatasetParam(const char *name, IOutputMetaData & metaVal, IRowStream * val)
     {
-        addArg(name, createECLDatasetIterator(metaVal.queryTypeInfo(), LINK(val)));
+#ifdef USE_ROW_BUFFERS
+        if (useRowBuffers && metaVal.isFixedSize())
+        {
+            addArg(name, createECLRowBuffer(sharedCtx->cache, metaVal.queryTypeInfo(), LINK(val)));
+            return;
+        }
+#endif
+        addArg(name, createECLDatasetIterator(sharedCtx->cache, metaVal.queryTypeInfo(), LINK(val)));
     }
 protected:
     virtual void addArg(const char *name, PyObject *arg) = 0;
 
     PythonThreadContext *sharedCtx = nullptr;
     ICodeContext *codeCtx = nullptr;
+    bool useRowBuffers = false;  // Pass fixed-size datasets as a single buffer rather than an iterator of tuples
     OwnedPyObject locals;
     OwnedPyObject globals;
     OwnedPyObject result;
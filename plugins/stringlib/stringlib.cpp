@@ -513,32 +513,37 @@ STRINGLIB_API void STRINGLIB_CALL slStringRepad(unsigned & tgtLen, char * & tgt,
     }
 }
 
+//Returns the first occurrence of hit that starts at or before last, or NULL if there are none.  hitLen must be > 0.
+//memchr() is used to find candidates since it is vectorized by the C library.
+static const char * findSubString(const char * cur, const char * last, unsigned hitLen, const char * hit)
+{
+    char first = *hit;
+    while (cur <= last)
+    {
+        cur = (const char *)memchr(cur, first, last - cur + 1);
+        if (!cur)
+            return NULL;
+        if (!memcmp(cur+1, hit+1, hitLen-1))
+            return cur;
+        cur++;
+    }
+    return NULL;
+}
+
 STRINGLIB_API unsigned STRINGLIB_CALL slStringFind(unsigned srcLen, const char * src, unsigned hitLen, const char * hit, unsigned instance)
 {
     if ( srcLen < hitLen )
         return 0;   
-    if (hitLen==1) {           // common case optimization
-        const char *p=src;
-        const char *e = p+srcLen;
-        char c = *hit;
-        while (p!=e)
-            if ((*(p++)==c))
-                if (!--instance)
-                    return (unsigned)(p-src);
-    }
-    else 
+    if (hitLen == 0)            // an empty string matches at every position
+        return (instance && (instance <= srcLen+1)) ? instance : 0;
+
+    const char * last = src + srcLen - hitLen;
+    const char * cur = src;
+    while ((cur = findSubString(cur, last, hitLen, hit)) != NULL)
     {
-        unsigned steps = srcLen-hitLen+1;
-        for ( unsigned i = 0; i < steps; i++ )
-        {
-            if ( !memcmp((char *)src+i,hit,hitLen) )
-            {
-                if ( !--instance )
-                    return i+1;
-                if (hitLen > 1)
-                    i += (hitLen-1);
-            }
-        }
+        if ( !--instance )
+            return (unsigned)(cur-src)+1;
+        cur += hitLen;
     }
     return 0;
 }
@@ -547,27 +552,16 @@ STRINGLIB_API unsigned STRINGLIB_CALL slStringFindCount(unsigned srcLen, const c
 {
     if ( srcLen < hitLen )
         return 0;   
+    if (hitLen == 0)
+        return srcLen+1;
+
     unsigned matches = 0;
-    if (hitLen==1) {           // common case optimization
-        const char *p=src;
-        const char *e = p+srcLen;
-        char c = *hit;
-        while (p!=e)
-            if ((*(p++)==c))
-                matches++;
-    }
-    else 
+    const char * last = src + srcLen - hitLen;
+    const char * cur = src;
+    while ((cur = findSubString(cur, last, hitLen, hit)) != NULL)
     {
-        unsigned steps = srcLen-hitLen+1;
-        for ( unsigned i = 0; i < steps; i++ )
-        {
-            if ( !memcmp((char *)src+i,hit,hitLen) )
-            {
-                matches++;
-                if (hitLen > 1)
-                    i += (hitLen-1);
-            }
-        }
+        matches++;
+        cur += hitLen;
     }
     return matches;
 }
@@ -718,9 +712,8 @@ STRINGLIB_API void STRINGLIB_CALL slString2Data(size32_t & __ret_len,void * & __
 STRINGLIB_API void STRINGLIB_CALL slStringToLowerCase(unsigned & tgtLen, char * & tgt, unsigned srcLen, const char * src)
 {
     char * res = (char *)CTXMALLOC(parentCtx, srcLen);
-    
-    for (unsigned int i=0;i<srcLen;i++)
-        res[i] = tolower(src[i]);
+    memcpy_iflen(res, src, srcLen);
+    rtlStringToLower(srcLen, res);
     
     tgt = res;
     tgtLen = srcLen;
@@ -732,9 +725,8 @@ STRINGLIB_API void STRINGLIB_CALL slStringToLowerCase(unsigned & tgtLen, char *
 STRINGLIB_API void STRINGLIB_CALL slStringToUpperCase(unsigned & tgtLen, char * & tgt, unsigned srcLen, const char * src)
 {
     char * res = (char *)CTXMALLOC(parentCtx, srcLen);
-    
-    for (unsigned int i=0;i<srcLen;i++)
-        res[i] = toupper(src[i]);
+    memcpy_iflen(res, src, srcLen);
+    rtlStringToUpper(srcLen, res);
     
     tgt = res;
     tgtLen = srcLen;
@@ -266,4 +266,18 @@ def load_list(cx, ptr, elem_type):
 
 */
 
+/*  load_byte_list  -------------------------------------------------------------------------------------
+
+  load_list specialised for list<u8>, returning the range rather than copying the elements
+
+*/
+std::pair<uint32_t /*ptr*/, uint32_t /*byte length*/> load_byte_list(const wasmtime::Span<uint8_t> &data, uint32_t ptr)
+{
+    uint32_t begin = load_int<uint32_t>(data, ptr);
+    uint32_t length = load_int<uint32_t>(data, ptr + 4);
+    if ((uint64_t)begin + length > data.size())
+        throw makeStringException(1, "Out of bounds");
+    return std::make_pair(begin, length);
+}
+
 //  Storing  ---
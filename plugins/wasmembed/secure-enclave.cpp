@@ -1,6 +1,7 @@
 #include "secure-enclave.hpp"
 
 #include "eclrtl_imp.hpp"
+#include "rtlds_imp.hpp"
 #include "jexcept.hpp"
 #include "jiface.hpp"
 #include "eclhelper.hpp"
@@ -9,7 +10,9 @@
 #include "abi.hpp"
 #include "util.hpp"
 
+#include <atomic>
 #include <mutex>
+#include <unordered_set>
 #include <filesystem>
 
 // From deftype.hpp in common
@@ -24,11 +27,17 @@
     {                      \
     } while (0)
 #endif
+//  Compiled modules are shared by all queries and workunits.  They are identified by the module name combined with a
+//  hash of the wasm binary, so that queries using different versions of a module with the same name do not clash, and
+//  queries using identical modules only compile them once.
 class WasmEngine
 {
 private:
-    std::once_flag wasmLoadedFlag;
+    std::mutex cacheMutex;
     std::unordered_map<std::string, wasmtime::Module> wasmModules;
+    std::unordered_map<std::string, unsigned> moduleQueryCount;                     //  module key -> number of queries using it
+    std::unordered_map<std::string, std::string> manifestModuleKeys;                //  manifest path -> module key
+    std::unordered_map<std::string, std::unordered_set<std::string>> queryModules;  //  query id -> module keys
 
     wasmtime::Module createModule(const std::string &wasmName, const wasmtime::Span<uint8_t> &wasm)
     {
@@ -51,29 +60,49 @@ private:
         }
     }
 
-    void loadWasmFiles(ICodeContext *codeCtx)
+    std::string loadWasmFile(const char *path, const std::string &wasmName)
     {
-        TRACE("WasmEngine loadWasmFiles");
-        IEngineContext *engine = codeCtx->queryEngineContext();
-        if (!engine)
-            throw makeStringException(100, "Failed to get engine context");
-
-        StringArray manifestModules;
-        engine->getManifestFiles("wasm", manifestModules);
+        TRACE("WasmEngine loadWasmFile %s", path);
+        std::vector<uint8_t> contents = readWasmBinaryToBuffer(path);
+        hash64_t hash = rtlHash64Data(contents.size(), contents.data(), HASH64_INIT);
+        VStringBuffer moduleKey("%s@%016" I64F "x", wasmName.c_str(), hash);
+        std::string key(moduleKey.str());
+        if (wasmModules.find(key) == wasmModules.end())
+            wasmModules.insert(std::make_pair(key, createModule(path, contents)));
+        return key;
+    }
 
-        ForEachItemIn(idx, manifestModules)
+    //  Called when a query is unloaded - modules that no other query uses are released
+    void releaseQuery(const char *queryId)
+    {
+        TRACE("WasmEngine releaseQuery %s", queryId);
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto found = queryModules.find(queryId);
+        if (found == queryModules.end())
+            return;
+        for (const std::string &key : found->second)
         {
-            const char *path = manifestModules.item(idx);
-            TRACE("WasmEngine loadWasmFiles %s", path);
-            std::vector<uint8_t> contents = readWasmBinaryToBuffer(path);
-            auto module = createModule(path, contents);
-            std::filesystem::path p(path);
-            wasmModules.insert(std::make_pair(p.stem(), module));
+            if (--moduleQueryCount[key])
+                continue;
+            moduleQueryCount.erase(key);
+            wasmModules.erase(key);
+            for (auto it = manifestModuleKeys.begin(); it != manifestModuleKeys.end();)
+            {
+                if (it->second == key)
+                    it = manifestModuleKeys.erase(it);
+                else
+                    ++it;
+            }
         }
+        queryModules.erase(found);
     }
 
+    static void onQueryUnloaded(const char *queryId);
+    static void onContextTerminated(const char *);
+
 public:
     wasmtime::Engine engine;
+    std::atomic<unsigned> contextGeneration{0};     //  changes whenever a query or engine context terminates
 
     WasmEngine()
     {
@@ -85,29 +114,100 @@ public:
         TRACE("WASM SE ~WasmEngine");
     }
 
-    void setCodeContext(ICodeContext *codeCtx)
-    {
-        TRACE("WASM SE setCodeContext");
-        std::call_once(wasmLoadedFlag, &WasmEngine::loadWasmFiles, this, codeCtx);
-    }
-
-    bool hasModule(const std::string &wasmName) const
+    //  Returns the key of the compiled module for the named wasm file in the query's manifest
+    std::string resolveModule(IEngineContext *engineCtx, const std::string &wasmName)
     {
-        TRACE("WASM SE hasModule");
-        return wasmModules.find(wasmName) != wasmModules.end();
+        TRACE("WASM SE resolveModule %s", wasmName.c_str());
+        StringArray manifestModules;
+        engineCtx->getManifestFiles("wasm", manifestModules);
+        ForEachItemIn(idx, manifestModules)
+        {
+            const char *path = manifestModules.item(idx);
+            std::filesystem::path p(path);
+            if (p.stem() != wasmName)
+                continue;
+
+            StringBuffer queryId;
+            engineCtx->getQueryId(queryId, true);
+            //  The caller caches the key until the engine context terminates
+            engineCtx->onTermination(onContextTerminated, queryId.str(), false);
+
+            //  Compilation is done inside the lock, so that a module is never compiled twice
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            std::string key;
+            auto found = manifestModuleKeys.find(path);
+            if (found != manifestModuleKeys.end())
+                key = found->second;
+            else
+            {
+                key = loadWasmFile(path, wasmName);
+                manifestModuleKeys.insert(std::make_pair(std::string(path), key));
+            }
+            auto query = queryModules.find(queryId.str());
+            if (query == queryModules.end())
+            {
+                query = queryModules.insert(std::make_pair(std::string(queryId.str()), std::unordered_set<std::string>())).first;
+                engineCtx->onTermination(onQueryUnloaded, queryId.str(), true);
+            }
+            if (query->second.insert(key).second)
+                moduleQueryCount[key]++;
+            return key;
+        }
+        throw makeStringExceptionV(100, "Wasm module not found: %s", wasmName.c_str());
     }
 
-    wasmtime::Module getModule(const std::string &wasmName) const
+    wasmtime::Module getModule(const std::string &moduleKey)
     {
         TRACE("WASM SE getModule");
-        auto found = wasmModules.find(wasmName);
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto found = wasmModules.find(moduleKey);
         if (found == wasmModules.end())
-            throw makeStringExceptionV(100, "Wasm module not found: %s", wasmName.c_str());
+            throw makeStringExceptionV(100, "Wasm module not found: %s", moduleKey.c_str());
         return found->second;
     }
 };
 static std::unique_ptr<WasmEngine> wasmEngine = std::make_unique<WasmEngine>();
 
+void WasmEngine::onQueryUnloaded(const char *queryId)
+{
+    wasmEngine->releaseQuery(queryId);
+    wasmEngine->contextGeneration++;
+}
+
+void WasmEngine::onContextTerminated(const char *)
+{
+    wasmEngine->contextGeneration++;
+}
+
+//  Each thread remembers the module keys resolved for the engine context it last used, so that the manifest is only
+//  searched on the first call.  The keys are forgotten when any context terminates, since its address may be reused.
+struct ModuleKeyCache
+{
+    const IEngineContext *engineCtx = nullptr;
+    unsigned generation = 0;
+    std::unordered_map<std::string, std::string> moduleKeys;   //  wasm name -> module key
+};
+thread_local ModuleKeyCache moduleKeyCache;
+
+static const std::string &queryModuleKey(ICodeContext *codeCtx, const std::string &wasmName)
+{
+    IEngineContext *engineCtx = codeCtx ? codeCtx->queryEngineContext() : nullptr;
+    if (!engineCtx)
+        throw makeStringException(100, "Failed to get engine context");
+    unsigned generation = wasmEngine->contextGeneration;
+    if ((moduleKeyCache.engineCtx != engineCtx) || (moduleKeyCache.generation != generation))
+    {
+        moduleKeyCache.moduleKeys.clear();
+        moduleKeyCache.engineCtx = engineCtx;
+        moduleKeyCache.generation = generation;
+    }
+    auto found = moduleKeyCache.moduleKeys.find(wasmName);
+    if (found != moduleKeyCache.moduleKeys.end())
+        return found->second;
+    std::string key = wasmEngine->resolveModule(engineCtx, wasmName);
+    return moduleKeyCache.moduleKeys.insert(std::make_pair(wasmName, key)).first->second;
+}
+
 class WasmStore
 {
 private:
@@ -128,6 +228,11 @@ public:
         TRACE("WASM SE ~WasmStore");
     }
 
+    size_t numInstances() const
+    {
+        return wasmInstances.size();
+    }
+
     bool hasInstance(const std::string &wasmName) const
     {
         TRACE("WASM SE hasInstance");
@@ -267,22 +372,66 @@ public:
         return found->second.data(store.context());
     }
 };
-thread_local std::unique_ptr<WasmStore> wasmStore = std::make_unique<WasmStore>();
+
+//  Each thread keeps an instance of every module it has called, so that instantiation only happens on the first call.
+//  A store cannot release individual instances, so once it holds too many the thread starts again with a new store.
+//  Function contexts hold a reference to the store they were created with, so that an active call is not affected.
+static constexpr size_t maxThreadInstances = 32;
+thread_local std::shared_ptr<WasmStore> wasmStore = std::make_shared<WasmStore>();
+
+class WasmRowStream : public CInterfaceOf<IRowStream>
+{
+    ConstPointerArray rows;
+    unsigned nextIdx = 0;
+
+public:
+    WasmRowStream(IEngineRowAllocator *resultAllocator, size32_t rowSize, const uint8_t *data, uint32_t bytes)
+    {
+        for (uint32_t offset = 0; offset + rowSize <= bytes; offset += rowSize)
+        {
+            RtlDynamicRowBuilder rowBuilder(resultAllocator);
+            memcpy(rowBuilder.getSelf(), data + offset, rowSize);
+            rows.append(rowBuilder.finalizeRowClear(rowSize));
+        }
+    }
+
+    ~WasmRowStream()
+    {
+        stop();
+    }
+
+    virtual const void *nextRow() override
+    {
+        if (nextIdx >= rows.ordinality())
+            return nullptr;
+        const void *row = rows.item(nextIdx);
+        rows.replace(nullptr, nextIdx++);
+        return row;
+    }
+
+    virtual void stop() override
+    {
+        while (nextIdx < rows.ordinality())
+            rtlReleaseRow(rows.item(nextIdx++));
+    }
+};
 
 class SecureFunction : public CInterfaceOf<IEmbedFunctionContext>
 {
+    ICodeContext *codeCtx = nullptr;
     std::string wasmName;
     std::string funcName;
+    std::string moduleKey;
     std::string qualifiedID;
+    std::shared_ptr<WasmStore> store;
 
     std::vector<wasmtime::Val> args;
     std::vector<wasmtime::Val> wasmResults;
 
 public:
-    SecureFunction(ICodeContext *codeCtx)
+    SecureFunction(ICodeContext *_codeCtx) : codeCtx(_codeCtx)
     {
         TRACE("WASM SE se:constructor");
-        wasmEngine->setCodeContext(codeCtx);
     }
 
     virtual ~SecureFunction()
@@ -291,12 +440,14 @@ public:
 
         //  Garbage Collection  ---
         //    Function results  ---
-        auto gc_func_name = createQualifiedID(wasmName, "cabi_post_" + funcName);
-        if (wasmStore->hasFunc(gc_func_name))
+        if (!store)
+            return;
+        auto gc_func_name = createQualifiedID(moduleKey, "cabi_post_" + funcName);
+        if (store->hasFunc(gc_func_name))
         {
             for (auto &result : wasmResults)
             {
-                wasmStore->call(gc_func_name, {result});
+                store->call(gc_func_name, {result});
             }
         }
     }
@@ -381,9 +532,9 @@ public:
     {
         TRACE("WASM SE bindUTF8Param %s %d %s", name, chars, val);
         auto bytes = rtlUtf8Size(chars, val);
-        auto memIdxVar = wasmStore->callRealloc(wasmName, {0, 0, 1, (int32_t)bytes});
+        auto memIdxVar = store->callRealloc(moduleKey, {0, 0, 1, (int32_t)bytes});
         auto memIdx = memIdxVar[0].i32();
-        auto mem = wasmStore->getData(wasmName);
+        auto mem = store->getData(moduleKey);
         memcpy(&mem[memIdx], val, bytes);
         args.push_back(memIdx);
         args.push_back((int32_t)bytes);
@@ -445,7 +596,7 @@ public:
         switch (typecode)
         {
         case type_boolean:
-            memIdxVar = wasmStore->callRealloc(wasmName, {0, 0, 1, (int32_t)numElems});
+            memIdxVar = store->callRealloc(moduleKey, {0, 0, 1, (int32_t)numElems});
             memIdx = memIdxVar[0].i32();
             break;
         default:
@@ -453,7 +604,7 @@ public:
             break;
         }
 
-        auto mem = wasmStore->getData(wasmName);
+        auto mem = store->getData(moduleKey);
         size32_t thisSize = elemSize;
         for (int idx = 0; idx < numElems; idx++)
         {
@@ -480,7 +631,25 @@ public:
     virtual void bindDatasetParam(const char *name, IOutputMetaData &metaVal, IRowStream *val)
     {
         TRACE("WASM SE bindDatasetParam %s %p", name, val);
-        throw makeStringException(200, "bindDatasetParam not implemented");
+        //  Datasets of fixed-size rows are passed in bulk as a list<u8> containing all the rows in their ECL layout
+        if (!metaVal.isFixedSize())
+            throw makeStringException(200, "bindDatasetParam only supports fixed-size records");
+        size32_t rowSize = metaVal.getFixedSize();
+        MemoryBuffer rows;
+        for (;;)
+        {
+            const void *row = val->ungroupedNextRow();
+            if (!row)
+                break;
+            rows.append(rowSize, row);
+            rtlReleaseRow(row);
+        }
+        auto memIdxVar = store->callRealloc(moduleKey, {0, 0, 1, (int32_t)rows.length()});
+        auto memIdx = memIdxVar[0].i32();
+        auto mem = store->getData(moduleKey);
+        memcpy(&mem[memIdx], rows.toByteArray(), rows.length());
+        args.push_back(memIdx);
+        args.push_back((int32_t)rows.length());
     }
     virtual bool getBooleanResult()
     {
@@ -519,7 +688,7 @@ public:
     {
         TRACE("WASM SE getStringResult %zu", wasmResults.size());
         auto ptr = wasmResults[0].i32();
-        auto data = wasmStore->getData(wasmName);
+        auto data = store->getData(moduleKey);
         uint32_t strPtr;
         std::string encoding;
         uint32_t bytes;
@@ -531,7 +700,7 @@ public:
     {
         TRACE("WASM SE getUTF8Result");
         auto ptr = wasmResults[0].i32();
-        auto data = wasmStore->getData(wasmName);
+        auto data = store->getData(moduleKey);
         uint32_t strPtr;
         std::string encoding;
         uint32_t bytes;
@@ -545,7 +714,7 @@ public:
     {
         TRACE("WASM SE getUnicodeResult");
         auto ptr = wasmResults[0].i32();
-        auto data = wasmStore->getData(wasmName);
+        auto data = store->getData(moduleKey);
         uint32_t strPtr;
         std::string encoding;
         uint32_t bytes;
@@ -557,15 +726,26 @@ public:
     {
         TRACE("WASM SE getSetResult %d %d %zu", elemType, elemSize, wasmResults.size());
         auto ptr = wasmResults[0].i32();
-        auto data = wasmStore->getData(wasmName);
+        auto data = store->getData(moduleKey);
 
         throw makeStringException(200, "getSetResult not implemented");
     }
     virtual IRowStream *getDatasetResult(IEngineRowAllocator *_resultAllocator)
     {
         TRACE("WASM SE getDatasetResult");
-        throw makeStringException(200, "getDatasetResult not implemented");
-        return NULL;
+        //  The result is a list<u8> of fixed-size rows, which are copied before the guest memory is released
+        IOutputMetaData *meta = _resultAllocator->queryOutputMeta();
+        if (!meta->isFixedSize())
+            throw makeStringException(200, "getDatasetResult only supports fixed-size records");
+        size32_t rowSize = meta->getFixedSize();
+        auto ptr = wasmResults[0].i32();
+        auto data = store->getData(moduleKey);
+        uint32_t listPtr;
+        uint32_t bytes;
+        std::tie(listPtr, bytes) = load_byte_list(data, ptr);
+        if (bytes % rowSize)
+            throw makeStringExceptionV(200, "getDatasetResult: %u bytes is not a multiple of the record size %u", bytes, rowSize);
+        return new WasmRowStream(_resultAllocator, rowSize, &data[listPtr], bytes);
     }
     virtual byte *getRowResult(IEngineRowAllocator *_resultAllocator)
     {
@@ -605,18 +785,22 @@ public:
     {
         TRACE("WASM SE importFunction: %s", qualifiedName);
 
-        qualifiedID = std::string(qualifiedName, lenChars);
-        std::tie(wasmName, funcName) = splitQualifiedID(qualifiedID);
+        std::tie(wasmName, funcName) = splitQualifiedID(std::string(qualifiedName, lenChars));
+        moduleKey = queryModuleKey(codeCtx, wasmName);
+        qualifiedID = createQualifiedID(moduleKey, funcName);
 
-        if (!wasmStore->hasInstance(wasmName))
+        if (!wasmStore->hasInstance(moduleKey))
         {
-            wasmStore->registerInstance(wasmName);
+            if (wasmStore->numInstances() >= maxThreadInstances)
+                wasmStore = std::make_shared<WasmStore>();
+            wasmStore->registerInstance(moduleKey);
         }
+        store = wasmStore;
     }
     virtual void callFunction()
     {
         TRACE("WASM SE callFunction %s", qualifiedID.c_str());
-        wasmResults = wasmStore->call(qualifiedID, args);
+        wasmResults = store->call(qualifiedID, args);
     }
 };
 
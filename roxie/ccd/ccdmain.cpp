@@ -29,6 +29,7 @@
 #include <jencrypt.hpp>
 #include "jutil.hpp"
 #include "jsecrets.hpp"
+#include "jprofiler.hpp"
 #include "udptopo.hpp"
 
 #include "rtlformat.hpp"
@@ -1219,6 +1220,10 @@ int CCD_API roxie_main(int argc, const char *argv[], const char * defaultYaml)
         IBYTIbufferLifetime = topology->getPropInt("@IBYTIbufferLifetime", initIbytiDelay);
         traceTranslations = topology->getPropBool("@traceTranslations", true);
         defaultTimeActivities = topology->getPropBool("@timeActivities", true);
+        setCollectHardwareCounters(topology->getPropBool("@hardwareCounters", false));
+        unsigned profileSampleRate = topology->getPropInt("@profileSampleRate", 0);
+        if (profileSampleRate)
+            startSamplingProfiler(profileSampleRate);
         defaultTraceEnabled = topology->getPropBool("@traceEnabled", false);
         defaultTraceLimit = topology->getPropInt("@traceLimit", 10);
         clientCert.certificate.set(topology->queryProp("@certificateFileName"));
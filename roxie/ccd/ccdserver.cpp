@@ -466,7 +466,8 @@ static const StatisticsMapping actStatistics({StWhenFirstRow, StTimeElapsed, StT
                                               StNumRowsProcessed, StNumSlaves, StNumStarts, StNumStops, StNumStrands,
                                               StNumScansPerRow, StNumAllocations, StNumAllocationScans,
                                               StWhenStarted, StTimeStart, StCycleStartCycles,
-                                              StTimeFirstExecute, StCycleDependenciesCycles, StCycleLocalExecuteCycles, StCycleTotalExecuteCycles});
+                                              StTimeFirstExecute, StCycleDependenciesCycles, StCycleLocalExecuteCycles, StCycleTotalExecuteCycles,
+                                              StNumHwCycles, StNumHwInstructions, StNumHwCacheMisses, StNumHwBranchMisses});
 static const StatisticsMapping joinStatistics({StNumAtmostTriggered}, actStatistics);
 static const StatisticsMapping keyedJoinStatistics({ StNumServerCacheHits, StNumIndexSeeks, StNumIndexScans, StNumIndexWildSeeks,
                                                     StNumIndexSkips, StNumIndexNullSkips, StNumIndexMerges, StNumIndexMergeCompares,
@@ -1167,6 +1168,7 @@ public:
         timeActivities = defaultTimeActivities;
         collectFactoryStatistics = defaultCollectFactoryStatistics && !debugging;
         aborted = false;
+        activityStats.profileActivityId = activityId;
         executeDependenciesSequentially = factory->executeDependenciesSequentially() || _ctx->queryOptions().executeDependenciesSequentially;
         traceActivityCharacteristics = _ctx->queryOptions().traceActivityCharacteristics;
     }
@@ -2153,6 +2155,7 @@ public:
     explicit StrandProcessor(CRoxieServerActivity &_parent, IEngineRowStream *_inputStream, bool needsAllocator)
       : parent(_parent), inputStream(_inputStream), stats(parent.queryStatsMapping()), timeActivities(_parent.timeActivities), abortRequested(false)
     {
+        activityStats.profileActivityId = parent.queryId();
         if (needsAllocator)
         {
             rowAllocator = parent.createRowAllocatorEx(parent.queryOutputMeta(), roxiemem::RHFunique);
@@ -22,6 +22,7 @@
 #include "jhash.hpp"
 #include "jsort.hpp"
 #include "jregexp.hpp"
+#include "jprofiler.hpp"
 
 #include "udptopo.hpp"
 #include "ccd.hpp"
@@ -2687,6 +2688,26 @@ private:
                 perf.traceFor(perfTime);
                 reply.append(perf.queryResult().str());
             }
+            else if (stricmp(queryName, "control:profile")==0)
+            {
+                // @rate starts (or with 0 stops) the sampling profiler, otherwise the folded stacks collected so far are returned
+                if (control->hasProp("@rate"))
+                {
+                    unsigned rate = control->getPropInt("@rate", 0);
+                    stopSamplingProfiler();
+                    if (rate)
+                        startSamplingProfiler(rate);
+                    topology->setPropInt("@profileSampleRate", rate);
+                }
+                else
+                {
+                    StringBuffer profile;
+                    getSamplingProfile(profile, control->getPropBool("@reset", false));
+                    reply.append("<Profile>");
+                    encodeXML(profile, reply);
+                    reply.append("</Profile>");
+                }
+            }
             else if (stricmp(queryName, "control:pingInterval")==0)
             {
                 unsigned newInterval = (unsigned) control->getPropInt64("@val", 0);
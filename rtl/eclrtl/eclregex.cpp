@@ -22,8 +22,13 @@
 #include <regex>
 #endif
 #include "platform.h"
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include "jlib.hpp"
 #include "eclrtl.hpp"
 #include "eclrtl_imp.hpp"
+#include "rtlregex.hpp"
 #ifdef _USE_ICU
 #include "unicode/regex.h"
 #endif
@@ -49,33 +54,169 @@ using std::cmatch;
 using std::match_results;
 #endif
 
+//A compiled regular expression.  These are shared by all the queries and threads that use the same pattern.
+class RegexCacheEntry
+{
+public:
+    RegexCacheEntry(const char * _regExp, bool _isCaseSensitive)
+    {
+        try
+        {
+#if defined(_USE_BOOST_REGEX)
+            if (_isCaseSensitive)
+                regEx.assign(_regExp, regex::perl);
+            else
+                regEx.assign(_regExp, regex::perl | regex::icase);
+#else
+            if (_isCaseSensitive)
+                regEx.assign(_regExp, regex::ECMAScript);
+            else
+                regEx.assign(_regExp, regex::ECMAScript | regex::icase);
+#endif
+        }
+#if defined(_USE_BOOST_REGEX)
+        catch(const boost::bad_expression & e)
+#else
+        catch(const std::regex_error & e)
+#endif
+        {
+            std::string msg = "Bad regular expression: ";
+            msg += e.what();
+            msg += ": ";
+            msg += _regExp;
+            rtlFail(0, msg.c_str());  //throws
+        }
+
+#if defined(_USE_BOOST_REGEX)
+        //The linear time matcher follows the boost (perl) syntax and semantics, which differ from std::regex
+        dfa.reset(RegexDfa::create(_regExp, _isCaseSensitive));
+#endif
+    }
+
+    //Returns false if the pattern definitely does not match, true if it matches or might match
+    inline bool mayMatch(const char * start, const char * end) const
+    {
+        return !dfa || dfa->matches(start, end);
+    }
+
+public:
+    regex regEx;
+    std::unique_ptr<RegexDfa> dfa;      // only set if the pattern is supported
+};
+
+//A bounded cache of the most recently used patterns, so that patterns which are built dynamically (and compiled
+//for each row) or are used by many queries are only compiled once.
+class RegexCache
+{
+    typedef std::shared_ptr<const RegexCacheEntry> Entry;
+    typedef std::list<std::pair<std::string, Entry>> LruList;
+
+public:
+    RegexCache(unsigned _maxEntries) : maxEntries(_maxEntries) {}
+
+    Entry get(const char * pattern, bool isCaseSensitive)
+    {
+        std::string key(pattern);
+        key += isCaseSensitive ? 'Y' : 'N';
+        {
+            CriticalBlock block(cs);
+            auto match = entries.find(key);
+            if (match != entries.end())
+            {
+                lru.splice(lru.begin(), lru, match->second);
+                return match->second->second;
+            }
+        }
+
+        //Compile outside the critical section.  Errors throw, so invalid patterns are never cached.
+        Entry compiled = std::make_shared<const RegexCacheEntry>(pattern, isCaseSensitive);
+
+        CriticalBlock block(cs);
+        auto match = entries.find(key);
+        if (match != entries.end())
+            return match->second->second;   // another thread compiled it at the same time
+
+        lru.emplace_front(key, compiled);
+        entries.emplace(key, lru.begin());
+        if (entries.size() > maxEntries)
+        {
+            entries.erase(lru.back().first);
+            lru.pop_back();
+        }
+        return compiled;
+    }
+
+    unsigned size() const
+    {
+        CriticalBlock block(cs);
+        return (unsigned)entries.size();
+    }
+
+private:
+    mutable CriticalSection cs;
+    LruList lru;
+    std::unordered_map<std::string, LruList::iterator> entries;
+    unsigned maxEntries;
+};
+
+static constexpr unsigned maxRegexCacheEntries = 500;
+static RegexCache strRegexCache(maxRegexCacheEntries);
+
+//---------------------------------------------------------------------------
+
 class CStrRegExprFindInstance : implements IStrRegExprFindInstance
 {
 private:
-    bool            matched;
-    const regex * regEx;
-    cmatch   subs;
+    mutable bool    matched;
+    mutable bool    searched;   // the groups are only calculated when they are used
+    const RegexCacheEntry * compiled;
+    mutable cmatch  subs;
     char *          sample; //only required if findstr/findvstr will be called
+    const char *    start;
+    const char *    end;
 
 public:
-    CStrRegExprFindInstance(const regex * _regEx, const char * _str, size32_t _from, size32_t _len, bool _keep)
-        : regEx(_regEx)
+    CStrRegExprFindInstance(const RegexCacheEntry * _compiled, const char * _str, size32_t _from, size32_t _len, bool _keep)
+        : compiled(_compiled)
     {
         matched = false;
+        searched = false;
         sample = NULL;
+        if (_keep)
+        {
+            sample = (char *)rtlMalloc(_len + 1);  //required for findstr
+            memcpy(sample, _str + _from, _len);
+            sample[_len] = '\0';
+            start = sample;
+            end = sample + strlen(sample);
+        }
+        else
+        {
+            start = _str + _from;
+            end = _str + _len;
+        }
+
+        //The linear time matcher can determine whether there is a match, the (backtracking) search is only
+        //required if the groups are used.
+        if (compiled->dfa)
+            matched = compiled->dfa->matches(start, end);
+        else
+            search();
+    }
+
+    ~CStrRegExprFindInstance() //CAVEAT non-virtual destructor !
+    {
+        free(sample);
+    }
+
+    void search() const
+    {
+        if (searched)
+            return;
+        searched = true;
         try
         {
-            if (_keep)
-            {
-                sample = (char *)rtlMalloc(_len + 1);  //required for findstr
-                memcpy(sample, _str + _from, _len);
-                sample[_len] = '\0';
-                matched = regex_search(sample, subs, *regEx);
-            }
-            else
-            {
-                matched = regex_search(_str + _from, _str + _len, subs, *regEx);
-            }
+            matched = regex_search(start, end, subs, compiled->regEx);
         }
         catch (const std::runtime_error & e)
         {
@@ -83,17 +224,11 @@ public:
             msg += e.what();
 #if defined(_USE_BOOST_REGEX)
             msg += "(regex: ";
-            msg += regEx->str();
+            msg += compiled->regEx.str();
             msg += ")";
 #endif
             rtlFail(0, msg.c_str());
         }
-
-    }
-
-    ~CStrRegExprFindInstance() //CAVEAT non-virtual destructor !
-    {
-        free(sample);
     }
 
     //IStrRegExprFindInstance
@@ -102,6 +237,8 @@ public:
 
     void getMatchX(unsigned & outlen, char * & out, unsigned n = 0) const
     {
+        if (matched)
+            search();
         if (matched && (n < subs.size()))
         {
             outlen = subs[n].second - subs[n].first;
@@ -117,6 +254,8 @@ public:
 
     char const * findvstr(unsigned outlen, char * out, unsigned n = 0)
     {
+        if (matched)
+            search();
         if (matched && (n < subs.size()))
         {
             unsigned sublen = subs[n].second - subs[n].first;
@@ -138,43 +277,29 @@ public:
 class CCompiledStrRegExpr : implements ICompiledStrRegExpr
 {
 private:
-    regex    regEx;
+    std::shared_ptr<const RegexCacheEntry> compiled;
+    const regex & regEx;
 
 public:
     CCompiledStrRegExpr(const char * _regExp, bool _isCaseSensitive = false)
+        : compiled(strRegexCache.get(_regExp, _isCaseSensitive)), regEx(compiled->regEx)
     {
-        try
-        {
-#if defined(_USE_BOOST_REGEX)
-            if (_isCaseSensitive)
-                regEx.assign(_regExp, regex::perl);
-            else
-                regEx.assign(_regExp, regex::perl | regex::icase);
-#else
-            if (_isCaseSensitive)
-                regEx.assign(_regExp, regex::ECMAScript);
-            else
-                regEx.assign(_regExp, regex::ECMAScript | regex::icase);
-#endif
-        }
-#if defined(_USE_BOOST_REGEX)
-        catch(const boost::bad_expression & e)
-#else
-        catch(const std::regex_error & e)
-#endif
-        {
-            std::string msg = "Bad regular expression: ";
-            msg += e.what();
-            msg += ": ";
-            msg += _regExp;
-            rtlFail(0, msg.c_str());  //throws
-        }
     }
 
+    const RegexCacheEntry * queryEntry() const { return compiled.get(); }
+
     //ICompiledStrRegExpr
 
     void replace(size32_t & outlen, char * & out, size32_t slen, char const * str, size32_t rlen, char const * replace) const
     {
+        if (!compiled->mayMatch(str, str + slen))
+        {
+            outlen = slen;
+            out = (char *)rtlMalloc(outlen);
+            memcpy_iflen(out, str, outlen);
+            return;
+        }
+
         std::string src(str, str + slen);
         std::string fmt(replace, replace + rlen);
         std::string tgt;
@@ -205,7 +330,7 @@ public:
 
     IStrRegExprFindInstance * find(const char * str, size32_t from, size32_t len, bool needToKeepSearchString) const
     {
-        CStrRegExprFindInstance * findInst = new CStrRegExprFindInstance(&regEx, str, from, len, needToKeepSearchString);
+        CStrRegExprFindInstance * findInst = new CStrRegExprFindInstance(compiled.get(), str, from, len, needToKeepSearchString);
         return findInst;
     }
 
@@ -214,6 +339,13 @@ public:
         rtlRowBuilder out;
         size32_t outBytes = 0;
         const char * search_end = _search+_srcLen;
+        if (!compiled->mayMatch(_search, search_end))
+        {
+            __isAllResult = false;
+            __resultBytes = 0;
+            __result = nullptr;
+            return;
+        }
 
         regex_iterator<const char *> cur(_search, search_end, regEx);
         regex_iterator<const char *> end; // Default contructor creates an end of list marker
@@ -46,6 +46,13 @@
 #include "rtlqstr.ipp"
 
 #include "roxiemem.hpp"
+#include "jset.hpp"
+
+//SSE2 is part of the x86-64 baseline, so the vectorized string functions do not need to check the cpu at runtime
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RTL_USE_SSE2
+#endif
 
 #define UTF8_CODEPAGE "UTF-8"
 #define UTF8_MAXSIZE     4
@@ -1029,10 +1036,40 @@ done:
 done:
 
 
+//Returns true if the next 8 characters are all digits, and sets value to the number they represent.
+//Used to convert long numbers 8 digits at a time - the results (including overflow) are identical.
+static inline bool readEightDigits(const char * t, unsigned __int64 & value)
+{
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+    unsigned __int64 chunk;
+    memcpy(&chunk, t, sizeof(chunk));
+    //A byte is a digit if the top nibble is 3, and adding 6 does not change the top nibble
+    if ((chunk & 0xF0F0F0F0F0F0F0F0ULL) != 0x3030303030303030ULL)
+        return false;
+    if (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) != 0x3030303030303030ULL)
+        return false;
+
+    chunk -= 0x3030303030303030ULL;
+    chunk = (chunk * 10) + (chunk >> 8);    // pairs of digits
+    value = (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+             (((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+    return true;
+#else
+    return false;
+#endif
+}
+
 unsigned rtlStrToUInt4(size32_t l, const char * t)
 {
     SkipSpaces(l, t);
     unsigned v = 0;
+    unsigned __int64 digits;
+    while ((l >= 8) && readEightDigits(t, digits))
+    {
+        v = v * 100000000U + (unsigned)digits;
+        t += 8;
+        l -= 8;
+    }
     while (l--)
     {
         char c = *t++;
@@ -1048,6 +1085,13 @@ unsigned __int64 rtlStrToUInt8(size32_t l, const char * t)
 {
     SkipSpaces(l, t);
     unsigned __int64 v = 0;
+    unsigned __int64 digits;
+    while ((l >= 8) && readEightDigits(t, digits))
+    {
+        v = v * 100000000U + digits;
+        t += 8;
+        l -= 8;
+    }
     while (l--)
     {
         char c = *t++;
@@ -1064,6 +1108,13 @@ int rtlStrToInt4(size32_t l, const char * t)
     bool negate = false;
     SkipSignSpaces(l, t, negate);
     int v = 0;
+    unsigned __int64 digits;
+    while ((l >= 8) && readEightDigits(t, digits))
+    {
+        v = (int)((unsigned)v * 100000000U + (unsigned)digits);
+        t += 8;
+        l -= 8;
+    }
     while (l--)
     {
         char c = *t++;
@@ -1080,6 +1131,13 @@ __int64 rtlStrToInt8(size32_t l, const char * t)
     bool negate = false;
     SkipSignSpaces(l, t, negate);
     __uint64 v = 0;
+    unsigned __int64 digits;
+    while ((l >= 8) && readEightDigits(t, digits))
+    {
+        v = v * 100000000U + digits;
+        t += 8;
+        l -= 8;
+    }
     while (l--)
     {
         char c = *t++;
@@ -1974,6 +2032,17 @@ void rtlSubQStrFT(unsigned tlen, char * tgt, unsigned slen, const char * src, un
 
 unsigned rtlTrimStrLen(size32_t l, const char * t)
 {
+#ifdef RTL_USE_SSE2
+    const __m128i spaces = _mm_set1_epi8(' ');
+    while (l >= 16)
+    {
+        __m128i next = _mm_loadu_si128((const __m128i *)(t + l - 16));
+        unsigned nonSpaces = _mm_movemask_epi8(_mm_cmpeq_epi8(next, spaces)) ^ 0xFFFF;
+        if (nonSpaces)
+            return l - 16 + getMostSignificantBit(nonSpaces);
+        l -= 16;
+    }
+#endif
     while (l)
     {
         if (t[l-1] != ' ')
@@ -2735,6 +2804,25 @@ ECLRTL_API void rtlAssignTrimVUnicodeAllV(size32_t tlen, UChar * tgt, const UCha
 
 //-----------------------------------------------------------------------------
 
+//Returns the offset of the first character that is not a space, or len if they are all spaces
+static inline size32_t findFirstNonSpace(size32_t len, const char * str)
+{
+    size32_t offset = 0;
+#ifdef RTL_USE_SSE2
+    const __m128i spaces = _mm_set1_epi8(' ');
+    for (; offset + 16 <= len; offset += 16)
+    {
+        __m128i next = _mm_loadu_si128((const __m128i *)(str + offset));
+        unsigned nonSpaces = _mm_movemask_epi8(_mm_cmpeq_epi8(next, spaces)) ^ 0xFFFF;
+        if (nonSpaces)
+            return offset + countTrailingUnsetBits(nonSpaces);
+    }
+#endif
+    while ((offset != len) && (str[offset] == ' '))
+        offset++;
+    return offset;
+}
+
 int rtlCompareStrStr(unsigned l1, const char * p1, unsigned l2, const char * p2)
 {
     unsigned len = l1;
@@ -2745,12 +2833,14 @@ int rtlCompareStrStr(unsigned l1, const char * p1, unsigned l2, const char * p2)
     {
         if (len != l1)
         {
-            for (;(diff == 0) && (len != l1);len++)
+            len += findFirstNonSpace(l1 - len, p1 + len);
+            if (len != l1)
                 diff = ((unsigned char *)p1)[len] - ' ';
         }
         else if (len != l2)
         {
-            for (;(diff == 0) && (len != l2);len++)
+            len += findFirstNonSpace(l2 - len, p2 + len);
+            if (len != l2)
                 diff = ' ' - ((unsigned char *)p2)[len];
         }
     }
@@ -2764,12 +2854,9 @@ int rtlCompareVStrVStr(const char * p1, const char * p2)
 
 int rtlCompareStrBlank(unsigned l1, const char * p1)
 {
-    while (l1--)
-    {
-        int diff = (*(unsigned char *)(p1++)) - ' ';
-        if (diff)
-            return diff;
-    }
+    size32_t offset = findFirstNonSpace(l1, p1);
+    if (offset != l1)
+        return ((unsigned char *)p1)[offset] - ' ';
     return 0;
 }
 
@@ -2936,14 +3023,55 @@ ECLRTL_API int rtlPrefixDiffUnicode(unsigned l1, const UChar * p1, unsigned l2,
 
 //-----------------------------------------------------------------------------
 
+#ifdef RTL_USE_SSE2
+//Convert the case of 16 characters at a time.  Blocks containing non-ascii characters are converted using the
+//library functions since the results depend on the locale.  Returns the number of characters processed.
+static size32_t convertAsciiCase(size32_t l, char * t, bool toUpper)
+{
+    if (l < 16)
+        return 0;
+    //Only valid if the locale uses the normal mapping for ascii letters (not the case for turkish)
+    if ((tolower('I') != 'i') || (toupper('i') != 'I'))
+        return 0;
+
+    const __m128i first = _mm_set1_epi8(toUpper ? 'a' - 1 : 'A' - 1);
+    const __m128i last = _mm_set1_epi8(toUpper ? 'z' + 1 : 'Z' + 1);
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    size32_t offset = 0;
+    for (; offset + 16 <= l; offset += 16)
+    {
+        __m128i next = _mm_loadu_si128((const __m128i *)(t + offset));
+        if (unlikely(_mm_movemask_epi8(next)))
+        {
+            for (unsigned i=0; i < 16; i++)
+                t[offset+i] = toUpper ? toupper(t[offset+i]) : tolower(t[offset+i]);
+            continue;
+        }
+        __m128i isLetter = _mm_and_si128(_mm_cmpgt_epi8(next, first), _mm_cmplt_epi8(next, last));
+        _mm_storeu_si128((__m128i *)(t + offset), _mm_xor_si128(next, _mm_and_si128(isLetter, caseBit)));
+    }
+    return offset;
+}
+#endif
+
 void rtlStringToLower(size32_t l, char * t)
 {
+#ifdef RTL_USE_SSE2
+    size32_t done = convertAsciiCase(l, t, false);
+    l -= done;
+    t += done;
+#endif
     for (;l--;t++)
         *t = tolower(*t);
 }
 
 void rtlStringToUpper(size32_t l, char * t)
 {
+#ifdef RTL_USE_SSE2
+    size32_t done = convertAsciiCase(l, t, true);
+    l -= done;
+    t += done;
+#endif
     for (;l--;t++)
         *t = toupper(*t);
 }
@@ -3881,6 +4009,23 @@ hash64_t rtlHash64VUnicode(UChar const * k, hash64_t initval)
 
 
 
+//---------------------------------------------------------------------------
+
+hash64_t rtlFastHash64Data(size32_t len, const void *buf, hash64_t hval)
+{
+    return hashw64(buf, len, hval);
+}
+
+unsigned rtlFastHash32Data(size32_t len, const void *buf, unsigned hval)
+{
+    return hashw32(buf, len, hval);
+}
+
+hash64_t rtlFastHash64Str(size32_t len, const char *str, hash64_t hval)
+{
+    return hashw64(str, rtlTrimStrLen(len, str), hval);
+}
+
 //---------------------------------------------------------------------------
 // See http://www.isthe.com/chongo/tech/comp/fnv/index.html
 
@@ -6593,4 +6738,190 @@ protected:
 CPPUNIT_TEST_SUITE_REGISTRATION( EclRtlTests );
 CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( EclRtlTests, "EclRtlTests" );
 
+class EclRtlStringTests : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( EclRtlStringTests );
+        CPPUNIT_TEST(testTrimCompare);
+        CPPUNIT_TEST(testCase);
+        CPPUNIT_TEST(testStrToInt);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    //The simple versions of the functions, the vectorized versions must return identical results
+    static unsigned simpleTrimStrLen(size32_t l, const char * t)
+    {
+        while (l && (t[l-1] == ' '))
+            l--;
+        return l;
+    }
+
+    static int simpleCompareStrStr(unsigned l1, const char * p1, unsigned l2, const char * p2)
+    {
+        for (unsigned i=0; (i < l1) || (i < l2); i++)
+        {
+            int diff = (int)((i < l1) ? (byte)p1[i] : ' ') - (int)((i < l2) ? (byte)p2[i] : ' ');
+            if (diff)
+                return diff;
+        }
+        return 0;
+    }
+
+    static __int64 simpleStrToInt8(size32_t l, const char * t)
+    {
+        bool negate = false;
+        while (l && ((*t == ' ') || (*t == '\t') || (*t == '+') || (*t == '-')))
+        {
+            if (*t == '-')
+                negate = true;
+            l--;
+            t++;
+        }
+        unsigned __int64 v = 0;
+        while (l && (*t >= '0') && (*t <= '9'))
+        {
+            v = v * 10 + (*t++ - '0');
+            l--;
+        }
+        return negate ? (__int64)(0-v) : (__int64)v;
+    }
+
+    void testTrimCompare()
+    {
+        //Every length, and a non-space in every position, to test both the vectorized and the remaining characters
+        char left[100];
+        char right[100];
+        for (unsigned len=0; len < sizeof(left); len++)
+        {
+            memset(left, ' ', len);
+            CPPUNIT_ASSERT_EQUAL(0U, rtlTrimStrLen(len, left));
+            CPPUNIT_ASSERT_EQUAL(0, rtlCompareStrBlank(len, left));
+            for (unsigned pos=0; pos < len; pos++)
+            {
+                for (char c : { 'x', '\x01', '\xf0' })
+                {
+                    memset(left, ' ', len);
+                    memset(right, ' ', len);
+                    left[pos] = c;
+                    CPPUNIT_ASSERT_EQUAL(simpleTrimStrLen(len, left), rtlTrimStrLen(len, left));
+                    CPPUNIT_ASSERT_EQUAL(simpleCompareStrStr(len, left, 0, right), rtlCompareStrBlank(len, left));
+                    for (unsigned len2 : { 0U, pos/2, pos, len })
+                    {
+                        CPPUNIT_ASSERT_EQUAL(simpleCompareStrStr(len, left, len2, right), rtlCompareStrStr(len, left, len2, right));
+                        CPPUNIT_ASSERT_EQUAL(simpleCompareStrStr(len2, right, len, left), rtlCompareStrStr(len2, right, len, left));
+                    }
+                }
+            }
+        }
+    }
+
+    void testCase()
+    {
+        char source[256];
+        for (unsigned i=0; i < sizeof(source); i++)
+            source[i] = (char)(i * 37 + 11);
+        for (unsigned start=0; start < 64; start++)
+        {
+            for (unsigned len=0; len + start <= sizeof(source); len += 7)
+            {
+                char upper[256];
+                char lower[256];
+                memcpy(upper, source + start, len);
+                memcpy(lower, source + start, len);
+                rtlStringToUpper(len, upper);
+                rtlStringToLower(len, lower);
+                for (unsigned i=0; i < len; i++)
+                {
+                    CPPUNIT_ASSERT_EQUAL((char)toupper(source[start+i]), upper[i]);
+                    CPPUNIT_ASSERT_EQUAL((char)tolower(source[start+i]), lower[i]);
+                }
+            }
+        }
+    }
+
+    void testStrToInt()
+    {
+        const char * values[] = { "", "0", "-1", "  +42", "12345678", "123456789", "-1234567890123456", "12345678x12345678",
+                                  "1234567 8", "99999999999999999999", "18446744073709551615", "18446744073709551616",
+                                  "-9223372036854775808", "00000000000000000001", "4294967296", "1234567:", "1234567/" };
+        for (const char * value : values)
+        {
+            size32_t len = strlen(value);
+            __int64 expected = simpleStrToInt8(len, value);
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(value, expected, rtlStrToInt8(len, value));
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(value, (int)expected, rtlStrToInt4(len, value));
+            if (!strchr(value, '-'))
+            {
+                CPPUNIT_ASSERT_EQUAL_MESSAGE(value, (unsigned __int64)expected, rtlStrToUInt8(len, value));
+                CPPUNIT_ASSERT_EQUAL_MESSAGE(value, (unsigned)expected, rtlStrToUInt4(len, value));
+            }
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( EclRtlStringTests );
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( EclRtlStringTests, "EclRtlStringTests" );
+
+class EclRtlStringTiming : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( EclRtlStringTiming );
+        CPPUNIT_TEST(testTiming);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testTiming()
+    {
+        //Representative field sizes, each half filled, with the rest padded with spaces
+        const unsigned lengths[] = { 8, 20, 40, 100, 1000 };
+        for (unsigned len : lengths)
+        {
+            std::string value(len, ' ');
+            for (unsigned i=0; i < len/2; i++)
+                value[i] = 'a' + (i % 26);
+            std::string other(value);
+            char * text = const_cast<char *>(value.data());
+            const unsigned numIter = 200000000 / (len + 20);
+
+            unsigned total = 0;
+            cycle_t start = get_cycles_now();
+            for (unsigned i=0; i < numIter; i++)
+                total += rtlTrimStrLen(len - (i & 1), text);
+            cycle_t trimElapsed = get_cycles_now() - start;
+
+            start = get_cycles_now();
+            for (unsigned i=0; i < numIter; i++)
+                total += rtlCompareStrStr(len/2 + (i & 1), text, len, other.data());
+            cycle_t compareElapsed = get_cycles_now() - start;
+
+            start = get_cycles_now();
+            for (unsigned i=0; i < numIter; i++)
+            {
+                if (i & 1)
+                    rtlStringToLower(len, text);
+                else
+                    rtlStringToUpper(len, text);
+            }
+            cycle_t caseElapsed = get_cycles_now() - start;
+
+            DBGLOG("String length %4u: trim %.2fns compare %.2fns case %.2fns (%u)", len, (double)cycle_to_nanosec(trimElapsed) / numIter,
+                   (double)cycle_to_nanosec(compareElapsed) / numIter, (double)cycle_to_nanosec(caseElapsed) / numIter, total);
+        }
+
+        const char * numbers[] = { "7", "1234", "12345678", "1234567890123456" };
+        for (const char * number : numbers)
+        {
+            const unsigned numIter = 10000000;
+            size32_t len = strlen(number);
+            __int64 total = 0;
+            cycle_t start = get_cycles_now();
+            for (unsigned i=0; i < numIter; i++)
+                total += rtlStrToInt8(len - (i & 1), number);
+            cycle_t elapsed = get_cycles_now() - start;
+            DBGLOG("StrToInt8 %16s: %.2fns (%" I64F "d)", number, (double)cycle_to_nanosec(elapsed) / numIter, total);
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( EclRtlStringTiming );
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( EclRtlStringTiming, "EclRtlStringTiming" );
+
 #endif
@@ -395,6 +395,12 @@ ECLRTL_API unsigned rtlHash32Unicode(unsigned length, UChar const * k, unsigned
 ECLRTL_API unsigned rtlHash32Utf8(unsigned length, const char * k, unsigned initval);
 ECLRTL_API unsigned rtlHash32VUnicode(UChar const * k, unsigned initval);
 
+// Quicker hash functions for longer keys - not compatible with the functions above, so they are only used where the
+// hash values are never persisted, or by new ECL code that explicitly requests them.
+ECLRTL_API hash64_t rtlFastHash64Data(size32_t len, const void *buf, hash64_t hval);
+ECLRTL_API unsigned rtlFastHash32Data(size32_t len, const void *buf, unsigned hval);
+ECLRTL_API hash64_t rtlFastHash64Str(size32_t len, const char *str, hash64_t hval);  // trailing spaces are ignored
+
 ECLRTL_API unsigned rtlCrcData( unsigned length, const void *_k, unsigned initval);
 ECLRTL_API unsigned rtlCrcUnicode(unsigned length, UChar const * k, unsigned initval);
 ECLRTL_API unsigned rtlCrcUtf8(unsigned length, const char * k, unsigned initval);
@@ -575,6 +575,7 @@ void RtlLinkedDictionaryBuilder::init(IEngineRowAllocator * _rowAllocator, IHTho
         initialSize = 4;
     rowAllocator = LINK(_rowAllocator);
     table = NULL;
+    hashes = NULL;
     usedCount = 0;
     usedLimit = 0;
     tableSize = 0;
@@ -585,6 +586,7 @@ RtlLinkedDictionaryBuilder::~RtlLinkedDictionaryBuilder()
 //    builder.clear();
     if (table)
         rowAllocator->releaseRowset(tableSize, table);
+    rtlFree(hashes);
     ::Release(rowAllocator);
 }
 
@@ -601,32 +603,44 @@ void RtlLinkedDictionaryBuilder::appendOwn(const void * source)
     if (source)
     {
         checkSpace();
-        unsigned rowidx = hash->hash(source) % tableSize;
-        for (;;)
+        insertOwn(source, hash->hash(source));
+    }
+}
+
+void RtlLinkedDictionaryBuilder::insertOwn(const void * source, unsigned hashValue)
+{
+    unsigned rowidx = hashValue % tableSize;
+    for (;;)
+    {
+        const void *entry = table[rowidx];
+        if (!entry)
         {
-            const void *entry = table[rowidx];
-            if (entry && compare->docompare(source, entry)==0)
-            {
-                rowAllocator->releaseRow(source);
-                break;
-            }
-            if (!entry)
-            {
-                table[rowidx] = (byte *) source;
-                usedCount++;
-                break;
-            }
-            rowidx++;
-            if (rowidx==tableSize)
-                rowidx = 0;
+            table[rowidx] = (byte *) source;
+            hashes[rowidx] = hashValue;
+            usedCount++;
+            break;
         }
+        //Only rows with the same hash can be duplicates, so most collisions never touch the existing row
+        if ((hashes[rowidx] == hashValue) && compare->docompare(source, entry)==0)
+        {
+            rowAllocator->releaseRow(source);
+            break;
+        }
+        rowidx++;
+        if (rowidx==tableSize)
+            rowidx = 0;
     }
 }
 
+/*
+ * The table is resized once it is 3/4 full.  The size determines the order that a dictionary is iterated in, so it
+ * must match the sizes used by the code generator for constant dictionaries.
+ */
 void RtlLinkedDictionaryBuilder::checkSpace()
 {
     if (!table)
     {
+        hashes = (unsigned *)rtlMalloc(initialSize * sizeof(unsigned));
         table = rowAllocator->createRowset(initialSize);
         tableSize = initialSize;
         memset(table, 0, tableSize*sizeof(byte *));
@@ -635,20 +649,46 @@ void RtlLinkedDictionaryBuilder::checkSpace()
     }
     else if (usedCount >= usedLimit)
     {
-        // Rehash
+        // Rehash - using the saved hash values rather than calculating them again
         const byte * * oldTable = table;
+        unsigned * oldHashes = hashes;
         unsigned oldSize = tableSize;
-        table = rowAllocator->createRowset(tableSize*2);
+        unsigned * newHashes = (unsigned *)rtlMalloc(tableSize * 2 * sizeof(unsigned));
+        try
+        {
+            table = rowAllocator->createRowset(tableSize*2);
+        }
+        catch (...)
+        {
+            rtlFree(newHashes);
+            throw;
+        }
+        hashes = newHashes;
         tableSize = tableSize*2; // Don't update until we have successfully allocated, so that we remain consistent if createRowset throws an exception.
         memset(table, 0, tableSize * sizeof(byte *));
         usedLimit = (tableSize * 3) / 4;
         usedCount = 0;
-        unsigned i;
-        for (i = 0; i < oldSize; i++)
+        for (unsigned i = 0; i < oldSize; i++)
         {
-            append(oldTable[i]);  // we link the rows here...
+            const byte * row = oldTable[i];
+            if (row)
+            {
+                //The rows are already unique, so only an empty slot needs to be found
+                unsigned hashValue = oldHashes[i];
+                unsigned rowidx = hashValue % tableSize;
+                while (table[rowidx])
+                {
+                    rowidx++;
+                    if (rowidx==tableSize)
+                        rowidx = 0;
+                }
+                table[rowidx] = (const byte *) rowAllocator->linkRow(row);  // we link the rows here...
+                hashes[rowidx] = hashValue;
+                usedCount++;
+            }
         }
         rowAllocator->releaseRowset(oldSize, oldTable);   // ... because this will release them
+        rtlFree(oldHashes);
     }
 }
 
@@ -728,18 +768,32 @@ extern ECLRTL_API const byte *rtlDictionaryLookup(IHThorHashLookupInfo &hashInfo
 
 // Optimized cases for common single-field lookups
 
+// The dictionary table does not record the hashes of the rows (see RtlLinkedDictionaryBuilder), so every row that is
+// probed must be compared.  This rejects most non-matching string entries without a full comparison: a match must be
+// at least as long as the search string without trailing spaces, and if that is not blank it must start with the same
+// character.
+static inline bool mayMatchString(size32_t trimLen, const char *searchFor, size32_t entryLen, const char *entry)
+{
+    if (entryLen < trimLen)
+        return false;
+    return (trimLen == 0) || (entry[0] == searchFor[0]);
+}
+
 extern ECLRTL_API const byte *rtlDictionaryLookupString(size32_t tableSize, const byte **table, size32_t searchLen, const char *searchFor, const byte *defaultRow)
 {
     if (!tableSize)
         return (const byte *) rtlLinkRow(defaultRow);
-    unsigned hash = rtlHash32Data(rtlTrimStrLen(searchLen, searchFor), searchFor, HASH32_INIT);
+    size32_t trimLen = rtlTrimStrLen(searchLen, searchFor);
+    unsigned hash = rtlHash32Data(trimLen, searchFor, HASH32_INIT);
     unsigned rowidx = hash % tableSize;
     for (;;)
     {
         const char *entry = (const char *) table[rowidx];
         if (!entry)
             return (const byte *) rtlLinkRow(defaultRow);
-        if (rtlCompareStrStr(searchLen, searchFor, * (size32_t *) entry, entry+sizeof(size32_t))==0)
+        size32_t entryLen = * (size32_t *) entry;
+        const char *entryData = entry+sizeof(size32_t);
+        if (mayMatchString(trimLen, searchFor, entryLen, entryData) && rtlCompareStrStr(searchLen, searchFor, entryLen, entryData)==0)
             return (const byte *) rtlLinkRow(entry);
         rowidx++;
         if (rowidx==tableSize)
@@ -751,14 +805,15 @@ extern ECLRTL_API const byte *rtlDictionaryLookupStringN(size32_t tableSize, con
 {
     if (!tableSize)
         return (byte *) rtlLinkRow(defaultRow);
-    unsigned hash = rtlHash32Data(rtlTrimStrLen(searchLen, searchFor), searchFor, HASH32_INIT);
+    size32_t trimLen = rtlTrimStrLen(searchLen, searchFor);
+    unsigned hash = rtlHash32Data(trimLen, searchFor, HASH32_INIT);
     unsigned rowidx = hash % tableSize;
     for (;;)
     {
         const char *entry = (const char *) table[rowidx];
         if (!entry)
             return (byte *) rtlLinkRow(defaultRow);
-        if (rtlCompareStrStr(searchLen, searchFor, N, entry)==0)
+        if (mayMatchString(trimLen, searchFor, N, entry) && rtlCompareStrStr(searchLen, searchFor, N, entry)==0)
             return (byte *) rtlLinkRow(entry);
         rowidx++;
         if (rowidx==tableSize)
@@ -869,14 +924,17 @@ extern ECLRTL_API bool rtlDictionaryLookupExistsString(size32_t tableSize, const
 {
     if (!tableSize)
         return false;
-    unsigned hash = rtlHash32Data(rtlTrimStrLen(searchLen, searchFor), searchFor, HASH32_INIT);
+    size32_t trimLen = rtlTrimStrLen(searchLen, searchFor);
+    unsigned hash = rtlHash32Data(trimLen, searchFor, HASH32_INIT);
     unsigned rowidx = hash % tableSize;
     for (;;)
     {
         const char *entry = (const char *) table[rowidx];
         if (!entry)
             return false;
-        if (rtlCompareStrStr(searchLen, searchFor, * (size32_t *) entry, entry+sizeof(size32_t))==0)
+        size32_t entryLen = * (size32_t *) entry;
+        const char *entryData = entry+sizeof(size32_t);
+        if (mayMatchString(trimLen, searchFor, entryLen, entryData) && rtlCompareStrStr(searchLen, searchFor, entryLen, entryData)==0)
             return true;
         rowidx++;
         if (rowidx==tableSize)
@@ -888,14 +946,15 @@ extern ECLRTL_API bool rtlDictionaryLookupExistsStringN(size32_t tableSize, cons
 {
     if (!tableSize)
         return false;
-    unsigned hash = rtlHash32Data(rtlTrimStrLen(searchLen, searchFor), searchFor, HASH32_INIT);
+    size32_t trimLen = rtlTrimStrLen(searchLen, searchFor);
+    unsigned hash = rtlHash32Data(trimLen, searchFor, HASH32_INIT);
     unsigned rowidx = hash % tableSize;
     for (;;)
     {
         const char *entry = (const char *) table[rowidx];
         if (!entry)
             return false;
-        if (rtlCompareStrStr(searchLen, searchFor, N, entry)==0)
+        if (mayMatchString(trimLen, searchFor, N, entry) && rtlCompareStrStr(searchLen, searchFor, N, entry)==0)
             return true;
         rowidx++;
         if (rowidx==tableSize)
@@ -427,6 +427,7 @@ public:
 protected:
     void checkSpace();
     void init(IEngineRowAllocator * _rowAllocator, IHThorHashLookupInfo *_hashInfo, unsigned _initialTableSize);
+    void insertOwn(const void * source, unsigned hashValue);
 
 protected:
     IEngineRowAllocator *rowAllocator;
@@ -434,6 +435,7 @@ protected:
     ICompare *compare;
     RtlDynamicRowBuilder builder;
     const byte * * table;
+    unsigned * hashes;      // hash of the row in each slot of table - avoids comparing rows that cannot match, and rehashing rows when the table grows
     size32_t usedCount;
     size32_t usedLimit;
     size32_t initialSize;
@@ -0,0 +1,810 @@
+/*##############################################################################
+
+    HPCC SYSTEMS software Copyright (C) 2024 HPCC Systems®.
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+############################################################################## */
+
+#include "platform.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include "rtlregex.hpp"
+
+enum RegexStateType : byte { RSchars, RSsplit, RSempty, RSassert, RSmatch };
+enum RegexAssertion : unsigned { RAbeginLine, RAendLine, RAbeginText, RAendText, RAwordBoundary, RAnotWordBoundary, RAbeginWord, RAendWord };
+
+static constexpr unsigned maxNfaStates = 5000;
+static constexpr unsigned maxRepeat = 1000;
+static constexpr unsigned maxDfaStates = 1000;
+static constexpr unsigned maxDfaTransitions = 0x10000;
+static constexpr unsigned unboundedRepeat = (unsigned)-1;
+static constexpr unsigned matchedState = (unsigned)-1;    // dfa transition taken once a match has been found
+
+//The character classes match the ascii definitions, which is what boost uses in the C locale
+static bool isWordChar(unsigned c)  { return ((c < 0x80) && isalnum(c)) || (c == '_'); }
+static bool isSpaceChar(unsigned c) { return (c == ' ') || ((c >= '\t') && (c <= '\r')); }
+
+static byte getCategory(unsigned c)
+{
+    switch (c)
+    {
+    case '\n': return RegexDfa::CatLF;
+    case '\r': return RegexDfa::CatCR;
+    case '\f': return RegexDfa::CatFF;
+    }
+    return isWordChar(c) ? RegexDfa::CatWord : RegexDfa::CatOther;
+}
+
+//Matches the boost semantics - ^ and $ match at the start and end of each line, but not between \r and \n
+static bool checkAssertion(unsigned assertion, byte prevCat, byte nextCat)
+{
+    switch (assertion)
+    {
+    case RAbeginLine:
+        return (prevCat == RegexDfa::CatNone) || (prevCat == RegexDfa::CatLF) || (prevCat == RegexDfa::CatFF) ||
+               ((prevCat == RegexDfa::CatCR) && (nextCat != RegexDfa::CatLF));
+    case RAendLine:
+        return (nextCat == RegexDfa::CatNone) || (nextCat == RegexDfa::CatCR) || (nextCat == RegexDfa::CatFF) ||
+               ((nextCat == RegexDfa::CatLF) && (prevCat != RegexDfa::CatCR));
+    case RAbeginText:
+        return (prevCat == RegexDfa::CatNone);
+    case RAendText:
+        return (nextCat == RegexDfa::CatNone);
+    case RAwordBoundary:
+        return (prevCat == RegexDfa::CatWord) != (nextCat == RegexDfa::CatWord);
+    case RAnotWordBoundary:
+        //boost never matches \B at the start or end of the text
+        if ((prevCat == RegexDfa::CatNone) || (nextCat == RegexDfa::CatNone))
+            return false;
+        return (prevCat == RegexDfa::CatWord) == (nextCat == RegexDfa::CatWord);
+    case RAbeginWord:
+        return (prevCat != RegexDfa::CatWord) && (nextCat == RegexDfa::CatWord);
+    case RAendWord:
+        return (prevCat == RegexDfa::CatWord) && (nextCat != RegexDfa::CatWord);
+    }
+    return false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+struct RegexNode
+{
+    enum Kind { Chars, Concat, Alternate, Repeat, Assert, Empty };
+
+    RegexNode(Kind _kind, unsigned _value = 0) : kind(_kind), value(_value) {}
+
+    Kind kind;
+    unsigned value;             // the charset or assertion
+    unsigned min = 0;
+    unsigned max = 0;
+    std::vector<std::unique_ptr<RegexNode>> children;
+};
+
+typedef std::bitset<256> RegexCharset;
+
+//Parses the pattern and generates the NFA.  Any syntax that is not supported causes the parse to fail - the pattern
+//has already been successfully compiled by boost, so there is no need to report errors.
+class RegexDfaBuilder
+{
+public:
+    RegexDfaBuilder(RegexDfa & _dfa, const char * _pattern, bool _isCaseSensitive)
+        : dfa(_dfa), pattern(_pattern), isCaseSensitive(_isCaseSensitive)
+    {
+    }
+
+    bool build()
+    {
+        std::unique_ptr<RegexNode> root(parseAlternation());
+        if (!root || *cur)
+            return false;
+
+        dfa.states.push_back({ RSmatch, 0, 0, 0 });
+        dfa.startState = compile(*root, 0);
+        return !failed;
+    }
+
+protected:
+    RegexNode * parseAlternation()
+    {
+        std::unique_ptr<RegexNode> first(parseSequence());
+        if (!first || (*cur != '|'))
+            return first.release();
+
+        std::unique_ptr<RegexNode> alternate(new RegexNode(RegexNode::Alternate));
+        alternate->children.emplace_back(first.release());
+        while (*cur == '|')
+        {
+            cur++;
+            RegexNode * next = parseSequence();
+            if (!next)
+                return nullptr;
+            alternate->children.emplace_back(next);
+        }
+        return alternate.release();
+    }
+
+    RegexNode * parseSequence()
+    {
+        std::unique_ptr<RegexNode> sequence(new RegexNode(RegexNode::Concat));
+        while (*cur && (*cur != '|') && (*cur != ')'))
+        {
+            RegexNode * next = parseRepeat();
+            if (!next)
+                return nullptr;
+            sequence->children.emplace_back(next);
+        }
+        if (sequence->children.empty())
+            return new RegexNode(RegexNode::Empty);
+        if (sequence->children.size() == 1)
+            return sequence->children[0].release();
+        return sequence.release();
+    }
+
+    RegexNode * parseRepeat()
+    {
+        std::unique_ptr<RegexNode> atom(parseAtom());
+        if (!atom)
+            return nullptr;
+
+        for (;;)
+        {
+            unsigned min, max;
+            switch (*cur)
+            {
+            case '*':
+                min = 0;
+                max = unboundedRepeat;
+                cur++;
+                break;
+            case '+':
+                min = 1;
+                max = unboundedRepeat;
+                cur++;
+                break;
+            case '?':
+                min = 0;
+                max = 1;
+                cur++;
+                break;
+            case '{':
+                if (!parseRepeatRange(min, max))
+                    return nullptr;
+                break;
+            default:
+                return atom.release();
+            }
+
+            //Whether a repeat is lazy does not change whether there is a match, but possessive repeats do
+            if (*cur == '?')
+                cur++;
+            else if (*cur == '+')
+                return nullptr;
+
+            //boost does not always allow an iteration to match an empty string (e.g., (?:$)+ never matches), so
+            //avoid any differences by not supporting those repeats.
+            if (canMatchEmpty(*atom) && ((min != 0) || (max != 1)))
+                return nullptr;
+
+            std::unique_ptr<RegexNode> repeat(new RegexNode(RegexNode::Repeat));
+            repeat->min = min;
+            repeat->max = max;
+            repeat->children.emplace_back(atom.release());
+            atom.reset(repeat.release());
+        }
+    }
+
+    bool parseRepeatRange(unsigned & min, unsigned & max)
+    {
+        cur++;
+        if (!readNumber(min))
+            return false;
+        max = min;
+        if (*cur == ',')
+        {
+            cur++;
+            max = unboundedRepeat;
+            if ((*cur != '}') && !readNumber(max))
+                return false;
+        }
+        if (*cur != '}')
+            return false;
+        cur++;
+        return (min <= max) && (min <= maxRepeat) && ((max == unboundedRepeat) || (max <= maxRepeat));
+    }
+
+    bool readNumber(unsigned & value)
+    {
+        if (!isdigit((byte)*cur))
+            return false;
+        value = 0;
+        while (isdigit((byte)*cur))
+        {
+            value = value * 10 + (*cur++ - '0');
+            if (value > maxRepeat)
+                return false;
+        }
+        return true;
+    }
+
+    RegexNode * parseAtom()
+    {
+        byte next = *cur++;
+        switch (next)
+        {
+        case '(':
+        {
+            if (*cur == '?')
+            {
+                if (cur[1] != ':')
+                    return nullptr;
+                cur += 2;
+            }
+            std::unique_ptr<RegexNode> group(parseAlternation());
+            if (!group || (*cur != ')'))
+                return nullptr;
+            cur++;
+            return group.release();
+        }
+        case '.':
+            return createChars(RegexCharset().set());
+        case '[':
+            return parseSet();
+        case '^':
+            return new RegexNode(RegexNode::Assert, RAbeginLine);
+        case '$':
+            return new RegexNode(RegexNode::Assert, RAendLine);
+        case '\\':
+        {
+            switch (*cur)
+            {
+            case 'A':
+            case '`':
+                cur++;
+                return new RegexNode(RegexNode::Assert, RAbeginText);
+            case 'z':
+            case '\'':
+                cur++;
+                return new RegexNode(RegexNode::Assert, RAendText);
+            case 'b':
+                cur++;
+                return new RegexNode(RegexNode::Assert, RAwordBoundary);
+            case 'B':
+                cur++;
+                return new RegexNode(RegexNode::Assert, RAnotWordBoundary);
+            case '<':
+                cur++;
+                return new RegexNode(RegexNode::Assert, RAbeginWord);
+            case '>':
+                cur++;
+                return new RegexNode(RegexNode::Assert, RAendWord);
+            }
+            RegexCharset set;
+            if (!parseEscape(set))
+                return nullptr;
+            return createChars(set);
+        }
+        case ')': case '*': case '+': case '?': case '{':
+            return nullptr;
+        }
+
+        RegexCharset set;
+        set.set(next);
+        return createChars(set);
+    }
+
+    RegexNode * parseSet()
+    {
+        bool negate = false;
+        if (*cur == '^')
+        {
+            negate = true;
+            cur++;
+        }
+
+        RegexCharset set;
+        bool first = true;
+        while (first || (*cur != ']'))
+        {
+            first = false;
+            unsigned low;
+            if (!*cur)
+                return nullptr;
+            if (*cur == '[')
+            {
+                if (cur[1] == ':')
+                {
+                    if (!parseNamedClass(set))
+                        return nullptr;
+                    continue;
+                }
+                if ((cur[1] == '.') || (cur[1] == '='))
+                    return nullptr;
+            }
+            if (*cur == '\\')
+            {
+                cur++;
+                RegexCharset escaped;
+                if (!parseEscape(escaped))
+                    return nullptr;
+                if (escaped.count() != 1)
+                {
+                    set |= escaped;
+                    continue;
+                }
+                low = findFirst(escaped);
+            }
+            else
+                low = (byte)*cur++;
+
+            if ((*cur == '-') && cur[1] && (cur[1] != ']'))
+            {
+                cur++;
+                unsigned high;
+                if (*cur == '\\')
+                {
+                    cur++;
+                    RegexCharset escaped;
+                    if (!parseEscape(escaped) || (escaped.count() != 1))
+                        return nullptr;
+                    high = findFirst(escaped);
+                }
+                else if (*cur == '[')
+                    return nullptr;
+                else
+                    high = (byte)*cur++;
+                if (high < low)
+                    return nullptr;
+                for (unsigned c = low; c <= high; c++)
+                    set.set(c);
+            }
+            else
+                set.set(low);
+        }
+        cur++;
+
+        if (!isCaseSensitive)
+            foldCase(set);
+        if (negate)
+            set.flip();
+        return createChars(set, false);
+    }
+
+    bool parseNamedClass(RegexCharset & set)
+    {
+        const char * start = cur + 2;
+        const char * end = strstr(start, ":]");
+        if (!end)
+            return false;
+        std::string name(start, end - start);
+        cur = end + 2;
+        for (unsigned c = 0; c < 128; c++)
+        {
+            bool matched;
+            if (name == "alnum")
+                matched = isalnum(c);
+            else if (name == "alpha")
+                matched = isalpha(c);
+            else if (name == "blank")
+                matched = (c == ' ') || (c == '\t');
+            else if (name == "cntrl")
+                matched = iscntrl(c);
+            else if (name == "digit")
+                matched = isdigit(c);
+            else if (name == "graph")
+                matched = isgraph(c);
+            else if (name == "lower")
+                matched = islower(c);
+            else if (name == "print")
+                matched = isprint(c);
+            else if (name == "punct")
+                matched = ispunct(c);
+            else if (name == "space")
+                matched = isSpaceChar(c);
+            else if (name == "upper")
+                matched = isupper(c);
+            else if (name == "xdigit")
+                matched = isxdigit(c);
+            else if (name == "word")
+                matched = isWordChar(c);
+            else
+                return false;
+            if (matched)
+                set.set(c);
+        }
+        return true;
+    }
+
+    //Called with cur following the \ - character classes add multiple characters to the set
+    bool parseEscape(RegexCharset & set)
+    {
+        byte next = *cur++;
+        switch (next)
+        {
+        case 'd': case 'D':
+            for (unsigned c = '0'; c <= '9'; c++)
+                set.set(c);
+            break;
+        case 'w': case 'W':
+            for (unsigned c = 0; c < 128; c++)
+                if (isWordChar(c))
+                    set.set(c);
+            break;
+        case 's': case 'S':
+            for (unsigned c = 0; c < 128; c++)
+                if (isSpaceChar(c))
+                    set.set(c);
+            break;
+        case 'n': set.set('\n'); return true;
+        case 't': set.set('\t'); return true;
+        case 'r': set.set('\r'); return true;
+        case 'f': set.set('\f'); return true;
+        case 'v': set.set('\v'); return true;
+        case 'a': set.set('\a'); return true;
+        case 'e': set.set(0x1b); return true;
+        case 'c':
+            if (!isalpha((byte)*cur))
+                return false;
+            set.set(toupper((byte)*cur++) - '@');
+            return true;
+        case 'x':
+        {
+            unsigned value = 0;
+            if (*cur == '{')
+            {
+                const char * end = strchr(cur, '}');
+                if (!end || (end == cur + 1) || (end > cur + 3))
+                    return false;
+                for (cur++; cur != end; cur++)
+                {
+                    if (!isxdigit((byte)*cur))
+                        return false;
+                    value = value * 16 + hexValue(*cur);
+                }
+                cur++;
+            }
+            else
+            {
+                if (!isxdigit((byte)cur[0]) || !isxdigit((byte)cur[1]))
+                    return false;
+                value = hexValue(cur[0]) * 16 + hexValue(cur[1]);
+                cur += 2;
+            }
+            set.set(value);
+            return true;
+        }
+        default:
+            //Escaped punctuation matches itself (the assertions \` \' \< and \> are handled by the caller outside a
+            //set), any other escape (back references etc.) is not supported
+            if (!next || isalnum(next) || (next >= 0x80))
+                return false;
+            set.set(next);
+            return true;
+        }
+
+        if (isupper(next))
+            set.flip();
+        return true;
+    }
+
+    RegexNode * createChars(RegexCharset set, bool fold = true)
+    {
+        if (fold && !isCaseSensitive)
+            foldCase(set);
+        dfa.charsets.push_back(set);
+        return new RegexNode(RegexNode::Chars, (unsigned)dfa.charsets.size()-1);
+    }
+
+    //----------------------------------------------------------------------------------------------------------------
+
+    unsigned addState(byte type, unsigned charset, unsigned out, unsigned out1 = 0)
+    {
+        if (dfa.states.size() >= maxNfaStates)
+        {
+            failed = true;
+            return 0;
+        }
+        dfa.states.push_back({ type, charset, out, out1 });
+        return (unsigned)dfa.states.size()-1;
+    }
+
+    //The NFA is generated backwards, each node is passed the state that follows it
+    unsigned compile(const RegexNode & node, unsigned next)
+    {
+        if (failed)
+            return 0;
+
+        switch (node.kind)
+        {
+        case RegexNode::Chars:
+            return addState(RSchars, node.value, next);
+        case RegexNode::Assert:
+            return addState(RSassert, node.value, next);
+        case RegexNode::Empty:
+            return next;
+        case RegexNode::Concat:
+            for (unsigned i = (unsigned)node.children.size(); i--; )
+                next = compile(*node.children[i], next);
+            return next;
+        case RegexNode::Alternate:
+        {
+            unsigned alternate = compile(*node.children.back(), next);
+            for (unsigned i = (unsigned)node.children.size()-1; i--; )
+            {
+                unsigned branch = compile(*node.children[i], next);
+                alternate = addState(RSsplit, 0, branch, alternate);
+            }
+            return alternate;
+        }
+        case RegexNode::Repeat:
+        {
+            const RegexNode & child = *node.children[0];
+            unsigned cur = next;
+            if (node.max == unboundedRepeat)
+            {
+                unsigned loop = addState(RSsplit, 0, 0, next);
+                unsigned body = compile(child, loop);
+                if (failed)
+                    return 0;
+                dfa.states[loop].out = body;
+                cur = loop;
+            }
+            else
+            {
+                //x{0,2} is generated as (x(x)?)?
+                for (unsigned i = node.min; i < node.max; i++)
+                {
+                    unsigned body = compile(child, cur);
+                    cur = addState(RSsplit, 0, body, next);
+                }
+            }
+            for (unsigned i = 0; i < node.min; i++)
+                cur = compile(child, cur);
+            return cur;
+        }
+        }
+        return 0;
+    }
+
+    static bool canMatchEmpty(const RegexNode & node)
+    {
+        switch (node.kind)
+        {
+        case RegexNode::Chars:
+            return false;
+        case RegexNode::Concat:
+            for (const auto & child : node.children)
+                if (!canMatchEmpty(*child))
+                    return false;
+            return true;
+        case RegexNode::Alternate:
+            for (const auto & child : node.children)
+                if (canMatchEmpty(*child))
+                    return true;
+            return false;
+        case RegexNode::Repeat:
+            return (node.min == 0) || canMatchEmpty(*node.children[0]);
+        }
+        return true;
+    }
+
+    static void foldCase(RegexCharset & set)
+    {
+        for (unsigned c = 'A'; c <= 'Z'; c++)
+        {
+            if (set[c] || set[tolower(c)])
+            {
+                set.set(c);
+                set.set(tolower(c));
+            }
+        }
+    }
+
+    static unsigned findFirst(const RegexCharset & set)
+    {
+        for (unsigned c = 0; c < 256; c++)
+            if (set[c])
+                return c;
+        return 0;
+    }
+
+    static unsigned hexValue(char c)
+    {
+        return isdigit((byte)c) ? c - '0' : (tolower((byte)c) - 'a' + 10);
+    }
+
+protected:
+    RegexDfa & dfa;
+    const char * pattern;
+    const char * cur = pattern;
+    bool isCaseSensitive;
+    bool failed = false;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+RegexDfa * RegexDfa::create(const char * pattern, bool isCaseSensitive)
+{
+    std::unique_ptr<RegexDfa> dfa(new RegexDfa);
+    RegexDfaBuilder builder(*dfa, pattern, isCaseSensitive);
+    if (!builder.build())
+        return nullptr;
+
+    dfa->calculateClasses();
+    if (!dfa->buildDfa())
+    {
+        dfa->transitions.clear();
+        dfa->acceptsAtEnd.clear();
+    }
+    return dfa.release();
+}
+
+//Bytes which are in the same charsets and have the same category can share the same transitions
+void RegexDfa::calculateClasses()
+{
+    std::map<std::string, unsigned> signatures;
+    for (unsigned c = 0; c < 256; c++)
+    {
+        std::string signature;
+        signature.reserve(charsets.size() + 1);
+        signature += (char)getCategory(c);
+        for (const RegexCharset & set : charsets)
+            signature += set[c] ? '1' : '0';
+
+        auto match = signatures.find(signature);
+        if (match == signatures.end())
+        {
+            match = signatures.emplace(signature, numClasses++).first;
+            classCategory.push_back(getCategory(c));
+            classRepresentative.push_back((byte)c);
+        }
+        classes[c] = (byte)match->second;
+    }
+}
+
+//Calculate the set of character states reachable (without consuming any input) from the core states or from the start
+//of the pattern - since the pattern can match at any position.  Returns true if the pattern has matched.
+bool RegexDfa::closure(Workspace & ws, const std::vector<unsigned> & core, byte prevCat, byte nextCat) const
+{
+    if (++ws.generation == 0)
+    {
+        std::fill(ws.marks.begin(), ws.marks.end(), 0);
+        ws.generation = 1;
+    }
+    ws.closure.clear();
+    ws.pending.assign(core.begin(), core.end());
+    ws.pending.push_back(startState);
+    while (ws.pending.size())
+    {
+        unsigned cur = ws.pending.back();
+        ws.pending.pop_back();
+        if (ws.marks[cur] == ws.generation)
+            continue;
+        ws.marks[cur] = ws.generation;
+
+        const NfaState & state = states[cur];
+        switch (state.type)
+        {
+        case RSchars:
+            ws.closure.push_back(cur);
+            break;
+        case RSmatch:
+            return true;
+        case RSsplit:
+            ws.pending.push_back(state.out1);
+            ws.pending.push_back(state.out);
+            break;
+        case RSempty:
+            ws.pending.push_back(state.out);
+            break;
+        case RSassert:
+            if (checkAssertion(state.charset, prevCat, nextCat))
+                ws.pending.push_back(state.out);
+            break;
+        }
+    }
+    return false;
+}
+
+bool RegexDfa::step(Workspace & ws, std::vector<unsigned> & next, const std::vector<unsigned> & core, byte prevCat, unsigned byteClass) const
+{
+    if (closure(ws, core, prevCat, classCategory[byteClass]))
+        return true;
+
+    byte c = classRepresentative[byteClass];
+    next.clear();
+    for (unsigned cur : ws.closure)
+    {
+        const NfaState & state = states[cur];
+        if (charsets[state.charset][c])
+            next.push_back(state.out);
+    }
+    std::sort(next.begin(), next.end());
+    next.erase(std::unique(next.begin(), next.end()), next.end());
+    return false;
+}
+
+bool RegexDfa::buildDfa()
+{
+    typedef std::pair<byte, std::vector<unsigned>> DfaKey;
+    std::map<DfaKey, unsigned> dfaStates;
+    std::vector<const DfaKey *> pending;
+
+    Workspace ws;
+    ws.marks.resize(states.size());
+    auto it = dfaStates.emplace(DfaKey(CatNone, {}), 0).first;
+    pending.push_back(&it->first);
+
+    std::vector<unsigned> next;
+    for (unsigned i = 0; i < pending.size(); i++)
+    {
+        const DfaKey & key = *pending[i];
+        for (unsigned byteClass = 0; byteClass < numClasses; byteClass++)
+        {
+            unsigned target = matchedState;
+            if (!step(ws, next, key.second, key.first, byteClass))
+            {
+                DfaKey nextKey(classCategory[byteClass], next);
+                auto match = dfaStates.find(nextKey);
+                if (match == dfaStates.end())
+                {
+                    if ((dfaStates.size() >= maxDfaStates) || ((dfaStates.size() + 1) * numClasses > maxDfaTransitions))
+                        return false;
+                    match = dfaStates.emplace(std::move(nextKey), (unsigned)dfaStates.size()).first;
+                    pending.push_back(&match->first);
+                }
+                target = match->second;
+            }
+            transitions.push_back(target);
+        }
+        acceptsAtEnd.push_back(closure(ws, key.second, key.first, CatNone));
+    }
+    return true;
+}
+
+bool RegexDfa::simulate(const byte * cur, const byte * end) const
+{
+    Workspace ws;
+    ws.marks.resize(states.size());
+    std::vector<unsigned> core;
+    std::vector<unsigned> next;
+    byte prevCat = CatNone;
+    for (; cur != end; cur++)
+    {
+        unsigned byteClass = classes[*cur];
+        if (step(ws, next, core, prevCat, byteClass))
+            return true;
+        core.swap(next);
+        prevCat = classCategory[byteClass];
+    }
+    return closure(ws, core, prevCat, CatNone);
+}
+
+bool RegexDfa::matches(const char * start, const char * end) const
+{
+    const byte * cur = (const byte *)start;
+    const byte * last = (const byte *)end;
+    if (isSimulated())
+        return simulate(cur, last);
+
+    const unsigned * table = transitions.data();
+    unsigned state = 0;
+    for (; cur != last; cur++)
+    {
+        state = table[state * numClasses + classes[*cur]];
+        if (state == matchedState)
+            return true;
+    }
+    return acceptsAtEnd[state];
+}
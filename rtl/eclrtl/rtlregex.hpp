@@ -0,0 +1,91 @@
+/*##############################################################################
+
+    HPCC SYSTEMS software Copyright (C) 2024 HPCC Systems®.
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+############################################################################## */
+
+#ifndef RTLREGEX_HPP
+#define RTLREGEX_HPP
+
+#include "platform.h"
+#include "eclrtl.hpp"
+#include <bitset>
+#include <vector>
+
+/*
+ * A linear time matcher for the subset of (boost perl syntax) regular expressions that describe regular
+ * languages - i.e. no back references, look-around, possessive quantifiers or inline options.
+ *
+ * It can only determine whether there is a match somewhere within a string, not where the match is or what the
+ * groups matched, but that is enough to avoid running the backtracking matcher on rows that do not match.  This
+ * removes the risk of catastrophic backtracking when no match is found, and is much quicker in that case.
+ *
+ * The pattern is converted to an NFA, and the states of the equivalent DFA are generated when it is compiled.  If
+ * the DFA would be too large then the NFA is simulated directly, which is slower but still linear.  Once compiled
+ * the matcher is immutable, so it can be shared between threads.
+ */
+class ECLRTL_API RegexDfa
+{
+    friend class RegexDfaBuilder;
+public:
+    //Returns nullptr if the pattern uses features that are not supported
+    static RegexDfa * create(const char * pattern, bool isCaseSensitive);
+
+    bool matches(const char * start, const char * end) const;   // does the pattern match anywhere within [start,end)
+    bool isSimulated() const { return transitions.empty(); }
+    unsigned numDfaStates() const { return (unsigned)acceptsAtEnd.size(); }
+
+    //The category of a byte, used when checking assertions, which depend on the bytes either side of a position
+    enum : byte { CatNone, CatOther, CatWord, CatLF, CatCR, CatFF, CatMax };
+
+private:
+    struct Workspace
+    {
+        std::vector<unsigned> marks;
+        std::vector<unsigned> pending;
+        std::vector<unsigned> closure;
+        unsigned generation = 0;
+    };
+
+    RegexDfa() = default;
+    bool step(Workspace & ws, std::vector<unsigned> & next, const std::vector<unsigned> & core, byte prevCat, unsigned byteClass) const;
+    bool closure(Workspace & ws, const std::vector<unsigned> & core, byte prevCat, byte nextCat) const;
+    bool simulate(const byte * cur, const byte * end) const;
+    bool buildDfa();
+    void calculateClasses();
+
+private:
+    struct NfaState
+    {
+        byte type;
+        unsigned charset;       // for a character state, or the assertion
+        unsigned out;
+        unsigned out1;
+    };
+
+    std::vector<NfaState> states;
+    std::vector<std::bitset<256>> charsets;
+    unsigned startState = 0;
+
+    byte classes[256];                      // bytes that are matched by the same charsets and have the same category
+    std::vector<byte> classCategory;
+    std::vector<byte> classRepresentative;
+    unsigned numClasses = 0;
+
+    //The DFA - empty if it would have been too large
+    std::vector<unsigned> transitions;      // [state * numClasses + class]
+    std::vector<bool> acceptsAtEnd;
+};
+
+#endif
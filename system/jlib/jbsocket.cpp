@@ -28,9 +28,27 @@ private:
     unsigned short m_endptr;
     unsigned short m_curptr;
     unsigned int m_timeout;
+    unsigned __int64 m_remaining = (unsigned __int64)-1;
+    MemoryBuffer m_initial;
 
     ISocket* m_socket;
 
+    void fill(unsigned & readlen)
+    {
+        readlen = 0;
+        if (m_remaining == 0)
+            return;
+        size32_t maxRead = (m_remaining < BSOCKET_BUFSIZE) ? (size32_t)m_remaining : BSOCKET_BUFSIZE;
+        if (m_initial.remaining())
+        {
+            readlen = std::min(maxRead, m_initial.remaining());
+            m_initial.read(readlen, m_buf);
+        }
+        else
+            m_socket->read(m_buf, 0, maxRead, readlen, m_timeout);
+        m_remaining -= readlen;
+    }
+
 public:
     IMPLEMENT_IINTERFACE;
 
@@ -44,6 +62,10 @@ public:
     virtual int read(char* buf, int maxlen);
     virtual void setReadTimeout(unsigned int timeout)
     { m_timeout = timeout;  }
+    virtual void setReadLimit(unsigned __int64 limit)
+    { m_remaining = limit; }
+    virtual void setInitialData(const void * data, size32_t len)
+    { m_initial.clear().append(len, data); }
 };
 
 
@@ -100,7 +122,7 @@ int BufferedSocket::readline(char* buf, int maxlen, bool keepcrlf, IMultiExcepti
                         m_curptr = 0;
                         m_endptr = 0;
                         unsigned readlen;
-                        m_socket->read(m_buf, 0, BSOCKET_BUFSIZE, readlen, m_timeout);
+                        fill(readlen);
                         if(readlen > 0)
                         {
                             m_endptr = readlen;
@@ -136,7 +158,7 @@ int BufferedSocket::readline(char* buf, int maxlen, bool keepcrlf, IMultiExcepti
                 m_curptr = 0;
                 m_endptr = 0;
                 unsigned readlen;
-                m_socket->read(m_buf, 0, BSOCKET_BUFSIZE, readlen, m_timeout);
+                fill(readlen);
                 if(readlen <= 0)
                     break;
                 m_endptr = readlen;
@@ -218,7 +240,7 @@ int BufferedSocket::read(char* buf, int maxlen)
             unsigned readlen;
             try
             {
-                m_socket->read(m_buf, 0, BSOCKET_BUFSIZE, readlen, m_timeout);
+                fill(readlen);
             }
             catch (IException *e) 
             {
@@ -24,6 +24,8 @@
 #include "jexcept.hpp"
 #include "jregexp.hpp"
 #include "jerror.hpp"
+#include "jmd5.hpp"
+#include "jutil.hpp"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -88,6 +90,8 @@ static const char * CC_OPTION_C[] = { "", "", "" };
 static const char * CC_OPTION_CPP[] = { "", "-std=c++11", "-std=c++11" };
 
 static const char * CC_OPTION_PRECOMPILEHEADER[] = { "", " -x c++-header", " -x c++-header" };
+static const char * CC_OPTION_FORCEINCLUDE[] = { "/FI", "-include ", "-include " };
+static const char * PCH_STUB_NAME = "eclprecompiled.hpp";
 
 static const char * DLL_LINK_OPTION_DEBUG[] = { "/BASE:" BASE_ADDRESS " /NOLOGO /LARGEADDRESSAWARE /INCREMENTAL:NO /DEBUG /DEBUGTYPE:CV", "-g -shared -L. -fPIC -pipe -O0", "-g -shared -L. -fPIC -pipe -O0" };
 static const char * EXE_LINK_OPTION_DEBUG[] = { "/BASE:" BASE_ADDRESS " /NOLOGO /LARGEADDRESSAWARE /INCREMENTAL:NO /DEBUG /DEBUGTYPE:CV", "-g -L. -Wl,-E -fPIC -pipe -O0", "-g -L. -fPIC -pipe -O0 -Wl,-export_dynamic -v" };
@@ -218,12 +222,14 @@ static void doSetCompilerPath(const char * path, const char * includes, const ch
 class CCompilerThreadParam : public CInterface
 {
 public:
-    CCompilerThreadParam(const StringBuffer & _cmdline, Semaphore & _finishedCompiling, const StringBuffer & _logfile, StringBuffer &_batchOutText, bool _describeOnly)
-    : cmdline(_cmdline), logfile(_logfile), finishedCompiling(_finishedCompiling), batchOutText(_batchOutText), describeOnly(_describeOnly)
+    CCompilerThreadParam(const StringBuffer & _cmdline, Semaphore & _finishedCompiling, const StringBuffer & _logfile, StringBuffer &_batchOutText, bool _describeOnly, const char * _cacheKey, const char * _objectName)
+    : cmdline(_cmdline), logfile(_logfile), cacheKey(_cacheKey), objectName(_objectName), finishedCompiling(_finishedCompiling), batchOutText(_batchOutText), describeOnly(_describeOnly)
     {};
 
     StringBuffer        cmdline;
     StringBuffer        logfile;
+    StringAttr          cacheKey;
+    StringAttr          objectName;
     Semaphore          &finishedCompiling;
     StringBuffer       &batchOutText;
     bool                describeOnly;
@@ -335,6 +341,107 @@ void extractErrorsFromCppLog(IArrayOf<IError> & errors, const char * cur, bool l
     } while (cur);
 }
 
+//===========================================================================
+
+static StringBuffer & getCachedObjectName(StringBuffer & out, const char * cacheDir, const char * key, const char * objectName)
+{
+    out.append(cacheDir);
+    addPathSepChar(out).append(key);
+    const char * ext = pathExtension(objectName);
+    if (ext)
+        out.append(ext);
+    return out;
+}
+
+bool restoreCachedObject(const char * cacheDir, const char * key, const char * objectName)
+{
+    StringBuffer cachedName;
+    getCachedObjectName(cachedName, cacheDir, key, objectName);
+    if (!checkFileExists(cachedName))
+        return false;
+
+    try
+    {
+        copyFile(objectName, cachedName);
+        return true;
+    }
+    catch (IException * e)
+    {
+        EXCLOG(e, "restoreCachedObject");
+        e->Release();
+    }
+    //Do not leave a partially copied object behind - it would be linked in
+    removeFileTraceIfFail(objectName);
+    return false;
+}
+
+bool storeCachedObject(const char * cacheDir, const char * key, const char * objectName)
+{
+    StringBuffer cachedName, tempName;
+    getCachedObjectName(cachedName, cacheDir, key, objectName);
+    if (checkFileExists(cachedName))
+        return true;
+
+    //The cache may be shared by several processes, so copy to a unique temporary and rename into place
+    tempName.append(cachedName).appendf(".%u.%" I64F "u.tmp", (unsigned)GetCurrentProcessId(), (unsigned __int64)GetCurrentThreadId());
+    try
+    {
+        recursiveCreateDirectoryForFile(cachedName);
+        copyFile(tempName, objectName);
+        renameFile(cachedName, tempName, true);
+        return true;
+    }
+    catch (IException * e)
+    {
+        EXCLOG(e, "storeCachedObject");
+        e->Release();
+    }
+    removeFileTraceIfFail(tempName);
+    return false;
+}
+
+//Hash the contents of a source file, replacing any #include of a local file with the contents of that file.
+//This means that the generated header (whose name depends on the workunit) does not affect the key.
+static void hashSourceFile(MemoryBuffer & target, const char * path, StringArray & visited)
+{
+    StringBuffer contents;
+    contents.loadFile(path, false);
+    visited.append(path);
+
+    StringBuffer dir;
+    splitDirTail(path, dir);
+
+    const char * cur = contents.str();
+    while (*cur)
+    {
+        const char * eol = strchr(cur, '\n');
+        const char * next = eol ? eol + 1 : cur + strlen(cur);
+        bool expanded = false;
+        if (startsWith(cur, "#include \""))
+        {
+            const char * start = cur + strlen("#include \"");
+            const char * end = strchr(start, '"');
+            if (end && end < next)
+            {
+                StringBuffer includePath(dir);
+                includePath.append(end - start, start);
+                if (visited.contains(includePath))
+                    expanded = true;
+                else if (checkFileExists(includePath))
+                {
+                    hashSourceFile(target, includePath, visited);
+                    expanded = true;
+                }
+            }
+        }
+        if (!expanded)
+            target.append(next - cur, cur);
+        cur = next;
+    }
+}
+
+//===========================================================================
+
 CppCompiler::CppCompiler(const char * _coreName, const char * _sourceDir, const char * _targetDir, unsigned _targetCompiler, bool _verbose, const char *_compileBatchOut)
 {
     coreName.set(_coreName);
@@ -358,6 +465,9 @@ CppCompiler::CppCompiler(const char * _coreName, const char * _sourceDir, const
     abortChecker = NULL;
     precompileHeader = false;
     linkFailed = false;
+    numCacheHits.store(0);
+    numCacheAdds.store(0);
+    pchTimeNs = 0;
 }
 
 void CppCompiler::addCompileOption(const char * option)
@@ -372,6 +482,20 @@ void CppCompiler::setPrecompileHeader(bool _pch)
     precompileHeader = _pch;
 }
 
+void CppCompiler::setObjectCache(const char * cacheDir)
+{
+    if (targetCompiler==Vs6CppCompiler)
+        throw MakeStringException(0, "object file caching only supported for g++ and compatible compilers");
+    objectCacheDir.set(cacheDir);
+}
+
+void CppCompiler::setPrecompiledHeaderCache(const char * cacheDir)
+{
+    if (targetCompiler==Vs6CppCompiler)
+        throw MakeStringException(0, "precompiled header generation only supported for g++ and compatible compilers");
+    pchCacheDir.set(cacheDir);
+}
+
 bool CppCompiler::fireException(IException *e)
 {
     CriticalBlock block(cs);
@@ -488,6 +612,14 @@ bool CppCompiler::compile()
     Owned<IThreadPool> pool = createThreadPool("CCompilerWorker", this, this, maxCompileThreads && !reportOnly() ? maxCompileThreads : 1, INFINITE);
     addCompileOption(COMPILE_ONLY[targetCompiler]);
 
+    pchOption.clear();
+    if (pchCacheDir && !precompileHeader)
+    {
+        CCycleTimer pchTimer;
+        preparePrecompiledHeader();
+        pchTimeNs = pchTimer.elapsedNs();
+    }
+
     bool ret = false;
     Semaphore finishedCompiling;
     int numSubmitted = 0;
@@ -523,6 +655,14 @@ bool CppCompiler::compile()
             finishedCompiling.wait();
     }
 
+    if (reportOnly() && objectCacheDir && !precompileHeader)
+    {
+        //The objects only exist once the batch has been executed, so the caller adds them to the cache
+        batchOutText.append("#cache ").append((unsigned)numCacheHits).newline();
+        ForEachItemIn(iCache, cacheKeys)
+            batchOutText.append("cachestore ").append(cacheKeys.item(iCache)).append(' ').append(cacheObjects.item(iCache)).newline();
+    }
+
     if (numFailed > 0)
         ret = false;
     else if (!onlyCompile && !precompileHeader)
@@ -584,6 +724,28 @@ bool CppCompiler::compileFile(IThreadPool * pool, const char * filename, const c
     StringBuffer cmdline;
     const char *ext = pathExtension(filename);
     bool isC = ext != nullptr && strieq(ext, ".c");
+
+    StringBuffer cacheKey, objectName;
+    if (objectCacheDir && !precompileHeader)
+    {
+        getObjectName(objectName, filename);
+        getObjectCacheKey(cacheKey, filename, flags, isC);
+        if (restoreCachedObject(objectCacheDir, cacheKey, objectName))
+        {
+            if (verbose)
+                DBGLOG("Object for %s restored from cache %s", filename, cacheKey.str());
+            numCacheHits++;
+            finishedCompiling.signal();
+            return true;
+        }
+        if (reportOnly())
+        {
+            cacheKeys.append(cacheKey);
+            cacheObjects.append(objectName);
+            cacheKey.clear();
+        }
+    }
+
     cmdline.append(isC ? CC_NAME_C[targetCompiler] : CC_NAME_CPP[targetCompiler]);
     if (precompileHeader)
         cmdline.append(CC_OPTION_PRECOMPILEHEADER[targetCompiler]);
@@ -603,7 +765,9 @@ bool CppCompiler::compileFile(IThreadPool * pool, const char * filename, const c
         cmdline.append(" ").append(LIBFLAG_RELEASE[targetCompiler]);
 
     _addInclude(cmdline, stdIncludes);
-    
+    if (!isC)
+        cmdline.append(pchOption);
+
     if (targetCompiler == Vs6CppCompiler)
     {
         if (targetDir.get())
@@ -634,12 +798,178 @@ bool CppCompiler::compileFile(IThreadPool * pool, const char * filename, const c
     Owned<CCompilerThreadParam> parm;
     if (verbose)
         DBGLOG("%s", expanded.str());
-    parm.setown(new CCompilerThreadParam(expanded, finishedCompiling, logFile, batchOutText, reportOnly()));
+    parm.setown(new CCompilerThreadParam(expanded, finishedCompiling, logFile, batchOutText, reportOnly(), cacheKey.str(), objectName.str()));
     pool->start(parm.get());
 
     return true;
 }
 
+void CppCompiler::getObjectCacheKey(StringBuffer & key, const char * filename, const char * flags, bool isC)
+{
+    //Anything that could change the generated object must be included in the key.  The standard headers are
+    //only expected to change when the platform version changes.
+    MemoryBuffer hashData;
+    StringBuffer options;
+    options.append(hpccBuildInfo.buildTag).newline();
+    appendCompilerSignature(options, isC);
+    expandCompileOptions(options, isC);
+    options.append(" ").append(useDebugLibrary ? LIBFLAG_DEBUG[targetCompiler] : LIBFLAG_RELEASE[targetCompiler]);
+    _addInclude(options, stdIncludes);
+    if (flags)
+        options.append(" ").append(flags);
+    hashData.append(options.length(), options.str()).append('\n');
+
+    StringBuffer sourcePath;
+    if (sourceDir.length())
+    {
+        sourcePath.append(sourceDir);
+        addPathSepChar(sourcePath);
+    }
+    sourcePath.append(filename);
+    StringArray visited;
+    hashSourceFile(hashData, sourcePath, visited);
+    md5_data(hashData, key);
+}
+
+//Find a compiler that is specified without a directory in the same way as the shell would
+static bool findOnPath(StringBuffer & resolved, const char * name)
+{
+    const char * path = getenv("PATH");
+    if (isEmptyString(path))
+        return false;
+    StringArray dirs;
+    dirs.appendList(path, ENVSEPSTR);
+    ForEachItemIn(i, dirs)
+    {
+        const char * dir = dirs.item(i);
+        if (!*dir)
+            continue;
+        StringBuffer candidate(dir);
+        addPathSepChar(candidate).append(name);
+#ifdef _WIN32
+        if (!strchr(name, '.'))
+            candidate.append(".exe");
+#endif
+        if (checkFileExists(candidate))
+        {
+            resolved.swapWith(candidate);
+            return true;
+        }
+    }
+    return false;
+}
+
+void CppCompiler::appendCompilerSignature(StringBuffer & out, bool isC)
+{
+    //Include the size and timestamp of the compiler so that upgrading the compiler invalidates anything cached.  If the
+    //compiler cannot be found, the version it reports is used instead.
+    StringAttr & signature = compilerSignature[isC ? 1 : 0];
+    if (!signature)
+    {
+        StringBuffer name, expanded, text;
+        name.append(isC ? CC_NAME_C[targetCompiler] : CC_NAME_CPP[targetCompiler]);
+        expandRootDirectory(expanded, name);
+        dequote(expanded);
+        if (!containsPathSepChar(expanded))
+        {
+            StringBuffer resolved;
+            if (findOnPath(resolved, expanded))
+                expanded.swapWith(resolved);
+        }
+        text.append(expanded);
+
+        Owned<IFile> compilerFile = createIFile(expanded);
+        CDateTime modified;
+        if (compilerFile->getTime(nullptr, &modified, nullptr))
+        {
+            text.append(' ').append(compilerFile->size()).append(' ');
+            modified.getString(text);
+        }
+        else
+        {
+            StringBuffer cmd, output, error;
+            cmd.append('"').append(expanded).append("\" --version");
+            runExternalCommand(output, error, cmd, nullptr);
+            text.append(' ').append(output.trim()).append(' ').append(error.trim());
+        }
+        signature.set(text);
+    }
+    out.append(signature).newline();
+}
+
+bool CppCompiler::preparePrecompiledHeader()
+{
+    //A precompiled header can only be used if it was built with the same compiler and options, so each
+    //combination has its own directory within the cache.
+    StringBuffer options, key;
+    options.append(hpccBuildInfo.buildTag).newline();
+    appendCompilerSignature(options, false);
+    expandCompileOptions(options, false);
+    options.append(" ").append(useDebugLibrary ? LIBFLAG_DEBUG[targetCompiler] : LIBFLAG_RELEASE[targetCompiler]);
+    _addInclude(options, stdIncludes);
+    md5_string(options, key);
+
+    StringBuffer pchDir, stubName, pchName;
+    pchDir.append(pchCacheDir);
+    addPathSepChar(pchDir).append(key);
+    addPathSepChar(pchDir);
+    stubName.append(pchDir).append(PCH_STUB_NAME);
+    pchName.append(stubName).append('.').append(PCH_FILE_EXT[targetCompiler]);
+
+    if (!checkFileExists(pchName))
+    {
+        //The cache may be shared by several processes, so generate to unique temporaries and rename into place
+        StringBuffer tempName, logFile;
+        tempName.append(pchName).appendf(".%u.tmp", (unsigned)GetCurrentProcessId());
+        logFile.append(coreName).append("_pch.log.tmp");
+        try
+        {
+            recursiveCreateDirectory(pchDir);
+            if (!checkFileExists(stubName))
+            {
+                StringBuffer stubTemp, stubText;
+                stubTemp.append(stubName).appendf(".%u.tmp", (unsigned)GetCurrentProcessId());
+                stubText.append("#include \"eclinclude4.hpp\"").newline();
+                Owned<IFile> stubFile = createIFile(stubTemp);
+                Owned<IFileIO> stubIO = stubFile->open(IFOcreate);
+                stubIO->write(0, stubText.length(), stubText.str());
+                stubIO.clear();
+                renameFile(stubName, stubTemp, true);
+            }
+
+            StringBuffer cmdline, expanded;
+            cmdline.append(CC_NAME_CPP[targetCompiler]).append(CC_OPTION_PRECOMPILEHEADER[targetCompiler]);
+            cmdline.append(" \"").append(stubName).append("\" ");
+            expandCompileOptions(cmdline, false);
+            cmdline.append(" ").append(useDebugLibrary ? LIBFLAG_DEBUG[targetCompiler] : LIBFLAG_RELEASE[targetCompiler]);
+            _addInclude(cmdline, stdIncludes);
+            cmdline.append(" -o \"").append(tempName).append("\"");
+            expandRootDirectory(expanded, cmdline);
+            if (verbose)
+                DBGLOG("%s", expanded.str());
+
+            DWORD runcode = 0;
+            if (invoke_program(expanded.str(), runcode, true, logFile, nullptr, true) && (runcode == 0))
+                renameFile(pchName, tempName, true);
+            else
+                IWARNLOG("Failed to generate precompiled header %s (see %s)", pchName.str(), logFile.str());
+        }
+        catch (IException * e)
+        {
+            EXCLOG(e, "Generating precompiled header");
+            e->Release();
+        }
+        if (checkFileExists(tempName))
+            removeFileTraceIfFail(tempName);
+        if (!checkFileExists(pchName))
+            return false;
+        removeFileTraceIfFail(logFile);
+    }
+
+    pchOption.append(" ").append(CC_OPTION_FORCEINCLUDE[targetCompiler]).append("\"").append(stubName).append("\"");
+    return true;
+}
+
 void CppCompiler::extractErrors(IArrayOf<IError> & errors)
 {
     ForEachItemIn(i, exceptions)
@@ -1018,6 +1348,11 @@ public:
 
         if (!success || aborted || runcode != 0)
             compiler->numFailed++;
+        else if (params->cacheKey.length())
+        {
+            if (storeCachedObject(compiler->objectCacheDir, params->cacheKey, params->objectName))
+                compiler->numCacheAdds++;
+        }
         params->finishedCompiling.signal();
         if (error)
             throw error.getClear();
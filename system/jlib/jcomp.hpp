@@ -45,6 +45,10 @@ extern jlib_decl void setCompilerPath(const char * path, const char *ipath, cons
 extern jlib_decl bool fileIsOlder(const char *dest, const char *src);
 extern jlib_decl void extractErrorsFromCppLog(IArrayOf<IError> & errors, const char * cur, bool linkFailed);
 
+//Content addressed cache of compiled object files - the key is a hash of the source, compiler options and build version
+extern jlib_decl bool restoreCachedObject(const char * cacheDir, const char * key, const char * objectName);
+extern jlib_decl bool storeCachedObject(const char * cacheDir, const char * key, const char * objectName);
+
 interface ICppCompiler : public IInterface
 {
 public:
@@ -69,6 +73,11 @@ public:
     virtual void setCCLogPath(const char* path) = 0;
     virtual void setSaveTemps(bool _save) = 0;
     virtual void setPrecompileHeader(bool _pch) = 0;
+    virtual void setObjectCache(const char * cacheDir) = 0;
+    virtual unsigned getNumObjectCacheHits() const = 0;
+    virtual unsigned getNumObjectCacheAdds() const = 0;
+    virtual void setPrecompiledHeaderCache(const char * cacheDir) = 0;
+    virtual unsigned __int64 getPrecompiledHeaderTimeNs() const = 0;
     virtual void setAbortChecker(IAbortRequestCallback * abortChecker) = 0;
     virtual void removeTemporary(const char *fname) = 0;
     virtual void removeTempDir(const char *fname) = 0;
@@ -50,6 +50,11 @@ public:
     virtual void setCCLogPath(const char* path);
     virtual void setSaveTemps(bool _save) { saveTemps = _save; }
     virtual void setPrecompileHeader(bool _pch);
+    virtual void setObjectCache(const char * cacheDir);
+    virtual unsigned getNumObjectCacheHits() const { return numCacheHits; }
+    virtual unsigned getNumObjectCacheAdds() const { return numCacheAdds; }
+    virtual void setPrecompiledHeaderCache(const char * cacheDir);
+    virtual unsigned __int64 getPrecompiledHeaderTimeNs() const { return pchTimeNs; }
     virtual void setAbortChecker(IAbortRequestCallback * _abortChecker) {abortChecker = _abortChecker;}
     virtual bool fireException(IException *e);
     virtual void removeTempDir(const char *fname);
@@ -63,11 +68,17 @@ protected:
     StringBuffer & getObjectName(StringBuffer & out, const char * filename);
     void removeTemporaries();
     bool compileFile(IThreadPool * pool, const char * filename, const char *flags, Semaphore & finishedCompiling);
+    void getObjectCacheKey(StringBuffer & key, const char * filename, const char * flags, bool isC);
+    void appendCompilerSignature(StringBuffer & out, bool isC);
+    bool preparePrecompiledHeader();
     bool doLink();
     void writeLogFile(const char* filepath, StringBuffer& log) ;
 
 public:
     std::atomic_uint numFailed;
+    std::atomic_uint numCacheHits;
+    std::atomic_uint numCacheAdds;
+    StringAttr      objectCacheDir;
 
 protected:
     StringBuffer    compilerOptions;
@@ -80,7 +91,12 @@ protected:
     StringArray     allSources;
     StringArray     allFlags;
     StringArray     logFiles;
+    StringArray     cacheKeys;      // objects to add to the cache once a batch compile has completed
+    StringArray     cacheObjects;
     StringAttr      ccLogPath;
+    StringAttr      pchCacheDir;
+    StringAttr      compilerSignature[2];   // indexed by isC, calculated when first needed
+    StringBuffer    pchOption;
     StringAttr      coreName;
     unsigned        targetCompiler;
     unsigned        maxCompileThreads;
@@ -93,6 +109,7 @@ protected:
     bool            saveTemps;
     bool            precompileHeader;
     bool            linkFailed;
+    unsigned __int64 pchTimeNs;
     IAbortRequestCallback * abortChecker;
     CriticalSection cs;
     IArrayOf<IException> exceptions;
@@ -20,6 +20,7 @@
 #include "jcrc.hpp"
 #include "jlib.hpp"
 #include "jfile.hpp"
+#include <atomic>
 
 const static unsigned short crc_16_tab[256] = { // x^16+x^15+x^2+1
       0x0000,0xc0c1,0xc181,0x0140,0xc301,0x03c0,0x0280,0xc241,
@@ -453,7 +454,7 @@ const static uint32_t Crc32Lookup[8][256] =
 };
 
 /// compute CRC32 (Slicing-by-8 algorithm)
-uint32_t crc32(const char *data, uint32_t length, uint32_t previousCrc32 = 0)
+static uint32_t crc32Slicing8(const char *data, uint32_t length, uint32_t previousCrc32)
 {
   // uint32_t crc = ~previousCrc32; // same as previousCrc32 ^ 0xFFFFFFFF
   // MCK - changed to match orig crc32() above
@@ -501,6 +502,188 @@ uint32_t crc32(const char *data, uint32_t length, uint32_t previousCrc32 = 0)
   return crc;
 }
 /////////////////////////////////////////////////////////////
+
+// Hardware accelerated versions of the same CRC, selected when the cpu supports them.  Both process the
+// raw crc register in the same way as the table driven version, so the results are identical.
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+
+// Folds 64 bytes at a time using carry-less multiplies.  Based on "Fast CRC Computation for Generic Polynomials
+// Using PCLMULQDQ Instruction", V. Gopal, E. Ozturk, et al., 2009, using the bit-reflected constants for
+// polynomial 0x04c11db7 given in the paper.  The length must be a multiple of 16 and at least 64.
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t crc32FoldPclmul(const byte * buf, size32_t len, uint32_t crc)
+{
+    const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+    const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+    const __m128i k5k0 = _mm_set_epi64x(0x0000000000, 0x0163cd6124);
+    const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+
+    __m128i x1 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+    __m128i x2 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+    __m128i x3 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+    __m128i x4 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+    buf += 64;
+    len -= 64;
+
+    // Fold four independent 128 bit lanes in parallel
+    while (len >= 64)
+    {
+        __m128i x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+        __m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+        __m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+        __m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *)(buf + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *)(buf + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *)(buf + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *)(buf + 0x30)));
+        buf += 64;
+        len -= 64;
+    }
+
+    // Fold the four lanes into one
+    __m128i x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    while (len >= 16)
+    {
+        x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i *)buf)), x5);
+        buf += 16;
+        len -= 16;
+    }
+
+    // Fold 128 bits to 64 bits
+    const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask32);
+    x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction to 32 bits
+    x2 = _mm_and_si128(x1, mask32);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+    x2 = _mm_and_si128(x2, mask32);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return _mm_extract_epi32(x1, 1);
+}
+
+static uint32_t crc32Pclmul(const char *data, uint32_t length, uint32_t crc)
+{
+    if (length >= 64)
+    {
+        uint32_t chunk = length & ~15U;
+        crc = crc32FoldPclmul((const byte *)data, chunk, crc);
+        data += chunk;
+        length -= chunk;
+    }
+    return crc32Slicing8(data, length, crc);
+}
+
+#define HAS_CRC32_HARDWARE
+static bool cpuSupportsCrc32()
+{
+    __builtin_cpu_init();       // may be called from a static initialiser
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+}
+#define crc32Hardware crc32Pclmul
+
+#elif defined(__aarch64__) && defined(__linux__) && defined(__GNUC__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+
+// The armv8 crc32 instructions use the same (reflected 0x04c11db7) polynomial
+__attribute__((target("+crc")))
+static uint32_t crc32Armv8(const char *data, uint32_t length, uint32_t crc)
+{
+    const byte * buf = (const byte *)data;
+    while (length && ((memsize_t)buf & 7))
+    {
+        crc = __crc32b(crc, *buf++);
+        length--;
+    }
+    while (length >= 32)
+    {
+        crc = __crc32d(crc, *(const uint64_t *)(buf));
+        crc = __crc32d(crc, *(const uint64_t *)(buf + 8));
+        crc = __crc32d(crc, *(const uint64_t *)(buf + 16));
+        crc = __crc32d(crc, *(const uint64_t *)(buf + 24));
+        buf += 32;
+        length -= 32;
+    }
+    while (length >= 8)
+    {
+        crc = __crc32d(crc, *(const uint64_t *)buf);
+        buf += 8;
+        length -= 8;
+    }
+    while (length--)
+        crc = __crc32b(crc, *buf++);
+    return crc;
+}
+
+#define HAS_CRC32_HARDWARE
+static bool cpuSupportsCrc32() { return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0; }
+#define crc32Hardware crc32Armv8
+#endif
+
+typedef uint32_t (* Crc32Function)(const char *data, uint32_t length, uint32_t crc);
+
+static uint32_t crc32Resolve(const char *data, uint32_t length, uint32_t crc);
+
+// Initialised to a function that selects the implementation on the first call, so crc32() can safely be
+// called by other modules' static initialisers.
+static std::atomic<Crc32Function> crc32Function{crc32Resolve};
+
+static Crc32Function selectCrc32Function()
+{
+#ifdef HAS_CRC32_HARDWARE
+    if (cpuSupportsCrc32())
+        return crc32Hardware;
+#endif
+    return crc32Slicing8;
+}
+
+static uint32_t crc32Resolve(const char *data, uint32_t length, uint32_t crc)
+{
+    Crc32Function fn = selectCrc32Function();
+    crc32Function.store(fn, std::memory_order_relaxed);
+    return fn(data, length, crc);
+}
+
+uint32_t crc32(const char *data, uint32_t length, uint32_t previousCrc32)
+{
+    return crc32Function.load(std::memory_order_relaxed)(data, length, previousCrc32);
+}
+
+bool isCrc32HardwareAccelerated()
+{
+    return selectCrc32Function() != crc32Slicing8;
+}
+
+unsigned crc32Software(const char *buf, unsigned len, unsigned crc)
+{
+    return crc32Slicing8(buf, len, crc);
+}
+
 #endif // _USE_OLD_CRC32
 
 #define UPDC32_0(crc) (crc_32_tab[(crc) & 0xff] ^ ((crc) >> 8))
@@ -31,6 +31,8 @@
 jlib_decl unsigned crc32(const char *buf, unsigned len, unsigned crc);
 jlib_decl unsigned cxc32(unsigned * buf, unsigned numWords, unsigned cxc32);
 jlib_decl unsigned short crc16(const void *buf,size32_t len,unsigned short crc);
+jlib_decl unsigned crc32Software(const char *buf, unsigned len, unsigned crc);     // crc32() without any hardware acceleration
+jlib_decl bool isCrc32HardwareAccelerated();
 
 class jlib_decl CRC32
 {
@@ -45,6 +47,8 @@ protected:
     unsigned crc;
 };
 
+// Combines the crcs of adjacent blocks of data into the crc of the whole.  The blocks can be crc'd independently
+// (e.g., by different threads), provided they are added in order.
 class jlib_decl CRC32Merger
 {
 public:
@@ -47,6 +47,9 @@
 #include <sys/stat.h>
 #include <sys/klog.h>
 #include <dirent.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 #endif
 #ifdef __APPLE__
  #include <sys/param.h>
@@ -2215,6 +2218,139 @@ bool OsNetworkStats::updateCurrent(const char * ifname)
 
 //---------------------------------------------------------------------------------------------------------------------
 
+void HardwareCounterValues::clear()
+{
+    for (unsigned i=0; i < HwMaxCounter; i++)
+        values[i] = 0;
+}
+
+bool HardwareCounterValues::isEmpty() const
+{
+    for (unsigned i=0; i < HwMaxCounter; i++)
+    {
+        if (values[i])
+            return false;
+    }
+    return true;
+}
+
+HardwareCounterValues & HardwareCounterValues::operator += (const HardwareCounterValues & other)
+{
+    for (unsigned i=0; i < HwMaxCounter; i++)
+        values[i] += other.values[i];
+    return *this;
+}
+
+HardwareCounterValues HardwareCounterValues::operator - (const HardwareCounterValues & other) const
+{
+    HardwareCounterValues result;
+    for (unsigned i=0; i < HwMaxCounter; i++)
+        result.values[i] = values[i] - other.values[i];
+    return result;
+}
+
+bool collectHardwareCounters = false;
+
+#ifdef __linux__
+static std::atomic<bool> hardwareCountersUnavailable{false};
+
+//The counters for each thread are opened as a single group the first time they are read, so that they are
+//scheduled onto the pmu together and can be read with a single system call.
+class ThreadHardwareCounters
+{
+public:
+    ~ThreadHardwareCounters()
+    {
+        for (unsigned i=0; i < HwMaxCounter; i++)
+        {
+            if (fds[i] != -1)
+                close(fds[i]);
+        }
+    }
+
+    bool read(HardwareCounterValues & values)
+    {
+        if (unlikely(!opened))
+        {
+            opened = true;
+            open();
+        }
+        if (fds[0] == -1)
+            return false;
+
+        //Format of a PERF_FORMAT_GROUP read: the number of counters followed by a value for each
+        __uint64 buffer[1 + HwMaxCounter];
+        ssize_t len = ::read(fds[0], buffer, sizeof(buffer));
+        if ((len != sizeof(buffer)) || (buffer[0] != HwMaxCounter))
+            return false;
+        for (unsigned i=0; i < HwMaxCounter; i++)
+            values.values[i] = buffer[1+i];
+        return true;
+    }
+
+protected:
+    void open()
+    {
+        if (hardwareCountersUnavailable)
+            return;
+
+        static const __uint64 configs[HwMaxCounter] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+        };
+        for (unsigned i=0; i < HwMaxCounter; i++)
+        {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.read_format = PERF_FORMAT_GROUP;
+            attr.disabled = (i == 0);       // The group is enabled once all the counters have been added
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            //pid=0, cpu=-1 counts this thread on whichever cpu it runs on
+            int fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, fds[0], 0);
+            if (fd == -1)
+            {
+                //Only report the failure once - it is likely to be the same for every thread
+                if (!hardwareCountersUnavailable.exchange(true))
+                    OWARNLOG("Hardware counters are not available (errno %d) - perf_event_paranoid may need to be reduced", errno);
+                for (unsigned j=0; j < i; j++)
+                {
+                    close(fds[j]);
+                    fds[j] = -1;
+                }
+                return;
+            }
+            fds[i] = fd;
+        }
+        ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+protected:
+    int fds[HwMaxCounter] = { -1, -1, -1, -1 };
+    bool opened = false;
+};
+
+static thread_local ThreadHardwareCounters threadHardwareCounters;
+#endif
+
+void setCollectHardwareCounters(bool enable)
+{
+    collectHardwareCounters = enable;
+}
+
+bool readThreadHardwareCounters(HardwareCounterValues & values)
+{
+#ifdef __linux__
+    return threadHardwareCounters.read(values);
+#else
+    return false;
+#endif
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
 #ifndef _WIN32
 //---------------------------------------------------------------------------
 
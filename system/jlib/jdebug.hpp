@@ -535,6 +535,35 @@ public:
     __uint64 txdrops = 0;
 };
 
+//Hardware performance counters for the calling thread, gathered using perf_event_open on linux.
+//Collection is disabled by default because each read is a system call, and the kernel may not allow
+//unprivileged access (see /proc/sys/kernel/perf_event_paranoid).
+enum HardwareCounter : unsigned
+{
+    HwCycles,
+    HwInstructions,
+    HwCacheMisses,          // Last level cache misses
+    HwBranchMisses,
+    HwMaxCounter
+};
+
+class jlib_decl HardwareCounterValues
+{
+public:
+    void clear();
+    bool isEmpty() const;
+    HardwareCounterValues & operator += (const HardwareCounterValues & other);
+    HardwareCounterValues operator - (const HardwareCounterValues & other) const;
+
+public:
+    __uint64 values[HwMaxCounter];     // Not initialized, so that timers that do not use them have no extra cost
+};
+
+extern jlib_decl bool collectHardwareCounters;
+inline bool queryCollectHardwareCounters() { return collectHardwareCounters; }
+extern jlib_decl void setCollectHardwareCounters(bool enable);
+extern jlib_decl bool readThreadHardwareCounters(HardwareCounterValues & values); // returns false if the counters are not available
+
 
 interface IPerfMonHook : extends IInterface
 {
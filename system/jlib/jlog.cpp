@@ -978,7 +978,7 @@ void FileLogMsgHandlerTable::handleMessage(const LogMsg & msg)
     CriticalBlock block(crit);
     msg.toStringTable(curMsgText.clear(), messageFields);
     fputs(curMsgText.str(), handle);
-    if(flushes)
+    if(flushes && !logMsgBatchActive)
         fflush(handle);
 }
 
@@ -1000,7 +1000,7 @@ void FileLogMsgHandlerXML::handleMessage(const LogMsg & msg)
     CriticalBlock block(crit);
     msg.toStringXML(curMsgText.clear(), messageFields);
     fputs(curMsgText.str(), handle);
-    if(flushes)
+    if(flushes && !logMsgBatchActive)
         fflush(handle);
 }
 
@@ -1021,7 +1021,7 @@ void FileLogMsgHandlerJSON::handleMessage(const LogMsg & msg)
     CriticalBlock block(crit);
     msg.toStringJSON(curMsgText.clear(), messageFields);
     fputs(curMsgText.str(), handle);
-    if(flushes)
+    if(flushes && !logMsgBatchActive)
         fflush(handle);
 }
 
@@ -1062,7 +1062,7 @@ void PostMortemLogMsgHandler::handleMessage(const LogMsg & msg)
         checkRollover();
         msg.toStringTable(curMsgText.clear(), messageFields);
         fputs(curMsgText.str(), handle);
-        if(flushes)
+        if(flushes && !logMsgBatchActive)
             fflush(handle);
         linesInCurrent++;
     }
@@ -1387,105 +1387,295 @@ void LogMsgMonitor::addToPTree(IPropertyTree * tree) const
 
 // CLogMsgManager
 
+thread_local bool logMsgBatchActive = false;
+
+//Each thread that logs owns one ring per processor, shared with the processor.  The ring is orphaned (and later
+//released by the processor) when the thread exits or starts logging to a different processor.  The processor is
+//identified by a unique id rather than its address, which could be reused by a later processor.
+struct ThreadMsgRing
+{
+    unsigned processorId = 0;
+    std::shared_ptr<void> ring;
+    std::atomic<bool> * orphaned = nullptr;
+
+    void release()
+    {
+        if (orphaned)
+            orphaned->store(true, std::memory_order_release);
+        orphaned = nullptr;
+        ring.reset();
+    }
+    ~ThreadMsgRing()
+    {
+        release();
+    }
+};
+static thread_local ThreadMsgRing threadMsgRing;
+
+static std::atomic<unsigned> nextMsgProcessorId{0};
+
+//The metrics cover all the processors in the process, so they are only registered once
+static std::atomic<unsigned> queuedLogMsgs{0};
+static std::atomic<unsigned __int64> droppedLogMsgs{0};
+
+static void registerLogQueueMetrics()
+{
+    static auto queueDepthMetric = hpccMetrics::registerCustomMetric("log.queue.depth", "The number of log messages waiting to be written", hpccMetrics::METRICS_GAUGE, queuedLogMsgs, SMeasureCount);
+    static auto droppedMetric = hpccMetrics::registerCustomMetric("log.messages.dropped", "The number of log messages dropped because the queue was full", hpccMetrics::METRICS_COUNTER, droppedLogMsgs, SMeasureCount);
+}
+
+CLogMsgManager::MsgProcessor::MsgProcessor(CLogMsgManager * _owner) : Thread("CLogMsgManager::MsgProcessor"), owner(_owner), id(++nextMsgProcessorId)
+{
+    registerLogQueueMetrics();
+}
+
+CLogMsgManager::MsgProcessor::~MsgProcessor()
+{
+    //Rings that still belong to a running thread are kept alive by that thread, but any messages left in them are released now
+    for (auto & ring : rings)
+    {
+        while (LogMsg * msg = ring->pop())
+        {
+            msg->Release();
+            queuedLogMsgs--;
+        }
+    }
+}
+
+CLogMsgManager::MsgRing * CLogMsgManager::MsgProcessor::queryThreadRing()
+{
+    if (likely(threadMsgRing.processorId == id))
+        return static_cast<MsgRing *>(threadMsgRing.ring.get());
+
+    threadMsgRing.release();
+    std::shared_ptr<MsgRing> ring = std::make_shared<MsgRing>();
+    {
+        CriticalBlock block(ringsLock);
+        rings.push_back(ring);
+    }
+    threadMsgRing.processorId = id;
+    threadMsgRing.orphaned = &ring->orphaned;
+    threadMsgRing.ring = std::move(ring);
+    return static_cast<MsgRing *>(threadMsgRing.ring.get());
+}
+
+void CLogMsgManager::MsgProcessor::wakeProcessor()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed) && sleeping.exchange(false))
+        wakeSem.signal();
+}
+
+void CLogMsgManager::MsgProcessor::waitForSpace()
+{
+    spaceWaiters++;
+    wakeProcessor();
+    spaceSem.wait(10);
+    spaceWaiters--;
+}
+
 void CLogMsgManager::MsgProcessor::push(LogMsg * msg)
 {
     //assertex(more); an assertex will just recurse here
-    if (!more) // we are effective stopped so don't bother even dropping (and leak parameter) as drop will involve 
-               // interaction with the base class which is stopped and could easily crash (as this condition 
-               // is expected not to occur - typically occurs if the user has incorrectly called exit on one thread 
+    if (!more) // we are effective stopped so don't bother even dropping (and leak parameter) as drop will involve
+               // interaction with the base class which is stopped and could easily crash (as this condition
+               // is expected not to occur - typically occurs if the user has incorrectly called exit on one thread
                // while still in the process of logging on another)
                // cf Bug #53695 for more discussion of the issue
         return;
-    else if(droppingLimit && (q.ordinality() >= droppingLimit))
-        drop();
-    q.enqueue(msg);
+
+    MsgRing * ring = queryThreadRing();
+    for (;;)
+    {
+        unsigned dropLimit = droppingLimit.load(std::memory_order_relaxed);
+        if (dropLimit && (numQueued.load(std::memory_order_relaxed) >= dropLimit))
+        {
+            //Only the processor can remove queued messages, so ask it to drop the oldest
+            if (!dropRequested.load(std::memory_order_relaxed))
+                dropRequested = true;
+        }
+        unsigned blockLimit = blockingLimit.load(std::memory_order_relaxed);
+        if (!(blockLimit && (numQueued.load(std::memory_order_relaxed) >= blockLimit)))
+        {
+            if (ring->push(msg))
+                break;
+            if (dropLimit)
+            {
+                //This thread's ring is full - drop the incoming message rather than blocking the caller
+                msg->Release();
+                numPendingDrops++;
+                droppedLogMsgs++;
+                return;
+            }
+        }
+        //Wait for the processor to catch up
+        waitForSpace();
+        if (!more)
+        {
+            msg->Release();
+            return;
+        }
+    }
+    numQueued++;
+    queuedLogMsgs++;
+    numPushed++;
+    wakeProcessor();
 }
 
-int CLogMsgManager::MsgProcessor::run()
+bool CLogMsgManager::MsgProcessor::collect(std::vector<LogMsg *> & batch)
 {
-    Owned<LogMsg> msg;
-    while(more)
+    CriticalBlock block(ringsLock);
+    for (unsigned i = 0; i < rings.size(); )
     {
-        msg.setown(q.dequeueAndNotify(this)); // notify locks mutex on non-null return
-        if(!msg)
-            break;
-        owner->doReport(*msg);
-        pullCycleMutex.unlock();
+        MsgRing * ring = rings[i].get();
+        //Read the orphaned flag before draining, so that nothing added before the thread exited can be lost
+        bool orphaned = ring->orphaned.load(std::memory_order_acquire);
+        while (LogMsg * msg = ring->pop())
+            batch.push_back(msg);
+        if (orphaned)
+        {
+            rings[i] = std::move(rings.back());
+            rings.pop_back();
+        }
+        else
+            i++;
     }
-    while(true)
+    return !batch.empty();
+}
+
+//Drop the oldest messages in the (sorted) batch, as the shared queue used to.  Job id changes are never dropped.
+void CLogMsgManager::MsgProcessor::dropOldest(std::vector<LogMsg *> & batch)
+{
+    unsigned toDrop = numToDrop.load();
+    unsigned dropped = 0;
+    auto keep = batch.begin();
+    for (LogMsg * msg : batch)
+    {
+        LogMsgClass msgClass = msg->queryCategory().queryClass();
+        if ((dropped < toDrop) && (msgClass != MSGCLS_addid) && (msgClass != MSGCLS_removeid))
+        {
+            msg->Release();
+            dropped++;
+        }
+        else
+            *keep++ = msg;
+    }
+    batch.erase(keep, batch.end());
+    numPendingDrops += dropped;
+    droppedLogMsgs += dropped;
+}
+
+void CLogMsgManager::MsgProcessor::processBatch(std::vector<LogMsg *> & batch)
+{
+    //Each ring is in order, but the rings need to be merged.  Job ids are registered before, and removed after,
+    //any messages in the same batch that may refer to them.
+    auto rank = [](const LogMsg * msg) -> unsigned
+    {
+        switch (msg->queryCategory().queryClass())
+        {
+        case MSGCLS_addid: return 0;
+        case MSGCLS_removeid: return 2;
+        default: return 1;
+        }
+    };
+    std::stable_sort(batch.begin(), batch.end(), [&rank](const LogMsg * l, const LogMsg * r)
+    {
+        unsigned lrank = rank(l);
+        unsigned rrank = rank(r);
+        if (lrank != rrank)
+            return lrank < rrank;
+        return (lrank == 1) && (l->querySysInfo().queryMsgID() < r->querySysInfo().queryMsgID());
+    });
+
+    size_t numCollected = batch.size();
+    if (dropRequested.exchange(false))
+        dropOldest(batch);
+
+    unsigned dropped = numPendingDrops.exchange(0);
+    logMsgBatchActive = true;
+    for (LogMsg * msg : batch)
     {
-        msg.setown(q.dequeueNowAndNotify(this)); // notify locks mutex on non-null return
-        if(!msg)
-            break;
         owner->doReport(*msg);
-        pullCycleMutex.unlock();
+        msg->Release();
     }
-    return 0;
+    if (dropped)
+    {
+        Owned<LogMsg> dropMsg = new DropLogMsg(owner, owner->getNextID(), dropped);
+        owner->doReport(*dropMsg);
+    }
+    logMsgBatchActive = false;
+    owner->flushHandlers();
+
+    numQueued -= numCollected;
+    queuedLogMsgs -= numCollected;
+    numProcessed += numCollected;
+    batch.clear();
+    unsigned waiters = spaceWaiters.load();
+    if (waiters)
+        spaceSem.signal(waiters);
 }
 
-void CLogMsgManager::MsgProcessor::notify(LogMsg *)
+int CLogMsgManager::MsgProcessor::run()
 {
-    pullCycleMutex.lock();
+    std::vector<LogMsg *> batch;
+    while (more)
+    {
+        if (!collect(batch))
+        {
+            sleeping = true;
+            //Check again in case a message was added before the flag was set
+            if (!collect(batch))
+            {
+                wakeSem.wait(100);
+                sleeping = false;
+                continue;
+            }
+            sleeping = false;
+        }
+        processBatch(batch);
+    }
+    while (collect(batch))
+        processBatch(batch);
+    return 0;
 }
 
 void CLogMsgManager::MsgProcessor::setBlockingLimit(unsigned lim)
 {
-    q.setLimit(lim);
+    blockingLimit = lim;
     droppingLimit = 0;
 }
 
 void CLogMsgManager::MsgProcessor::setDroppingLimit(unsigned lim, unsigned num)
 {
-    numToDrop = num;
+    //Once the limit is reached the processor drops the num oldest queued messages
+    numToDrop = num ? num : 1;
     droppingLimit = lim;
-    q.setLimit(0);
+    blockingLimit = 0;
 }
 
 void CLogMsgManager::MsgProcessor::resetLimit()
 {
     droppingLimit = 0;
-    q.setLimit(0);
+    blockingLimit = 0;
 }
 
 void CLogMsgManager::MsgProcessor::stop()
 {
     more = false;
-    q.stop();
-}
-
-void CLogMsgManager::MsgProcessor::drop()
-{
-    Owned<LogMsg> msg, lastMsg;
-    unsigned count;
-    unsigned prev = 0;
-    for(count = 0; count < numToDrop; count++)
-    {
-        msg.setown(q.dequeueTail(0));
-        if(!msg) break;
-        DropLogMsg * dmsg = dynamic_cast<DropLogMsg *>(msg.get());
-        if(dmsg) prev += dmsg->queryCount()-1;
-        lastMsg.setown(msg.getClear());
-    }
-    if(lastMsg)
-        q.enqueue(new DropLogMsg(owner, lastMsg->querySysInfo().queryMsgID(), count+prev));
+    wakeSem.signal();
+    spaceSem.signal(spaceWaiters.load());
 }
 
 bool CLogMsgManager::MsgProcessor::flush(unsigned timeout)
 {
+    unsigned __int64 target = numPushed.load();
     unsigned start = msTick();
-    if(!q.waitMaxOrdinality(0, timeout))
-        return false;
-    unsigned now = msTick();
-    if(now - start >= timeout)
-        return false;
-    try
+    while (numProcessed.load() < target)
     {
-        synchronized block(pullCycleMutex, timeout+start-now);
-    }
-    catch(IException * e)
-    {
-        e->Release();
-        return false;
+        if (msTick() - start >= timeout)
+            return false;
+        wakeProcessor();
+        Sleep(1);
     }
     return true;
 }
@@ -1691,6 +1881,13 @@ void CLogMsgManager::pushMsg(LogMsg * _msg)
         doReport(*msg);
 }
 
+void CLogMsgManager::flushHandlers() const
+{
+    ReadLockBlock block(monitorLock);
+    ForEachItemIn(i, monitors)
+        monitors.item(i).queryHandler()->flush();
+}
+
 void CLogMsgManager::doReport(const LogMsg & msg) const
 {
     try
@@ -29,6 +29,10 @@
 #include "jfile.hpp"
 #include "jqueue.tpp"
 #include "jregexp.hpp"
+#include "jmetrics.hpp"
+#include <atomic>
+#include <memory>
+#include <vector>
 
 static unsigned const defaultMsgQueueLimit = 256;
 static LogMsgCategory const dropWarningCategory(MSGAUD_operator, MSGCLS_error, 0);
@@ -425,6 +429,9 @@ private:
     Linked<ILogMsgFilter>     no;
 };
 
+// Set while the log processor is writing a batch - file handlers then flush once at the end of the batch
+extern thread_local bool logMsgBatchActive;
+
 // Implementations of handlers which writes selected fields to file handle (XML and table output)
 
 class HandleLogMsgHandler : public ILogMsgHandler
@@ -592,7 +599,7 @@ public:
             msg.toStringTable(curMsgText.clear(), messageFields);
         fputs(curMsgText.str(), handle);
 
-        if(flushes) fflush(handle);
+        if(flushes && !logMsgBatchActive) fflush(handle);
     }
     bool                      needsPrep() const { return false; }
     void                      prep() {}
@@ -700,13 +707,50 @@ typedef MapBetween<LogMsgJobId, LogMsgJobId, StringAttr, const char *> MapLogMsg
 class CLogMsgManager : public ILogMsgManager, public CInterface
 {
 private:
+    // Messages are formatted by the thread that reports them, and then added to a lock-free ring owned by that thread.
+    // Formatting cannot be deferred to the processor because the arguments (e.g. %s) may not outlive the call.
+    // The processor thread drains all the rings in batches, so producers never contend with each other or with
+    // the handlers, and file handlers only flush once per batch rather than once per message.
+    class MsgRing
+    {
+    public:
+        static constexpr unsigned ringSize = 512;       // Must be a power of 2
+
+        bool push(LogMsg * msg)
+        {
+            unsigned h = head.load(std::memory_order_relaxed);
+            if (h - tail.load(std::memory_order_acquire) >= ringSize)
+                return false;
+            slots[h & (ringSize-1)] = msg;
+            head.store(h+1, std::memory_order_release);
+            return true;
+        }
+        LogMsg * pop()
+        {
+            unsigned t = tail.load(std::memory_order_relaxed);
+            if (t == head.load(std::memory_order_acquire))
+                return nullptr;
+            LogMsg * msg = slots[t & (ringSize-1)];
+            tail.store(t+1, std::memory_order_release);
+            return msg;
+        }
+        bool isEmpty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+    public:
+        std::atomic<bool> orphaned{false};      // Set when the owning thread exits (or logs to another processor) - released once it is empty
+    private:
+        std::atomic<unsigned> head{0};          // Only updated by the producer
+        std::atomic<unsigned> tail{0};          // Only updated by the processor
+        LogMsg * slots[ringSize];
+    };
+
     class MsgProcessor : public Thread
     {
     public:
-        MsgProcessor(CLogMsgManager * _owner) : Thread("CLogMsgManager::MsgProcessor"), owner(_owner), more(true), droppingLimit(0) {}
+        MsgProcessor(CLogMsgManager * _owner);
+        ~MsgProcessor();
         void push(LogMsg * msg);
         virtual int run();
-        void notify(LogMsg * msg);
         void stop();
         void setBlockingLimit(unsigned lim);
         void setDroppingLimit(unsigned lim, unsigned num);
@@ -714,15 +758,31 @@ private:
         bool flush(unsigned timeout);
 
     private:
-        void drop();
+        MsgRing * queryThreadRing();
+        void dropOldest(std::vector<LogMsg *> & batch);
+        bool collect(std::vector<LogMsg *> & batch);
+        void processBatch(std::vector<LogMsg *> & batch);
+        void waitForSpace();
+        void wakeProcessor();
 
     private:
         CLogMsgManager * owner;
-        bool more;
-        CallbackInterThreadQueueOf<LogMsg, MsgProcessor, false> q;
-        unsigned droppingLimit;
-        unsigned numToDrop = 1;
-        Mutex pullCycleMutex;
+        const unsigned id;                                  // Unique to each processor, identifies the thread's cached ring
+        std::atomic<bool> more{true};
+        CriticalSection ringsLock;
+        std::vector<std::shared_ptr<MsgRing>> rings;        // Shared with the owning thread, which may outlive the processor
+        Semaphore wakeSem;
+        std::atomic<bool> sleeping{false};
+        Semaphore spaceSem;
+        std::atomic<unsigned> spaceWaiters{0};
+        std::atomic<unsigned> blockingLimit{0};
+        std::atomic<unsigned> droppingLimit{0};
+        std::atomic<unsigned> numToDrop{1};                 // How many of the oldest messages are dropped once the dropping limit is reached
+        std::atomic<bool> dropRequested{false};
+        std::atomic<unsigned> numQueued{0};
+        std::atomic<unsigned> numPendingDrops{0};           // Messages dropped since the last DropLogMsg was reported
+        std::atomic<unsigned __int64> numPushed{0};
+        std::atomic<unsigned __int64> numProcessed{0};
     };
     Owned<MsgProcessor> processor;
 
@@ -787,6 +847,7 @@ private:
     void                      buildPrefilter();
     void                      pushMsg(LogMsg * msg);
     void                      doReport(const LogMsg & msg) const;
+    void                      flushHandlers() const;
     void                      panic(char const * reason) const;
     aindex_t                  findChild(ILogMsgLinkToChild * child) const;
 
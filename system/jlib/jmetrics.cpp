@@ -13,6 +13,7 @@
 
 #include "jmetrics.hpp"
 #include "jlog.hpp"
+#include "jtrace.hpp"
 #include <regex>
 
 using namespace hpccMetrics;
@@ -48,6 +49,41 @@ void HistogramMetric::recordMeasurement(__uint64 measurement)
 }
 
 
+// Replacing an exemplar involves extracting the trace id, so each bucket's exemplar is only refreshed occasionally
+static constexpr unsigned exemplarRefreshMs = 10000;
+
+void HistogramMetric::recordMeasurement(__uint64 measurement, const ISpan * span)
+{
+    bool wantExemplar = false;
+    {
+        CriticalBlock block(cs);
+        sum += measurement;
+        Bucket & bucket = findBucket(measurement);
+        bucket.count++;
+        if (span && (bucket.exemplar.traceId.empty() || (msTick() - bucket.exemplarTick >= exemplarRefreshMs)))
+        {
+            bucket.exemplarTick = msTick();     // Prevent other threads also trying to refresh it
+            wantExemplar = true;
+        }
+    }
+
+    if (!wantExemplar || !span->isRecording())
+        return;
+
+    Owned<IProperties> spanContext = getSpanContext(span);
+    const char * traceId = spanContext->queryProp("traceID");
+    if (isEmptyString(traceId))
+        return;
+
+    __uint64 timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    CriticalBlock block(cs);
+    MetricExemplar & exemplar = findBucket(measurement).exemplar;
+    exemplar.traceId.assign(traceId);
+    exemplar.value = scaleExemplarValue(measurement);
+    exemplar.timestampMs = timestampMs;
+}
+
+
 std::vector<__uint64> HistogramMetric::queryHistogramValues() const
 {
     std::vector<__uint64> histogramValues;
@@ -62,6 +98,20 @@ std::vector<__uint64> HistogramMetric::queryHistogramValues() const
 }
 
 
+std::vector<MetricExemplar> HistogramMetric::queryHistogramExemplars() const
+{
+    std::vector<MetricExemplar> exemplars;
+    exemplars.reserve(buckets.size()+1);
+    CriticalBlock block(cs);
+    for (auto const &bucket: buckets)
+    {
+        exemplars.push_back(bucket.exemplar);
+    }
+    exemplars.push_back(inf.exemplar);
+    return exemplars;
+}
+
+
 std::vector<__uint64> HistogramMetric::queryHistogramBucketLimits() const
 {
     std::vector<__uint64> limits;
@@ -30,7 +30,7 @@
 #include "jatomic.hpp"
 #include <regex>
 
-
+interface ISpan;
 
 namespace hpccMetrics {
 
@@ -60,6 +60,18 @@ struct MetricMetaDataItem
 
 typedef std::vector<MetricMetaDataItem> MetricMetaData;
 
+
+/*
+ * An example measurement from a histogram bucket, linked to the trace that produced it.
+ * An empty traceId indicates the bucket has no exemplar.
+ */
+struct MetricExemplar
+{
+    std::string traceId;
+    __uint64 value = 0;             // In the same units as the bucket limits
+    __uint64 timestampMs = 0;       // ms since the epoch
+};
+
 /*
  * IMetric
  *
@@ -108,6 +120,11 @@ interface IMetric
      * Query histogram bucket limits
      */
     virtual std::vector<__uint64> queryHistogramBucketLimits() const = 0;
+
+    /*
+     * Query the most recent exemplar for each histogram bucket (including the +Inf bucket)
+     */
+    virtual std::vector<MetricExemplar> queryHistogramExemplars() const = 0;
 };
 
 
@@ -126,6 +143,7 @@ public:
     StatisticMeasure queryUnits() const override { return units; }
     virtual std::vector<__uint64> queryHistogramValues() const override { return {}; }
     virtual std::vector<__uint64> queryHistogramBucketLimits() const override { return {}; }
+    virtual std::vector<MetricExemplar> queryHistogramExemplars() const override { return {}; }
 
 
 protected:
@@ -263,8 +281,11 @@ public:
     }
 
     void recordMeasurement(__uint64 measurement);
+    // As above, and if the measurement is from a sampled trace, occasionally keep it as an exemplar for its bucket
+    void recordMeasurement(__uint64 measurement, const ISpan * span);
     virtual std::vector<__uint64> queryHistogramValues() const override;
     virtual std::vector<__uint64> queryHistogramBucketLimits() const override;
+    virtual std::vector<MetricExemplar> queryHistogramExemplars() const override;
 
 protected:
     struct Bucket
@@ -273,8 +294,11 @@ protected:
                 limit{_limit}, count{0} {}
         __uint64 limit;
         __uint64 count;
+        MetricExemplar exemplar;
+        unsigned exemplarTick = 0;
     };
     Bucket &findBucket(__uint64 measurement);
+    virtual __uint64 scaleExemplarValue(__uint64 measurement) const { return measurement; }
 
 protected:
     std::vector<Bucket> buckets;
@@ -298,6 +322,9 @@ public:
         }
     }
 
+protected:
+    virtual __uint64 scaleExemplarValue(__uint64 measurement) const override { return (__uint64)((double)measurement * outputScaleFactor); }
+
 protected:
     double outputScaleFactor;
 };
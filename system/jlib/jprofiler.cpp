@@ -0,0 +1,332 @@
+/*##############################################################################
+
+    HPCC SYSTEMS software Copyright (C) 2024 HPCC Systems®.
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+############################################################################## */
+
+#include "platform.h"
+#include "jprofiler.hpp"
+#include "jstring.hpp"
+#include "jmutex.hpp"
+#include "jthread.hpp"
+#include "jfile.hpp"
+#include "jlog.hpp"
+
+#include <atomic>
+#include <string>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <signal.h>
+#include <sys/time.h>
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#endif
+
+bool samplingProfilerActive = false;
+
+#ifdef __linux__
+
+static constexpr unsigned maxSampleFrames = 48;
+static constexpr unsigned numSampleSlots = 4096;                // Must be a power of 2
+static constexpr unsigned skipSampleFrames = 2;                 // The signal handler and the signal trampoline
+static constexpr unsigned drainIntervalMs = 100;
+
+//initial-exec so that accessing it from the signal handler can never allocate
+static thread_local unsigned currentActivity __attribute__((tls_model("initial-exec"))) = 0;
+
+//Each slot is claimed by a single writer (the signal handler) and released by the single reader (the drain thread)
+struct ProfileSample
+{
+    enum : unsigned { Empty, Writing, Full };
+    std::atomic<unsigned> state{Empty};
+    unsigned activity = 0;
+    unsigned numFrames = 0;
+    void * frames[maxSampleFrames];
+};
+
+class CSamplingProfiler
+{
+public:
+    CSamplingProfiler()
+    {
+        samples = new ProfileSample[numSampleSlots];
+    }
+    ~CSamplingProfiler()
+    {
+        delete [] samples;
+    }
+
+    //Called from the signal handler - must be async signal safe
+    inline void recordSample()
+    {
+        unsigned idx = writePos.fetch_add(1, std::memory_order_relaxed) & (numSampleSlots - 1);
+        ProfileSample & sample = samples[idx];
+        unsigned expected = ProfileSample::Empty;
+        if (!sample.state.compare_exchange_strong(expected, ProfileSample::Writing, std::memory_order_acquire))
+        {
+            //The reader has fallen behind - discard rather than block
+            numDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        sample.activity = currentActivity;
+        sample.numFrames = backtrace(sample.frames, maxSampleFrames);
+        sample.state.store(ProfileSample::Full, std::memory_order_release);
+    }
+
+    void drain()
+    {
+        CriticalBlock block(cs);
+        for (;;)
+        {
+            ProfileSample & sample = samples[readPos & (numSampleSlots - 1)];
+            if (sample.state.load(std::memory_order_acquire) != ProfileSample::Full)
+                break;
+            if (sample.numFrames > skipSampleFrames)
+            {
+                //Key on the raw activity id and return addresses - symbols are only resolved when the profile is output
+                std::string key((const char *)&sample.activity, sizeof(sample.activity));
+                key.append((const char *)(sample.frames + skipSampleFrames), (sample.numFrames - skipSampleFrames) * sizeof(void *));
+                stacks[key]++;
+            }
+            sample.state.store(ProfileSample::Empty, std::memory_order_release);
+            readPos++;
+        }
+    }
+
+    StringBuffer & getProfile(StringBuffer & out, bool reset)
+    {
+        drain();
+        CriticalBlock block(cs);
+        for (const auto & cur : stacks)
+        {
+            const char * data = cur.first.data();
+            unsigned activity;
+            memcpy(&activity, data, sizeof(activity));
+            void * const * frames = (void * const *)(data + sizeof(activity));
+            unsigned numFrames = (cur.first.size() - sizeof(activity)) / sizeof(void *);
+
+            if (activity)
+                out.append("activity_").append(activity);
+            else
+                out.append("unknown");
+            //backtrace() returns the innermost frame first, folded stacks are outermost first
+            for (unsigned i = numFrames; i--; )
+                appendSymbol(out.append(';'), frames[i]);
+            out.append(' ').append(cur.second).newline();
+        }
+        unsigned dropped = numDropped.load();
+        if (dropped)
+            out.append("dropped ").append(dropped).newline();
+        if (reset)
+        {
+            stacks.clear();
+            numDropped.store(0);
+        }
+        return out;
+    }
+
+protected:
+    void appendSymbol(StringBuffer & out, void * address)
+    {
+        auto match = symbols.find(address);
+        if (match == symbols.end())
+        {
+            StringBuffer name;
+            Dl_info info;
+            bool found = dladdr(address, &info) != 0;
+            if (found && info.dli_sname)
+            {
+                int status = 0;
+                char * demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+                name.append(demangled ? demangled : info.dli_sname);
+                free(demangled);
+            }
+            else if (found && info.dli_fname)
+            {
+                //Not an exported symbol - use the module and offset, which can be resolved later with addr2line
+                const char * module = strrchr(info.dli_fname, PATHSEPCHAR);
+                name.append(module ? module+1 : info.dli_fname).appendf("+0x%zx", (size_t)((const byte *)address - (const byte *)info.dli_fbase));
+            }
+            else
+                name.appendf("%p", address);
+            match = symbols.emplace(address, name.str()).first;
+        }
+        out.append(match->second.c_str());
+    }
+
+protected:
+    ProfileSample * samples = nullptr;
+    std::atomic<unsigned> writePos{0};
+    std::atomic<unsigned> numDropped{0};
+    unsigned readPos = 0;
+    CriticalSection cs;
+    std::unordered_map<std::string, unsigned> stacks;
+    std::unordered_map<void *, std::string> symbols;
+};
+
+//Drains the ring regularly so that it does not overflow while the profiler is running
+class CProfileDrainThread : public Thread
+{
+public:
+    CProfileDrainThread(CSamplingProfiler & _owner) : Thread("ProfileDrainThread"), owner(_owner) {}
+
+    virtual int run() override
+    {
+        while (!stopping)
+        {
+            stopSem.wait(drainIntervalMs);
+            owner.drain();
+        }
+        return 0;
+    }
+
+    void stop()
+    {
+        stopping = true;
+        stopSem.signal();
+        join();
+    }
+
+protected:
+    CSamplingProfiler & owner;
+    Semaphore stopSem;
+    std::atomic<bool> stopping{false};
+};
+
+static CriticalSection profilerCs;
+static CSamplingProfiler * profiler = nullptr;   // Not released when stopped, so the signal handler can never see a freed object
+static Owned<CProfileDrainThread> drainThread;
+static struct sigaction prevAction;
+
+static void profileSignalHandler(int sig, siginfo_t * info, void * context)
+{
+    int savedErrno = errno;
+    if (samplingProfilerActive)
+        profiler->recordSample();
+    errno = savedErrno;
+}
+
+bool startSamplingProfiler(unsigned samplesPerSecond)
+{
+    CriticalBlock block(profilerCs);
+    if (samplingProfilerActive || !samplesPerSecond)
+        return false;
+
+    //The first call to backtrace() may load libgcc, which is not safe within a signal handler
+    void * dummy[1];
+    backtrace(dummy, 1);
+
+    if (!profiler)
+        profiler = new CSamplingProfiler;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = profileSignalHandler;
+    action.sa_flags = SA_RESTART | SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, &prevAction) != 0)
+    {
+        OERRLOG("startSamplingProfiler: failed to install SIGPROF handler (errno %d)", errno);
+        return false;
+    }
+
+    samplingProfilerActive = true;
+    unsigned intervalUs = 1000000 / std::min(samplesPerSecond, 10000U);
+    struct itimerval timer;
+    timer.it_interval.tv_sec = intervalUs / 1000000;
+    timer.it_interval.tv_usec = intervalUs % 1000000;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, nullptr) != 0)
+    {
+        OERRLOG("startSamplingProfiler: failed to start profiling timer (errno %d)", errno);
+        samplingProfilerActive = false;
+        sigaction(SIGPROF, &prevAction, nullptr);
+        return false;
+    }
+    drainThread.setown(new CProfileDrainThread(*profiler));
+    drainThread->start();
+    DBGLOG("Sampling profiler started at %u samples per second", samplesPerSecond);
+    return true;
+}
+
+void stopSamplingProfiler()
+{
+    CriticalBlock block(profilerCs);
+    if (!samplingProfilerActive)
+        return;
+
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    samplingProfilerActive = false;
+    //Any signal that is still pending is ignored by the handler, so it is left installed
+    drainThread->stop();
+    drainThread.clear();
+    profiler->drain();
+    DBGLOG("Sampling profiler stopped");
+}
+
+StringBuffer & getSamplingProfile(StringBuffer & out, bool reset)
+{
+    CriticalBlock block(profilerCs);
+    if (profiler)
+        profiler->getProfile(out, reset);
+    return out;
+}
+
+unsigned setProfilerActivity(unsigned activityId)
+{
+    unsigned prev = currentActivity;
+    currentActivity = activityId;
+    return prev;
+}
+
+#else
+
+bool startSamplingProfiler(unsigned samplesPerSecond)
+{
+    return false;
+}
+
+void stopSamplingProfiler()
+{
+}
+
+StringBuffer & getSamplingProfile(StringBuffer & out, bool reset)
+{
+    return out;
+}
+
+unsigned setProfilerActivity(unsigned activityId)
+{
+    return 0;
+}
+
+#endif
+
+bool saveSamplingProfile(const char * filename, bool reset)
+{
+    StringBuffer profile;
+    getSamplingProfile(profile, reset);
+    if (!profile.length())
+        return false;
+    Owned<IFile> file = createIFile(filename);
+    Owned<IFileIO> io = file->open(IFOcreate);
+    if (!io)
+        return false;
+    io->write(0, profile.length(), profile.str());
+    return true;
+}
@@ -0,0 +1,51 @@
+/*##############################################################################
+
+    HPCC SYSTEMS software Copyright (C) 2024 HPCC Systems®.
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+############################################################################## */
+
+#ifndef JPROFILER_HPP
+#define JPROFILER_HPP
+
+#include "jiface.hpp"
+
+class StringBuffer;
+
+/*
+ * A low overhead sampling profiler that can be left running in production processes.
+ *
+ * An ITIMER_PROF timer delivers SIGPROF to whichever thread is consuming cpu.  The signal handler captures the
+ * call stack, tags it with the activity that thread is currently executing, and adds it to a lock-free ring
+ * buffer.  A background thread drains the ring and aggregates identical stacks, so the memory used depends on the
+ * number of distinct stacks rather than the number of samples.
+ *
+ * The results are returned in the "folded stack" format (one line per stack: "frame;frame;frame count", outermost
+ * frame first) that is understood by flamegraph.pl, speedscope and similar tools.  The outermost frame is the
+ * activity id ("activity_<n>") if the sample was taken inside an activity.
+ *
+ * When the profiler is not running the only cost is a test of a global flag in ActivityTimer.
+ */
+
+extern jlib_decl bool samplingProfilerActive;
+inline bool isSamplingProfilerActive() { return samplingProfilerActive; }
+
+extern jlib_decl bool startSamplingProfiler(unsigned samplesPerSecond);     // returns false if already running or not supported
+extern jlib_decl void stopSamplingProfiler();
+extern jlib_decl StringBuffer & getSamplingProfile(StringBuffer & out, bool reset);
+extern jlib_decl bool saveSamplingProfile(const char * filename, bool reset);    // returns false if there were no samples
+
+//Which activity is the current thread executing?  Returns the previous value, so that it can be restored.
+extern jlib_decl unsigned setProfilerActivity(unsigned activityId);
+
+#endif
@@ -661,6 +661,8 @@ interface IBufferedSocket : implements IInterface
     virtual int read(char* buf, int maxlen) = 0;
     virtual int readline(char* buf, int maxlen, bool keepcrlf, IMultiException *me) = 0;
     virtual void setReadTimeout(unsigned int timeout) = 0;
+    virtual void setReadLimit(unsigned __int64 limit) = 0;     // never read more than limit bytes from the socket, e.g. so a pipelined request is left for the next reader
+    virtual void setInitialData(const void * data, size32_t len) = 0;     // data already read from the socket, returned before the socket is read (and counted in the read limit)
 };
 
 #define BSOCKET_READ_TIMEOUT 600
@@ -302,6 +302,12 @@ enum StatisticKind
     StSizeContinuationData,
     StNumContinuationRequests,
     StNumFailures,
+    StNumCompileCacheHits,
+    StNumCompileCacheAdds,
+    StNumHwCycles,                      // Hardware counters - only gathered if enabled
+    StNumHwInstructions,
+    StNumHwCacheMisses,
+    StNumHwBranchMisses,
     StMax,
 
     //For any quantity there is potentially the following variants.
@@ -974,6 +974,12 @@ static const constexpr StatisticMeta statsMetaData[StMax] = {
     { SIZESTAT(ContinuationData), "The total size of continuation data sent from agent to the server\nA large number may indicate a poor filter, or merging from many different index locations" },
     { NUMSTAT(ContinuationRequests), "The number of times the agent indicated there was more data to be returned" },
     { NUMSTAT(Failures), "The number of times a query has failed" },
+    { NUMSTAT(CompileCacheHits), "The number of generated c++ files whose object file was found in the compiled object cache" },
+    { NUMSTAT(CompileCacheAdds), "The number of generated c++ files that were compiled and added to the compiled object cache" },
+    { NUMSTAT(HwCycles), "The number of cpu cycles counted by the hardware performance counters while executing this activity" },
+    { NUMSTAT(HwInstructions), "The number of instructions retired while executing this activity" },
+    { NUMSTAT(HwCacheMisses), "The number of last level cache misses while executing this activity" },
+    { NUMSTAT(HwBranchMisses), "The number of mispredicted branches while executing this activity" },
 };
 
 static MapStringTo<StatisticKind, StatisticKind> statisticNameMap(true);
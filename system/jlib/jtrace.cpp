@@ -39,13 +39,18 @@
 #include "opentelemetry/exporters/memory/in_memory_span_data.h"
 
 #include "opentelemetry/sdk/trace/exporter.h"
+#include "opentelemetry/sdk/trace/processor.h"
+#include "opentelemetry/sdk/trace/recordable.h"
 #include "opentelemetry/sdk/trace/span_data.h"
 
 #include "platform.h"
 #include "jlib.hpp"
 #include "jmisc.hpp"
-#include "jtrace.hpp"
+#include "jtrace.ipp"
+#include "jregexp.hpp"
 #include "lnuid.h"
+#include <deque>
+#include <list>
 #include <variant>
 
 namespace context     = opentelemetry::context;
@@ -430,6 +435,344 @@ public:
     }
 };
 
+//---------------------------------------------------------------------------------------------------------------------
+
+/*
+ * Tail based sampling.  The spans of each trace are buffered until the local root span of the trace (the span whose
+ * parent is remote or absent, normally the server span for a query) has ended.  The whole trace is then either passed
+ * on to the exporters or discarded:  it is kept if any span took longer than the latency threshold, ended with an
+ * error, or has a name that matches one of the configured patterns.  Fast successful queries therefore cost nothing
+ * to export, but complete traces are available for the slow or failing ones.
+ *
+ * Each span is recorded directly into a recordable created by every downstream processor (in the same way as the otel
+ * multi span processor), so a buffered span can be handed to any exporter without being copied.
+ */
+class TailSamplingRecordable final : public opentelemetry::sdk::trace::Recordable
+{
+public:
+    TailSamplingRecordable(const std::vector<std::unique_ptr<opentelemetry::sdk::trace::SpanProcessor>> & processors)
+    {
+        recordables.reserve(processors.size());
+        for (auto & processor : processors)
+            recordables.push_back(processor->MakeRecordable());
+    }
+
+    virtual void SetIdentity(const opentelemetry::trace::SpanContext & spanContext, opentelemetry::trace::SpanId parentSpanId) noexcept override
+    {
+        auto id = spanContext.trace_id().Id();
+        traceKey.assign((const char *)id.data(), id.size());
+        for (auto & recordable : recordables)
+        {
+            if (recordable)
+                recordable->SetIdentity(spanContext, parentSpanId);
+        }
+    }
+
+    virtual void SetAttribute(nostd::string_view key, const opentelemetry::common::AttributeValue & value) noexcept override
+    {
+        for (auto & recordable : recordables)
+        {
+            if (recordable)
+                recordable->SetAttribute(key, value);
+        }
+    }
+
+    virtual void AddEvent(nostd::string_view name, opentelemetry::common::SystemTimestamp timestamp, const opentelemetry::common::KeyValueIterable & attributes) noexcept override
+    {
+        for (auto & recordable : recordables)
+        {
+            if (recordable)
+                recordable->AddEvent(name, timestamp, attributes);
+        }
+    }
+
+    virtual void AddLink(const opentelemetry::trace::SpanContext & spanContext, const opentelemetry::common::KeyValueIterable & attributes) noexcept override
+    {
+        for (auto & recordable : recordables)
+        {
+            if (recordable)
+                recordable->AddLink(spanContext, attributes);
+        }
+    }
+
+    virtual void SetStatus(opentelemetry::trace::StatusCode code, nostd::string_view description) noexcept override
+    {
+        isError = (code == opentelemetry::trace::StatusCode::kError);
+        for (auto & recordable : recordables)
+        {
+            if (recordable)
+                recordable->SetStatus(code, description);
+        }
+    }
+
+    virtual void SetName(nostd::string_view _name) noexcept override
+    {
+        name.assign(_name.data(), _name.size());
+        for (auto & recordable : recordables)
+        {
+            if (recordable)
+                recordable->SetName(_name);
+        }
+    }
+
+    virtual void SetSpanKind(opentelemetry::trace::SpanKind spanKind) noexcept override
+    {
+        for (auto & recordable : recordables)
+        {
+            if (recordable)
+                recordable->SetSpanKind(spanKind);
+        }
+    }
+
+    virtual void SetResource(const opentelemetry::sdk::resource::Resource & resource) noexcept override
+    {
+        for (auto & recordable : recordables)
+        {
+            if (recordable)
+                recordable->SetResource(resource);
+        }
+    }
+
+    virtual void SetStartTime(opentelemetry::common::SystemTimestamp startTime) noexcept override
+    {
+        for (auto & recordable : recordables)
+        {
+            if (recordable)
+                recordable->SetStartTime(startTime);
+        }
+    }
+
+    virtual void SetDuration(std::chrono::nanoseconds _duration) noexcept override
+    {
+        duration = _duration;
+        for (auto & recordable : recordables)
+        {
+            if (recordable)
+                recordable->SetDuration(_duration);
+        }
+    }
+
+    virtual void SetInstrumentationScope(const opentelemetry::sdk::instrumentationscope::InstrumentationScope & scope) noexcept override
+    {
+        for (auto & recordable : recordables)
+        {
+            if (recordable)
+                recordable->SetInstrumentationScope(scope);
+        }
+    }
+
+public:
+    std::vector<std::unique_ptr<opentelemetry::sdk::trace::Recordable>> recordables;   // one per downstream processor
+    std::string traceKey;       // raw bytes of the trace id
+    std::string name;
+    std::chrono::nanoseconds duration{0};
+    bool isError = false;
+    bool isLocalRoot = false;
+};
+
+class TailSamplingSpanProcessor final : public opentelemetry::sdk::trace::SpanProcessor
+{
+    using SpanList = std::vector<std::unique_ptr<TailSamplingRecordable>>;
+
+    struct PendingTrace
+    {
+        SpanList spans;
+        std::list<std::string>::iterator orderPos;    // position within pendingOrder
+        unsigned startTick = 0;
+    };
+
+public:
+    TailSamplingSpanProcessor(std::vector<std::unique_ptr<opentelemetry::sdk::trace::SpanProcessor>> && _processors, const IPropertyTree * config)
+        : processors(std::move(_processors))
+    {
+        latencyThresholdNs = (__uint64)config->getPropInt64("@latencyThresholdMs", 1000) * 1000000;
+        keepErrors = config->getPropBool("@keepErrors", true);
+        keepPercent = config->getPropInt("@keepPercent", 0);
+        maxBufferedSpans = config->getPropInt("@maxBufferedSpans", 10000);
+        maxPendingMs = config->getPropInt("@maxPendingMs", 60000);
+        Owned<IPropertyTreeIterator> rules = config->getElements("rules");
+        ForEach(*rules)
+        {
+            const char * pattern = rules->query().queryProp("@name");
+            if (!isEmptyString(pattern))
+                keepNames.append(pattern);
+        }
+        LOG(MCoperatorInfo, "Tail sampling traces: latency threshold %llums, keep errors %s, max buffered spans %u",
+            (unsigned long long)(latencyThresholdNs / 1000000), boolToStr(keepErrors), maxBufferedSpans);
+    }
+
+    virtual std::unique_ptr<opentelemetry::sdk::trace::Recordable> MakeRecordable() noexcept override
+    {
+        return std::unique_ptr<opentelemetry::sdk::trace::Recordable>(new TailSamplingRecordable(processors));
+    }
+
+    virtual void OnStart(opentelemetry::sdk::trace::Recordable & span, const opentelemetry::trace::SpanContext & parentContext) noexcept override
+    {
+        TailSamplingRecordable & tail = static_cast<TailSamplingRecordable &>(span);
+        tail.isLocalRoot = !parentContext.IsValid() || parentContext.IsRemote();
+        for (size_t i = 0; i < processors.size(); i++)
+        {
+            if (tail.recordables[i])
+                processors[i]->OnStart(*tail.recordables[i], parentContext);
+        }
+    }
+
+    virtual void OnEnd(std::unique_ptr<opentelemetry::sdk::trace::Recordable> && span) noexcept override
+    {
+        std::unique_ptr<TailSamplingRecordable> tail(static_cast<TailSamplingRecordable *>(span.release()));
+        SpanList toExport;
+        {
+            CriticalBlock block(cs);
+            auto decided = decisions.find(tail->traceKey);
+            if (decided != decisions.end())
+            {
+                //A span that ended after the local root of its trace follows the decision made for the trace
+                if (decided->second)
+                    toExport.push_back(std::move(tail));
+            }
+            else
+            {
+                std::string traceKey = tail->traceKey;
+                bool isLocalRoot = tail->isLocalRoot;
+                PendingTrace & trace = pending[traceKey];
+                if (trace.spans.empty())
+                {
+                    trace.startTick = msTick();
+                    trace.orderPos = pendingOrder.insert(pendingOrder.end(), traceKey);
+                }
+                trace.spans.push_back(std::move(tail));
+                numBuffered++;
+                if (isLocalRoot)
+                    decide(traceKey, toExport);
+                limitPending(toExport);
+            }
+        }
+        exportSpans(toExport);
+    }
+
+    virtual bool ForceFlush(std::chrono::microseconds timeout) noexcept override
+    {
+        bool ok = true;
+        for (auto & processor : processors)
+            ok = processor->ForceFlush(timeout) && ok;
+        return ok;
+    }
+
+    virtual bool Shutdown(std::chrono::microseconds timeout) noexcept override
+    {
+        SpanList toExport;
+        {
+            //Traces that are still incomplete are decided on the spans that have been seen
+            CriticalBlock block(cs);
+            while (!pending.empty())
+                decide(pending.begin()->first, toExport);
+        }
+        exportSpans(toExport);
+        LOG(MCoperatorInfo, "Tail sampling traces: %llu kept, %llu discarded", (unsigned long long)numKept, (unsigned long long)numDiscarded);
+
+        bool ok = true;
+        for (auto & processor : processors)
+            ok = processor->Shutdown(timeout) && ok;
+        return ok;
+    }
+
+protected:
+    bool shouldKeep(const PendingTrace & trace)
+    {
+        for (auto & span : trace.spans)
+        {
+            if (keepErrors && span->isError)
+                return true;
+            if ((__uint64)span->duration.count() >= latencyThresholdNs)
+                return true;
+            ForEachItemIn(i, keepNames)
+            {
+                if (WildMatch(span->name.c_str(), keepNames.item(i), true))
+                    return true;
+            }
+        }
+        return keepPercent && ((unsigned)(getRandom() % 100) < keepPercent);
+    }
+
+    void decide(const std::string & traceKey, SpanList & toExport)
+    {
+        auto match = pending.find(traceKey);
+        if (match == pending.end())
+            return;
+        PendingTrace & trace = match->second;
+        bool keep = shouldKeep(trace);
+        numBuffered -= trace.spans.size();
+        if (keep)
+        {
+            numKept++;
+            for (auto & span : trace.spans)
+                toExport.push_back(std::move(span));
+        }
+        else
+            numDiscarded++;
+
+        //Remember the decision for a while so that any spans that end later follow it.
+        if (decisions.emplace(traceKey, keep).second)
+            decisionOrder.push_back(traceKey);
+        while (decisionOrder.size() > maxBufferedSpans)
+        {
+            decisions.erase(decisionOrder.front());
+            decisionOrder.pop_front();
+        }
+        pendingOrder.erase(trace.orderPos);
+        pending.erase(match);
+    }
+
+    //Bound the memory used by traces that have not completed (or whose local root ended in another process)
+    void limitPending(SpanList & toExport)
+    {
+        unsigned now = msTick();
+        while (!pendingOrder.empty())
+        {
+            //decide() removes the trace from pendingOrder, so the front is always the oldest pending trace
+            std::string oldest = pendingOrder.front();
+            const PendingTrace & trace = pending.find(oldest)->second;
+            if ((numBuffered <= maxBufferedSpans) && (now - trace.startTick < maxPendingMs))
+                break;
+            decide(oldest, toExport);
+        }
+    }
+
+    void exportSpans(SpanList & spans)
+    {
+        for (auto & span : spans)
+        {
+            for (size_t i = 0; i < processors.size(); i++)
+            {
+                if (span->recordables[i])
+                    processors[i]->OnEnd(std::move(span->recordables[i]));
+            }
+        }
+    }
+
+protected:
+    std::vector<std::unique_ptr<opentelemetry::sdk::trace::SpanProcessor>> processors;
+    CriticalSection cs;
+    std::unordered_map<std::string, PendingTrace> pending;
+    std::list<std::string> pendingOrder;        // keys of the pending traces, oldest first
+    std::unordered_map<std::string, bool> decisions;
+    std::deque<std::string> decisionOrder;
+    StringArray keepNames;
+    __uint64 latencyThresholdNs = 0;
+    __uint64 numKept = 0;
+    __uint64 numDiscarded = 0;
+    size_t numBuffered = 0;
+    unsigned maxBufferedSpans = 0;
+    unsigned maxPendingMs = 0;
+    unsigned keepPercent = 0;
+    bool keepErrors = true;
+};
+
+std::unique_ptr<opentelemetry::sdk::trace::SpanProcessor> createTailSamplingSpanProcessor(std::vector<std::unique_ptr<opentelemetry::sdk::trace::SpanProcessor>> && processors, const IPropertyTree * config)
+{
+    return std::unique_ptr<opentelemetry::sdk::trace::SpanProcessor>(new TailSamplingSpanProcessor(std::move(processors), config));
+}
+
 class CHPCCHttpTextMapCarrier : public opentelemetry::context::propagation::TextMapCarrier
 {
 public:
@@ -1260,6 +1603,15 @@ void CTraceManager::initTracerProviderAndGlobalInternals(const IPropertyTree * t
         processors.push_back(opentelemetry::sdk::trace::SimpleSpanProcessorFactory::Create(std::move(exporter)));
     }
 
+    //Tail sampling sits in front of all the exporters, and only passes on the traces it decides to keep
+    const IPropertyTree * tailSamplingConfig = traceConfig ? traceConfig->queryPropTree("tailSampling") : nullptr;
+    if (tailSamplingConfig && tailSamplingConfig->getPropBool("@enabled", false) && !processors.empty())
+    {
+        std::unique_ptr<opentelemetry::sdk::trace::SpanProcessor> tailSampler = createTailSamplingSpanProcessor(std::move(processors), tailSamplingConfig);
+        processors.clear();
+        processors.push_back(std::move(tailSampler));
+    }
+
     // Default is an always-on sampler.
     std::shared_ptr<opentelemetry::sdk::trace::TracerContext> context =
         opentelemetry::sdk::trace::TracerContextFactory::Create(std::move(processors));
@@ -1284,6 +1636,15 @@ global:
             sslCredentialsCACcert: "ssl-certificate"
             batch:                        #optional - Controls span processing style
                 enabled                    #is batched processing enabled?
+        tailSampling:                   #optional - only export traces that are slow, fail or match a rule
+            enabled: true
+            latencyThresholdMs: 1000      #keep traces containing a span that took at least this long
+            keepErrors: true              #keep traces containing a span with an error status
+            keepPercent: 0                #percentage of the remaining traces to keep
+            maxBufferedSpans: 10000       #limit on the spans held while waiting for a decision
+            maxPendingMs: 60000           #decide traces that have not completed within this time
+            rules:                        #keep traces containing a span whose name matches a pattern
+            -   name: "*workunit*"
 */
 void CTraceManager::initTracer(const IPropertyTree * traceConfig)
 {
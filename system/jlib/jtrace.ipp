@@ -0,0 +1,31 @@
+/*##############################################################################
+
+    HPCC SYSTEMS software Copyright (C) 2024 HPCC Systems®.
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+############################################################################## */
+
+
+#ifndef JTRACE_IPP
+#define JTRACE_IPP
+
+#include <memory>
+#include <vector>
+#include "opentelemetry/sdk/trace/processor.h"
+#include "jtrace.hpp"
+
+//Creates the tail sampling processor that sits in front of the exporters.  Exported so that the sampling decisions
+//can be unit tested without configuring a trace manager.
+extern jlib_decl std::unique_ptr<opentelemetry::sdk::trace::SpanProcessor> createTailSamplingSpanProcessor(std::vector<std::unique_ptr<opentelemetry::sdk::trace::SpanProcessor>> && processors, const IPropertyTree * config);
+
+#endif
@@ -20,8 +20,6 @@
 
 using namespace hpccMetrics;
 
-std::map<std::string, std::vector<std::string>> histogramLabels;
-
 extern "C" MetricSink* getSinkInstance(const char *name, const IPropertyTree *pSettingsTree)
 {
     return new PrometheusMetricSink(name, pSettingsTree);
@@ -74,12 +72,22 @@ PrometheusMetricSink::PrometheusMetricSink(const char *name, const IPropertyTree
         {
             LOG(MCdebugInfo, "GET PrometheusMetricsService%s, from %s:%d", req.path.c_str(), req.remote_addr.c_str(), req.remote_port);
 
-            StringBuffer payload;
-            toPrometheusMetrics(m_metricsManager->queryMetricsForReport(std::string(m_metricsSinkName.str())), payload, m_verbose);
+            std::call_once(m_scrapeMetricsRegistered, [this]() { registerScrapeMetrics(); });
 
-            res.set_content(payload.str(), PROMETHEUS_METRICS_SERVICE_RESP_TYPE);
+            // Exemplars are only part of the OpenMetrics format, so they are only returned if the scraper asks for it
+            bool openMetrics = strstr(req.get_header_value("Accept").c_str(), "application/openmetrics-text") != nullptr;
+            cycle_t startCycles = get_cycles_now();
+            auto reportMetrics = m_metricsManager->queryMetricsForReport(std::string(m_metricsSinkName.str()));
+            {
+                std::lock_guard<std::mutex> guard(m_renderMutex);
+                RenderCache & cache = m_renderCaches[openMetrics ? 1 : 0];
+                unsigned numRendered = renderMetrics(reportMetrics, cache, openMetrics);
+                res.set_content(cache.payload, openMetrics ? OPENMETRICS_RESP_TYPE : PROMETHEUS_METRICS_SERVICE_RESP_TYPE);
+                m_scrapeRenderedMetric->set(numRendered);
+            }
+            m_scrapeTimeMetric->recordMeasurement(get_cycles_now() - startCycles);
             res.status = 200;
-            LOG(MCdebugInfo, "PrometheusMetricsService Response: %s\n", payload.str());
+            LOG(MCdebugInfo, "PrometheusMetricsService Response: %s\n", res.body.c_str());
             LOG(MCuserInfo, "TxSummary[status=%d;user=@%s:%d;contLen=%ld;req=GET;path=%s]", res.status, req.remote_addr.c_str(), req.remote_port, req.content_length, req.path.c_str());
         });
     }
@@ -101,7 +109,16 @@ const char * PrometheusMetricSink::mapHPCCMetricTypeToPrometheusStr(MetricType t
     }
 }
 
-void PrometheusMetricSink::toPrometheusMetrics(const std::vector<std::shared_ptr<IMetric>> & reportMetrics, StringBuffer & out, bool verbose)
+void PrometheusMetricSink::registerScrapeMetrics()
+{
+    static const std::vector<__uint64> scrapeBuckets = {
+        100000, 200000, 500000, 1000000, 2000000, 5000000, 10000000, 20000000, 50000000, 100000000, 200000000, 500000000, 1000000000 };
+    MetricMetaData metaData{{"sink", m_metricsSinkName.str()}};
+    m_scrapeTimeMetric = registerCyclesToNsScaledHistogramMetric("prometheus.scrape.time", "Time taken to collect and render the metrics for a scrape", scrapeBuckets, metaData);
+    m_scrapeRenderedMetric = registerGaugeMetric("prometheus.scrape.rendered", "Number of metrics whose text was re-rendered by the last scrape", SMeasureCount, metaData);
+}
+
+unsigned PrometheusMetricSink::renderMetrics(const std::vector<std::shared_ptr<IMetric>> & reportMetrics, RenderCache & cache, bool openMetrics)
 {
     /*
      * [# HELP <metric name> <metric summary>\n]
@@ -110,61 +127,137 @@ void PrometheusMetricSink::toPrometheusMetrics(const std::vector<std::shared_ptr
      *
      * where metric name := [a-zA-Z_:][a-zA-Z0-9_:]*
      */
-
+    unsigned generation = ++cache.generation;
+    unsigned numRendered = 0;
+    size_t prevLength = cache.payload.length();
+    cache.payload.clear();
+    cache.payload.reserve(prevLength);
     for (auto &pMetric: reportMetrics)
     {
-        std::string metricName = getPrometheusMetricName(pMetric);
+        RenderedMetric & rendered = cache.metrics[pMetric.get()];
+        if (rendered.metric.expired())
+        {
+            rendered = RenderedMetric();
+            rendered.metric = pMetric;
+            initRenderedMetric(rendered, pMetric, m_verbose, openMetrics);
+        }
+        rendered.generation = generation;
+        if (renderMetric(rendered, pMetric, openMetrics))
+            numRendered++;
+        cache.payload.append(rendered.header).append(rendered.text);
+    }
+    if (openMetrics)
+        cache.payload.append("# EOF\n");
+
+    // Forget any metrics that have been deleted since the previous scrape
+    for (auto it = cache.metrics.begin(); it != cache.metrics.end(); )
+    {
+        if (it->second.generation != generation)
+            it = cache.metrics.erase(it);
+        else
+            ++it;
+    }
+    return numRendered;
+}
 
-        MetricType metricType = pMetric->queryMetricType();
+void PrometheusMetricSink::initRenderedMetric(RenderedMetric & rendered, const std::shared_ptr<IMetric> & pMetric, bool verbose, bool openMetrics)
+{
+    std::string metricName = getPrometheusMetricName(pMetric);
+    MetricType metricType = pMetric->queryMetricType();
 
-        if (verbose)
-        {
-            const char * prometheusMetricType = mapHPCCMetricTypeToPrometheusStr(metricType);
-            if (!pMetric->queryDescription().empty())
-                out.append("# HELP ").append(metricName.c_str()).append(" ").append(pMetric->queryDescription().c_str()).append("\n");
+    if (verbose)
+    {
+        // OpenMetrics names a counter's family without the _total suffix of its samples
+        std::string familyName = metricName;
+        if (openMetrics && (metricType == hpccMetrics::METRICS_COUNTER) && (familyName.length() > 6) && (familyName.compare(familyName.length() - 6, 6, "_total") == 0))
+            familyName.erase(familyName.length() - 6);
 
-            if (prometheusMetricType)
-                out.append("# TYPE ").append(metricName.c_str()).append(" ").append(prometheusMetricType).append("\n");
-        }
+        const char * prometheusMetricType = mapHPCCMetricTypeToPrometheusStr(metricType);
+        if (!pMetric->queryDescription().empty())
+            rendered.header.append("# HELP ").append(familyName).append(" ").append(pMetric->queryDescription()).append("\n");
+
+        if (prometheusMetricType)
+            rendered.header.append("# TYPE ").append(familyName).append(" ").append(prometheusMetricType).append("\n");
+    }
 
-        if (metricType == hpccMetrics::METRICS_HISTOGRAM)
+    if (metricType == hpccMetrics::METRICS_HISTOGRAM)
+        getHistogramLabels(rendered.labels, metricName, pMetric);
+    else
+    {
+        rendered.sampleName = metricName;
+        std::string labels = getPrometheusLabels(pMetric, nullptr);
+        if (!labels.empty())
         {
-            toPrometheusHistogram(metricName, pMetric, out);
+            if (!openMetrics)
+                rendered.sampleName.append(" ");
+            rendered.sampleName.append(labels);
         }
-        else
+    }
+}
+
+bool PrometheusMetricSink::renderMetric(RenderedMetric & rendered, const std::shared_ptr<IMetric> & pMetric, bool openMetrics)
+{
+    if (pMetric->queryMetricType() == hpccMetrics::METRICS_HISTOGRAM)
+    {
+        std::vector<__uint64> bucketCounts = pMetric->queryHistogramValues();
+        __uint64 sum = pMetric->queryValue();
+        std::vector<MetricExemplar> exemplars;
+        __uint64 exemplarStamp = 0;
+        if (openMetrics)
         {
-            out.append(metricName.c_str());
-            const auto &metaData = pMetric->queryMetaData();
-            if (!metaData.empty())
-            {
-                out.append(" {");
-                bool firstEntry = true;
-                for (auto &metaDataIt: metaData)
-                {
-                    if (!firstEntry)
-                        out.append(",");
-                    else
-                        firstEntry = false;
-
-                    out.append(metaDataIt.key.c_str()).append("=\"").append(metaDataIt.value.c_str()).append("\"");
-                }
-                out.append("}");
-            }
-            out.append(" ").append(pMetric->queryValue()).append("\n");
+            exemplars = pMetric->queryHistogramExemplars();
+            for (auto const &exemplar: exemplars)
+                exemplarStamp += exemplar.timestampMs;
         }
+        if (rendered.rendered && (sum == rendered.lastValue) && (exemplarStamp == rendered.lastExemplarStamp) && (bucketCounts == rendered.lastBuckets))
+            return false;
+
+        toPrometheusHistogram(rendered, bucketCounts, sum, openMetrics ? &exemplars : nullptr, pMetric->queryUnits());
+        rendered.lastValue = sum;
+        rendered.lastExemplarStamp = exemplarStamp;
+        rendered.lastBuckets.swap(bucketCounts);
+    }
+    else
+    {
+        __uint64 value = pMetric->queryValue();
+        if (rendered.rendered && (value == rendered.lastValue))
+            return false;
+
+        rendered.text.assign(rendered.sampleName).append(" ").append(std::to_string(value)).append("\n");
+        rendered.lastValue = value;
     }
+    rendered.rendered = true;
+    return true;
 }
 
-void PrometheusMetricSink::toPrometheusHistogram(const std::string &name, const std::shared_ptr<IMetric> &pHistogram, StringBuffer & out)
+static void appendExemplar(std::string & out, const MetricExemplar & exemplar, StatisticMeasure units)
 {
-    auto labels = getHistogramLabels(name, pHistogram);
-    auto bucketCounts = pHistogram->queryHistogramValues();
+    if (exemplar.traceId.empty())
+        return;
+    out.append(" # {trace_id=\"").append(exemplar.traceId).append("\"} ");
+    if (units == SMeasureTimeNs)
+        out.append(std::to_string((double)exemplar.value / 1000000000.0));
+    else
+        out.append(std::to_string(exemplar.value));
+    VStringBuffer timestamp(" %llu.%03u", (unsigned long long)(exemplar.timestampMs / 1000), (unsigned)(exemplar.timestampMs % 1000));
+    out.append(timestamp.str());
+}
+
+void PrometheusMetricSink::toPrometheusHistogram(RenderedMetric & rendered, const std::vector<__uint64> & bucketCounts, __uint64 sum, const std::vector<MetricExemplar> * exemplars, StatisticMeasure units)
+{
+    const std::vector<std::string> & labels = rendered.labels;
+    std::string & out = rendered.text;
+    out.clear();
     unsigned bucketLabelIndex = 0;
     __uint64 cumulativeBucketCount = 0;
     for (auto const &bucketCount: bucketCounts)
     {
         cumulativeBucketCount += bucketCount;
-        out.append(labels[bucketLabelIndex++].c_str()).append(" ").append(cumulativeBucketCount).append("\n");
+        out.append(labels[bucketLabelIndex]).append(" ").append(std::to_string(cumulativeBucketCount));
+        if (exemplars && (bucketLabelIndex < exemplars->size()))
+            appendExemplar(out, (*exemplars)[bucketLabelIndex], units);
+        out.append("\n");
+        bucketLabelIndex++;
     }
 
     // Indices for the histogram value and cumulative count labels (stored sequentially after the
@@ -172,8 +265,8 @@ void PrometheusMetricSink::toPrometheusHistogram(const std::string &name, const
     unsigned valueLabelIndex = bucketCounts.size();
     unsigned cumulativeCountLabelIndex = valueLabelIndex + 1;
 
-    out.append(labels[valueLabelIndex].c_str()).append(" ").append(pHistogram->queryValue()).append("\n");
-    out.append(labels[cumulativeCountLabelIndex].c_str()).append(" ").append(cumulativeBucketCount).append("\n");
+    out.append(labels[valueLabelIndex]).append(" ").append(std::to_string(sum)).append("\n");
+    out.append(labels[cumulativeCountLabelIndex]).append(" ").append(std::to_string(cumulativeBucketCount)).append("\n");
 }
 
 
@@ -211,54 +304,66 @@ std::string PrometheusMetricSink::getPrometheusMetricUnits(const std::shared_ptr
     return unitsStr;
 }
 
-// return a vector of label strings matching the exposition format for a histogram as defined by the Prometheus spec.
-// See https://prometheus.io/docs/instrumenting/exposition_formats/ for more information
-const std::vector<std::string> &PrometheusMetricSink::getHistogramLabels(const std::string &name, const std::shared_ptr<IMetric> &pHistogram)
+// Returns the metric's meta data formatted as a label set, followed by the extra label if one is supplied
+std::string PrometheusMetricSink::getPrometheusLabels(const std::shared_ptr<IMetric> &pMetric, const char * extraLabel)
 {
-    auto it = histogramLabels.find(name);
-    if (it != histogramLabels.end())
+    const auto &metaData = pMetric->queryMetaData();
+    if (metaData.empty() && !extraLabel)
+        return std::string();
+
+    std::string labels("{");
+    bool firstEntry = true;
+    for (auto &metaDataIt: metaData)
     {
-        return it->second;
+        if (!firstEntry)
+            labels.append(",");
+        else
+            firstEntry = false;
+
+        labels.append(metaDataIt.key).append("=\"").append(metaDataIt.value).append("\"");
     }
+    if (extraLabel)
+    {
+        if (!firstEntry)
+            labels.append(",");
+        labels.append(extraLabel);
+    }
+    labels.append("}");
+    return labels;
+}
 
+// Build the label strings matching the exposition format for a histogram as defined by the Prometheus spec.
+// See https://prometheus.io/docs/instrumenting/exposition_formats/ for more information
+void PrometheusMetricSink::getHistogramLabels(std::vector<std::string> & labels, const std::string &name, const std::shared_ptr<IMetric> &pHistogram)
+{
     StatisticMeasure units = pHistogram->queryUnits();
-    std::vector<std::string> labels;
     std::vector<__uint64> bucketLimits = pHistogram->queryHistogramBucketLimits();
 
     for (const auto &limit: bucketLimits)
     {
-        std::string label(name);
-        label.append("_bucket{le=\"");
+        std::string le("le=\"");
         if (units == SMeasureTimeNs)
         {
             double secs = (double)limit / 1000000000.0;
-            label.append(std::to_string(secs)).append("\"}");
+            le.append(std::to_string(secs)).append("\"");
         }
         else
         {
-            label.append(std::to_string(limit)).append("\"}");
+            le.append(std::to_string(limit)).append("\"");
         }
-        labels.emplace_back(label);
+        labels.emplace_back(name + "_bucket" + getPrometheusLabels(pHistogram, le.c_str()));
     }
 
     // Add the inf label
-    std::string infLabel(name);
-    infLabel.append("_bucket{le=\"+Inf\"}");
-    labels.emplace_back(infLabel);
+    labels.emplace_back(name + "_bucket" + getPrometheusLabels(pHistogram, "le=\"+Inf\""));
 
     // Sum and count
-    std::string sumLabel(name);
-    sumLabel.append("_sum{}");
-    labels.emplace_back(sumLabel);
-
-    std::string countLabel(name);
-    countLabel.append("_count{}");
-    labels.emplace_back(countLabel);
-
-    // Insert the labels for reuse
-    auto insertRet = histogramLabels.insert({name, labels});
-    return insertRet.first->second;
-};
+    std::string metaLabels = getPrometheusLabels(pHistogram, nullptr);
+    if (metaLabels.empty())
+        metaLabels.assign("{}");
+    labels.emplace_back(name + "_sum" + metaLabels);
+    labels.emplace_back(name + "_count" + metaLabels);
+}
 
 void PrometheusMetricSink::startCollection(MetricsManager *_pManager)
 {
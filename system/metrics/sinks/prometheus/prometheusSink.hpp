@@ -23,6 +23,8 @@
 #include "jstring.hpp"
 #include <thread>
 #include <map>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 //including cpp-httplib single header file REST client
@@ -68,11 +70,13 @@ private:
     int                             m_port;
     StringBuffer                    m_metricsServiceName;
     bool                            m_verbose;
+    std::once_flag                  m_scrapeMetricsRegistered;
 
     static constexpr const char * BIND_ALL_LOCAL_NICS = "0.0.0.0";
     static constexpr const char * PROMETHEUS_REPORTER_TYPE = "prometheus";
     static constexpr const char * PROMETHEUS_METRICS_HTTP_PAGE_TITLE = "HPCC Systems - Prometheus Metrics Service";
     static constexpr const char * PROMETHEUS_METRICS_SERVICE_RESP_TYPE = "text/html; charset=UTF-8";
+    static constexpr const char * OPENMETRICS_RESP_TYPE = "application/openmetrics-text; version=1.0.0; charset=utf-8";
     static constexpr int          DEFAULT_PROMETHEUS_METRICS_SERVICE_PORT = 8767;
     static constexpr const char * DEFAULT_PROMETHEUS_METRICS_SERVICE_NAME = "/metrics";
     static constexpr const char * HTTPLIB_ERROR_MESSAGE_HEADER_NAME = "EXCEPTION_WHAT";
@@ -88,24 +92,57 @@ private:
 )!!";
 
 protected:
+    // The text for each metric is kept between scrapes, and is only rendered again if the metric's value has changed.
+    // The names, help text and labels are only built the first time a metric is seen.
+    struct RenderedMetric
+    {
+        std::weak_ptr<IMetric> metric;      // Detects a new metric that has been allocated at the address of a deleted one
+        std::string header;                 // # HELP and # TYPE lines
+        std::string sampleName;             // name and labels of a counter or gauge
+        std::vector<std::string> labels;    // bucket, sum and count labels of a histogram
+        std::string text;
+        __uint64 lastValue = 0;
+        std::vector<__uint64> lastBuckets;
+        __uint64 lastExemplarStamp = 0;
+        bool rendered = false;
+        unsigned generation = 0;
+    };
+
+    // Rendering state for one exposition format
+    struct RenderCache
+    {
+        std::unordered_map<const IMetric *, RenderedMetric> metrics;
+        std::string payload;                // reused between scrapes, so it does not need to grow each time
+        unsigned generation = 0;
+    };
+
     static void collectionThread(PrometheusMetricSink * prometheussink)
     {
         prometheussink->startServer();
     }
 
     Server m_server;
+    std::mutex m_renderMutex;
+    RenderCache m_renderCaches[2];          // indexed by whether OpenMetrics (with exemplars) is being returned
+    std::shared_ptr<ScaledHistogramMetric> m_scrapeTimeMetric;
+    std::shared_ptr<GaugeMetric> m_scrapeRenderedMetric;
 
     virtual void startCollection(MetricsManager * pReporter) override;
     virtual void stopCollection() override;
 
+    void registerScrapeMetrics();
+    unsigned renderMetrics(const std::vector<std::shared_ptr<IMetric>> & reportMetrics, RenderCache & cache, bool openMetrics);
+
     static const char * mapHPCCMetricTypeToPrometheusStr(MetricType type);
-    static void toPrometheusMetrics(const std::vector<std::shared_ptr<IMetric>> &, StringBuffer & out, bool verbose);
+    static void initRenderedMetric(RenderedMetric & rendered, const std::shared_ptr<IMetric> & pMetric, bool verbose, bool openMetrics);
+    static bool renderMetric(RenderedMetric & rendered, const std::shared_ptr<IMetric> & pMetric, bool openMetrics);
 
     static std::string getPrometheusMetricName(const std::shared_ptr<IMetric> &pMetric);
     static std::string getPrometheusMetricUnits(const std::shared_ptr<IMetric> &pMetric);
+    static std::string getPrometheusLabels(const std::shared_ptr<IMetric> &pMetric, const char * extraLabel);
 
-    static void toPrometheusHistogram(const std::string &name, const std::shared_ptr<IMetric> &, StringBuffer & out);
-    static const std::vector<std::string> &getHistogramLabels(const std::string &name, const std::shared_ptr<IMetric> &pHistogram);
+    static void toPrometheusHistogram(RenderedMetric & rendered, const std::vector<__uint64> & bucketCounts, __uint64 sum, const std::vector<MetricExemplar> * exemplars, StatisticMeasure units);
+    static void getHistogramLabels(std::vector<std::string> & labels, const std::string &name, const std::shared_ptr<IMetric> &pHistogram);
 };
 
 extern "C" MetricSink* getSinkInstance(const char *name, const IPropertyTree *pSettingsTree);
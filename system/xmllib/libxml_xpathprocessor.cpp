@@ -39,10 +39,13 @@
 #include "xpathprocessor.hpp"
 #include "xmlerror.hpp"
 
+#include <atomic>
 #include <map>
 #include <stack>
 #include <string>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 static inline char *skipWS(char *s)
 {
@@ -130,6 +133,113 @@ public:
 };
 static xmlXPathObjectPtr variableLookupFunc(void *data, const xmlChar *name, const xmlChar *ns_uri);
 
+//Xpaths that are evaluated as strings rather than precompiled by the caller are compiled once and then shared.
+//Strings built from substituted variable values can be unique to a request, so the number cached is limited.
+//Once the cache is full, entries that have not been used since the clock hand last passed them are replaced, so
+//one-off xpaths do not prevent xpaths that are first seen later from being cached.
+static constexpr unsigned maxCachedXpaths = 4096;
+
+class CCompiledXpathCache
+{
+    struct CacheEntry
+    {
+        CacheEntry(const std::string & _xpath, CLibCompiledXpath * _compiled) : xpath(_xpath), compiled(_compiled) {}
+
+        std::string xpath;
+        Owned<CLibCompiledXpath> compiled;
+        std::atomic<bool> referenced{false};   // set when used, cleared as the clock hand passes
+    };
+
+public:
+    CCompiledXpathCache(unsigned _maxEntries) : maxEntries(_maxEntries)
+    {
+        assertex(maxEntries);
+    }
+
+    CLibCompiledXpath * getCompiled(const char * xpath)
+    {
+        std::string key(xpath);
+        {
+            ReadLockBlock rblock(lock);
+            auto match = cache.find(key);
+            if (match != cache.end())
+            {
+                CacheEntry & entry = *entries[match->second];
+                entry.referenced.store(true, std::memory_order_relaxed);
+                return LINK(entry.compiled.get());
+            }
+        }
+        Owned<CLibCompiledXpath> compiled = new CLibCompiledXpath(xpath);
+        if (compiled->getCompiledXPathExpression()) //invalid xpaths are not cached, so the error is reported each time
+        {
+            WriteLockBlock wblock(lock);
+            if (cache.find(key) == cache.end()) //if another thread added it first, that copy is kept
+            {
+                unsigned slot;
+                if (entries.size() < maxEntries)
+                {
+                    slot = (unsigned)entries.size();
+                    entries.emplace_back();
+                }
+                else
+                {
+                    slot = nextVictim();
+                    cache.erase(entries[slot]->xpath);
+                }
+                entries[slot].reset(new CacheEntry(key, compiled.getLink()));
+                cache.emplace(key, slot);
+            }
+        }
+        return compiled.getClear();
+    }
+
+    unsigned numCached() const
+    {
+        ReadLockBlock rblock(lock);
+        return (unsigned)cache.size();
+    }
+
+private:
+    unsigned nextVictim()
+    {
+        //Only called with the write lock held.  Terminates within two passes since each visited entry is cleared.
+        for (;;)
+        {
+            unsigned slot = hand;
+            hand = (hand + 1) % entries.size();
+            if (!entries[slot]->referenced.exchange(false, std::memory_order_relaxed))
+                return slot;
+        }
+    }
+
+private:
+    std::unordered_map<std::string, unsigned> cache;    // xpath -> index in entries
+    std::vector<std::unique_ptr<CacheEntry>> entries;
+    unsigned maxEntries;
+    unsigned hand = 0;
+    mutable ReadWriteLock lock;
+};
+
+static CCompiledXpathCache compiledXpathCache(maxCachedXpaths);
+
+static xmlXPathObjectPtr evaluateCachedXpath(const char * xpath, xmlXPathContextPtr ctx)
+{
+    if (isEmptyString(xpath))
+        return nullptr;
+    Owned<CLibCompiledXpath> compiled = compiledXpathCache.getCompiled(xpath);
+    xmlXPathCompExprPtr expr = compiled->getCompiledXPathExpression();
+    if (!expr)
+        return nullptr;
+    return xmlXPathCompiledEval(expr, ctx);
+}
+
+static xmlXPathObjectPtr evaluateCachedXpath(xmlNodePtr node, const char * xpath, xmlXPathContextPtr ctx)
+{
+    if (xmlXPathSetContextNode(node, ctx) != 0)
+        return nullptr;
+    return evaluateCachedXpath(xpath, ctx);
+}
+
 typedef std::map<std::string, xmlXPathObjectPtr> XPathObjectMap;
 
 
@@ -676,7 +786,7 @@ public:
             if (*finger=='@')
                 throw MakeStringException(XPATHERR_InvalidState,"XpathContext:ensureLocation: attribute cannot be selected '%s'", xpath);
 
-            xmlXPathObjectPtr obj = xmlXPathNodeEval(node, (const xmlChar*) finger, m_xpathContext);
+            xmlXPathObjectPtr obj = evaluateCachedXpath(node, finger, m_xpathContext);
             xmlXPathSetContextNode(current, m_xpathContext); //restore
 
             if (!obj)
@@ -772,7 +882,7 @@ public:
                 xmlSetProp(node, (const xmlChar *) finger+1, (const xmlChar *) value);
                 return;
             }
-            xmlXPathObjectPtr obj = xmlXPathNodeEval(node, (const xmlChar*) finger, m_xpathContext);
+            xmlXPathObjectPtr obj = evaluateCachedXpath(node, finger, m_xpathContext);
             xmlXPathSetContextNode(current, m_xpathContext);
 
             if (!obj)
@@ -885,7 +995,7 @@ public:
     {
         if (isEmptyString(xpath) || isEmptyString(name))
             return;
-        xmlXPathObjectPtr obj = xmlXPathEval((const xmlChar*) xpath, m_xpathContext);
+        xmlXPathObjectPtr obj = evaluateCachedXpath(xpath, m_xpathContext);
         if (!obj)
             return;
         if (obj->type!=xmlXPathObjectType::XPATH_NODESET || obj->nodesetval->nodeNr==0)
@@ -908,7 +1018,7 @@ public:
     {
         if (isEmptyString(xpath))
             return;
-        xmlXPathObjectPtr obj = xmlXPathEval((const xmlChar*) xpath, m_xpathContext);
+        xmlXPathObjectPtr obj = evaluateCachedXpath(xpath, m_xpathContext);
         if (!obj)
             return;
         if (obj->type!=xmlXPathObjectType::XPATH_NODESET || !obj->nodesetval || obj->nodesetval->nodeNr==0)
@@ -1462,7 +1572,7 @@ private:
         if (!m_xpathContext)
             throw MakeStringException(XPATHERR_InvalidState,"XpathProcessor:evaluate: Error: Could not evaluate XPATH '%s'; ensure xmldoc has been set", xpath);
         ReadLockBlock rlock(m_rwlock);
-        return xmlXPathEval((const xmlChar *)xpath, m_xpathContext);
+        return evaluateCachedXpath(xpath, m_xpathContext);
     }
 };
 
@@ -1687,7 +1797,7 @@ private:
         if (!isEmptyString(xpath))
             fullXpath.append('/').append(xpath);
         xmlNodePtr sect = nullptr;
-        xmlXPathObjectPtr eval = xmlXPathEval((const xmlChar *) fullXpath.str(), xpathCtx);
+        xmlXPathObjectPtr eval = evaluateCachedXpath(fullXpath.str(), xpathCtx);
         if (eval && XPATH_NODESET == eval->type && eval->nodesetval && eval->nodesetval->nodeNr && eval->nodesetval->nodeTab!=nullptr)
             sect = eval->nodesetval->nodeTab[0];
         xmlXPathFreeObject(eval);
@@ -1696,7 +1806,7 @@ private:
 
     void addXpathCtxConfigInputs(IXpathContext *tgtXpathCtx)
     {
-        xmlXPathObjectPtr eval = xmlXPathEval((const xmlChar *) "config/*/Transform/Param", xpathCtx);
+        xmlXPathObjectPtr eval = evaluateCachedXpath("config/*/Transform/Param", xpathCtx);
         if (!eval)
             return;
         if (XPATH_NODESET==eval->type && eval->nodesetval!=nullptr && eval->nodesetval->nodeNr!=0 && eval->nodesetval->nodeTab!=nullptr)
@@ -1717,7 +1827,7 @@ private:
     }
     const char *getXPathString(const char *xpath, StringBuffer &s) const override
     {
-        xmlXPathObjectPtr eval = xmlXPathEval((const xmlChar *) xpath, xpathCtx);
+        xmlXPathObjectPtr eval = evaluateCachedXpath(xpath, xpathCtx);
         if (eval)
         {
             xmlChar *v = xmlXPathCastToString(eval);
@@ -1735,7 +1845,7 @@ private:
     __int64 getXPathInt64(const char *xpath, __int64 dft=0) const override
     {
         __int64 ret = dft;
-        xmlXPathObjectPtr eval = xmlXPathEval((const xmlChar *) xpath, xpathCtx);
+        xmlXPathObjectPtr eval = evaluateCachedXpath(xpath, xpathCtx);
         if (eval)
         {
             xmlChar *val = xmlXPathCastToString(eval);
@@ -1752,7 +1862,7 @@ private:
     bool getXPathBool(const char *xpath, bool dft=false) const override
     {
         bool ret = dft;
-        xmlXPathObjectPtr eval = xmlXPathEval((const xmlChar *) xpath, xpathCtx);
+        xmlXPathObjectPtr eval = evaluateCachedXpath(xpath, xpathCtx);
         if (eval)
         {
             xmlChar *val = xmlXPathCastToString(eval);
@@ -1811,7 +1921,7 @@ private:
     void removeSection(const char *name)
     {
         sanityCheckSectionName(name);
-        xmlXPathObjectPtr eval = xmlXPathEval((const xmlChar *) name, xpathCtx);
+        xmlXPathObjectPtr eval = evaluateCachedXpath(name, xpathCtx);
         if (!eval)
             return;
         //should be just one node, but if there are more, clean them up anyway
@@ -2038,6 +2148,7 @@ class LibXml2XPathProcessorTests : public CppUnit::TestFixture
 {
     CPPUNIT_TEST_SUITE( LibXml2XPathProcessorTests );
         CPPUNIT_TEST(testWriteUTF8);
+        CPPUNIT_TEST(testCompiledXpathCache);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -2051,6 +2162,42 @@ public:
         CPPUNIT_ASSERT(!failed);
     }
 
+    void testCompiledXpathCache()
+    {
+        CCompiledXpathCache cache(4);
+
+        //Repeated lookups return the same compiled expression
+        Owned<CLibCompiledXpath> hot = cache.getCompiled("a/b[@c='d']");
+        CPPUNIT_ASSERT(hot->getCompiledXPathExpression());
+        Owned<CLibCompiledXpath> hot2 = cache.getCompiled("a/b[@c='d']");
+        CPPUNIT_ASSERT_EQUAL((void *)hot.get(), (void *)hot2.get());
+        CPPUNIT_ASSERT_EQUAL(1U, cache.numCached());
+
+        //Invalid xpaths are not cached
+        Owned<CLibCompiledXpath> invalid = cache.getCompiled("a/b[");
+        CPPUNIT_ASSERT(!invalid->getCompiledXPathExpression());
+        Owned<CLibCompiledXpath> invalid2 = cache.getCompiled("a/b[");
+        CPPUNIT_ASSERT(invalid.get() != invalid2.get());
+        CPPUNIT_ASSERT_EQUAL(1U, cache.numCached());
+
+        //A stream of one-off xpaths replaces the entries that are not being used, but not the hot entry
+        for (unsigned i=0; i < 20; i++)
+        {
+            VStringBuffer xpath("x/y[%u]", i);
+            Owned<CLibCompiledXpath> oneOff = cache.getCompiled(xpath);
+            CPPUNIT_ASSERT(oneOff->getCompiledXPathExpression());
+            Owned<CLibCompiledXpath> match = cache.getCompiled("a/b[@c='d']");
+            CPPUNIT_ASSERT_EQUAL((void *)hot.get(), (void *)match.get());
+        }
+        CPPUNIT_ASSERT_EQUAL(4U, cache.numCached());
+
+        //An xpath first seen once the cache is full is still cached
+        Owned<CLibCompiledXpath> late = cache.getCompiled("late/path");
+        Owned<CLibCompiledXpath> late2 = cache.getCompiled("late/path");
+        CPPUNIT_ASSERT_EQUAL((void *)late.get(), (void *)late2.get());
+        CPPUNIT_ASSERT_EQUAL(4U, cache.numCached());
+    }
+
 private:
     ISectionalXmlDocModel* createScriptContext(const char* section, const char* content)
     {
@@ -31,6 +31,7 @@
 #include "dasds.hpp"
 #include "danqs.hpp"
 #include "dautils.hpp"
+#include "sautil.hpp"
 
 #include <vector>
 #include <future>
@@ -3034,4 +3035,77 @@ public:
 CPPUNIT_TEST_SUITE_REGISTRATION( CFileNameNormalizeUnitTest );
 CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( CFileNameNormalizeUnitTest, "CFileNameNormalizeUnitTest" );
 
+// Tests the batching of archived DFU workunit removals by sasha - does not need dali
+class CSashaPendingDeletesTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(CSashaPendingDeletesTest);
+        CPPUNIT_TEST(testRestoreBeforeDelete);
+        CPPUNIT_TEST(testDeleteThenRestore);
+        CPPUNIT_TEST(testFailedDelete);
+        CPPUNIT_TEST(testRestoreDuringDelete);
+    CPPUNIT_TEST_SUITE_END();
+
+    void testRestoreBeforeDelete()
+    {
+        CPendingWorkUnitDeletes pending;
+        CPPUNIT_ASSERT_EQUAL(1U, pending.add("D1"));
+        CPPUNIT_ASSERT_EQUAL(2U, pending.add("D2"));
+        CPPUNIT_ASSERT_EQUAL(3U, pending.add("D3"));
+        // A restored workunit is still in dali, and must not be removed with the rest of the batch
+        CPPUNIT_ASSERT(pending.cancel("D2"));
+        CPPUNIT_ASSERT(!pending.cancel("D2"));
+        std::vector<std::string> removed;
+        unsigned num = pending.flush([&](const std::vector<std::string> &wuids) { removed = wuids; return true; });
+        CPPUNIT_ASSERT_EQUAL(2U, num);
+        CPPUNIT_ASSERT_EQUAL(2U, (unsigned)removed.size());
+        CPPUNIT_ASSERT_EQUAL(std::string("D1"), removed[0]);
+        CPPUNIT_ASSERT_EQUAL(std::string("D3"), removed[1]);
+    }
+
+    void testDeleteThenRestore()
+    {
+        CPendingWorkUnitDeletes pending;
+        pending.add("D1");
+        CPPUNIT_ASSERT_EQUAL(1U, pending.flush([](const std::vector<std::string> &) { return true; }));
+        // Once removed from dali the workunit must be restored from the archive
+        CPPUNIT_ASSERT(!pending.cancel("D1"));
+        unsigned calls = 0;
+        CPPUNIT_ASSERT_EQUAL(0U, pending.flush([&](const std::vector<std::string> &) { calls++; return true; }));
+        CPPUNIT_ASSERT_EQUAL(0U, calls);
+    }
+
+    void testFailedDelete()
+    {
+        CPendingWorkUnitDeletes pending;
+        pending.add("D1");
+        pending.add("D2");
+        CPPUNIT_ASSERT_EQUAL(0U, pending.flush([](const std::vector<std::string> &) { return false; }));
+        // The batch is retried by the next flush, and can still be restored until then
+        CPPUNIT_ASSERT_EQUAL(3U, pending.add("D3"));
+        CPPUNIT_ASSERT(pending.cancel("D1"));
+        CPPUNIT_ASSERT_EQUAL(2U, pending.flush([](const std::vector<std::string> &) { return true; }));
+    }
+
+    void testRestoreDuringDelete()
+    {
+        CPendingWorkUnitDeletes pending;
+        pending.add("D1");
+        Semaphore started, finish;
+        std::future<unsigned> flushed = std::async(std::launch::async, [&]()
+        {
+            return pending.flush([&](const std::vector<std::string> &) { started.signal(); finish.wait(); return true; });
+        });
+        started.wait();
+        // A restore that starts while the batch is being removed waits for the removal, and then finds it has gone
+        std::future<bool> cancelled = std::async(std::launch::async, [&]() { return pending.cancel("D1"); });
+        CPPUNIT_ASSERT(cancelled.wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout);
+        finish.signal();
+        CPPUNIT_ASSERT_EQUAL(1U, flushed.get());
+        CPPUNIT_ASSERT(!cancelled.get());
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CSashaPendingDeletesTest );
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( CSashaPendingDeletesTest, "CSashaPendingDeletesTest" );
+
 #endif // _USE_CPPUNIT
@@ -24,6 +24,8 @@
 #include "txsummary.hpp"
 #include "SecureUser.hpp"
 #include "datamaskingengine.hpp"
+#include "esdl_def.hpp"
+#include "esdl_transformer.hpp"
 
 #include <stdio.h>
 #include "dllserver.hpp"
@@ -3378,4 +3380,104 @@ inline void ESDLTests::CMockTraceMsgSink::valog(const LogMsgCategory& category,
 CPPUNIT_TEST_SUITE_REGISTRATION( ESDLTests );
 CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( ESDLTests, "ESDL" );
 
+// Times the ESDL request transform over small, medium and large requests.  The definition includes versioned,
+// optional and xml_tag fields so the version and name resolution is exercised as well as the xml parsing.
+static constexpr const char * benchEsdlDefinition = R"!!(<esxdl name="Bench">
+<EsdlStruct name="BenchAddress">
+  <EsdlElement type="string" name="Line1"/>
+  <EsdlElement type="string" name="Line2"/>
+  <EsdlElement type="string" name="City"/>
+  <EsdlElement type="string" name="State"/>
+  <EsdlElement type="string" name="Zip"/>
+  <EsdlElement type="string" name="County" min_ver="1.5"/>
+  <EsdlElement type="string" name="Country" depr_ver="2"/>
+</EsdlStruct>
+<EsdlStruct name="BenchPerson">
+  <EsdlElement type="string" name="First"/>
+  <EsdlElement type="string" name="Middle" optional="names"/>
+  <EsdlElement type="string" name="Last"/>
+  <EsdlElement type="int" name="Age"/>
+  <EsdlElement type="string" name="Phone" xml_tag="Telephone"/>
+  <EsdlElement type="string" name="Email" max_ver="3"/>
+  <EsdlElement name="Address" complex_type="BenchAddress"/>
+  <EsdlArray type="BenchAddress" name="PreviousAddresses"/>
+</EsdlStruct>
+<EsdlRequest name="BenchSearchRequest">
+  <EsdlElement type="string" name="Reference"/>
+  <EsdlElement type="int" name="MaxResults"/>
+  <EsdlArray type="BenchPerson" name="People"/>
+</EsdlRequest>
+<EsdlResponse name="BenchSearchResponse">
+  <EsdlElement type="int" name="Count"/>
+</EsdlResponse>
+<EsdlService name="BenchService" version="1" default_client_version="1">
+  <EsdlMethod name="Search" request_type="BenchSearchRequest" response_type="BenchSearchResponse"/>
+</EsdlService>
+</esxdl>)!!";
+
+class ESDLTransformTimingTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( ESDLTransformTimingTest );
+        CPPUNIT_TEST(testRequestSizes);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void appendAddress(StringBuffer &xml, const char *tag, unsigned i)
+    {
+        xml.appendf("<%s><Line1>%u Main Street</Line1><Line2>Apartment %u</Line2><City>Springfield</City><State>IL</State>"
+                    "<Zip>6270%u</Zip><County>Sangamon</County><Country>USA</Country></%s>", tag, i, i, i % 10, tag);
+    }
+
+    void buildRequest(StringBuffer &xml, unsigned numPeople)
+    {
+        xml.append("<BenchSearchRequest><Reference>bench</Reference><MaxResults>100</MaxResults><People>");
+        for (unsigned i=0; i < numPeople; i++)
+        {
+            xml.appendf("<BenchPerson><First>First%u</First><Middle>M</Middle><Last>Last%u</Last><Age>%u</Age>"
+                        "<Telephone>555-01%02u</Telephone><Email>person%u@example.com</Email>", i, i, 20 + i % 60, i % 100, i);
+            appendAddress(xml, "Address", i);
+            xml.append("<PreviousAddresses>");
+            for (unsigned j=0; j < 3; j++)
+                appendAddress(xml, "BenchAddress", i*3+j);
+            xml.append("</PreviousAddresses></BenchPerson>");
+        }
+        xml.append("</People></BenchSearchRequest>");
+    }
+
+    void testRequestSizes()
+    {
+        Owned<IEsdlDefinition> def = createNewEsdlDefinition();
+        def->addDefinitionFromXML(StringBuffer(benchEsdlDefinition), "Bench.1");
+        Owned<IEsdlTransformer> transformer = createEsdlXFormer(def);
+        transformer->precompile("BenchService", 1.0);
+
+        Owned<IEspContext> ctx = createEspContext(nullptr);
+        ctx->setClientVersion(1.0);
+
+        const unsigned sizes[] = { 1, 10, 100, 1000 };
+        for (unsigned numPeople : sizes)
+        {
+            StringBuffer request;
+            buildRequest(request, numPeople);
+            unsigned iterations = 20000 / numPeople + 10;
+
+            StringBuffer out;
+            transformer->process(*ctx, EsdlRequestMode, "BenchService", "Search", out, request.str());
+            CPPUNIT_ASSERT(strstr(out.str(), "555-01") != nullptr);        // matched by its xml_tag
+            CPPUNIT_ASSERT(strstr(out.str(), "<Country>") != nullptr);
+            CPPUNIT_ASSERT(strstr(out.str(), "<County>") == nullptr);      // not in version 1
+            CPPUNIT_ASSERT(strstr(out.str(), "<Middle>") == nullptr);      // optional group not requested
+
+            CCycleTimer timer;
+            for (unsigned i=0; i < iterations; i++)
+                transformer->process(*ctx, EsdlRequestMode, "BenchService", "Search", out.clear(), request.str());
+            unsigned __int64 elapsedNs = timer.elapsedNs();
+            DBGLOG("ESDL request transform: %u people (%u bytes) %" I64F "uns per request, %.1fMB/s", numPeople, request.length(),
+                   elapsedNs / iterations, (double)request.length() * iterations * 1000.0 / elapsedNs);
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( ESDLTransformTimingTest, "ESDLTransformTimingTest" );
+
 #endif // _USE_CPPUNIT
@@ -26,6 +26,7 @@
 #include <algorithm>
 #include "jsem.hpp"
 #include "jfile.hpp"
+#include "jcrc.hpp"
 #include "jdebug.hpp"
 #include "jset.hpp"
 #include "rmtfile.hpp"
@@ -38,6 +39,9 @@
 
 #include "opentelemetry/sdk/common/attribute_utils.h"
 #include "opentelemetry/sdk/resource/resource.h"
+#include "opentelemetry/sdk/trace/processor.h"
+#include "opentelemetry/sdk/trace/span_data.h"
+#include "jtrace.ipp"
 
 #include "unittests.hpp"
 
@@ -45,6 +49,29 @@
 
 static const unsigned oneMinute = 60000; // msec
 
+//Records the names of the spans that the tail sampler passes on
+class TailSamplingCollector final : public opentelemetry::sdk::trace::SpanProcessor
+{
+public:
+    TailSamplingCollector(std::vector<std::string> & _exported) : exported(_exported) {}
+
+    virtual std::unique_ptr<opentelemetry::sdk::trace::Recordable> MakeRecordable() noexcept override
+    {
+        return std::unique_ptr<opentelemetry::sdk::trace::Recordable>(new opentelemetry::sdk::trace::SpanData);
+    }
+    virtual void OnStart(opentelemetry::sdk::trace::Recordable & span, const opentelemetry::trace::SpanContext & parentContext) noexcept override {}
+    virtual void OnEnd(std::unique_ptr<opentelemetry::sdk::trace::Recordable> && span) noexcept override
+    {
+        auto name = static_cast<opentelemetry::sdk::trace::SpanData &>(*span).GetName();
+        exported.emplace_back(name.data(), name.size());
+    }
+    virtual bool ForceFlush(std::chrono::microseconds timeout) noexcept override { return true; }
+    virtual bool Shutdown(std::chrono::microseconds timeout) noexcept override { return true; }
+
+protected:
+    std::vector<std::string> & exported;
+};
+
 class JlibTraceTest : public CppUnit::TestFixture
 {
 public:
@@ -63,6 +90,11 @@ public:
         CPPUNIT_TEST(testNullSpan);
         CPPUNIT_TEST(testClientSpanGlobalID);
         CPPUNIT_TEST(testEnsureTraceID);
+        CPPUNIT_TEST(testTailSamplingLatency);
+        CPPUNIT_TEST(testTailSamplingErrors);
+        CPPUNIT_TEST(testTailSamplingRules);
+        CPPUNIT_TEST(testTailSamplingLateSpans);
+        CPPUNIT_TEST(testTailSamplingLimits);
 
         //CPPUNIT_TEST(testJTraceJLOGExporterprintResources);
         //CPPUNIT_TEST(testJTraceJLOGExporterprintAttributes);
@@ -190,6 +222,156 @@ protected:
     }*/
 
     //not able to programmatically test yet, but can visually inspect trace output
+    std::unique_ptr<opentelemetry::sdk::trace::SpanProcessor> createTailSampler(const IPropertyTree * config, std::vector<std::string> & exported)
+    {
+        std::vector<std::unique_ptr<opentelemetry::sdk::trace::SpanProcessor>> processors;
+        processors.push_back(std::unique_ptr<opentelemetry::sdk::trace::SpanProcessor>(new TailSamplingCollector(exported)));
+        return createTailSamplingSpanProcessor(std::move(processors), config);
+    }
+
+    //Simulate a span of trace traceNo ending.  Span 1 is the local root, all other spans are its children
+    void endTailSampledSpan(opentelemetry::sdk::trace::SpanProcessor & processor, uint8_t traceNo, uint8_t spanNo, const char * name, unsigned durationMs, bool isError = false)
+    {
+        const uint8_t traceBytes[opentelemetry::trace::TraceId::kSize] = { 0x11, traceNo };
+        const uint8_t spanBytes[opentelemetry::trace::SpanId::kSize] = { 0x22, spanNo };
+        const uint8_t rootBytes[opentelemetry::trace::SpanId::kSize] = { 0x22, 1 };
+        opentelemetry::trace::TraceId traceId(traceBytes);
+        opentelemetry::trace::TraceFlags flags(opentelemetry::trace::TraceFlags::kIsSampled);
+        opentelemetry::trace::SpanContext spanContext(traceId, opentelemetry::trace::SpanId(spanBytes), flags, false);
+        opentelemetry::trace::SpanContext parentContext = (spanNo == 1) ? opentelemetry::trace::SpanContext::GetInvalid()
+            : opentelemetry::trace::SpanContext(traceId, opentelemetry::trace::SpanId(rootBytes), flags, false);
+
+        std::unique_ptr<opentelemetry::sdk::trace::Recordable> span = processor.MakeRecordable();
+        span->SetIdentity(spanContext, parentContext.span_id());
+        span->SetName(name);
+        processor.OnStart(*span, parentContext);
+        span->SetDuration(std::chrono::milliseconds(durationMs));
+        if (isError)
+            span->SetStatus(opentelemetry::trace::StatusCode::kError, "failed");
+        processor.OnEnd(std::move(span));
+    }
+
+    void testTailSamplingLatency()
+    {
+        Owned<IPropertyTree> config = createPTree("tailSampling");
+        config->setPropInt("@latencyThresholdMs", 100);
+        std::vector<std::string> exported;
+        auto sampler = createTailSampler(config, exported);
+
+        //Nothing is exported until the local root ends, then the whole trace is exported if any span is slow
+        endTailSampledSpan(*sampler, 1, 2, "slowChild", 150);
+        endTailSampledSpan(*sampler, 1, 3, "fastChild", 1);
+        CPPUNIT_ASSERT_EQUAL((size_t)0, exported.size());
+        endTailSampledSpan(*sampler, 1, 1, "slowRoot", 160);
+        CPPUNIT_ASSERT_EQUAL((size_t)3, exported.size());
+        CPPUNIT_ASSERT_EQUAL(std::string("slowChild"), exported[0]);
+        CPPUNIT_ASSERT_EQUAL(std::string("slowRoot"), exported[2]);
+
+        //A trace where every span is quicker than the threshold is dropped
+        exported.clear();
+        endTailSampledSpan(*sampler, 2, 2, "fastChild", 10);
+        endTailSampledSpan(*sampler, 2, 1, "fastRoot", 20);
+        CPPUNIT_ASSERT_EQUAL((size_t)0, exported.size());
+        sampler->Shutdown();
+        CPPUNIT_ASSERT_EQUAL((size_t)0, exported.size());
+    }
+
+    void testTailSamplingErrors()
+    {
+        Owned<IPropertyTree> config = createPTree("tailSampling");
+        config->setPropInt("@latencyThresholdMs", 1000);
+        std::vector<std::string> exported;
+        auto sampler = createTailSampler(config, exported);
+
+        endTailSampledSpan(*sampler, 1, 2, "failedChild", 1, true);
+        endTailSampledSpan(*sampler, 1, 1, "root", 1);
+        CPPUNIT_ASSERT_EQUAL((size_t)2, exported.size());
+
+        //Errors are not special if keepErrors is disabled
+        exported.clear();
+        config->setPropBool("@keepErrors", false);
+        auto noErrorSampler = createTailSampler(config, exported);
+        endTailSampledSpan(*noErrorSampler, 1, 2, "failedChild", 1, true);
+        endTailSampledSpan(*noErrorSampler, 1, 1, "root", 1);
+        CPPUNIT_ASSERT_EQUAL((size_t)0, exported.size());
+    }
+
+    void testTailSamplingRules()
+    {
+        Owned<IPropertyTree> config = createPTree("tailSampling");
+        config->setPropInt("@latencyThresholdMs", 1000);
+        config->addPropTree("rules")->setProp("@name", "keep*");
+        std::vector<std::string> exported;
+        auto sampler = createTailSampler(config, exported);
+
+        endTailSampledSpan(*sampler, 1, 2, "KeepMe", 1);       // rules are case insensitive
+        endTailSampledSpan(*sampler, 1, 1, "root", 1);
+        CPPUNIT_ASSERT_EQUAL((size_t)2, exported.size());
+
+        exported.clear();
+        endTailSampledSpan(*sampler, 2, 2, "discardMe", 1);
+        endTailSampledSpan(*sampler, 2, 1, "root", 1);
+        CPPUNIT_ASSERT_EQUAL((size_t)0, exported.size());
+    }
+
+    void testTailSamplingLateSpans()
+    {
+        Owned<IPropertyTree> config = createPTree("tailSampling");
+        config->setPropInt("@latencyThresholdMs", 100);
+        std::vector<std::string> exported;
+        auto sampler = createTailSampler(config, exported);
+
+        //Spans that end after the local root follow the decision already made for their trace
+        endTailSampledSpan(*sampler, 1, 1, "slowRoot", 500);
+        CPPUNIT_ASSERT_EQUAL((size_t)1, exported.size());
+        endTailSampledSpan(*sampler, 1, 2, "lateChild", 1);
+        CPPUNIT_ASSERT_EQUAL((size_t)2, exported.size());
+        CPPUNIT_ASSERT_EQUAL(std::string("lateChild"), exported[1]);
+
+        exported.clear();
+        endTailSampledSpan(*sampler, 2, 1, "fastRoot", 1);
+        endTailSampledSpan(*sampler, 2, 2, "slowLateChild", 500);
+        CPPUNIT_ASSERT_EQUAL((size_t)0, exported.size());
+    }
+
+    void testTailSamplingLimits()
+    {
+        Owned<IPropertyTree> config = createPTree("tailSampling");
+        config->setPropInt("@latencyThresholdMs", 100);
+        config->setPropInt("@maxBufferedSpans", 4);
+        std::vector<std::string> exported;
+        auto sampler = createTailSampler(config, exported);
+
+        //Trace 1 never sees its local root end, so it is decided on its buffered spans once the limit is exceeded
+        endTailSampledSpan(*sampler, 1, 2, "slowOrphan", 500);
+        endTailSampledSpan(*sampler, 1, 3, "orphan", 1);
+        //Traces that complete in the meantime must not hold up the eviction of trace 1
+        for (uint8_t trace = 2; trace < 10; trace++)
+        {
+            endTailSampledSpan(*sampler, trace, 2, "child", 1);
+            endTailSampledSpan(*sampler, trace, 1, "root", 1);
+        }
+        CPPUNIT_ASSERT_EQUAL((size_t)0, exported.size());
+        endTailSampledSpan(*sampler, 10, 2, "child", 1);
+        endTailSampledSpan(*sampler, 11, 2, "child", 1);
+        endTailSampledSpan(*sampler, 12, 2, "child", 1);
+        CPPUNIT_ASSERT_EQUAL((size_t)2, exported.size());
+        CPPUNIT_ASSERT_EQUAL(std::string("slowOrphan"), exported[0]);
+
+        //The remaining incomplete traces are discarded after maxPendingMs
+        exported.clear();
+        config->setPropInt("@maxBufferedSpans", 10000);
+        config->setPropInt("@maxPendingMs", 50);
+        auto timedSampler = createTailSampler(config, exported);
+        endTailSampledSpan(*timedSampler, 1, 2, "slowOrphan", 500);
+        endTailSampledSpan(*timedSampler, 2, 2, "fastOrphan", 1);
+        CPPUNIT_ASSERT_EQUAL((size_t)0, exported.size());
+        MilliSleep(100);
+        endTailSampledSpan(*timedSampler, 3, 1, "fastRoot", 1);
+        CPPUNIT_ASSERT_EQUAL((size_t)1, exported.size());
+        CPPUNIT_ASSERT_EQUAL(std::string("slowOrphan"), exported[0]);
+    }
+
     void manualTestsDeclaredSpanStartTime()
     {
         Owned<IProperties> emptyMockHTTPHeaders = createProperties();
@@ -3555,6 +3737,211 @@ class HashTableTests : public CppUnit::TestFixture
 CPPUNIT_TEST_SUITE_REGISTRATION( HashTableTests );
 CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( HashTableTests, "HashTableTests" );
 
+class HashFunctionTests : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( HashFunctionTests );
+        CPPUNIT_TEST(testKnownValues);
+        CPPUNIT_TEST(testAllLengths);
+    CPPUNIT_TEST_SUITE_END();
+
+    void testKnownValues()
+    {
+        //These values must never change - they are returned by Std.Str.FastHash64()
+        //The inputs and values are the test vectors for version 4 of wyhash, seeded with their index
+        const char * inputs[] = { "", "a", "abc", "message digest", "abcdefghijklmnopqrstuvwxyz",
+                                  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789",
+                                  "12345678901234567890123456789012345678901234567890123456789012345678901234567890" };
+        const unsigned __int64 expected[] = { 0x93228a4de0eec5a2ULL, 0xc5bac3db178713c4ULL, 0xa97f2f7b1d9b3314ULL, 0x786d1f1df3801df4ULL,
+                                              0xdca5a8138ad37c87ULL, 0xb9e734f117cfaf70ULL, 0x6cc5eab49a92d617ULL };
+        for (unsigned i=0; i < _elements_in(inputs); i++)
+            CPPUNIT_ASSERT_EQUAL(expected[i], hashw64(inputs[i], strlen(inputs[i]), i));
+
+        //Inputs that are an exact multiple of the 48 byte block size only use the block loop while more than 48 bytes remain
+        const char * block = "123456789012345678901234567890123456789012345678";
+        std::string twoBlocks = std::string(block) + block;
+        CPPUNIT_ASSERT_EQUAL(0x4b8f527c95882b62ULL, hashw64(block, 48, 7));
+        CPPUNIT_ASSERT_EQUAL(0x45cd61ab6427eee8ULL, hashw64(twoBlocks.c_str(), 96, 8));
+
+        unsigned __int64 hash64 = hashw64("abc", 3, 0);
+        CPPUNIT_ASSERT_EQUAL((unsigned)(hash64 ^ (hash64 >> 32)), hashw32("abc", 3, 0));
+    }
+
+    void testAllLengths()
+    {
+        //Check every length takes every byte into account, including the boundaries between the code paths
+        byte buffer[200];
+        for (unsigned i=0; i < sizeof(buffer); i++)
+            buffer[i] = (byte)(i * 7 + 3);
+        for (unsigned len=1; len <= sizeof(buffer); len++)
+        {
+            unsigned __int64 base = hashw64(buffer, len, 0);
+            CPPUNIT_ASSERT(base != hashw64(buffer, len-1, 0));
+            CPPUNIT_ASSERT(base != hashw64(buffer, len, 1));
+            for (unsigned i=0; i < len; i++)
+            {
+                buffer[i] ^= 0x10;
+                CPPUNIT_ASSERT(base != hashw64(buffer, len, 0));
+                buffer[i] ^= 0x10;
+            }
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( HashFunctionTests );
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( HashFunctionTests, "HashFunctionTests" );
+
+class HashFunctionTiming : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( HashFunctionTiming );
+        CPPUNIT_TEST(testTiming);
+    CPPUNIT_TEST_SUITE_END();
+
+    void testTiming()
+    {
+        //Compare the byte at a time hash (the same algorithm as HASH32 in ECL) with the block based hash
+        byte buffer[1024];
+        for (unsigned i=0; i < sizeof(buffer); i++)
+            buffer[i] = (byte)(i * 13 + 1);
+
+        const unsigned lengths[] = { 4, 8, 16, 32, 64, 128, 256, 1024 };
+        for (unsigned len : lengths)
+        {
+            const unsigned numIter = 100000000 / (len + 16);
+            unsigned hashc32 = 0;
+            cycle_t start = get_cycles_now();
+            for (unsigned pass=0; pass < numIter; pass++)
+                hashc32 = hashc(buffer, len, hashc32);
+            cycle_t hashcElapsed = get_cycles_now() - start;
+
+            unsigned __int64 hashw = 0;
+            start = get_cycles_now();
+            for (unsigned pass=0; pass < numIter; pass++)
+                hashw = hashw64(buffer, len, hashw);
+            cycle_t hashwElapsed = get_cycles_now() - start;
+
+            DBGLOG("Hash %4u bytes: hashc %.2fns hashw64 %.2fns (%x,%" I64F "x)", len,
+                   (double)cycle_to_nanosec(hashcElapsed) / numIter, (double)cycle_to_nanosec(hashwElapsed) / numIter, hashc32, hashw);
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( HashFunctionTiming );
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( HashFunctionTiming, "HashFunctionTiming" );
+
+class CRC32Tests : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( CRC32Tests );
+        CPPUNIT_TEST(testKnownValues);
+        CPPUNIT_TEST(testHardware);
+        CPPUNIT_TEST(testCombine);
+    CPPUNIT_TEST_SUITE_END();
+
+    void testKnownValues()
+    {
+        CRC32 crc;
+        crc.tally(9, "123456789");
+        CPPUNIT_ASSERT_EQUAL(0xcbf43926U, crc.get());
+        CPPUNIT_ASSERT_EQUAL(0U, crc32("", 0, 0));
+    }
+
+    void testHardware()
+    {
+        //Check the accelerated version matches for all alignments, and lengths either side of the block sizes
+        byte buffer[4096+16];
+        for (unsigned i=0; i < sizeof(buffer); i++)
+            buffer[i] = (byte)(i * 13 + 1);
+        for (unsigned align=0; align < 16; align++)
+        {
+            for (unsigned len=0; len <= 4096; len += (len < 300) ? 1 : 61)
+            {
+                const char * data = (const char *)buffer + align;
+                CPPUNIT_ASSERT_EQUAL(crc32Software(data, len, 0), crc32(data, len, 0));
+                CPPUNIT_ASSERT_EQUAL(crc32Software(data, len, ~0U), crc32(data, len, ~0U));
+            }
+        }
+    }
+
+    void testCombine()
+    {
+        byte buffer[10000];
+        for (unsigned i=0; i < sizeof(buffer); i++)
+            buffer[i] = (byte)(i * 7 + 3);
+
+        CRC32 whole;
+        whole.tally(sizeof(buffer), buffer);
+        const unsigned splits[] = { 0, 1, 15, 64, 4096, 9999, 10000 };
+        for (unsigned split : splits)
+        {
+            CRC32 first, second;
+            first.tally(split, buffer);
+            second.tally(sizeof(buffer) - split, buffer + split);
+            CRC32Merger merger;
+            merger.addChildCRC(split, first.get(), true);
+            merger.addChildCRC(sizeof(buffer) - split, second.get(), true);
+            CPPUNIT_ASSERT_EQUAL(whole.get(), merger.get());
+        }
+
+        //Chunks can be combined in any grouping
+        const unsigned chunkSize = 1000;
+        unsigned chunkCrcs[10];
+        for (unsigned i=0; i < 10; i++)
+        {
+            CRC32 chunk;
+            chunk.tally(chunkSize, buffer + i * chunkSize);
+            chunkCrcs[i] = chunk.get();
+        }
+        CRC32Merger left, right;
+        for (unsigned i=0; i < 5; i++)
+            left.addChildCRC(chunkSize, chunkCrcs[i], true);
+        for (unsigned i=5; i < 10; i++)
+            right.addChildCRC(chunkSize, chunkCrcs[i], true);
+        CRC32Merger merged;
+        merged.addChildCRC(5 * chunkSize, left.get(), true);
+        merged.addChildCRC(5 * chunkSize, right.get(), true);
+        CPPUNIT_ASSERT_EQUAL(whole.get(), merged.get());
+    }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CRC32Tests );
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( CRC32Tests, "CRC32Tests" );
+
+class CRC32Timing : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( CRC32Timing );
+        CPPUNIT_TEST(testTiming);
+    CPPUNIT_TEST_SUITE_END();
+
+    void testTiming()
+    {
+        MemoryBuffer buffer;
+        const unsigned size = 0x100000;
+        byte * data = (byte *)buffer.reserveTruncate(size);
+        for (unsigned i=0; i < size; i++)
+            data[i] = (byte)(i * 13 + 1);
+
+        const unsigned numIter = 100;
+        unsigned softwareCrc = 0;
+        cycle_t start = get_cycles_now();
+        for (unsigned pass=0; pass < numIter; pass++)
+            softwareCrc = crc32Software((const char *)data, size, softwareCrc);
+        cycle_t softwareElapsed = get_cycles_now() - start;
+
+        unsigned crc = 0;
+        start = get_cycles_now();
+        for (unsigned pass=0; pass < numIter; pass++)
+            crc = crc32((const char *)data, size, crc);
+        cycle_t elapsed = get_cycles_now() - start;
+
+        CPPUNIT_ASSERT_EQUAL(softwareCrc, crc);
+        DBGLOG("CRC32 of 1MB: software %.2fms crc32 %.2fms (hardware %s)", (double)cycle_to_nanosec(softwareElapsed) / numIter / 1000000,
+               (double)cycle_to_nanosec(elapsed) / numIter / 1000000, isCrc32HardwareAccelerated() ? "yes" : "no");
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CRC32Timing );
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( CRC32Timing, "CRC32Timing" );
+
 class BlockedTimingTests : public CppUnit::TestFixture
 {
     static constexpr bool trace = false;
@@ -4250,4 +4637,45 @@ public:
 CPPUNIT_TEST_SUITE_REGISTRATION( JLibStringTest );
 CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( JLibStringTest, "JLibStringTest" );
 
+
+#include "jprofiler.hpp"
+
+class JLibProfilerTest : public CppUnit::TestFixture
+{
+public:
+    CPPUNIT_TEST_SUITE(JLibProfilerTest);
+        CPPUNIT_TEST(testActivitySamples);
+    CPPUNIT_TEST_SUITE_END();
+
+    void testActivitySamples()
+    {
+#ifdef __linux__
+        CPPUNIT_ASSERT(startSamplingProfiler(1000));
+        unsigned prev = setProfilerActivity(42);
+        //The timer measures cpu time, so keep busy for long enough to guarantee some samples
+        volatile unsigned __int64 total = 0;
+        CCycleTimer timer;
+        while (timer.elapsedMs() < 200)
+        {
+            for (unsigned i=0; i < 10000; i++)
+                total += i;
+        }
+        setProfilerActivity(prev);
+        stopSamplingProfiler();
+
+        StringBuffer profile;
+        getSamplingProfile(profile, true);
+        CPPUNIT_ASSERT(strstr(profile, "activity_42;") != nullptr);
+
+        //The samples were cleared by the previous call
+        profile.clear();
+        getSamplingProfile(profile, false);
+        CPPUNIT_ASSERT(strstr(profile, "activity_42;") == nullptr);
+#endif
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( JLibProfilerTest );
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( JLibProfilerTest, "JLibProfilerTest" );
+
 #endif // _USE_CPPUNIT
@@ -22,6 +22,7 @@
 #include <algorithm>
 
 #include "jmetrics.hpp"
+#include "jtrace.hpp"
 
 using namespace hpccMetrics;
 
@@ -392,6 +393,16 @@ protected:
         sumMeasurements += 8;
         checkHistogramBucketResult(pHistogram, sumMeasurements, {0,2,1,1});
 
+        //
+        // A measurement from an untraced request is counted, but is not kept as an exemplar
+        pHistogram->recordMeasurement(8, getNullSpan());
+        sumMeasurements += 8;
+        checkHistogramBucketResult(pHistogram, sumMeasurements, {0,2,2,1});
+        std::vector<MetricExemplar> exemplars = pHistogram->queryHistogramExemplars();
+        CPPUNIT_ASSERT_EQUAL(bucketDefs.size()+1, exemplars.size());
+        for (auto const &exemplar: exemplars)
+            CPPUNIT_ASSERT(exemplar.traceId.empty());
+
         //
         // Test scaled histogram for ns.
         // Duplicate the convenience function so we don't actually add the metric to the manager
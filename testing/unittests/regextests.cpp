@@ -0,0 +1,272 @@
+/*##############################################################################
+
+    Copyright (C) 2024 HPCC Systems®.
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+############################################################################## */
+
+#if defined(_USE_CPPUNIT) && defined(_USE_BOOST_REGEX)
+#include "boost/regex.hpp" // must precede platform.h
+#include <memory>
+#include "jlib.hpp"
+#include "jdebug.hpp"
+#include "eclrtl.hpp"
+#include "eclrtl_imp.hpp"
+#include "rtlregex.hpp"
+#include "unittests.hpp"
+
+//Compile the pattern the same way as the ecl runtime
+static boost::regex createBoostRegex(const char * pattern, bool isCaseSensitive)
+{
+    if (isCaseSensitive)
+        return boost::regex(pattern, boost::regex::perl);
+    return boost::regex(pattern, boost::regex::perl | boost::regex::icase);
+}
+
+static bool dfaMatches(const char * pattern, const char * search)
+{
+    std::unique_ptr<RegexDfa> dfa(RegexDfa::create(pattern, true));
+    CPPUNIT_ASSERT_MESSAGE(pattern, dfa != nullptr);
+    return dfa->matches(search, search + strlen(search));
+}
+
+class RegexDfaTests : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( RegexDfaTests );
+        CPPUNIT_TEST(testMatches);
+        CPPUNIT_TEST(testAssertions);
+        CPPUNIT_TEST(testUnsupported);
+        CPPUNIT_TEST(testFind);
+        CPPUNIT_TEST(testCache);
+    CPPUNIT_TEST_SUITE_END();
+
+    void testMatches()
+    {
+        //Check the linear time matcher gives the same results as boost
+        const char * patterns[] = { "abc", "a.c", "^abc$", "[a-z]+@[a-z]+\\.com", "\\bcat\\b", "\\Bcat", "(ab|cd)*e", "x{2,3}y",
+                                    "\\d{3}-\\d{4}", "[^[:alpha:]]+", "colou?r", "\\Aab", "ab\\z", "(a+)+b", "[]x]", "a\\.b", "\\x41",
+                                    "[\\w-]+$", "^$", "(?:x|y)*?z", "\\s+\\S", "a\\'", "\\`a", "\\<cat", "cat\\>", "\\<\\w+\\>",
+                                    "[\\<\\>]" };
+        const char * searches[] = { "", "abc", "ABC", "xabcx", "a\nabc\r\nx", "joe@example.com", "the cat sat", "concatenate",
+                                    "ababcde", "xxy", "xxxxy", "555-1234", "12", "color", "colour", "aaaaaaaaaaaab", "aaaaaaaaaaaa",
+                                    "]", "a.b", "axb", "A", "foo-bar", "\r\n", "xyz", " \t x", "xa", "a", "a cat", "cats", "<>",
+                                    "a\n" };
+        for (const char * pattern : patterns)
+        {
+            for (bool isCaseSensitive : { true, false })
+            {
+                boost::regex regEx = createBoostRegex(pattern, isCaseSensitive);
+                std::unique_ptr<RegexDfa> dfa(RegexDfa::create(pattern, isCaseSensitive));
+                CPPUNIT_ASSERT_MESSAGE(pattern, dfa != nullptr);
+                for (const char * search : searches)
+                {
+                    boost::cmatch subs;
+                    const char * end = search + strlen(search);
+                    bool expected = boost::regex_search(search, end, subs, regEx);
+                    VStringBuffer msg("/%s/ %s '%s'", pattern, isCaseSensitive ? "" : "nocase", search);
+                    CPPUNIT_ASSERT_EQUAL_MESSAGE(msg.str(), expected, dfa->matches(search, end));
+                }
+            }
+        }
+    }
+
+    void testAssertions()
+    {
+        //The text and word assertions must not be treated as escaped punctuation
+        CPPUNIT_ASSERT(dfaMatches("a\\'", "xa"));
+        CPPUNIT_ASSERT(!dfaMatches("a\\'", "a'"));
+        CPPUNIT_ASSERT(dfaMatches("\\`a", "a"));
+        CPPUNIT_ASSERT(!dfaMatches("\\`a", "`a"));
+        CPPUNIT_ASSERT(dfaMatches("\\<cat", "a cat"));
+        CPPUNIT_ASSERT(!dfaMatches("\\<cat", "concat"));
+        CPPUNIT_ASSERT(dfaMatches("cat\\>", "the cat sat"));
+        CPPUNIT_ASSERT(!dfaMatches("cat\\>", "cats"));
+        CPPUNIT_ASSERT(dfaMatches("[\\<]", "<"));
+    }
+
+    void testUnsupported()
+    {
+        const char * patterns[] = { "(a)\\1", "a(?=b)", "a(?!b)", "(?<=a)b", "(?i)abc", "a++", "(?:$)+", "a\\Z" };
+        for (const char * pattern : patterns)
+        {
+            std::unique_ptr<RegexDfa> dfa(RegexDfa::create(pattern, true));
+            CPPUNIT_ASSERT_MESSAGE(pattern, !dfa);
+        }
+    }
+
+    void testFind()
+    {
+        rtlCompiledStrRegex r("([a-z]+)@([a-z]+)", true);
+        rtlStrRegexFindInstance finder;
+        size32_t outlen;
+        char * out;
+
+        finder.find(r, 17, "mail joe@example.", false);
+        CPPUNIT_ASSERT(finder->found());
+        finder->getMatchX(outlen, out, 1);
+        CPPUNIT_ASSERT_EQUAL(std::string("joe"), std::string(out, outlen));
+        rtlFree(out);
+
+        finder.find(r, 8, "no email", false);
+        CPPUNIT_ASSERT(!finder->found());
+        finder->getMatchX(outlen, out, 1);
+        CPPUNIT_ASSERT_EQUAL(0U, outlen);
+
+        r->replace(outlen, out, 8, "no email", 4, "$2$1");
+        CPPUNIT_ASSERT_EQUAL(std::string("no email"), std::string(out, outlen));
+        rtlFree(out);
+        r->replace(outlen, out, 11, "to: joe@com", 4, "$2$1");
+        CPPUNIT_ASSERT_EQUAL(std::string("to: comjoe"), std::string(out, outlen));
+        rtlFree(out);
+
+        bool isAll;
+        size32_t resultBytes;
+        void * result;
+        r->getMatchSet(isAll, resultBytes, result, 8, "no email");
+        CPPUNIT_ASSERT_EQUAL(0U, resultBytes);
+        rtlFree(result);
+    }
+
+    void testCache()
+    {
+        //The case sensitivity is part of the key, so the cached entries must not be shared
+        rtlCompiledStrRegex r1("cache[0-9]+", true);
+        rtlCompiledStrRegex r2("cache[0-9]+", true);
+        rtlCompiledStrRegex r3("cache[0-9]+", false);
+        rtlStrRegexFindInstance finder;
+        finder.find(r2, 7, "CACHE12", false);
+        CPPUNIT_ASSERT(!finder->found());
+        finder.find(r3, 7, "CACHE12", false);
+        CPPUNIT_ASSERT(finder->found());
+        finder.find(r1, 7, "cache12", false);
+        CPPUNIT_ASSERT(finder->found());
+
+        //Bad patterns are reported each time they are used
+        for (unsigned i=0; i < 2; i++)
+        {
+            try
+            {
+                rtlCompiledStrRegex bad("cache[0-9", true);
+                CPPUNIT_FAIL("Bad pattern did not fail");
+            }
+            catch (IException * e)
+            {
+                e->Release();
+            }
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( RegexDfaTests );
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( RegexDfaTests, "RegexDfaTests" );
+
+class RegexTiming : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( RegexTiming );
+        CPPUNIT_TEST(testCompile);
+        CPPUNIT_TEST(testSearch);
+        CPPUNIT_TEST(testBacktracking);
+    CPPUNIT_TEST_SUITE_END();
+
+    static constexpr const char * emailPattern = "([a-z0-9._%+-]+)@([a-z0-9.-]+)\\.(com|org|net)";
+
+    void testCompile()
+    {
+        const unsigned numIter = 10000;
+        cycle_t start = get_cycles_now();
+        for (unsigned i=0; i < numIter; i++)
+        {
+            boost::regex regEx = createBoostRegex(emailPattern, false);
+            std::unique_ptr<RegexDfa> dfa(RegexDfa::create(emailPattern, false));
+        }
+        cycle_t compileElapsed = get_cycles_now() - start;
+
+        start = get_cycles_now();
+        for (unsigned i=0; i < numIter; i++)
+            rtlCompiledStrRegex r(emailPattern, false);
+        cycle_t cachedElapsed = get_cycles_now() - start;
+
+        DBGLOG("Regex compile: %.2fus cached %.2fus", (double)cycle_to_nanosec(compileElapsed) / numIter / 1000,
+               (double)cycle_to_nanosec(cachedElapsed) / numIter / 1000);
+    }
+
+    void testSearch()
+    {
+        boost::regex regEx = createBoostRegex(emailPattern, false);
+        std::unique_ptr<RegexDfa> dfa(RegexDfa::create(emailPattern, false));
+        CPPUNIT_ASSERT(dfa);
+
+        //A long row that does not contain a match
+        std::string search;
+        while (search.length() < 1000)
+            search.append("some text with an @ sign but no address. ");
+        const char * begin = search.c_str();
+        const char * end = begin + search.length();
+
+        const unsigned numIter = 1000;
+        bool found = false;
+        cycle_t start = get_cycles_now();
+        for (unsigned i=0; i < numIter; i++)
+        {
+            boost::cmatch subs;
+            found |= boost::regex_search(begin, end, subs, regEx);
+        }
+        cycle_t boostElapsed = get_cycles_now() - start;
+
+        start = get_cycles_now();
+        for (unsigned i=0; i < numIter; i++)
+            found |= dfa->matches(begin, end);
+        cycle_t dfaElapsed = get_cycles_now() - start;
+
+        CPPUNIT_ASSERT(!found);
+        DBGLOG("Regex search %u bytes: boost %.2fus dfa %.2fus (%u states)", (unsigned)search.length(),
+               (double)cycle_to_nanosec(boostElapsed) / numIter / 1000, (double)cycle_to_nanosec(dfaElapsed) / numIter / 1000, dfa->numDfaStates());
+    }
+
+    void testBacktracking()
+    {
+        //A pattern that requires exponential time for a backtracking matcher to fail
+        const char * pattern = "(x+x+)+y";
+        boost::regex regEx = createBoostRegex(pattern, true);
+        std::unique_ptr<RegexDfa> dfa(RegexDfa::create(pattern, true));
+        CPPUNIT_ASSERT(dfa);
+        std::string search(24, 'x');
+        const char * begin = search.c_str();
+        const char * end = begin + search.length();
+
+        bool boostFailed = false;
+        cycle_t start = get_cycles_now();
+        try
+        {
+            boost::cmatch subs;
+            CPPUNIT_ASSERT(!boost::regex_search(begin, end, subs, regEx));
+        }
+        catch (const std::runtime_error &)
+        {
+            boostFailed = true;     // boost gives up if the search is too complex
+        }
+        cycle_t boostElapsed = get_cycles_now() - start;
+
+        start = get_cycles_now();
+        CPPUNIT_ASSERT(!dfa->matches(begin, end));
+        cycle_t dfaElapsed = get_cycles_now() - start;
+
+        DBGLOG("Regex backtracking: boost %.2fms%s dfa %.2fms", (double)cycle_to_nanosec(boostElapsed) / 1000000,
+               boostFailed ? " (failed)" : "", (double)cycle_to_nanosec(dfaElapsed) / 1000000);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( RegexTiming );
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( RegexTiming, "RegexTiming" );
+
+#endif
@@ -0,0 +1,111 @@
+/*##############################################################################
+
+    Copyright (C) 2024 HPCC Systems®.
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+############################################################################## */
+
+#ifdef _USE_CPPUNIT
+#include <set>
+#include "jlib.hpp"
+#include "thorsoapcall.hpp"
+#include "unittests.hpp"
+
+class SoapCallTests : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( SoapCallTests );
+        CPPUNIT_TEST(testBatchDisabled);
+        CPPUNIT_TEST(testBatchShrinks);
+        CPPUNIT_TEST(testBatchGrows);
+        CPPUNIT_TEST(testBatchSettles);
+        CPPUNIT_TEST(testEndpointMetrics);
+        CPPUNIT_TEST(testEndpointMetricsBounded);
+    CPPUNIT_TEST_SUITE_END();
+
+    void testBatchDisabled()
+    {
+        CPPUNIT_ASSERT_EQUAL(50U, calcAdaptiveRecordsPerBatch(10, 50, 10, 5000, 0));
+        CPPUNIT_ASSERT_EQUAL(1U, calcAdaptiveRecordsPerBatch(1, 1, 1, 5000, 100));
+    }
+
+    void testBatchShrinks()
+    {
+        //Reduced to the number of rows that would have completed within the target
+        CPPUNIT_ASSERT_EQUAL(25U, calcAdaptiveRecordsPerBatch(100, 100, 100, 400, 100));
+        CPPUNIT_ASSERT_EQUAL(1U, calcAdaptiveRecordsPerBatch(100, 100, 100, 100000, 100));
+        //A partial batch that is slow is still a good estimate of the time for each row
+        CPPUNIT_ASSERT_EQUAL(4U, calcAdaptiveRecordsPerBatch(10, 100, 5, 110, 100));
+    }
+
+    void testBatchGrows()
+    {
+        //Grows gradually while full batches are fast, up to the size requested in the query
+        CPPUNIT_ASSERT_EQUAL(13U, calcAdaptiveRecordsPerBatch(10, 100, 10, 10, 100));
+        CPPUNIT_ASSERT_EQUAL(100U, calcAdaptiveRecordsPerBatch(90, 100, 90, 0, 100));
+        //Partial batches do not say how long a full batch would take
+        CPPUNIT_ASSERT_EQUAL(10U, calcAdaptiveRecordsPerBatch(10, 100, 2, 10, 100));
+
+        //Recovers once the latency drops again
+        unsigned current = 100;
+        current = calcAdaptiveRecordsPerBatch(current, 100, current, 1000, 100);
+        CPPUNIT_ASSERT_EQUAL(10U, current);
+        for (unsigned i=0; i < 20; i++)
+            current = calcAdaptiveRecordsPerBatch(current, 100, current, current / 2, 100);
+        CPPUNIT_ASSERT_EQUAL(100U, current);
+    }
+
+    void testBatchSettles()
+    {
+        //With a fixed cost per row the size should settle just within the target, rather than shrinking further
+        const unsigned msPerRow = 3;
+        const unsigned target = 100;
+        unsigned current = 200;
+        for (unsigned i=0; i < 50; i++)
+            current = calcAdaptiveRecordsPerBatch(current, 200, current, current * msPerRow, target);
+        CPPUNIT_ASSERT(current * msPerRow <= target);
+        CPPUNIT_ASSERT(current * msPerRow >= target * 3 / 4);
+    }
+
+    void testEndpointMetrics()
+    {
+        const SoapCallEndpointMetrics & first = querySoapCallEndpointMetrics("soapcalltest.first", 8010);
+        const SoapCallEndpointMetrics & again = querySoapCallEndpointMetrics("soapcalltest.first", 8010);
+        const SoapCallEndpointMetrics & other = querySoapCallEndpointMetrics("soapcalltest.first", 8011);
+        CPPUNIT_ASSERT(&first == &again);
+        CPPUNIT_ASSERT(&first != &other);
+        CPPUNIT_ASSERT(first.latency && first.connects);
+        CPPUNIT_ASSERT(first.connects != other.connects);
+
+        first.connects->inc(1);
+        first.connects->inc(2);
+        CPPUNIT_ASSERT_EQUAL((__uint64)3, first.connects->queryValue());
+        CPPUNIT_ASSERT_EQUAL((__uint64)0, other.connects->queryValue());
+    }
+
+    void testEndpointMetricsBounded()
+    {
+        std::set<const SoapCallEndpointMetrics *> distinct;
+        for (unsigned port=1; port <= maxSoapCallEndpointMetrics * 2; port++)
+            distinct.insert(&querySoapCallEndpointMetrics("soapcalltest.bounded", port));
+        //Once the limit is reached, all new endpoints share the same metrics
+        CPPUNIT_ASSERT(distinct.size() <= maxSoapCallEndpointMetrics + 1);
+        const SoapCallEndpointMetrics & extra1 = querySoapCallEndpointMetrics("soapcalltest.extra", 1);
+        const SoapCallEndpointMetrics & extra2 = querySoapCallEndpointMetrics("soapcalltest.extra", 2);
+        CPPUNIT_ASSERT(&extra1 == &extra2);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( SoapCallTests );
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( SoapCallTests, "SoapCallTests" );
+
+#endif
@@ -2734,6 +2734,7 @@ void CJobBase::init()
 
     // global setting default on, can be overridden by #option
     timeActivities = getLegacyExpertSettingBool(THOROPT_TIME_ACTIVITIES, true);
+    setCollectHardwareCounters(timeActivities && getLegacyExpertSettingBool(THOROPT_HARDWARE_COUNTERS, false));
     maxActivityCores = getOptUInt(THOROPT_MAX_ACTIVITY_CORES, 0); // NB: 0 means system decides
     if (0 == maxActivityCores)
         maxActivityCores = getAffinityCpus();
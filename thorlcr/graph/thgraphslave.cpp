@@ -130,6 +130,7 @@ CSlaveActivity::CSlaveActivity(CGraphElementBase *_container, const StatisticsMa
     : CActivityBase(_container, statsMapping), CEdgeProgress(this), inactiveStats(statsMapping)
 {
     data = NULL;
+    slaveTimerStats.profileActivityId = container.queryId();
 }
 
 CSlaveActivity::~CSlaveActivity()
@@ -585,6 +586,7 @@ void CSlaveActivity::serializeStats(MemoryBuffer &mb)
     serializedStats.setStatistic(StTimeLocalExecute, (unsigned __int64)cycle_to_nanosec(queryLocalCycles()));
     serializedStats.setStatistic(StTimeTotalExecute, (unsigned __int64)cycle_to_nanosec(queryTotalCycles()));
     serializedStats.setStatistic(StTimeBlocked, (unsigned __int64)cycle_to_nanosec(queryBlockedCycles()));
+    slaveTimerStats.addHardwareStatistics(serializedStats);
     serializedStats.serialize(mb);
     ForEachItemIn(i, outputs)
     {
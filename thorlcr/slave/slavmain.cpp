@@ -1774,6 +1774,7 @@ public:
         bool doReply;
 
         OwnedPtr<CThorPerfTracer> perf;
+        CThorSamplingProfiler profiler;
         while (!stopped && queryNodeComm().recv(msg, 0, masterSlaveMpTag))
         {
             doReply = true;
@@ -1984,36 +1985,48 @@ public:
                             perf.setown(new CThorPerfTracer);
                             perf->start(job->queryWuid(), subGraphId, perfInterval);
                         }
+                        unsigned profileSampleRate = job->getOptUInt(THOROPT_PROFILE_SAMPLE_RATE);
+                        if (profileSampleRate)
+                            profiler.start(job->queryWuid(), subGraphId, profileSampleRate);
 
-                        VStringBuffer xpath("node[@id='%" GIDPF "u']", subGraphId);
-                        Owned<IPropertyTree> graphNode = job->queryGraphXGMML()->getPropTree(xpath.str());
-                        job->addSubGraph(*graphNode);
-
-                        /* JCSMORE - should improve, create 1st graph with create context/init data and clone
-                         * Should perhaps do this initialization in parallel..
-                         */
-                        for (unsigned c=0; c<job->queryJobChannels(); c++)
+                        try
                         {
-                            PROGLOG("GraphInit: %s, graphId=%" GIDPF "d, slaveChannel=%d", jobKey.get(), subGraphId, c);
-                            CJobChannel &jobChannel = job->queryJobChannel(c);
-                            Owned<CSlaveGraph> subGraph = (CSlaveGraph *)jobChannel.getGraph(subGraphId);
-                            subGraph->setExecuteReplyTag(executeReplyTag);
+                            VStringBuffer xpath("node[@id='%" GIDPF "u']", subGraphId);
+                            Owned<IPropertyTree> graphNode = job->queryGraphXGMML()->getPropTree(xpath.str());
+                            job->addSubGraph(*graphNode);
 
-                            createInitData.reset(0);
-                            subGraph->deserializeCreateContexts(createInitData);
+                            /* JCSMORE - should improve, create 1st graph with create context/init data and clone
+                             * Should perhaps do this initialization in parallel..
+                             */
+                            for (unsigned c=0; c<job->queryJobChannels(); c++)
+                            {
+                                PROGLOG("GraphInit: %s, graphId=%" GIDPF "d, slaveChannel=%d", jobKey.get(), subGraphId, c);
+                                CJobChannel &jobChannel = job->queryJobChannel(c);
+                                Owned<CSlaveGraph> subGraph = (CSlaveGraph *)jobChannel.getGraph(subGraphId);
+                                subGraph->setExecuteReplyTag(executeReplyTag);
 
-                            msg.reset(graphInitDataPos);
-                            subGraph->init(msg);
+                                createInitData.reset(0);
+                                subGraph->deserializeCreateContexts(createInitData);
 
-                            jobChannel.addDependencies(job->queryXGMML(), false);
-                        }
+                                msg.reset(graphInitDataPos);
+                                subGraph->init(msg);
 
-                        for (unsigned c=0; c<job->queryJobChannels(); c++)
-                        {
-                            CJobChannel &jobChannel = job->queryJobChannel(c);
-                            Owned<CSlaveGraph> subGraph = (CSlaveGraph *)jobChannel.getGraph(subGraphId);
+                                jobChannel.addDependencies(job->queryXGMML(), false);
+                            }
+
+                            for (unsigned c=0; c<job->queryJobChannels(); c++)
+                            {
+                                CJobChannel &jobChannel = job->queryJobChannel(c);
+                                Owned<CSlaveGraph> subGraph = (CSlaveGraph *)jobChannel.getGraph(subGraphId);
 
-                            jobChannel.startGraph(*subGraph, true, 0, NULL);
+                                jobChannel.startGraph(*subGraph, true, 0, NULL);
+                            }
+                        }
+                        catch (IException *)
+                        {
+                            // The subgraph will not run, so there will be no GraphEnd to stop the profiler
+                            profiler.stop();
+                            throw;
                         }
                         msg.clear();
                         msg.append(false);
@@ -2035,6 +2048,7 @@ public:
                                 perf->stop();
                                 perf.clear();
                             }
+                            profiler.stop();
 
                             msg.clear();
                             msg.append(false);
@@ -2090,6 +2104,7 @@ public:
                                     graph->abort(e);
                                 }
                             }
+                            profiler.stop();
                         }
                         msg.clear();
                         msg.append(false);
@@ -75,7 +75,8 @@ static Owned<IMPtagAllocator> ClusterMPAllocator;
 // stat. mappings shared between master and slave activities
 const StatisticsMapping spillStatistics({StTimeSpillElapsed, StTimeSortElapsed, StNumSpills, StSizeSpillFile});
 const StatisticsMapping soapcallStatistics({StTimeSoapcall});
-const StatisticsMapping basicActivityStatistics({StTimeTotalExecute, StTimeLocalExecute, StTimeBlocked});
+const StatisticsMapping basicActivityStatistics({StTimeTotalExecute, StTimeLocalExecute, StTimeBlocked,
+                                                 StNumHwCycles, StNumHwInstructions, StNumHwCacheMisses, StNumHwBranchMisses});
 const StatisticsMapping groupActivityStatistics({StNumGroups, StNumGroupMax}, basicActivityStatistics);
 const StatisticsMapping hashJoinActivityStatistics({StNumLeftRows, StNumRightRows}, basicActivityStatistics);
 const StatisticsMapping indexReadFileStatistics({}, diskReadRemoteStatistics, jhtreeCacheStatistics);
@@ -1684,6 +1685,39 @@ void CThorPerfTracer::stop()
     }
 }
 
+void CThorSamplingProfiler::start(const char *_workunit, unsigned _subGraphId, unsigned samplesPerSecond)
+{
+    stop();
+    workunit.set(_workunit);
+    subGraphId = _subGraphId;
+    started = startSamplingProfiler(samplesPerSecond);
+    if (started)
+        PROGLOG("Started sampling profile of subgraph %u, %u samples per second", subGraphId, samplesPerSecond);
+}
+
+void CThorSamplingProfiler::stop()
+{
+    if (!started)
+        return;
+    stopSamplingProfiler();
+    started = false;
+    StringBuffer profileName;
+    if (getConfigurationDirectory(globals->queryPropTree("Directories"), "debug", "thor", globals->queryProp("@name"), profileName))
+        addPathSepChar(profileName);
+    profileName.appendf("%s/%u/profile_%u.folded", workunit.get(), globals->getPropInt("@slavenum"), subGraphId);
+    try
+    {
+        ensureDirectoryForFile(profileName);
+        if (saveSamplingProfile(profileName, true))
+            PROGLOG("Sampling profile for subgraph %u written to %s", subGraphId, profileName.str());
+    }
+    catch (IException *E)
+    {
+        EXCLOG(E);
+        ::Release(E);
+    }
+}
+
 void saveWuidToFile(const char *wuid)
 {
     // Store current wuid to a local file, so post mortem script can find it (and if necessary publish files to it)
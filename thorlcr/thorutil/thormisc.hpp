@@ -107,6 +107,8 @@
 #define THOROPT_KJ_ASSUME_PRIMARY "keyedJoinAssumePrimary"      // assume primary part exists (don't check when mapping, which can be slow)
 #define THOROPT_COMPRESS_SORTOVERFLOW "compressSortOverflow"    // If global sort spills, compress the merged overflow file                      (default = true)
 #define THOROPT_TIME_ACTIVITIES "timeActivities"                // Time activities (default=true)
+#define THOROPT_HARDWARE_COUNTERS "hardwareCounters"            // Gather hardware performance counters for timed activities (default=false)
+#define THOROPT_PROFILE_SAMPLE_RATE "profileSampleRate"         // Samples per second taken by the built-in sampling profiler while a subgraph runs (default=0, off)
 #define THOROPT_MAX_ACTIVITY_CORES "maxActivityCores"           // controls number of default threads to use for very parallel phases (like sort/parallel join helper). (default = # of h/w cores)
 #define THOROPT_THOR_ROWCRC "THOR_ROWCRC"                       // Use a CRC checking row allocator (default=false)
 #define THOROPT_THOR_PACKEDALLOCATOR "THOR_PACKEDALLOCATOR"     // Use packed roxiemem row allocators by default (default=true)
@@ -616,6 +618,20 @@ public:
     void stop();
 };
 
+// Runs the built-in sampling profiler for a subgraph, and saves the folded stacks alongside the perf flame graphs
+class graph_decl CThorSamplingProfiler
+{
+    StringAttr workunit;
+    unsigned subGraphId = 0;
+    bool started = false;
+public:
+    ~CThorSamplingProfiler() { stop(); }
+
+    // Any profile that is still running is stopped and saved first
+    void start(const char *workunit, unsigned subGraphId, unsigned samplesPerSecond);
+    void stop();
+};
+
 extern graph_decl void saveWuidToFile(const char *wuid);
 
 #endif
@@ -34,6 +34,7 @@
 
 #ifdef _USE_CPPUNIT
 #include "workunitservices.hpp"
+#include "wustats.hpp"
 #include "eclrtl.hpp"
 #include <cppunit/extensions/TestFactoryRegistry.h>
 #include <cppunit/ui/text/TestRunner.h>
@@ -816,6 +817,7 @@ class WuTool : public CppUnit::TestFixture
         CPPUNIT_TEST(testListByFilesRead);
         CPPUNIT_TEST(testListByFilesWritten);
         CPPUNIT_TEST(testSortByThorTime);
+        CPPUNIT_TEST(testSummaryIndex);
         CPPUNIT_TEST(testSet);
         CPPUNIT_TEST(testResults);
         CPPUNIT_TEST(testWorkUnitServices);
@@ -824,6 +826,8 @@ class WuTool : public CppUnit::TestFixture
         CPPUNIT_TEST(testQuery);
         CPPUNIT_TEST(testGraph);
         CPPUNIT_TEST(testGraphProgress);
+        CPPUNIT_TEST(testColumnarStatistics);
+        CPPUNIT_TEST(testGraphProgressScopes);
     CPPUNIT_TEST_SUITE_END();
 protected:
     static StringArray wuids;
@@ -1387,6 +1391,272 @@ protected:
         factory->deleteWorkUnit(wuid);
     }
 
+    //The scopes and statistics of a collection, in the order of a depth first walk of the (sorted) collection
+    struct WalkedScope
+    {
+        std::string scope;
+        StatisticScopeType scopeType;
+        unsigned depth;
+        std::vector<std::pair<StatisticKind, stat_type>> stats;
+    };
+
+    void walkStatisticCollection(std::vector<WalkedScope> & scopes, IStatisticCollection & collection, unsigned depth, StringBuffer & scopeName)
+    {
+        size32_t prevLength = scopeName.length();
+        if (prevLength)
+            scopeName.append(':');
+        collection.getScope(scopeName);
+
+        WalkedScope cur{ scopeName.str(), collection.queryScopeType(), depth };
+        unsigned numStats = collection.getNumStatistics();
+        for (unsigned i=0; i < numStats; i++)
+        {
+            StatisticKind kind;
+            stat_type value;
+            collection.getStatistic(kind, value, i);
+            cur.stats.emplace_back(kind, value);
+        }
+        scopes.push_back(cur);
+
+        Owned<IStatisticCollectionIterator> childIter = &collection.getScopes(nullptr, true);
+        ForEach(*childIter)
+            walkStatisticCollection(scopes, childIter->query(), depth+1, scopeName);
+        scopeName.setLength(prevLength);
+    }
+
+    void addSubGraphTestStats(IStatisticGatherer & stats, unsigned subgraph)
+    {
+        StatsSubgraphScope subgraphScope(stats, subgraph);
+        stats.addStatistic(StTimeElapsed, subgraph * 1000);
+        //Added out of order to check the scopes are sorted
+        for (unsigned activity = 3; activity >= 1; activity--)
+        {
+            unsigned id = subgraph * 10 + activity;
+            {
+                StatsActivityScope activityScope(stats, id);
+                stats.addStatistic(StNumRowsProcessed, activity * 100);
+                stats.addStatistic(StTimeLocalExecute, activity);
+                if (activity == 2)
+                {
+                    StatsChildGraphScope childScope(stats, id * 10);
+                    StatsActivityScope childActivity(stats, id * 10 + 1);
+                    stats.addStatistic(StNumStarts, subgraph);
+                }
+            }
+            StatsEdgeScope edgeScope(stats, id, 0);
+            stats.addStatistic(StNumRowsProcessed, activity * 100);
+        }
+    }
+
+    void checkWalkedColumns(const std::vector<WalkedScope> & expected, const ColumnarStatistics & columns)
+    {
+        ASSERT(columns.numScopes() == expected.size());
+        for (unsigned i=0; i < expected.size(); i++)
+        {
+            const WalkedScope & cur = expected[i];
+            checkStringsMatch(cur.scope.c_str(), columns.queryScope(i));
+            ASSERT(columns.queryScopeType(i) == cur.scopeType);
+            ASSERT(columns.queryDepth(i) == cur.depth);
+            ASSERT(columns.queryNumStats(i) == cur.stats.size());
+            unsigned first = columns.queryFirstStat(i);
+            for (unsigned j=0; j < cur.stats.size(); j++)
+            {
+                ASSERT(columns.queryKind(first+j) == cur.stats[j].first);
+                ASSERT(columns.queryValue(first+j) == cur.stats[j].second);
+                stat_type value = 0;
+                ASSERT(columns.getStatistic(i, cur.stats[j].first, value) && (value == cur.stats[j].second));
+            }
+
+            //Check against the scopes that the walk of the collection would skip to
+            ASSERT(columns.skipChildren(i) == nextWalkedScope(expected, i, cur.depth + 1));
+            ASSERT(columns.skipToParentSibling(i) == nextWalkedScope(expected, i, cur.depth));
+        }
+    }
+
+    //Index of the first scope following scope that is less deeply nested than maxDepth
+    static unsigned nextWalkedScope(const std::vector<WalkedScope> & scopes, unsigned scope, unsigned maxDepth)
+    {
+        unsigned next = scope + 1;
+        while ((next < scopes.size()) && (scopes[next].depth >= maxDepth))
+            next++;
+        return next;
+    }
+
+    void checkSameRollups(const std::vector<StatisticRollup> & left, const std::vector<StatisticRollup> & right)
+    {
+        ASSERT(left.size() == right.size());
+        for (unsigned i=0; i < left.size(); i++)
+        {
+            ASSERT(left[i].scopeType == right[i].scopeType);
+            ASSERT(left[i].kind == right[i].kind);
+            ASSERT(left[i].count == right[i].count);
+            ASSERT(left[i].sum == right[i].sum);
+            ASSERT(left[i].minValue == right[i].minValue);
+            ASSERT(left[i].maxValue == right[i].maxValue);
+        }
+    }
+
+    IStatisticCollection * createTestCollection(unsigned subgraph)
+    {
+        Owned<IStatisticGatherer> stats = createStatisticsGatherer(SCThthor, queryStatisticsComponentName(), StatsScopeId(SSTworkflow, 1));
+        StatsScopeId graphScopeId;
+        verifyex(graphScopeId.setScopeText("graph1"));
+        stats->beginScope(graphScopeId);
+        addSubGraphTestStats(*stats, subgraph);
+        stats->endScope();
+        return stats->getResult();
+    }
+
+    void testColumnarStatistics()
+    {
+        Owned<IStatisticCollection> collection = createTestCollection(1);
+        std::vector<WalkedScope> expected;
+        StringBuffer scopeName;
+        walkStatisticCollection(expected, *collection, 0, scopeName);
+        ASSERT(expected.size() == 11);
+
+        ColumnarStatistics columns;
+        columns.build(*collection);
+        checkWalkedColumns(expected, columns);
+        ASSERT(columns.queryWhenCreated() == collection->queryWhenCreated());
+
+        //Round trip via the serialized form
+        MemoryBuffer serialized;
+        columns.serialize(serialized);
+        ColumnarStatistics copy;
+        copy.deserialize(serialized);
+        checkWalkedColumns(expected, copy);
+        checkSameRollups(columns.queryRollups(), copy.queryRollups());
+        ASSERT(copy.queryWhenCreated() == columns.queryWhenCreated());
+
+        //...and the compressed form that is stored in the progress tree
+        MemoryBuffer compressed;
+        columns.serialize(serialized.clear());
+        compressToBuffer(compressed, serialized.length(), serialized.toByteArray());
+        ColumnarStatistics uncompressed;
+        uncompressed.deserializeCompressed(compressed);
+        checkWalkedColumns(expected, uncompressed);
+        checkSameRollups(columns.queryRollups(), uncompressed.queryRollups());
+
+        //Check a couple of the rollups directly
+        bool seenActivityRows = false;
+        for (auto & rollup : columns.queryRollups())
+        {
+            if ((rollup.scopeType == SSTactivity) && (rollup.kind == StNumRowsProcessed))
+            {
+                ASSERT(rollup.count == 3 && rollup.sum == 600 && rollup.minValue == 100 && rollup.maxValue == 300);
+                seenActivityRows = true;
+            }
+        }
+        ASSERT(seenActivityRows);
+    }
+
+    //Return the first scope at or after scope that the graph progress iterator returns - the workflow root and a graph
+    //without any statistics are only containers
+    static unsigned nextVisibleScope(const std::vector<WalkedScope> & scopes, unsigned scope)
+    {
+        while (scope < scopes.size())
+        {
+            const WalkedScope & cur = scopes[scope];
+            if (!((cur.scopeType == SSTworkflow) && (cur.depth == 0)) && !((cur.scopeType == SSTgraph) && (cur.depth <= 1) && cur.stats.empty()))
+                break;
+            scope++;
+        }
+        return scope;
+    }
+
+    void checkIteratorMatches(IConstWUScopeIterator & iter, const std::vector<WalkedScope> & expected, unsigned scope)
+    {
+        if (scope == expected.size())
+        {
+            ASSERT(!iter.isValid());
+            return;
+        }
+        ASSERT(iter.isValid());
+        const WalkedScope & cur = expected[scope];
+        checkStringsMatch(cur.scope.c_str(), iter.queryScope());
+        ASSERT(iter.getScopeType() == cur.scopeType);
+        for (auto & stat : cur.stats)
+        {
+            stat_type value = 0;
+            ASSERT(iter.getStat(stat.first, value) && (value == stat.second));
+        }
+    }
+
+    void checkGraphProgressScopes(IConstWorkUnit * wu, const std::vector<WalkedScope> & expected)
+    {
+        const WuScopeFilter filter("source[stats]");
+        Owned<IConstWUScopeIterator> iter = &wu->getScopeIterator(filter);
+
+        //The iterator returns the same scopes as a walk of the collections
+        unsigned scope = nextVisibleScope(expected, 0);
+        iter->first();
+        for (;;)
+        {
+            checkIteratorMatches(*iter, expected, scope);
+            if (scope == expected.size())
+                break;
+            iter->next();
+            scope = nextVisibleScope(expected, scope + 1);
+        }
+
+        //nextSibling() and nextParent() skip to the same scopes as the walk
+        for (unsigned start = nextVisibleScope(expected, 0); start < expected.size(); start = nextVisibleScope(expected, start + 1))
+        {
+            unsigned depth = expected[start].depth;
+            for (unsigned pass = 0; pass < 2; pass++)
+            {
+                iter->first();
+                while (!streq(iter->queryScope(), expected[start].scope.c_str()))
+                    ASSERT(iter->next());
+                if (pass == 0)
+                {
+                    iter->nextSibling();
+                    checkIteratorMatches(*iter, expected, nextVisibleScope(expected, nextWalkedScope(expected, start, depth + 1)));
+                }
+                else
+                {
+                    iter->nextParent();
+                    checkIteratorMatches(*iter, expected, nextVisibleScope(expected, nextWalkedScope(expected, start, depth)));
+                }
+            }
+        }
+    }
+
+    void testGraphProgressScopes()
+    {
+        Owned<IWorkUnitFactory> factory = getWorkUnitFactory();
+        Owned<IWorkUnit> createWu = factory->createWorkUnit("WuTest", NULL, NULL, NULL);
+        StringBuffer wuid(createWu->queryWuid());
+        createWu->setState(WUStateCompleted);
+        createWu->commit();
+        createWu.clear();
+        Owned<IConstWorkUnit> wu = factory->openWorkUnit(wuid);
+
+        std::vector<WalkedScope> expected;
+        for (unsigned subgraph = 1; subgraph <= 2; subgraph++)
+        {
+            Owned<IWUGraphStats> progress = wu->updateStats("graph1", SCThthor, queryStatisticsComponentName(), 1, subgraph, false);
+            addSubGraphTestStats(progress->queryStatsBuilder(), subgraph);
+            progress.clear();
+
+            Owned<IStatisticCollection> collection = createTestCollection(subgraph);
+            StringBuffer scopeName;
+            walkStatisticCollection(expected, *collection, 0, scopeName);
+        }
+
+        //While the graph is running the columns are built from the serialized collection
+        wu->setGraphState("graph1", 1, WUGraphRunning);
+        checkGraphProgressScopes(wu, expected);
+
+        //Once it completes the columnar form is saved, and must produce the same results
+        wu->setGraphState("graph1", 1, WUGraphComplete);
+        checkGraphProgressScopes(wu, expected);
+
+        wu.clear();
+        factory->deleteWorkUnit(wuid);
+    }
+
     void sortStatistics(StringBuffer &xml)
     {
         Owned<IPropertyTree> p = createPTreeFromXMLString(xml);
@@ -2071,6 +2341,122 @@ protected:
         ASSERT(numIterated == before);
         numIterated++;
     }
+    static void getSortKey(StringBuffer & key, IConstWorkUnitInfo & wu, WUSortField sortorder)
+    {
+        switch (sortorder & 0xff)
+        {
+        case WUSFuser:
+            key.append(wu.queryUser());
+            break;
+        case WUSFcluster:
+            key.append(wu.queryClusterName());
+            break;
+        case WUSFjob:
+            key.append(wu.queryJobName());
+            break;
+        case WUSFstate:
+            key.append(wu.queryStateDesc());
+            break;
+        case WUSFtotalthortime:
+            key.append(wu.getTotalThorTime());
+            break;
+        default:
+            key.append(wu.queryWuid());
+            break;
+        }
+    }
+    void getSortedWorkUnits(IWorkUnitFactory * factory, WUSortField sortorder, WUSortField * filters, const void * filterbuf, unsigned startoffset, unsigned maxnum,
+                            StringArray & keys, StringArray & wuidList, unsigned & total)
+    {
+        Owned<IConstWorkUnitIterator> wus = factory->getWorkUnitsSorted(sortorder, filters, filterbuf, startoffset, maxnum, NULL, &total);
+        ForEach(*wus)
+        {
+            IConstWorkUnitInfo &wu = wus->query();
+            StringBuffer key;
+            getSortKey(key, wu, sortorder);
+            keys.append(key);
+            wuidList.append(wu.queryWuid());
+        }
+    }
+    void checkSummaryIndexMatches(IWorkUnitFactory * daliFactory, IWorkUnitFactory * indexFactory, WUSortField sortorder, WUSortField * filters, const void * filterbuf, unsigned startoffset, unsigned maxnum)
+    {
+        StringArray daliKeys, daliWuids, indexKeys, indexWuids;
+        unsigned daliTotal = (unsigned)-1;
+        unsigned indexTotal = (unsigned)-2;
+        getSortedWorkUnits(daliFactory, sortorder, filters, filterbuf, startoffset, maxnum, daliKeys, daliWuids, daliTotal);
+        getSortedWorkUnits(indexFactory, sortorder, filters, filterbuf, startoffset, maxnum, indexKeys, indexWuids, indexTotal);
+        ASSERT_EQUAL(daliTotal, indexTotal);
+        ASSERT_EQUAL(daliKeys.ordinality(), indexKeys.ordinality());
+        //Workunits with the same key may be returned in a different order, but the keys must be in the same order
+        ForEachItemIn(i, daliKeys)
+            checkStringsMatch(daliKeys.item(i), indexKeys.item(i));
+        //If all the matches were returned they must be the same workunits
+        if (startoffset == 0 && daliTotal <= maxnum)
+        {
+            ASSERT_EQUAL(daliTotal, daliWuids.ordinality());
+            daliWuids.sortAscii();
+            indexWuids.sortAscii();
+            ForEachItemIn(i, daliWuids)
+                checkStringsMatch(daliWuids.item(i), indexWuids.item(i));
+        }
+    }
+    void testSummaryIndex()
+    {
+        //The summary index is only used for workunits stored in dali
+        if (!streq(getWorkUnitFactory()->queryStoreType(), "Dali"))
+            return;
+
+        Owned<IWorkUnitFactory> daliFactory = createDaliWorkUnitFactory(false);
+        Owned<IWorkUnitFactory> indexFactory = createDaliWorkUnitFactory(true);
+        unsigned start = msTick();
+
+        StringBuffer lowWuid(wuids.ordinality() > 100 ? wuids.item(10) : "W");
+        StringBuffer highWuid(wuids.ordinality() > 100 ? wuids.item(100) : "X");
+        MemoryBuffer wuidRange;
+        wuidRange.append(lowWuid.str()).append(highWuid.str());
+
+        WUSortField noFilter[] = { WUSFterm };
+        WUSortField byUser[] = { WUSFuser, WUSFterm };
+        WUSortField byClusters[] = { WUSFcluster, WUSFterm };
+        WUSortField byStateAndJob[] = { WUSFstate, (WUSortField)(WUSFjob|WUSFwild), WUSFterm };
+        WUSortField byThorTime[] = { WUSFtotalthortime, WUSFterm };
+        WUSortField byAppValue[] = { WUSFappvalue, WUSFterm };
+        WUSortField byWuidRange[] = { WUSFwuid, WUSFwuidhigh, WUSFterm };
+        WUSortField byWildWuid[] = { WUSFwildwuid, WUSFterm };
+        struct
+        {
+            WUSortField * filters;
+            const void * filterbuf;
+        } filters[] = {
+            { noFilter, nullptr },
+            { byUser, "WuTestUser01" },
+            { byClusters, "WuTestCluster1|WuTestCluster3" },
+            { byStateAndJob, "completed\0WuTest job 1*" },
+            { byThorTime, "50" },
+            { byAppValue, "appname\0userId\0WuTestUser02" },
+            { byWuidRange, wuidRange.toByteArray() },
+            { byWildWuid, "W*1" },
+        };
+        WUSortField sortOrders[] = {
+            WUSFwuid,
+            (WUSortField)(WUSFwuid|WUSFreverse),
+            WUSFuser,
+            (WUSortField)(WUSFcluster|WUSFreverse),
+            (WUSortField)(WUSFjob|WUSFnocase),
+            WUSFstate,
+            (WUSortField)(WUSFtotalthortime|WUSFreverse)
+        };
+
+        for (auto & filter : filters)
+        {
+            for (WUSortField sortorder : sortOrders)
+            {
+                checkSummaryIndexMatches(daliFactory, indexFactory, sortorder, filter.filters, filter.filterbuf, 0, 100000);
+                checkSummaryIndexMatches(daliFactory, indexFactory, sortorder, filter.filters, filter.filterbuf, 7, 10);
+            }
+        }
+        DBGLOG("Summary index compared with dali in %d ms", msTick()-start);
+    }
     void testGlobal()
     {
         // Is global workunit ever actually used any more? For scalar persists, perhaps